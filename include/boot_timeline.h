@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+class ResponseSink;
+
+// Boot timeline configuration
+#define BOOT_MAX_STAGES     10
+
+// Points reached after setup() returns, while the scheduler runs
+enum BootMilestone : uint8_t {
+    BOOT_LOOP,              // First scheduler pass
+    BOOT_FIRST_SAMPLE,      // First I2C sample collected
+    BOOT_WIFI,              // WiFi joined
+    BOOT_MQTT,              // Broker session up
+    BOOT_MILESTONE_COUNT
+};
+
+/**
+ * Boot stage timing
+ *
+ * setup() calls stage() as each step completes; a stage's time is the time
+ * since the previous call (the first one counts from reset). Milestones are
+ * reached from the scheduler tasks and keep their first time only, so the
+ * report shows how long after reset sampling, WiFi and MQTT came up.
+ */
+class BootTimeline {
+public:
+    BootTimeline();
+
+    // End the current setup stage
+    void stage(const char* name);
+
+    // Record a milestone the first time it is reached
+    void reach(BootMilestone milestone);
+    bool isReached(BootMilestone milestone) const { return reached & (1 << milestone); }
+
+    unsigned long getSetupMs() const;
+    void getReport(ResponseSink& out) const;
+
+private:
+    struct Stage {
+        const char* name;
+        uint32_t endMs;
+    };
+
+    Stage stages[BOOT_MAX_STAGES];
+    uint8_t stageCount;
+    uint32_t milestoneMs[BOOT_MILESTONE_COUNT];
+    uint8_t reached;
+};
+
+extern BootTimeline* g_bootTimeline;
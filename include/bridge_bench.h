@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Arduino.h>
+#include "stream_filter.h"
+
+class ResponseSink;
+
+// Bridge bench configuration
+#define BENCH_MIN_RATE_HZ        1
+#define BENCH_MAX_RATE_HZ        1000
+#define BENCH_DEFAULT_SECONDS    10
+#define BENCH_MAX_SECONDS        300
+#define BENCH_RAMP_STEP_MS       3000
+#define BENCH_SETTLE_MS          1500    // Echo grace period after each step
+#define BENCH_MAX_CATCHUP        4       // Frames injected per pass when behind schedule
+#define BENCH_MAX_STEPS          9
+#define BENCH_CLEAN_ECHO_PERCENT 99      // A step is clean with no drops and this many echoes
+#define BENCH_HISTOGRAM_OCTAVES  22      // Latencies up to ~4.2 s
+#define BENCH_FRAME_TYPE         0x13    // Pressure layout, the most frequent controller frame
+#define BENCH_FRAME_LENGTH       15      // SIZE byte + 6 header + 8 payload
+#define BENCH_STEP_MARKER        0xB0    // Payload pin byte = marker + step, ties echoes to a step
+
+#define TOPIC_BRIDGE_BENCH       "monitor/bench/frame"
+
+// Timed stages of one bench frame
+enum BenchStage {
+    BENCH_STAGE_WAIT,       // Injected -> complete frame found by the parser
+    BENCH_STAGE_FORWARD,    // publishBinary() call
+    BENCH_STAGE_DECODE,     // decodeAndPublish() with publishing dropped
+    BENCH_STAGE_ECHO,       // Injected -> frame back from the broker (end to end)
+    BENCH_STAGE_COUNT
+};
+
+/**
+ * On-device bridge self-test
+ *
+ * Schedules synthetic size-prefixed frames at a fixed rate and collects
+ * per-stage latency histograms; SerialBridge writes the frames into its
+ * receive ring, so they go through the same framing, publishBinary() and
+ * decoder as controller traffic. They are published to TOPIC_BRIDGE_BENCH
+ * (not controller/protobuff), excluded from sequence accounting, and decoded
+ * in dry-run mode so the controller topics see nothing. Each frame carries
+ * its injection time in micros() as its timestamp, so the broker echo on the
+ * bench subscription gives the end-to-end latency without a lookup table.
+ *
+ * A run is one step at a fixed rate, or a ramp through BENCH_RAMP_RATES that
+ * stops at the first step with drops or missing echoes. Every step is
+ * followed by BENCH_SETTLE_MS without injection for late echoes.
+ */
+class BridgeBench {
+public:
+    BridgeBench();
+
+    bool start(uint16_t rateHz, uint16_t seconds);
+    void startRamp();
+    void stop();
+
+    bool isRunning() const { return phase == PHASE_RUNNING || phase == PHASE_SETTLING; }
+
+    /**
+     * Frames due for injection now; advances the schedule and counts frames
+     * that fell more than BENCH_MAX_CATCHUP behind as missed
+     */
+    uint8_t framesDue(unsigned long nowUs);
+
+    /**
+     * Build the next bench frame (BENCH_FRAME_LENGTH bytes)
+     */
+    void buildFrame(uint8_t* frame, unsigned long nowUs);
+    bool isBenchFrame(const uint8_t* data, size_t length) const;
+    uint32_t injectedAt(const uint8_t* data) const;
+
+    void recordInjected(uint8_t frames) { step().injected += frames; }
+    void recordDeferred(uint8_t frames) { step().deferred += frames; }
+    void recordForward(bool success, uint32_t us);
+    void recordStage(BenchStage stage, uint32_t us) { stages[stage].update(us); }
+    void onEcho(const uint8_t* data, size_t length);
+
+    /**
+     * Step and settle transitions
+     * @return true once when the run has just finished
+     */
+    bool service(unsigned long nowMs);
+
+    void getReport(ResponseSink& out);
+
+private:
+    enum Phase : uint8_t {
+        PHASE_IDLE,
+        PHASE_RUNNING,
+        PHASE_SETTLING,
+        PHASE_DONE
+    };
+
+    struct StepResult {
+        uint16_t rateHz;
+        uint32_t injected;
+        uint32_t deferred;          // Ring held controller bytes, frame not injected
+        uint32_t missed;            // Loop too slow to keep the schedule
+        uint32_t forwardFailures;
+        uint32_t echoed;
+        uint32_t echoP50Us;
+        uint32_t echoP99Us;
+    };
+
+    Phase phase;
+    bool ramp;
+    uint8_t stepCount;
+    uint8_t stepIndex;
+    unsigned long stepMs;
+    unsigned long phaseStartMs;
+    unsigned long periodUs;
+    unsigned long nextDueUs;
+    uint8_t sequence;
+
+    StepResult steps[BENCH_MAX_STEPS];
+    LatencyHistogram<BENCH_HISTOGRAM_OCTAVES> stages[BENCH_STAGE_COUNT];
+
+    StepResult& step() { return steps[stepIndex]; }
+    void beginStep(uint8_t index, uint16_t rateHz);
+    bool isClean(const StepResult& result) const;
+    uint16_t maxCleanRate() const;
+};
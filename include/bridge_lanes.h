@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Arduino.h>
+#include "stream_filter.h"
+
+class ResponseSink;
+
+// Outbound lane configuration
+#define BRIDGE_EVENT_LANE_SLOTS       8     // Edge frames waiting, FIFO
+#define BRIDGE_ROUTINE_LANE_SLOTS     6     // One per coalescing key (4 pressure pins + status + spare)
+#define BRIDGE_LANE_SLOTS             (BRIDGE_EVENT_LANE_SLOTS + BRIDGE_ROUTINE_LANE_SLOTS)
+#define BRIDGE_LANE_FRAME_SIZE        19    // Largest queued frame (0x16 System Status); longer ones go straight out
+#define BRIDGE_ROUTINE_INTERVAL_MS    10    // Minimum spacing of routine lane publishes
+#define BRIDGE_LANE_SENDS_PER_PASS    4     // Queued frames published per bridge update
+#define BRIDGE_LANE_HISTOGRAM_OCTAVES 20    // Latencies up to ~1 s
+
+// Outbound lanes, highest priority first
+enum BridgeLane : uint8_t {
+    LANE_CRITICAL,      // 0x14 System Error, 0x15 Safety Event: published as soon as framed
+    LANE_EVENT,         // 0x10/0x11 I/O, 0x12 Relay, 0x17 Sequence: FIFO behind critical
+    LANE_ROUTINE,       // 0x13 Pressure, 0x16 Status: last value per sensor, rate-shaped
+    LANE_COUNT
+};
+
+// What became of a frame handed to a lane
+enum LaneOutcome : uint8_t {
+    LANE_SENT,
+    LANE_STORED,        // MQTT down, kept in the store-and-forward log
+    LANE_DROPPED
+};
+
+/**
+ * Priority lanes for controller frames bound for controller/protobuff
+ *
+ * Critical frames never wait in a slot: the bridge forwards them the moment
+ * they are framed, and polls for them again between queued publishes, so a
+ * safety event waits at most one publish behind routine traffic. Event frames
+ * are state edges and keep every frame in arrival order. Routine frames are
+ * samples: a newer frame for the same key (type, and sensor pin for
+ * pressure) replaces the queued one, and the lane sends at most one frame per
+ * BRIDGE_ROUTINE_INTERVAL_MS, so a pressure burst collapses to the latest
+ * value per sensor instead of delaying everything behind it.
+ *
+ * Slots are one fixed pool; each lane keeps its own depth, latency
+ * (framed -> publish done) histogram and sent/coalesced/early/drop counters.
+ */
+class BridgeLanes {
+public:
+    BridgeLanes();
+
+    static BridgeLane laneOf(const uint8_t* frame, size_t length);
+
+    /**
+     * Queue a frame (coalescing on the routine lane)
+     * @return false if the lane is full or the frame does not fit a slot
+     */
+    bool enqueue(BridgeLane lane, const uint8_t* frame, size_t length, uint32_t nowUs);
+
+    /**
+     * Slot to publish now: the oldest event frame, else the oldest routine
+     * frame once the routine interval has passed; -1 if nothing is due
+     */
+    int8_t due(unsigned long nowMs) const;
+    int8_t oldest(BridgeLane lane) const;
+
+    const uint8_t* frameAt(uint8_t slot) const { return slots[slot].data; }
+    uint8_t lengthAt(uint8_t slot) const { return slots[slot].length; }
+    BridgeLane laneAt(uint8_t slot) const { return slots[slot].lane; }
+    uint32_t queuedAt(uint8_t slot) const { return slots[slot].queuedUs; }
+    uint8_t getDepth() const { return depth[LANE_EVENT] + depth[LANE_ROUTINE]; }
+
+    /**
+     * Free a slot after its frame was handed on
+     */
+    void release(uint8_t slot, LaneOutcome outcome, uint32_t nowUs, unsigned long nowMs);
+
+    /**
+     * Account a frame that did not go through a slot (critical lane, oversized)
+     */
+    void record(BridgeLane lane, LaneOutcome outcome, uint32_t latencyUs);
+    void recordEarly(BridgeLane lane) { stats[lane].early++; }
+
+    void getReport(ResponseSink& out);
+
+private:
+    struct Slot {
+        uint8_t data[BRIDGE_LANE_FRAME_SIZE];
+        uint8_t length;
+        BridgeLane lane;
+        bool used;
+        uint16_t key;               // Routine coalescing key
+        uint32_t order;             // Enqueue order, kept when coalesced
+        uint32_t queuedUs;          // micros() when the frame in the slot was framed
+    };
+
+    struct LaneStats {
+        uint32_t sent;
+        uint32_t stored;
+        uint32_t dropped;
+        uint32_t coalesced;         // Superseded by a newer frame for the same key
+        uint32_t early;             // Sent ahead of schedule because the lane was full
+        uint8_t peak;
+        LatencyHistogram<BRIDGE_LANE_HISTOGRAM_OCTAVES> latency;
+    };
+
+    Slot slots[BRIDGE_LANE_SLOTS];
+    LaneStats stats[LANE_COUNT];
+    uint8_t depth[LANE_COUNT];
+    uint32_t nextOrder;
+    unsigned long lastRoutineSend;
+
+    static uint16_t coalesceKey(const uint8_t* frame, size_t length);
+};
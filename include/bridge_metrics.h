@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+
+class ResponseSink;
+
+// Sliding-window bridge metrics configuration
+#define BRIDGE_METRICS_SECONDS        120   // One bucket per second, oldest overwritten
+#define BRIDGE_METRICS_LATENCY_BUCKETS 8    // publishBinary() time: <250us, doubling, last >=16ms
+#define BRIDGE_METRICS_LATENCY_BASE_US 250
+#define BRIDGE_METRICS_PUBLISH_INTERVAL_MS 10000    // Retained summary to TOPIC_BRIDGE_METRICS
+
+// Why a controller frame did not reach the broker
+enum BridgeDrop : uint8_t {
+    DROP_PUBLISH,       // publishBinary() failed
+    DROP_OFFLINE,       // MQTT down and the store-and-forward log full
+    DROP_PARSE,         // Invalid SIZE byte or incomplete frame discarded
+    DROP_OVERRUN,       // Receive ring full (counted in bytes)
+    DROP_COUNT
+};
+
+/**
+ * Per-second ring of bridge traffic for rates and tail latency
+ *
+ * Each second gets one bucket: frames and bytes framed from Serial1, frames
+ * published, drops by reason and a coarse log2 histogram of publishBinary()
+ * time. Buckets of seconds that passed without traffic are cleared lazily on
+ * the next record or summary, so an idle bridge costs nothing.
+ *
+ * summarize() adds up the last N complete seconds, so rates are per second
+ * over a real window rather than a counter that resets every few minutes.
+ * Percentiles are the upper bound of the bucket that holds them.
+ */
+class BridgeMetrics {
+public:
+    struct Summary {
+        uint16_t seconds;           // Complete seconds covered (less right after boot)
+        uint32_t framesIn;
+        uint32_t bytesIn;
+        uint32_t published;
+        uint32_t drops[DROP_COUNT];
+        float inRate;               // Frames per second
+        float byteRate;
+        float publishRate;
+        uint32_t p50Us;
+        uint32_t p95Us;
+        uint32_t p99Us;
+    };
+
+    BridgeMetrics();
+
+    void recordFrame(size_t bytes, unsigned long nowMs);
+    void recordPublish(uint32_t latencyUs, unsigned long nowMs);
+    void recordDrop(BridgeDrop reason, unsigned long nowMs);
+
+    /**
+     * Totals, rates and publish percentiles over the last `seconds` complete seconds
+     */
+    void summarize(uint16_t seconds, unsigned long nowMs, Summary& summary);
+
+    void getReport(ResponseSink& out, unsigned long nowMs);
+    void getSummaryJson(char* buffer, size_t bufferSize, uint16_t seconds, unsigned long nowMs);
+
+private:
+    struct Bucket {
+        uint16_t framesIn;
+        uint16_t bytesIn;
+        uint16_t published;
+        uint16_t drops[DROP_COUNT];                         // Saturating, like the counts above
+        uint16_t latency[BRIDGE_METRICS_LATENCY_BUCKETS];   // Saturating, one count per publish
+    };
+
+    Bucket buckets[BRIDGE_METRICS_SECONDS];
+    uint8_t current;                // Bucket of the second in progress
+    unsigned long currentSecond;    // millis() / 1000 of that second
+    uint16_t filled;                // Complete seconds held (caps at BRIDGE_METRICS_SECONDS - 1)
+
+    Bucket& advance(unsigned long nowMs);
+    static uint8_t latencyBucket(uint32_t us);
+    static uint32_t bucketUpperUs(uint8_t bucket);
+    static uint32_t percentile(const uint32_t* histogram, uint32_t count, uint8_t percent);
+};
@@ -3,35 +3,43 @@
 #include "constants.h"
 #include "network_manager.h"
 #include "monitor_system.h"
+#include "response_sink.h"
 
 class CommandProcessor {
 public:
     CommandProcessor();
     
     void begin(NetworkManager* network, MonitorSystem* monitor);
-    bool processCommand(char* commandBuffer, bool fromMqtt, char* response, size_t responseSize);
+    
+    /**
+     * Parse and run one command line
+     * Output is streamed to `out`; the caller calls out.finish() afterwards.
+     * Command words and sub-parameters are looked up in a sorted keyword
+     * table (binary search), not compared one by one.
+     */
+    bool processCommand(char* commandBuffer, bool fromMqtt, ResponseSink& out);
     
 private:
     NetworkManager* networkManager;
     MonitorSystem* monitorSystem;
     
     // Command handlers
-    void handleHelp(char* response, size_t responseSize, bool fromMqtt);
-    void handleShow(char* response, size_t responseSize, bool fromMqtt);
-    void handleStatus(char* response, size_t responseSize);
-    void handleSet(char* param, char* value, char* response, size_t responseSize);
-    void handleDebug(char* param, char* response, size_t responseSize);
-    void handleNetwork(char* response, size_t responseSize);
-    void handleReset(char* param, char* response, size_t responseSize);
-    void handleTest(char* param, char* response, size_t responseSize);
-    void handleSyslog(char* param, char* response, size_t responseSize);
-    void handleMonitor(char* param, char* value, char* response, size_t responseSize);
-    void handleWeight(char* param, char* value, char* response, size_t responseSize);
-    void handleTemperature(char* param, char* value, char* response, size_t responseSize);
-    void handleLCD(char* param, char* value, char* response, size_t responseSize);
-    void handleI2C(char* param, char* response, size_t responseSize);
-    void handleBridge(char* param, char* response, size_t responseSize);
-    void handleLogLevel(const char* param, char* response, size_t responseSize);
+    void handleHelp(ResponseSink& out, bool fromMqtt);
+    void handleShow(char* param, ResponseSink& out, bool fromMqtt);
+    void handleStatus(ResponseSink& out);
+    void handleSet(char* param, char* value, ResponseSink& out);
+    void handleDebug(char* param, ResponseSink& out);
+    void handleNetwork(ResponseSink& out);
+    void handleReset(char* param, ResponseSink& out);
+    void handleTest(char* param, ResponseSink& out);
+    void handleSyslog(char* param, ResponseSink& out);
+    void handleMonitor(char* param, char* value, ResponseSink& out);
+    void handleWeight(char* param, char* value, ResponseSink& out);
+    void handleTemperature(char* param, char* value, ResponseSink& out);
+    void handleLCD(char* param, char* value, ResponseSink& out);
+    void handleI2C(char* param, ResponseSink& out);
+    void handleBridge(char* param, char* value, ResponseSink& out);
+    void handleLogLevel(const char* param, ResponseSink& out);
 };
 
 class CommandValidator {
@@ -42,4 +50,5 @@ public:
     static bool validateSetCommand(const char* param, const char* value);
     static void sanitizeInput(char* input, size_t maxLength);
     static bool checkRateLimit();
+    static bool isRateLimited();       // Would checkRateLimit() refuse a command now
 };
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+class ResponseSink;
+
+// Config log configuration
+// Two banks below the store-and-forward log (1024+); the legacy fixed
+// images (MonitorConfig at 32, NAU7802 calibration at 100) sit in bank 0
+#define CONFIG_LOG_EEPROM_START     0
+#define CONFIG_LOG_BANK_SIZE        512
+#define CONFIG_LOG_HEADER_SIZE      4       // Magic (2) + generation (2)
+#define CONFIG_LOG_RECORD_HEADER    3       // Key, length, CRC-8
+#define CONFIG_LOG_MAX_VALUE        64      // Longest value (host name strings)
+#define CONFIG_LOG_WRITE_SLICE_BYTES 8      // Data flash bytes written per service() call
+#define CONFIG_LOG_ERASE_SLICE_BYTES 64     // Bytes checked per call while erasing a bank
+#define CONFIG_LOG_MAGIC            0x4C43  // "CL"
+
+// Binding flags
+#define CONFIG_LOG_STRING           0x01    // NUL-terminated: only the used length is stored
+
+/**
+ * Keys of the persisted values. These ids are stored in flash: append new
+ * keys at the end and never renumber or reuse one.
+ */
+enum ConfigKey : uint8_t {
+    CONFIG_KEY_SYSLOG_SERVER,
+    CONFIG_KEY_SYSLOG_PORT,
+    CONFIG_KEY_SYSLOG_HOSTNAME,
+    CONFIG_KEY_MQTT_BROKER,
+    CONFIG_KEY_MQTT_PORT,
+    CONFIG_KEY_MQTT_USERNAME,
+    CONFIG_KEY_MQTT_PASSWORD,
+    CONFIG_KEY_LOG_LEVEL,
+    CONFIG_KEY_LOG_TO_SERIAL,
+    CONFIG_KEY_LOG_TO_SYSLOG,
+    CONFIG_KEY_WIFI_CONNECT_TIMEOUT,
+    CONFIG_KEY_MQTT_RECONNECT_INTERVAL,
+    CONFIG_KEY_NETWORK_STABILITY_TIME,
+    CONFIG_KEY_MAX_CONNECT_RETRIES,
+    CONFIG_KEY_TEMPERATURE_OFFSET,
+    CONFIG_KEY_SENSOR_FILTERING,
+    CONFIG_KEY_SENSOR_READ_INTERVAL,
+    CONFIG_KEY_HEARTBEAT_ENABLE,
+    CONFIG_KEY_HEARTBEAT_INTERVAL,
+    CONFIG_KEY_WATCHDOG_ENABLE,
+    CONFIG_KEY_DEADBANDS,
+    CONFIG_KEY_RATE_POLICY,
+    CONFIG_KEY_WIFI_LEASE,
+    CONFIG_KEY_STATIC_IP,
+    CONFIG_KEY_STATIC_IP_ENABLED,
+    CONFIG_KEY_WEIGHT_CALIBRATION,
+    CONFIG_KEY_TOPIC_NAMESPACE,
+    CONFIG_KEY_COUNT
+};
+
+static_assert(CONFIG_KEY_COUNT <= 32, "Pending keys are a 32-bit mask");
+
+/**
+ * Log-structured key/value store for settings and calibration
+ *
+ * Owners bind() each value (a field in their own RAM) to a key once, then
+ * commit() queues the values that differ from their newest record. Nothing
+ * is written from commit(); service() appends one record at a time to the
+ * active bank, a few bytes per call, so a save never stalls the loop.
+ *
+ * Record layout (variable length, packed after the bank header):
+ *   [0]      key (0xFF = free space; written last, so a torn record stays invisible)
+ *   [1]      value length
+ *   [2]      CRC-8 over key, length and value
+ *   [3..]    value
+ *
+ * The newest record of a key wins. When a record does not fit, service()
+ * compacts in the background: it erases the other bank, copies the newest
+ * record of every key into it and commits it by writing its header with
+ * the next generation. Until then the old bank stays valid, so a reset
+ * at any point loses at most the record being written. begin() picks the
+ * bank with the newest generation and indexes it in one linear scan.
+ */
+class ConfigLog {
+public:
+    ConfigLog();
+
+    /**
+     * Find the active bank (format one if there is none) and index it
+     */
+    void begin();
+
+    /**
+     * Attach a key to the RAM value it persists
+     * @param flags CONFIG_LOG_STRING for NUL-terminated text
+     */
+    void bind(uint8_t key, void* value, uint8_t size, uint8_t flags = 0);
+
+    /**
+     * Copy the newest record of a key into its bound value
+     * @return false if there is no record, or it does not fit the binding
+     */
+    bool load(uint8_t key);
+    bool hasRecord(uint8_t key) const { return key < CONFIG_KEY_COUNT && index[key] != 0; }
+
+    /**
+     * Queue the bound value for writing if it differs from its newest record
+     * @return true if a write was queued
+     */
+    bool commit(uint8_t key);
+
+    /**
+     * Advance record writes and compaction - call frequently (scheduler task)
+     */
+    void service();
+
+    /**
+     * Finish every queued write now (blocking) - before a reset
+     */
+    void flush();
+
+    bool isIdle() const { return phase == PHASE_IDLE && pendingKeys == 0; }
+    void getStatistics(ResponseSink& out);
+
+private:
+    enum Phase : uint8_t {
+        PHASE_IDLE,
+        PHASE_WRITE,        // Appending the record in the buffer
+        PHASE_ERASE,        // Compaction: clearing the other bank
+        PHASE_COPY,         // Compaction: copying the newest record of each key
+        PHASE_COMMIT        // Compaction: writing the new bank header
+    };
+
+    struct Binding {
+        void* value;
+        uint8_t size;
+        uint8_t flags;
+    };
+
+    Binding bindings[CONFIG_KEY_COUNT];
+    uint16_t index[CONFIG_KEY_COUNT];   // Offset of the newest record in the active bank (0 = none)
+    uint32_t pendingKeys;
+    bool initialized;
+
+    uint8_t activeBank;
+    uint16_t generation;
+    uint16_t tail;                      // First free byte in the active bank
+
+    Phase phase;
+    uint8_t writeKey;
+    uint16_t progress;                  // Bytes done in the current record or erase
+    uint8_t copyKey;
+    uint16_t copyTail;                  // First free byte in the bank being filled
+    bool compacted;                     // Compacted for the queued record already
+    uint8_t record[CONFIG_LOG_RECORD_HEADER + CONFIG_LOG_MAX_VALUE];
+
+    // Statistics
+    uint32_t recordsWritten;
+    uint32_t bytesWritten;
+    uint32_t compactions;
+    uint32_t recordsDropped;            // Did not fit even after compaction
+    uint32_t corruptRecords;            // CRC failures found while scanning
+
+    static int bankAddress(uint8_t bank) { return CONFIG_LOG_EEPROM_START + bank * CONFIG_LOG_BANK_SIZE; }
+    uint8_t read(uint8_t bank, uint16_t offset) const { return EEPROM.read(bankAddress(bank) + offset); }
+    void write(uint8_t bank, uint16_t offset, uint8_t value);
+    bool readHeader(uint8_t bank, uint16_t& bankGeneration) const;
+    void writeHeader(uint8_t bank, uint16_t bankGeneration);
+    void scanBank();
+    uint8_t valueLength(const Binding& binding) const;
+    bool differs(uint8_t key) const;
+    void buildRecord(uint8_t key);
+    void serviceWrite();
+    void serviceErase();
+    void serviceCopy();
+    static uint8_t crc8(const uint8_t* data, size_t length, uint8_t crc = 0);
+};
+
+extern ConfigLog* g_configLog;
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <Arduino.h>
+// Host builds (env:native) use the committed placeholder credentials
+#ifdef NATIVE_BUILD
+#include "arduino_secrets.h.template"
+#else
 #include "arduino_secrets.h"
+#endif
 
 // System Constants
 const char* const SYSTEM_VERSION = "1.1.0";
@@ -12,13 +17,42 @@ const unsigned long WATCHDOG_TIMEOUT_MS = 15000;
 const unsigned long MAIN_LOOP_TIMEOUT_MS = 10000;
 
 // Network Constants (broker host/port from arduino_secrets.h)
-const unsigned long WIFI_CONNECT_TIMEOUT_MS = 20000;
+const unsigned long WIFI_CONNECT_TIMEOUT_MS = 20000;          // DHCP join attempt
+const unsigned long WIFI_LEASE_CONNECT_TIMEOUT_MS = 8000;     // Join on a reused lease or static profile
+const unsigned long WIFI_LEASE_MAX_AGE_MS = 1800000UL;        // Half of a 1 h DHCP lease, then a DHCP join renews it
+const uint8_t WIFI_RECONNECT_HISTOGRAM_OCTAVES = 17;          // Reconnect times in ms, up to ~131 s
 const unsigned long WIFI_CONNECT_CHECK_INTERVAL_MS = 500;
-const unsigned long MQTT_RECONNECT_INTERVAL_MS = 5000;
+const unsigned long MQTT_RECONNECT_INTERVAL_MS = 5000;   // First MQTT retry delay, doubles per failure
 const unsigned long NETWORK_STABILITY_TIME_MS = 10000;
 const uint8_t MAX_CONNECT_RETRIES = 3;
 const uint8_t MAX_WIFI_RETRIES = 3;
-const uint8_t MAX_MQTT_RETRIES = 3;
+
+// MQTT connect sequence (NetworkManager). Each step blocks for at most its
+// timeout; retries back off exponentially with +/- jitter and never give up.
+const unsigned long MQTT_TCP_CONNECT_TIMEOUT_MS = 3000;
+const unsigned long MQTT_CONNACK_TIMEOUT_MS = 2000;     // Also bounds each SUBACK wait
+const unsigned long MQTT_BACKOFF_MAX_MS = 120000;
+const uint8_t MQTT_BACKOFF_JITTER_PERCENT = 25;
+
+// Resolved-address cache (NetworkManager). The WiFiS3 resolver does not
+// report record TTLs, so a name is looked up again after a fixed TTL; the
+// old address stays in use until a new lookup succeeds.
+const unsigned long DNS_CACHE_TTL_MS = 600000;
+const unsigned long DNS_RETRY_INTERVAL_MS = 10000;     // After a failed lookup
+
+// MQTT outbound queue (NetworkManager). publish() enqueues and coalesces by
+// topic; update() drains within a time budget. ~2.7KB of RAM at these sizes.
+const uint8_t MQTT_QUEUE_DEPTH = 16;
+const size_t MQTT_QUEUE_TOPIC_SIZE = 48;
+const size_t MQTT_QUEUE_PAYLOAD_SIZE = 112;
+const unsigned long MQTT_QUEUE_DRAIN_BUDGET_MS = 20;   // Max time spent draining per update()
+const size_t MQTT_PACKED_DOC_SIZE = 256;               // Packed mode JSON document buffer
+const char* const MQTT_PACKED_TOPIC_SUFFIX = "/json";  // Packed docs go to <subsystem>/json
+const size_t MQTT_RAW_MESSAGE_SIZE = 64;                // Raw subscription payload limit (longer is cut)
+
+// Topic namespace: with it on, every topic goes out (and is subscribed) as
+// "<hostname>/<topic>". The prefix is built once in NetworkManager::begin().
+const size_t MQTT_TOPIC_PREFIX_SIZE = 24;               // "<hostname>/", longer hostnames are cut
 
 // Syslog Constants (hostname, tag, facility from arduino_secrets.h for server/port)
 const char* const SYSLOG_HOSTNAME = "LogMonitor";   // Hostname for syslog messages
@@ -26,6 +60,22 @@ const char* const SYSLOG_TAG = "logmonitor";        // Application tag for syslo
 const int SYSLOG_FACILITY = 16;                     // Local use facility (local0 = 16)
 const int SYSLOG_SEVERITY = 6;                      // Info level (0=emergency, 6=info, 7=debug)
 
+// Log ring (Logger). LOG_* store the format pointer and raw arguments; the
+// syslog task formats them later and sends them as syslog datagrams.
+const size_t LOGGER_RING_BYTES = 1024;
+const size_t LOGGER_MAX_RECORD = 192;               // Largest record, copied %s strings included
+const size_t LOGGER_LINE_SIZE = 256;                // Formatted message length limit
+const unsigned long LOGGER_DRAIN_BUDGET_US = 2000;  // Max formatting/sending time per syslog task run
+const size_t SYSLOG_DATAGRAM_SIZE = 512;
+// Lines per syslog datagram. Collectors take a UDP datagram as one message,
+// so more than 1 needs one that splits on LF (build flag -DSYSLOG_BATCH_LINES=8)
+#ifndef SYSLOG_BATCH_LINES
+#define SYSLOG_BATCH_LINES 1
+#endif
+const uint8_t SYSLOG_BATCH_MAX_LINES = SYSLOG_BATCH_LINES;
+const uint8_t LOGGER_SITE_BURST = 5;                // Messages one LOG_* call site may send back to back
+const unsigned long LOGGER_SITE_REFILL_MS = 2000;   // Then one more per interval
+
 // MQTT Topics - Monitor specific
 const char TOPIC_MONITOR_STATUS[] PROGMEM = "monitor/status";
 const char TOPIC_MONITOR_DATA[] PROGMEM = "monitor/data";
@@ -33,6 +83,10 @@ const char TOPIC_MONITOR_CONTROL[] PROGMEM = "monitor/control";
 const char TOPIC_MONITOR_CONTROL_RESP[] PROGMEM = "monitor/control/resp";
 const char TOPIC_MONITOR_HEARTBEAT[] PROGMEM = "monitor/heartbeat";
 const char TOPIC_MONITOR_ERROR[] PROGMEM = "monitor/error";
+const char TOPIC_MONITOR_PROTOBUF[] PROGMEM = "monitor/protobuff";  // MonitorSnapshot (monitor_telemetry.proto)
+const char TOPIC_MONITOR_STATS_PROTOBUF[] PROGMEM = "monitor/protobuff/stats";  // MonitorStats per closed window
+const char TOPIC_MONITOR_STATS[] PROGMEM = "monitor/stats";  // Text window summaries: monitor/stats/<window>/<channel>
+const char TOPIC_MONITOR_DIGEST[] PROGMEM = "monitor/digest";  // Retained device digest (monitor/digest/<hostname> without namespace)
 
 // Monitor-specific Topics
 const char TOPIC_SENSOR_TEMPERATURE[] PROGMEM = "monitor/temperature";
@@ -72,7 +126,8 @@ const uint8_t STATUS_LED_PIN = 13;  // Built-in LED
 const uint8_t NAU7802_SDA_PIN = SDA;     // I2C Data pin (A4 on Uno R4)
 const uint8_t NAU7802_SCL_PIN = SCL;     // I2C Clock pin (A5 on Uno R4)
 const uint8_t NAU7802_I2C_ADDRESS = 0x2A; // Default NAU7802 I2C address
-const unsigned long NAU7802_READ_INTERVAL_MS = 1000;  // Read every 1 second
+const unsigned long NAU7802_READ_INTERVAL_MS = 1000;  // Publish every 1 second (acquired continuously)
+const unsigned long NAU7802_STALL_MS = 500;           // No conversion for this long = check the connection
 
 // INA219 Power Sensor (I2C)
 const unsigned long POWER_READ_INTERVAL_MS = 2000;    // Read every 2 seconds
@@ -80,6 +135,12 @@ const unsigned long POWER_READ_INTERVAL_MS = 2000;    // Read every 2 seconds
 // MCP3421 ADC Sensor (I2C)
 const unsigned long ADC_READ_INTERVAL_MS = 1500;      // Read every 1.5 seconds
 
+// MCP9600 Temperature Sensor (I2C)
+const unsigned long TEMPERATURE_READ_INTERVAL_MS = 2000;  // Read every 2 seconds
+
+// LCD Display (I2C)
+const unsigned long LCD_UPDATE_INTERVAL_MS = 10000;   // Refresh every 10 seconds (live traffic is on the LED matrix)
+
 // Digital I/O
 const uint8_t DIGITAL_INPUT_1 = 2;       // Configurable digital input
 const uint8_t DIGITAL_INPUT_2 = 3;       // Configurable digital input
@@ -109,7 +170,9 @@ enum SystemState {
 const unsigned long STATUS_PUBLISH_INTERVAL_MS = 10000;  // 10 seconds
 const unsigned long HEARTBEAT_INTERVAL_MS = 30000;       // 30 seconds
 const unsigned long SENSOR_READ_INTERVAL_MS = 5000;      // 5 seconds
+const unsigned long SNAPSHOT_PUBLISH_INTERVAL_MS = 1000; // MonitorSnapshot on TOPIC_MONITOR_PROTOBUF
+const unsigned long DIGEST_PUBLISH_INTERVAL_MS = 30000;  // Retained digest on TOPIC_MONITOR_DIGEST
 
-// Command validation
-extern const char* const ALLOWED_COMMANDS[];
-extern const char* const ALLOWED_SET_PARAMS[];
\ No newline at end of file
+// Sensor telemetry formats (MonitorSystem::setTelemetryFormat bits)
+const uint8_t TELEMETRY_PROTOBUF = 0x01;   // One MonitorSnapshot per SNAPSHOT_PUBLISH_INTERVAL_MS
+const uint8_t TELEMETRY_TEXT = 0x02;       // Decimal text scalars on the monitor/* topics (compatibility)
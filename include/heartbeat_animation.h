@@ -3,73 +3,118 @@
 
 #include <Arduino.h>
 
+// Traffic gauge configuration
+#define MATRIX_GAUGE_BARS         3       // rx, tx, back-pressure
+#define MATRIX_GAUGE_LEVELS       9       // 0-8 lit rows per bar
+#define MATRIX_RATE_WINDOW_S      2       // Seconds of bridge traffic behind the rate bars
+#define MATRIX_UPDATE_INTERVAL_MS 100     // Gauge task period
+
 /**
  * @class HeartbeatAnimation
- * @brief Manages spinner animation on Arduino R4 WiFi LED matrix
- * 
+ * @brief Manages spinner animation and bridge traffic gauge on Arduino R4 WiFi LED matrix
+ *
  * Provides a simple spinning activity indicator in the top right corner
- * of the LED matrix, updating every second.
+ * of the LED matrix, updating every second. Three bars on the left show
+ * Serial1 frames in (cols 0-1), frames published (cols 3-4) and outbound
+ * back-pressure (cols 6-7). Rates use a log scale, one row per step of
+ * about 2x, so 1 frame/s and 100 frames/s are both readable.
+ *
+ * Every spinner glyph and every bar level is a constexpr mask in flash;
+ * a frame is the OR of four of them. The matrix is driven by the core's
+ * own timer, not I2C, and is only reloaded when the spinner steps or a
+ * quantized level changes.
  */
 class HeartbeatAnimation {
 private:
   bool isEnabled;
   uint8_t currentBrightness;
-  
+
   // Spinner animation in top right corner
   uint8_t spinnerFrame;
   unsigned long lastSpinnerTime;
-  
+
+  // Quantized gauge levels and what the matrix shows now
+  uint8_t levels[MATRIX_GAUGE_BARS];
+  uint8_t shownLevels[MATRIX_GAUGE_BARS];
+  uint8_t shownSpinner;
+  bool frameValid;
+  uint32_t framesLoaded;
+
 public:
   HeartbeatAnimation();
-  
+
   /**
    * Initialize the LED matrix and start animation
    */
   void begin();
-  
+
   /**
    * Update animation - call this frequently in main loop
    */
   void update();
-  
+
+  /**
+   * Set the gauge from bridge traffic
+   * @param rxPerSecond Frames per second framed from Serial1
+   * @param txPerSecond Frames per second published to MQTT
+   * @param backPressurePercent Outbound queue fill, 100 while frames spill to the outage log
+   */
+  void setTraffic(float rxPerSecond, float txPerSecond, uint8_t backPressurePercent);
+
   /**
    * Enable spinner animation
    */
   void enable();
-  
+
   /**
    * Disable spinner animation and clear display
    */
   void disable();
-  
+
   /**
    * Set LED matrix brightness
    * @param brightness 0-255 (0=off, 255=max brightness)
    */
   void setBrightness(uint8_t brightness);
-  
+
   /**
    * Check if animation is currently enabled
    * @return true if enabled, false if disabled
    */
   bool getEnabled() const;
-  
+
   /**
    * Get current brightness
    * @return Current brightness (0-255)
    */
   uint8_t getBrightness() const;
-  
+
+  /**
+   * Matrix reloads since boot (a reload happens only when the picture changes)
+   */
+  uint32_t getFramesLoaded() const { return framesLoaded; }
+
   /**
    * Clear the LED matrix display
    */
   void clear();
 
+  /**
+   * Bar height for a rate: 0 when idle, then one row per threshold reached
+   * (0.5, 1, 2, 5, 10, 20, 50, 100 frames/s)
+   */
+  static uint8_t rateLevel(float perSecond);
+
+  /**
+   * Bar height for a fill percentage; any back-pressure lights a row
+   */
+  static uint8_t pressureLevel(uint8_t percent);
+
 private:
   /**
-   * Display current spinner frame
+   * Combine the current spinner glyph and bar masks and load them
    */
-  void displaySpinner();
+  void render();
 };
 
-#endif // HEARTBEAT_ANIMATION_H
\ No newline at end of file
+#endif // HEARTBEAT_ANIMATION_H
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+class ResponseSink;
+
+// Register reads batched into one bus transaction
+#define I2C_BUS_MAX_REGISTERS   6       // Registers per readRegisters() call
+
+/**
+ * Multi-register reads for the sensor drivers
+ *
+ * A sample that needs several registers used to cost one START..STOP pair,
+ * and often a presence probe, per register. readRegisters() reads them in a
+ * single transaction held with repeated starts, so the bus (and the mux
+ * channel) is taken once and every field comes from the same instant.
+ * Each register gets a pointer write + read, all between one
+ * START and one STOP, for parts without auto-increment (MCP9600, INA219).
+ *
+ * Register values are big-endian on all parts; get16() unpacks them.
+ * There are no retries or delays here: a failed read is the caller's call.
+ */
+class I2CBus {
+public:
+    /**
+     * Read count registers of widths[i] bytes each into data, back to back
+     * @param regs Register addresses, in read order
+     * @param widths Bytes per register (1-3)
+     * @param data Receives sum(widths) bytes
+     */
+    static bool readRegisters(TwoWire& wire, uint8_t address, const uint8_t* regs,
+                              const uint8_t* widths, uint8_t count, uint8_t* data);
+
+    static inline uint16_t get16(const uint8_t* data) {
+        return (uint16_t)((data[0] << 8) | data[1]);
+    }
+
+    // Statistics: registers per transaction is what batching saves
+    static uint32_t getTransactions() { return transactions; }
+    static void getStatistics(ResponseSink& out);
+
+private:
+    static uint32_t transactions;       // Batched reads attempted
+    static uint32_t registersRead;      // Registers in successful reads
+    static uint32_t failures;
+};
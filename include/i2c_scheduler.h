@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+#include "tca9548a_multiplexer.h"
+
+class ResponseSink;
+
+// I2C transaction scheduler configuration
+#define I2C_SCHED_MAX_DEVICES   8
+#define I2C_SCHED_INVALID_ID    -1
+#define I2C_SCHED_MIN_RETRY_MS  5       // Floor for the not-ready poll interval
+#define I2C_SCHED_MAX_RETRIES   20      // Not-ready polls before a conversion counts as failed
+#define I2C_SCHED_MIN_PERIOD_MS 10      // Lowest accepted sample period (monitor task interval)
+
+/**
+ * Conversion-aware I2C transaction scheduler over the TCA9548A mux
+ *
+ * Every device has its own sample period and split start/collect steps:
+ * start() kicks off a conversion (one-shot ADC, triggered power monitor),
+ * collect() reads the result once the conversion time has elapsed. While one
+ * device converts, the scheduler visits other channels, so conversions on
+ * different devices overlap instead of being waited out one at a time.
+ *
+ * A visit selects one mux channel and services every due step on it in one
+ * go (collect, then restart if the next period is due). Channels set with
+ * setChannelGroup() hold devices with distinct addresses and are enabled
+ * together, so one visit serves all of them. Whatever is already enabled
+ * is preferred, and a real switch waits settleMs by yielding to the task
+ * scheduler rather than blocking.
+ *
+ * Devices without a start step (continuously converting parts) are collected
+ * every period; collect() returning RETRY re-polls after a fraction of the
+ * conversion time. PENDING is for work split into chunks (LCD refresh): the
+ * device is visited again after the minimum retry interval until it returns
+ * OK, without counting not-ready polls.
+ */
+class I2CScheduler {
+public:
+    enum Result : uint8_t {
+        RESULT_OK,          // Sample taken
+        RESULT_RETRY,       // Conversion not finished yet - poll again
+        RESULT_PENDING,     // Chunk done, more to do - come back soon
+        RESULT_FAILED       // Device error - wait for the next period
+    };
+
+    typedef bool (*StartFn)(void* context);
+    typedef Result (*CollectFn)(void* context);
+
+    struct Device {
+        const char* name;
+        uint8_t channel;
+        unsigned long periodMs;
+        unsigned long conversionMs;     // Start-to-ready time
+        StartFn start;                  // nullptr = device converts continuously
+        CollectFn collect;
+        void* context;
+        int8_t perfProbe;               // Profiler probe timing collect()
+
+        bool converting;
+        unsigned long nextStartMs;
+        unsigned long readyAtMs;
+        uint8_t retries;                // Not-ready polls for the current conversion
+
+        // Statistics
+        uint32_t samples;
+        uint32_t failures;
+        uint32_t notReady;
+        unsigned long lastSampleMs;
+        unsigned long lastIntervalMs;   // Measured time between the last two samples
+    };
+
+    I2CScheduler(TCA9548A_Multiplexer& mux, unsigned long settleMs);
+
+    /**
+     * Register a device
+     * @param name Short device name (must outlive the scheduler)
+     * @param channel Mux channel the device sits on
+     * @param periodMs Sample period
+     * @param conversionMs Time from start() until the result can be collected
+     * @param start Conversion trigger, or nullptr for continuous devices
+     * @param collect Result reader
+     * @param context Opaque pointer passed to both callbacks
+     * @return Device id, or I2C_SCHED_INVALID_ID if the table is full
+     */
+    int8_t addDevice(const char* name, uint8_t channel, unsigned long periodMs,
+                     unsigned long conversionMs, StartFn start, CollectFn collect,
+                     void* context);
+
+    int8_t findDevice(const char* name) const;
+    bool setPeriod(int8_t id, unsigned long periodMs);
+    void setConversionTime(int8_t id, unsigned long conversionMs);
+
+    /**
+     * Channels (bit n = channel n) whose devices never share an address and
+     * may be enabled at the same time
+     */
+    void setChannelGroup(uint8_t mask) { channelGroup = mask; }
+
+    /**
+     * Run at most one channel visit - call from the monitor task
+     */
+    void service();
+
+    // Status
+    uint8_t getDeviceCount() const { return deviceCount; }
+    const Device* getDevice(uint8_t index) const { return index < deviceCount ? &devices[index] : nullptr; }
+    void resetStatistics();
+    void getStatistics(ResponseSink& out);
+
+private:
+    TCA9548A_Multiplexer& mux;
+    unsigned long settleMs;
+
+    Device devices[I2C_SCHED_MAX_DEVICES];
+    uint8_t deviceCount;
+
+    uint8_t channelGroup;
+    uint8_t visitMask;              // Channels being visited (0 = pick next)
+
+    uint32_t visits;
+    uint32_t muxSwitches;
+
+    unsigned long dueAt(const Device& device) const;
+    uint8_t pickMask(unsigned long now) const;
+    void runVisit(uint8_t mask, unsigned long now);
+    void collect(Device& device, unsigned long now);
+};
@@ -52,8 +52,12 @@
 #define INA219_CONFIG_MODE_BVOLT_CONTINUOUS 0x0006
 #define INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS 0x0007
 
+// 12-bit shunt plus 12-bit bus conversion (2 x 532us), rounded up
+#define INA219_CONVERSION_MS      2
+
 // Calibration constants
 #define INA219_CURRENT_LSB_DEFAULT 0.1f  // 0.1mA per bit default
+#define INA219_SHUNT_MILLIOHMS     100   // Shunt fitted on the monitor board
 
 enum class INA219_Range {
     RANGE_16V_400MA,   // 16V, 400mA (0.1 ohm shunt)
@@ -63,13 +67,89 @@ enum class INA219_Range {
     RANGE_32V_2A       // 32V, 2A (0.1 ohm shunt)
 };
 
+// Compile-time calibration for a shunt and full-scale current (datasheet 8.5.1),
+// in integer units: shunt in milliohms, current LSB in nanoamps
+template <uint32_t ShuntMilliOhms, uint32_t MaxCurrentMilliAmps>
+struct INA219_Calibration {
+    // Current_LSB = max expected current / 2^15, rounded up
+    static constexpr uint32_t NOMINAL_LSB_NA =
+        (uint32_t)(((uint64_t)MaxCurrentMilliAmps * 1000000ULL + 32767) / 32768);
+
+    // Cal = trunc(0.04096 / (Current_LSB * R_shunt)); bit 0 of the register is unused
+    static constexpr uint64_t EXACT_VALUE = 40960000000ULL / ((uint64_t)NOMINAL_LSB_NA * ShuntMilliOhms);
+    static constexpr uint16_t VALUE = (uint16_t)(EXACT_VALUE & 0xFFFE);
+
+    // LSB actually realised by the truncated register value
+    static constexpr uint32_t CURRENT_LSB_NA =
+        (uint32_t)(40960000000ULL / ((uint64_t)VALUE * ShuntMilliOhms));
+
+    static_assert(EXACT_VALUE >= 2 && EXACT_VALUE <= 0xFFFE, "INA219 calibration register out of range");
+};
+
+// Per-range configuration bits and calibration
+template <INA219_Range Range> struct INA219_RangeTraits;
+
+template <> struct INA219_RangeTraits<INA219_Range::RANGE_32V_2A> {
+    static constexpr uint16_t CONFIG = INA219_CONFIG_BVOLTAGERANGE_32V | INA219_CONFIG_GAIN_8_320MV;
+    typedef INA219_Calibration<INA219_SHUNT_MILLIOHMS, 2000> Calibration;
+};
+
+template <> struct INA219_RangeTraits<INA219_Range::RANGE_32V_1A> {
+    static constexpr uint16_t CONFIG = INA219_CONFIG_BVOLTAGERANGE_32V | INA219_CONFIG_GAIN_4_160MV;
+    typedef INA219_Calibration<INA219_SHUNT_MILLIOHMS, 1000> Calibration;
+};
+
+template <> struct INA219_RangeTraits<INA219_Range::RANGE_16V_2A> {
+    static constexpr uint16_t CONFIG = INA219_CONFIG_BVOLTAGERANGE_16V | INA219_CONFIG_GAIN_8_320MV;
+    typedef INA219_Calibration<INA219_SHUNT_MILLIOHMS, 2000> Calibration;
+};
+
+template <> struct INA219_RangeTraits<INA219_Range::RANGE_16V_1A> {
+    static constexpr uint16_t CONFIG = INA219_CONFIG_BVOLTAGERANGE_16V | INA219_CONFIG_GAIN_4_160MV;
+    typedef INA219_Calibration<INA219_SHUNT_MILLIOHMS, 1000> Calibration;
+};
+
+template <> struct INA219_RangeTraits<INA219_Range::RANGE_16V_400MA> {
+    static constexpr uint16_t CONFIG = INA219_CONFIG_BVOLTAGERANGE_16V | INA219_CONFIG_GAIN_1_40MV;
+    typedef INA219_Calibration<INA219_SHUNT_MILLIOHMS, 400> Calibration;
+};
+
+// Integer register conversions (raw register in, fixed-point units out)
+struct INA219_Conversion {
+    // Bus voltage: bits 15:3, 4mV per bit
+    static constexpr int32_t busMillivolts(uint16_t raw) {
+        return (int32_t)(raw >> 3) * 4;
+    }
+
+    // Shunt voltage: signed, 10uV per bit
+    static constexpr int32_t shuntMicrovolts(uint16_t raw) {
+        return (int32_t)(int16_t)raw * 10;
+    }
+
+    // Current: signed, Current_LSB per bit
+    static constexpr int32_t currentMicroamps(uint16_t raw, uint32_t lsbNanoAmps) {
+        return (int32_t)((int64_t)(int16_t)raw * lsbNanoAmps / 1000);
+    }
+
+    // Power: unsigned, 20 x Current_LSB per bit
+    static constexpr int32_t powerMicrowatts(uint16_t raw, uint32_t lsbNanoAmps) {
+        return (int32_t)((uint64_t)raw * lsbNanoAmps / 50);
+    }
+};
+
+// Fixed-point reading; the float views are for publishing and display only
 struct INA219_Reading {
-    float busVoltage_V;     // Bus voltage in volts
-    float shuntVoltage_mV;  // Shunt voltage in millivolts
-    float current_mA;       // Current in milliamps
-    float power_mW;         // Power in milliwatts
+    int32_t busVoltage_mV;  // Bus voltage in millivolts
+    int32_t shuntVoltage_uV; // Shunt voltage in microvolts
+    int32_t current_uA;     // Current in microamps
+    int32_t power_uW;       // Power in microwatts
     bool valid;             // Reading validity
     unsigned long timestamp;
+
+    float busVoltageV() const { return busVoltage_mV * 0.001f; }
+    float shuntVoltageMillivolts() const { return shuntVoltage_uV * 0.001f; }
+    float currentMilliamps() const { return current_uA * 0.001f; }
+    float powerMilliwatts() const { return power_uW * 0.001f; }
 };
 
 class INA219_Sensor {
@@ -85,6 +165,7 @@ public:
     
     // Reading functions
     bool takereading();
+    bool triggerConversion();  // Start one shunt+bus conversion (triggered mode)
     INA219_Reading getLastReading() const { return lastReading; }
     
     // Individual value getters
@@ -105,9 +186,10 @@ public:
     bool setADCResolution(uint8_t busRes, uint8_t shuntRes);
     bool setOperatingMode(uint8_t mode);
     
-    // Calibration helpers
+    // Calibration helpers (runtime path for setCalibration; amps and ohms)
     static float calculateCurrentLSB(float maxCurrent_A);
     static uint16_t calculateCalibrationValue(float currentLSB, float shuntResistor_ohms);
+    uint32_t getCurrentLsbNanoAmps() const { return currentLsbNanoAmps; }
     
     // Debug and testing
     void enableDebug(bool enable) { debugEnabled = enable; }
@@ -123,8 +205,8 @@ private:
     bool initialized;
     bool debugEnabled;
     INA219_Range currentRange;
-    float shuntResistor;
-    float currentLSB;
+    bool customCalibration;         // setCalibration() overrides the range table
+    uint32_t currentLsbNanoAmps;
     uint16_t calibrationValue;
     
     // Last reading
@@ -137,14 +219,29 @@ private:
     
     // Configuration helpers
     uint16_t getRangeConfig(INA219_Range range);
-    void calculateCalibration();
     void debugPrint(const char* message);
     
-    // Conversion functions
-    float convertBusVoltage(uint16_t raw);
-    float convertShuntVoltage(uint16_t raw);
-    float convertCurrent(uint16_t raw);
-    float convertPower(uint16_t raw);
+    // Conversion, specialised per range so the LSB is a compile-time constant
+    template <INA219_Range Range>
+    void applyRange(uint16_t& config) {
+        config |= INA219_RangeTraits<Range>::CONFIG;
+        calibrationValue = INA219_RangeTraits<Range>::Calibration::VALUE;
+        currentLsbNanoAmps = INA219_RangeTraits<Range>::Calibration::CURRENT_LSB_NA;
+    }
+    
+    template <INA219_Range Range>
+    void convertReading(uint16_t busRaw, uint16_t shuntRaw, uint16_t currentRaw, uint16_t powerRaw) {
+        convertReading(busRaw, shuntRaw, currentRaw, powerRaw,
+                       INA219_RangeTraits<Range>::Calibration::CURRENT_LSB_NA);
+    }
+    
+    void convertReading(uint16_t busRaw, uint16_t shuntRaw, uint16_t currentRaw, uint16_t powerRaw,
+                        uint32_t lsbNanoAmps) {
+        lastReading.busVoltage_mV = INA219_Conversion::busMillivolts(busRaw);
+        lastReading.shuntVoltage_uV = INA219_Conversion::shuntMicrovolts(shuntRaw);
+        lastReading.current_uA = INA219_Conversion::currentMicroamps(currentRaw, lsbNanoAmps);
+        lastReading.power_uW = INA219_Conversion::powerMicrowatts(powerRaw, lsbNanoAmps);
+    }
 };
 
 // Global convenience functions for monitor system
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Arduino.h>
+
+class ResponseSink;
+
+// Digital input configuration
+#define INPUT_MAX_PINS          8
+#define INPUT_EDGE_QUEUE_SIZE   32      // Power of two; one slot stays empty
+
+/**
+ * Interrupt-driven digital inputs (WATCH_PINS, active low with pull-up)
+ *
+ * Pins wired to an ICU IRQ line get a CHANGE interrupt. The ISR only reads
+ * the level and pushes (input, level, micros) into a single-producer ring;
+ * all ISRs share one priority, so they never preempt each other. The other
+ * watch pins are read on every service() call and feed the same path.
+ *
+ * service() drains the ring and debounces: the first edge of a burst starts
+ * it, and once no edge has arrived for DEBOUNCE_DELAY_MS the pin is read
+ * again. If that level differs from the reported state, the change callback
+ * gets the time of the first edge, which is when the contact really moved.
+ */
+class DigitalInputMonitor {
+public:
+    struct Change {
+        uint8_t pin;
+        bool active;
+        unsigned long edgeMs;       // millis() at the first edge of the burst
+        uint32_t edgeUs;            // micros() at the first edge of the burst
+        uint16_t bounces;           // Further edges before the pin settled
+        bool interrupt;             // Seen by a pin-change interrupt (false = polled)
+    };
+
+    typedef void (*ChangeCallback)(void* context, const Change& change);
+
+    DigitalInputMonitor();
+
+    /**
+     * Configure the inputs and attach the pin-change interrupts
+     * @param pins Watch pins (pin number as in WATCH_PINS)
+     * @param skip Pins to leave alone (outputs)
+     */
+    void begin(const uint8_t* pins, size_t count, const uint8_t* skip, size_t skipCount);
+
+    void setChangeCallback(ChangeCallback callback, void* context);
+
+    /**
+     * Drain queued edges, poll the non-interrupt pins and report settled changes
+     * - call frequently (monitor task)
+     */
+    void service();
+
+    bool isActive(uint8_t pin) const;
+    uint32_t getQueueOverflows() const { return overflows; }
+    void getStatistics(ResponseSink& out);
+
+private:
+    struct Edge {
+        uint32_t us;
+        uint8_t input;
+        bool active;
+    };
+
+    struct Input {
+        uint8_t pin;
+        bool interrupt;             // Has an IRQ line (CHANGE interrupt attached)
+        bool state;                 // Last reported (debounced) state
+        bool level;                 // Last level seen, settled or not
+        bool settling;              // Burst in progress
+        uint16_t bounces;
+        uint32_t burstUs;           // First edge of the burst
+        uint32_t lastEdgeUs;
+        uint32_t edges;
+        uint32_t changes;
+        unsigned long lastChangeMs;
+    };
+
+    Input inputs[INPUT_MAX_PINS];
+    uint8_t inputCount;
+
+    ChangeCallback changeCallback;
+    void* changeContext;
+
+    // Ring: the ISRs write head, service() writes tail
+    Edge ring[INPUT_EDGE_QUEUE_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint32_t overflows;
+
+    static DigitalInputMonitor* instance;
+
+    static bool hasInterrupt(uint8_t pin);
+    template <uint8_t INDEX> static void isr();
+    static void (*const isrTable[INPUT_MAX_PINS])();    // One per slot: attachInterrupt() has no context
+    void onEdge(uint8_t index);
+    bool pop(Edge& edge);
+    void recordEdge(Input& input, bool active, uint32_t us);
+};
@@ -4,6 +4,11 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+// Framebuffer geometry (LCD2004A) and Wire1 transmit buffer size
+#define LCD_MAX_COLS    20
+#define LCD_MAX_ROWS    4
+#define LCD_TX_BYTES    32      // Wire I2C_BUFFER_LENGTH on the R4 core
+
 /**
  * LCD Display Manager for 20x4 I2C LCD (LCD2004A)
  * 
@@ -13,6 +18,14 @@
  * 
  * This implementation uses direct I2C communication with Wire1 bus
  * instead of the LiquidCrystal_I2C library for full control.
+ *
+ * The update and show methods only write into a 20x4 framebuffer; a cell
+ * whose character changes gets a dirty bit. refresh() sends dirty cells to
+ * the controller, one Wire1 transmission per call: every nibble and its
+ * enable pulse are packed back to back into the same transmission, and the
+ * I2C byte time covers the HD44780 execution time, so no delays are needed.
+ * The I2C scheduler calls refresh() on successive visits until the frame
+ * is clean, so a full redraw never holds the bus for more than one chunk.
  * 
  * Display Layout:
  * Line 1: System status, network status (W/M), and runtime in decimal hours
@@ -73,8 +86,10 @@ public:
      * @param voltage Bus voltage from power sensor
      * @param current Current from power sensor in mA
      * @param adcVoltage ADC voltage reading
+     * @param serialRate Frames per second received on Serial1
+     * @param mqttRate Frames per second published to MQTT
      */
-    void updateAdditionalSensors(float voltage, float current, float adcVoltage, uint32_t serialMsgCount = 0, uint32_t mqttMsgCount = 0);
+    void updateAdditionalSensors(float voltage, float current, float adcVoltage, float serialRate = 0.0f, float mqttRate = 0.0f);
     
     /**
      * Display error message (line 4)
@@ -143,6 +158,40 @@ public:
      * Update spinner animation
      */
     void updateSpinner();
+    
+    enum RefreshState : uint8_t {
+        REFRESH_DONE,       // Display matches the framebuffer
+        REFRESH_PENDING,    // Chunk sent, more dirty cells left
+        REFRESH_FAILED      // Transmission failed, cells stay dirty
+    };
+    
+    /**
+     * Send the next chunk of dirty cells (one Wire1 transmission)
+     * LCD mux channel must be selected by the caller
+     */
+    RefreshState refresh();
+    
+    /**
+     * Send all dirty cells now - for paths outside the I2C scheduler
+     * (startup, WiFi status, console commands)
+     */
+    void flush();
+    
+    /**
+     * Mark every cell dirty, e.g. when the display content is in doubt
+     */
+    void invalidate();
+    
+    /**
+     * True while a refresh pass has sent part of the frame
+     */
+    bool isRefreshing() const { return refreshActive; }
+    
+    /**
+     * Refresh statistics: passes, Wire1 time per pass, cells written
+     */
+    void resetStatistics();
+    void getStatistics(char* buffer, size_t bufferSize);
 
 private:
     uint8_t i2cAddress;             // I2C address
@@ -153,11 +202,30 @@ private:
     bool backlightEnabled;          // Backlight enabled state
     unsigned long lastUpdate;       // Last update timestamp
     
-    // Current display content for change detection
-    String line1Content;
-    String line2Content;
-    String line3Content;
-    String line4Content;
+    // Wanted display content; a set dirty bit (bit n = column n) means the
+    // cell still differs from the controller's DDRAM
+    char frame[LCD_MAX_ROWS][LCD_MAX_COLS];
+    uint32_t dirty[LCD_MAX_ROWS];
+    
+    // Wire1 transmission being packed
+    uint8_t txBuffer[LCD_TX_BYTES];
+    uint8_t txLength;
+    uint8_t expanderMode;           // RS level on the PCF8574 outputs (0xFF = unknown)
+    uint8_t cursorRow;              // Controller DDRAM address (0xFF = unknown)
+    uint8_t cursorCol;
+    
+    // Refresh statistics
+    bool refreshActive;
+    unsigned long passBusUs;        // Wire1 time of the pass in progress
+    uint16_t passCells;
+    uint32_t refreshCount;          // Passes that wrote at least one cell
+    uint32_t idleRefreshes;         // Passes with nothing to write
+    unsigned long lastRefreshUs;
+    unsigned long maxRefreshUs;
+    uint16_t lastRefreshCells;
+    uint32_t cellsWritten;
+    uint32_t transmissions;
+    uint32_t txErrors;
     
     // LCD spinner animation
     uint8_t spinnerFrame;
@@ -217,28 +285,30 @@ private:
     void i2cWrite(uint8_t data);
     
     /**
-     * Send command to LCD
+     * Send command to LCD (one transmission)
      * @param command Command byte
      */
     void sendCommand(uint8_t command);
     
     /**
-     * Send data to LCD
-     * @param data Data byte
+     * Write 4 bits to LCD with its enable pulse (one transmission)
+     * @param data 4-bit data
      */
-    void sendData(uint8_t data);
+    void write4bits(uint8_t data);
     
     /**
-     * Write 4 bits to LCD
-     * @param data 4-bit data
+     * Append one byte to the transmission as two enable-latched nibbles
+     * @param value Command or character
+     * @param mode Rs for data, 0 for a command
+     * @return false if it does not fit in the transmission
      */
-    void write4bits(uint8_t data);
+    bool queueByte(uint8_t value, uint8_t mode);
     
     /**
-     * Pulse enable pin
-     * @param data Data with enable bit
+     * Send the packed transmission
+     * @return true if the LCD acknowledged it
      */
-    void pulseEnable(uint8_t data);
+    bool sendQueued();
     
     /**
      * Format uptime string
@@ -262,30 +332,22 @@ private:
     String formatSystemState(uint8_t state);
     
     /**
-     * Update line if content changed
+     * Write a whole line into the framebuffer, padded or truncated to width
      * @param line Line number (0-3)
      * @param content New content
-     * @param currentContent Current content reference
      */
-    void updateLineIfChanged(uint8_t line, const String& content, String& currentContent);
+    void setLine(uint8_t line, const char* content);
     
     /**
-     * Get current spinner character
-     * @return Spinner character (-, /, |, \)
+     * Write one framebuffer cell, marking it dirty if it changed
      */
-    char getSpinnerChar();
+    void setCell(uint8_t row, uint8_t col, char c);
     
     /**
-     * Set cursor to beginning of line
-     * @param line Line number (0-3)
-     */
-    void setCursorToLine(uint8_t line);
-    
-    /**
-     * Print string to current cursor position
-     * @param str String to print
+     * Get current spinner character
+     * @return Spinner character (-, /, |, \)
      */
-    void printString(const String& str);
+    char getSpinnerChar();
 };
 
 #endif // LCD_DISPLAY_H
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <Arduino.h>
+#include <stdarg.h>
+#include "constants.h"
+
+class ResponseSink;
 
 // Syslog severity levels (RFC 3164)
 enum LogLevel {
@@ -14,12 +18,52 @@ enum LogLevel {
     LOG_DEBUG = 7       // Debug-level messages
 };
 
-// Logger configuration
+// Build-time floor (0-7): LOG_* call sites and debugPrintf() above this
+// level compile to nothing, arguments included. Set in platformio.ini.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 7
+#endif
+
+/**
+ * Per-call-site token bucket, one static instance per LOG_* statement
+ * Constant-initialized, so it costs no guard; linked into the site list
+ * on first use for reporting.
+ */
+struct LogSite {
+    const char* file;
+    uint16_t line;
+    uint8_t tokens;
+    bool registered;
+    unsigned long lastRefillMs;
+    uint32_t suppressed;            // Since boot
+    uint32_t unreported;            // Since the last message that got through
+    LogSite* next;
+};
+
+/**
+ * Deferred syslog logger
+ *
+ * log() never formats and never touches the network. It stores the level,
+ * timestamp, format pointer and raw argument values as one record in a
+ * byte ring (%s strings are copied, since the caller's buffer may not
+ * survive). service() runs as its own task: it formats records within a
+ * time budget and sends each as one RFC 3164 UDP datagram (several, LF
+ * separated, with SYSLOG_BATCH_LINES > 1). A record that does not fit is
+ * dropped and counted; the caller never waits.
+ *
+ * Format strings must be string literals (as all LOG_* and debugPrintf()
+ * call sites are). Conversions the capture does not handle (%n, 'L', 'j',
+ * 't') fall back to formatting at log time.
+ */
 class Logger {
 public:
     static void begin(class NetworkManager* netMgr);
     static void setLogLevel(LogLevel minLevel);
     static LogLevel getLogLevel();
+    static bool isEnabled(int level) { return level <= currentLogLevel; }
+    
+    // Take a token from a call site's bucket; false = suppress the message
+    static bool admit(LogSite& site);
     
     // Convenience logging functions
     static void logCritical(const char* fmt, ...);
@@ -30,19 +74,102 @@ public:
     
     // Generic logging function
     static void log(LogLevel level, const char* fmt, ...);
+    static void vlog(LogLevel level, const char* fmt, va_list args);
+    // Queued whatever the log level (debugPrintf() output behind `debug on`)
+    static void vlogAlways(LogLevel level, const char* fmt, va_list args);
+    
+    // Format and send queued records - call from the syslog task
+    static void service(unsigned long budgetUs = LOGGER_DRAIN_BUDGET_US);
+    
+    // Statistics
+    static uint16_t getQueuedCount() { return queuedCount; }
+    static uint32_t getDroppedCount() { return dropped; }
+    static uint32_t getSuppressedCount() { return suppressedTotal; }
+    static void resetStatistics();
+    static void getStatistics(char* buffer, size_t bufferSize);
+    static void getSiteStatistics(ResponseSink& out);
     
 private:
+    // Record layout in the ring: header, then the captured arguments in
+    // format order (or the formatted text when fmt is nullptr)
+    struct RecordHeader {
+        uint16_t length;            // Header included
+        uint8_t level;
+        uint8_t reserved;
+        uint32_t timestamp;         // millis() at log time
+        const char* fmt;
+    };
+    
     static class NetworkManager* networkManager;
     static LogLevel currentLogLevel;
-    static char logBuffer[512];
+    
+    // Rate-limited call sites seen so far
+    static LogSite* sites;
+    static uint16_t siteCount;
+    static uint32_t suppressedTotal;
+    
+    // Record ring
+    static uint8_t ring[LOGGER_RING_BYTES];
+    static size_t ringHead;         // Next write
+    static size_t ringTail;         // Oldest record
+    static size_t ringUsed;
+    static uint16_t queuedCount;
+    
+    // Drain state
+    static char lineBuffer[LOGGER_LINE_SIZE];
+    static char datagram[SYSLOG_DATAGRAM_SIZE];
+    static size_t datagramLength;
+    static uint8_t datagramLines;
+    
+    // Statistics
+    static uint32_t logged;
+    static uint32_t dropped;        // Ring full or record too large
+    static uint32_t eagerFormats;   // Fell back to formatting at log time
+    static size_t peakUsed;
+    static uint32_t linesSent;
+    static uint32_t datagramsSent;
+    static uint32_t sendFailures;
+    static unsigned long maxServiceUs;
     
     static bool shouldLog(LogLevel level);
     static const char* getLevelString(LogLevel level);
+    
+    static bool capture(uint8_t* payload, size_t payloadSize, const char* fmt, va_list args, size_t& length);
+    static size_t render(char* out, size_t outSize, const char* fmt, const uint8_t* payload, size_t payloadLength);
+    static void ringWrite(const void* data, size_t length);
+    static void ringRead(void* data, size_t length);
+    static void emit(uint8_t level, uint32_t timestamp, const char* message, bool online);
+    static void sendDatagram();
 };
 
+// Log at a level through this call site's rate limiter. The level test
+// comes first, so filtered messages never evaluate their arguments, and a
+// constant level above LOG_COMPILE_LEVEL removes the whole statement.
+#define LOG_AT(level, ...)                                                      \
+    do {                                                                        \
+        if ((level) <= LOG_COMPILE_LEVEL && Logger::isEnabled(level)) {         \
+            static LogSite logSite_ = {__FILE__, __LINE__, LOGGER_SITE_BURST,   \
+                                       false, 0, 0, 0, nullptr};                \
+            if (Logger::admit(logSite_)) Logger::log((LogLevel)(level), __VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+
 // Convenience macros for easier migration
-#define LOG_CRITICAL(...) Logger::logCritical(__VA_ARGS__)
-#define LOG_ERROR(...) Logger::logError(__VA_ARGS__)
-#define LOG_WARN(...) Logger::logWarn(__VA_ARGS__)
-#define LOG_INFO(...) Logger::logInfo(__VA_ARGS__)
-#define LOG_DEBUG(...) Logger::logDebug(__VA_ARGS__)
\ No newline at end of file
+#define LOG_CRITICAL(...) LOG_AT(LOG_CRITICAL, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_WARNING, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_DEBUG, __VA_ARGS__)
+
+// USB serial/syslog debug output behind `debug on` (defined in main.cpp),
+// rate limited per call site like LOG_AT
+extern bool g_debugEnabled;
+void (debugPrintf)(const char* fmt, ...);
+#define debugPrintf(...)                                                        \
+    do {                                                                        \
+        if (LOG_DEBUG <= LOG_COMPILE_LEVEL && g_debugEnabled) {                 \
+            static LogSite logSite_ = {__FILE__, __LINE__, LOGGER_SITE_BURST,   \
+                                       false, 0, 0, 0, nullptr};                \
+            if (Logger::admit(logSite_)) (debugPrintf)(__VA_ARGS__);            \
+        }                                                                       \
+    } while (0)
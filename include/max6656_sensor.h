@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "stream_filter.h"
+
+#define MAX6656_FILTER_MAX_SAMPLES  10
 
 // MAX6656 I2C addresses (7-bit)
 #define MAX6656_ADDRESS_DEFAULT     0x4C  // Default address
@@ -106,10 +109,8 @@ private:
     float remoteTempOffset;
     bool filteringEnabled;
     uint8_t filterSize;
-    float localTempBuffer[10];
-    float remoteTempBuffer[10];
-    uint8_t bufferIndex;
-    uint8_t validSamples;
+    MovingAverage<float, MAX6656_FILTER_MAX_SAMPLES> localFilter;
+    MovingAverage<float, MAX6656_FILTER_MAX_SAMPLES> remoteFilter;
     
     // Low-level I2C functions
     bool writeRegister(uint8_t reg, uint8_t value);
@@ -118,9 +119,6 @@ private:
     
     // Helper functions
     float convertTemperature(uint8_t tempReg, uint8_t extReg = 0);
-    float applyFiltering(float* buffer, float newValue);
-    void updateBuffer(float* buffer, float newValue);
-    float calculateAverage(float* buffer, uint8_t samples);
 };
 
 // Global external declaration for access from other modules
@@ -2,10 +2,15 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "stream_filter.h"
 
 // MCP3421 I2C address (7-bit address)
 #define MCP3421_DEFAULT_ADDRESS 0x68
 
+// Streaming filter over fresh conversions
+#define MCP3421_FILTER_MAX_SAMPLES     16
+#define MCP3421_FILTER_DEFAULT_SAMPLES 5
+
 // MCP3421 Configuration register bits
 #define MCP3421_RDY_BIT        0x80  // Ready bit (0 = conversion in progress, 1 = conversion complete)
 #define MCP3421_C1_BIT         0x40  // Configuration bit C1
@@ -38,10 +43,39 @@ enum MCP3421_ConversionMode {
     MCP3421_ONE_SHOT   = 0x10   // One-shot conversion
 };
 
+// Internal reference the output code is defined against (datasheet 4.9)
+#define MCP3421_INTERNAL_REF_MV 2048
+
+// Per-rate resolution and one-shot conversion time (1 / SPS, rounded up)
+template <MCP3421_SampleRate Rate> struct MCP3421_RateTraits;
+template <> struct MCP3421_RateTraits<MCP3421_12_BIT_240_SPS>  { static constexpr uint8_t BITS = 12; static constexpr uint16_t CONVERSION_MS = 5; };
+template <> struct MCP3421_RateTraits<MCP3421_14_BIT_60_SPS>   { static constexpr uint8_t BITS = 14; static constexpr uint16_t CONVERSION_MS = 17; };
+template <> struct MCP3421_RateTraits<MCP3421_16_BIT_15_SPS>   { static constexpr uint8_t BITS = 16; static constexpr uint16_t CONVERSION_MS = 67; };
+template <> struct MCP3421_RateTraits<MCP3421_18_BIT_3_75_SPS> { static constexpr uint8_t BITS = 18; static constexpr uint16_t CONVERSION_MS = 267; };
+
+/**
+ * Code to nanovolt conversion for one rate/gain pair
+ *
+ * LSB = 2 * Vref / 2^N / PGA = 2^(12 - N - g) mV with the 2.048V reference,
+ * so the scale is 1mV >> (N - 12 + g): one integer multiply and a constant
+ * divide by a power of two. Full-scale 18-bit codes give at most +/-2.048e9 nV,
+ * which fits an int32_t without losing a bit of resolution.
+ */
+template <MCP3421_SampleRate Rate, MCP3421_Gain Gain>
+struct MCP3421_Scale {
+    static constexpr uint8_t SHIFT = MCP3421_RateTraits<Rate>::BITS - 12 + Gain;
+    static constexpr int64_t DIVISOR = (int64_t)1 << SHIFT;
+
+    static constexpr int32_t toNanovolts(int32_t raw) {
+        // 2 * 2048mV / 2^12 = exactly 1mV = 1e6 nV at SHIFT 0
+        return (int32_t)((int64_t)raw * (2LL * MCP3421_INTERNAL_REF_MV * 1000000LL / 4096) / DIVISOR);
+    }
+};
+
 // Reading structure
 struct MCP3421_Reading {
     int32_t rawValue;      // Raw ADC value (18-bit signed)
-    float voltage;         // Converted voltage
+    int32_t nanovolts;     // Input voltage in nanovolts (fixed point)
     uint8_t config;        // Configuration byte
     bool valid;            // Reading validity
     unsigned long timestamp; // Reading timestamp
@@ -54,6 +88,7 @@ private:
     bool initialized;
     bool debugEnabled;
     MCP3421_Reading lastReading;
+    MovingAverage<int32_t, MCP3421_FILTER_MAX_SAMPLES, int64_t> voltageFilter;  // nV
     
     // Configuration settings
     MCP3421_SampleRate sampleRate;
@@ -63,12 +98,25 @@ private:
     
     // Reference voltage for conversion calculations
     float referenceVoltage;
+    float referenceScale;   // referenceVoltage / internal reference, applied to the float view
     
     // Internal methods
     bool writeConfig();
     bool readData();
     uint8_t calculateConfig();
-    float convertToVoltage(int32_t rawValue);
+    int32_t convertToNanovolts(int32_t rawValue) const;
+    float nanovoltsToVolts(int32_t nanovolts) const { return nanovolts * 1e-9f * referenceScale; }
+    
+    template <MCP3421_SampleRate Rate>
+    static int32_t convertForRate(MCP3421_Gain gain, int32_t rawValue) {
+        switch (gain) {
+            case MCP3421_GAIN_1X: return MCP3421_Scale<Rate, MCP3421_GAIN_1X>::toNanovolts(rawValue);
+            case MCP3421_GAIN_2X: return MCP3421_Scale<Rate, MCP3421_GAIN_2X>::toNanovolts(rawValue);
+            case MCP3421_GAIN_4X: return MCP3421_Scale<Rate, MCP3421_GAIN_4X>::toNanovolts(rawValue);
+            case MCP3421_GAIN_8X: return MCP3421_Scale<Rate, MCP3421_GAIN_8X>::toNanovolts(rawValue);
+        }
+        return 0;
+    }
     int getResolutionBits() const;
     float getMaxVoltage();
     
@@ -93,8 +141,10 @@ public:
     
     // Individual value getters
     int32_t getRawValue();
+    int32_t getNanovolts();
     float getVoltage();
-    float getFilteredVoltage(uint8_t samples = 5);
+    float getFilteredVoltage();                 // Moving average of recent conversions
+    bool setFilterSamples(uint8_t samples);
     
     // Status and diagnostics
     bool isReady() const { return initialized && lastReading.valid; }
@@ -109,6 +159,7 @@ public:
     MCP3421_ConversionMode getConversionMode() const { return conversionMode; }
     float getReferenceVoltage() const { return referenceVoltage; }
     int getResolution() const { return getResolutionBits(); }
+    unsigned long getConversionTimeMs() const;  // One-shot conversion time at the current rate
     
     // Debug and utilities
     void enableDebugOutput(bool enable) { debugEnabled = enable; }
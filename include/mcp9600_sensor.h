@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "stream_filter.h"
 
 // MCP9600/MCP9601 I2C addresses (7-bit)
 #define MCP9600_ADDRESS_DEFAULT     0x67  // Default address
@@ -42,6 +43,11 @@
 #define MCP9600_TYPE_B               0x06  // Type B thermocouple
 #define MCP9600_TYPE_R               0x07  // Type R thermocouple
 
+// Software filtering (moving average in mC, spike rejection on the thermocouple)
+#define MCP9600_FILTER_MAX_SAMPLES   10
+#define MCP9600_SPIKE_THRESHOLD_MC   50000  // Jump treated as a glitch (50C)
+#define MCP9600_SPIKE_CONFIRM        3      // Consecutive jumps accepted as a real change
+
 // Filter coefficients
 #define MCP9600_FILTER_OFF           0x00  // No filtering
 #define MCP9600_FILTER_MIN           0x01  // Minimum filtering
@@ -57,6 +63,15 @@
 #define MCP9600_STATUS_TH_UPDATE     0x40  // Thermocouple update flag
 #define MCP9600_STATUS_BURST_DONE    0x80  // Burst mode complete
 
+// One sample: both junctions and the status byte from one bus transaction
+struct MCP9600Reading {
+    float thermocoupleC;        // Hot junction, validated and filtered (-999 = rejected)
+    float ambientC;             // Cold junction, validated and filtered (-999 = rejected)
+    uint8_t status;             // MCP9600_STATUS_* bits
+    bool valid;                 // Registers were read
+    unsigned long timestamp;
+};
+
 /**
  * MCP9600/MCP9601 Thermocouple-to-Digital Converter
  * 
@@ -90,6 +105,14 @@ public:
      */
     bool checkConnection();
     
+    /**
+     * Read hot junction, cold junction and status in one transaction
+     * (pointer write + read per register, repeated starts, one STOP)
+     * @return true if the registers were read; see getLastReading()
+     */
+    bool takeReading();
+    const MCP9600Reading& getLastReading() const { return lastReading; }
+    
     /**
      * Get thermocouple (hot junction) temperature
      * @return temperature in degrees Celsius
@@ -185,6 +208,11 @@ public:
      */
     void enableFiltering(bool enabled, uint8_t filterLevel = 4);
     
+    /**
+     * Thermocouple samples dropped by spike rejection
+     */
+    uint32_t getRejectedSpikes() const { return thermocoupleSpike.getRejected(); }
+    
     /**
      * Enable/disable debug output for temperature readings
      * @param enabled true to enable debug output
@@ -200,19 +228,23 @@ public:
 private:
     uint8_t i2cAddress;                // I2C address
     bool initialized;                  // Initialization status
-    float ambientTempOffset;           // Ambient temperature offset for calibration
-    float thermocoupleTempOffset;      // Thermocouple temperature offset for calibration
+    int32_t ambientOffset_mC;          // Ambient temperature offset for calibration
+    int32_t thermocoupleOffset_mC;     // Thermocouple temperature offset for calibration
     bool filteringEnabled;             // Temperature filtering enabled
     uint8_t filterLevel;               // Filter level (1-7)
     bool debugOutputEnabled;           // Debug output enabled
     
-    // Temperature filter buffers
-    static const int MAX_FILTER_SIZE = 10;
-    float ambientTempBuffer[MAX_FILTER_SIZE];
-    float thermocoupleTempBuffer[MAX_FILTER_SIZE];
-    int filterSize;
-    int bufferIndex;
-    int validSamples;
+    // Temperature filters, one per channel, in mC
+    MovingAverage<int32_t, MCP9600_FILTER_MAX_SAMPLES> ambientFilter;
+    MovingAverage<int32_t, MCP9600_FILTER_MAX_SAMPLES> thermocoupleFilter;
+    SpikeFilter<int32_t> thermocoupleSpike;
+    
+    MCP9600Reading lastReading;
+    
+    // Offset, range check and filtering of one register value (shared by
+    // takeReading() and the single-value getters)
+    float processThermocouple(uint16_t raw);
+    float processAmbient(uint16_t raw);
     
     /**
      * Check if I2C device is present at address
@@ -244,11 +276,14 @@ private:
     bool writeRegister8(uint8_t reg, uint8_t value);
     
     /**
-     * Convert raw temperature data to Celsius
-     * @param raw Raw temperature data
-     * @return temperature in Celsius
+     * Convert raw temperature data to milli-degrees Celsius
+     * (16-bit signed, 0.0625C = 62.5 mC per bit) without float math
+     * @param raw Raw temperature register
+     * @return temperature in mC
      */
-    float convertRawToTemperature(uint16_t raw);
+    static constexpr int32_t toMilliCelsius(uint16_t raw) {
+        return (int32_t)(int16_t)raw * 125 / 2;
+    }
     
     /**
      * Convert Celsius to Fahrenheit
@@ -256,14 +291,6 @@ private:
      * @return temperature in Fahrenheit
      */
     float celsiusToFahrenheit(float celsius);
-    
-    /**
-     * Apply filtering to temperature reading
-     * @param newValue New temperature value
-     * @param buffer Filter buffer to use
-     * @return filtered temperature value
-     */
-    float applyFilter(float newValue, float* buffer);
 };
 
 #endif // MCP9600_SENSOR_H
\ No newline at end of file
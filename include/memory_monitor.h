@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+#include "task_scheduler.h"
+
+class NetworkManager; // Forward declaration
+class ResponseSink;
+
+// Memory instrumentation configuration
+#define MEMORY_STACK_PAINT          0xA5A5A5A5UL  // Pattern for untouched stack words
+#define MEMORY_STACK_PAINT_MARGIN   256           // Bytes below the live stack pointer left unpainted
+#define MEMORY_SUBSYSTEM_OTHER      0             // Allocations outside any scheduler task (setup, ISRs)
+#define MEMORY_SUBSYSTEM_COUNT      (SCHEDULER_MAX_TASKS + 1)
+
+// MQTT topics (monitor/memory itself carries the free byte count)
+#define TOPIC_MEMORY_HEAP_USED      "monitor/memory/heap_used"
+#define TOPIC_MEMORY_HEAP_PEAK      "monitor/memory/heap_peak"
+#define TOPIC_MEMORY_HEAP_FREE      "monitor/memory/heap_free"
+#define TOPIC_MEMORY_LARGEST_FREE   "monitor/memory/largest_free"
+#define TOPIC_MEMORY_FRAGMENTATION  "monitor/memory/fragmentation"
+#define TOPIC_MEMORY_STACK_PEAK     "monitor/memory/stack_peak"
+#define TOPIC_MEMORY_STACK_SIZE     "monitor/memory/stack_size"
+#define TOPIC_MEMORY_ALLOCATIONS    "monitor/memory/allocations"
+
+/**
+ * Heap and stack instrumentation
+ *
+ * Heap figures come from newlib's mallinfo() and the heap region symbols of
+ * the Renesas FSP linker script (__HeapBase/__HeapLimit). The stack is
+ * painted with MEMORY_STACK_PAINT at begin(); the high-water mark is found
+ * by scanning for the first overwritten word above __StackLimit.
+ *
+ * When built with MEMORY_TRACK_ALLOCATIONS and the matching -Wl,--wrap
+ * flags (see platformio.ini), every malloc/calloc/realloc/free is counted
+ * against the scheduler task that was running, which gives allocation
+ * counts per subsystem and an exact live-bytes high-water mark.
+ */
+class MemoryMonitor {
+public:
+    struct Snapshot {
+        uint32_t heapSize;          // Size of the heap region (0 if unknown)
+        uint32_t heapUsed;          // Bytes in allocated blocks
+        uint32_t heapPeak;          // Highest heapUsed seen
+        uint32_t heapFree;          // Free bytes in the arena plus never-claimed region
+        uint32_t largestFree;       // Lower bound: top chunk plus never-claimed region
+        uint8_t fragmentation;      // 100 - largestFree * 100 / heapFree
+        uint32_t stackSize;         // 0 if the stack region is unknown
+        uint32_t stackPeak;         // Deepest stack use since boot
+    };
+
+    MemoryMonitor();
+
+    /**
+     * Paint the unused stack - call once early in setup()
+     */
+    void begin();
+
+    void sample(Snapshot& snapshot);
+    uint32_t getFreeMemory();
+
+    /**
+     * Publish the monitor/memory/<name> topic family
+     */
+    void publish(NetworkManager* network);
+
+    // "show memory" text, including per-subsystem allocation counts
+    void getStatistics(ResponseSink& out);
+
+    // Allocation hooks (called from the malloc wrappers)
+    static void recordAllocation(size_t bytes);
+    static void recordRelease(size_t bytes);
+    static bool isTrackingAllocations();
+
+private:
+    uint32_t peakHeapUsed;
+    bool stackPainted;
+
+    uint32_t scanStackPeak() const;
+
+    // Plain zero-initialised statics: the wrappers can run before constructors
+    static uint32_t allocCounts[MEMORY_SUBSYSTEM_COUNT];
+    static uint32_t freeCounts[MEMORY_SUBSYSTEM_COUNT];
+    static uint32_t liveBytes;
+    static uint32_t peakLiveBytes;
+};
+
+extern MemoryMonitor* g_memoryMonitor;
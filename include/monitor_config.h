@@ -3,17 +3,125 @@
 #include <Arduino.h>
 #include <EEPROM.h>
 #include "logger.h"
+#include "network_manager.h"
+#include "config_log.h"
 
-// EEPROM address for monitor configuration (after NAU7802 calibration data)
-// NAU7802 uses addresses 0-31, so we start at 32
+// Settings are persisted field by field in the config log (config_log.h).
+// The fixed image below is only read once, to migrate an older install;
+// 32 is where released firmware wrote it. Nothing writes it any more.
 #define MONITOR_CONFIG_EEPROM_ADDR 32
-
-// Configuration magic number for validation
 #define MONITOR_CONFIG_MAGIC 0x4D4F4E43  // "MONC" in hex
 
+// Config log keys owned by MonitorConfigManager
+#define MONITOR_CONFIG_FIRST_KEY   CONFIG_KEY_SYSLOG_SERVER
+#define MONITOR_CONFIG_LAST_KEY    CONFIG_KEY_STATIC_IP_ENABLED
+
+// Report-by-exception publishing (deadband per topic group)
+#define DEADBAND_PERCENT            0x01    // threshold is % of the last published value
+#define DEADBAND_MAX_SILENCE_S      3600    // Longest accepted keepalive interval
+#define DEADBAND_DEFAULT_SILENCE_S  300     // Publish at least every 5 minutes
+
+enum DeadbandTopic : uint8_t {
+    DEADBAND_TEMPERATURE,   // monitor/temperature/* (F)
+    DEADBAND_WEIGHT,        // monitor/weight, weight/raw, fuel/gallons
+    DEADBAND_VOLTAGE,       // monitor/power/voltage (V)
+    DEADBAND_CURRENT,       // monitor/power/current (mA)
+    DEADBAND_POWER,         // monitor/power/watts (mW)
+    DEADBAND_ADC,           // monitor/adc/* (V)
+    DEADBAND_SYSTEM,        // monitor/memory (bytes), monitor/uptime rides along
+    DEADBAND_TOPIC_COUNT
+};
+
+/**
+ * Deadband for one topic group
+ * A value is published when it moved more than threshold from the last
+ * published value, or maxSilenceS passed without a publish. threshold 0
+ * with maxSilenceS 0 turns the deadband off (publish every time).
+ */
+struct DeadbandSetting {
+    float threshold;                   // Absolute units, or percent with DEADBAND_PERCENT
+    uint16_t maxSilenceS;              // Keepalive interval (0 = none)
+    uint8_t flags;
+    uint8_t unused;
+};
+
+/**
+ * Last published value of one deadband-filtered value
+ */
+struct DeadbandTrack {
+    float reference;
+    unsigned long lastPublishMs;
+    bool primed;
+
+    bool exceeded(const DeadbandSetting& setting, float value) const {
+        float limit = setting.threshold;
+        if (setting.flags & DEADBAND_PERCENT) limit = fabsf(reference) * setting.threshold / 100.0f;
+        return limit > 0.0f ? fabsf(value - reference) > limit : value != reference;
+    }
+
+    bool silent(const DeadbandSetting& setting, unsigned long now) const {
+        return setting.maxSilenceS > 0 && now - lastPublishMs >= (unsigned long)setting.maxSilenceS * 1000UL;
+    }
+
+    bool due(const DeadbandSetting& setting, float value, unsigned long now) const {
+        if (!primed) return true;
+        if (setting.threshold == 0.0f && setting.maxSilenceS == 0) return true;
+        return exceeded(setting, value) || silent(setting, now);
+    }
+
+    void mark(float value, unsigned long now) {
+        reference = value;
+        lastPublishMs = now;
+        primed = true;
+    }
+};
+
+/**
+ * Publish rate policy for decoded controller samples (pressure, status)
+ * Zero fields take the decoder defaults, so an unset policy is valid.
+ */
+struct RatePolicy {
+    uint8_t minHz;                     // Floor the adaptive rate backs off to
+    uint8_t maxHz;                     // Ceiling it climbs to on a healthy link
+    uint8_t burst;                     // Token credit per stream
+    uint8_t unused;
+};
+
+/**
+ * Fixed EEPROM image written by released firmware before the config log
+ * Frozen: byte for byte the layout stored at MONITOR_CONFIG_EEPROM_ADDR,
+ * only read by MonitorConfigManager::loadLegacy(). Do not add fields.
+ */
+struct LegacyMonitorConfig {
+    uint32_t magic;
+    char syslogServer[64];
+    uint16_t syslogPort;
+    char syslogHostname[32];
+    char mqttBroker[64];
+    uint16_t mqttPort;
+    char mqttUsername[32];
+    char mqttPassword[32];
+    uint8_t logLevel;
+    bool logToSerial;
+    bool logToSyslog;
+    uint32_t wifiConnectTimeoutMs;
+    uint32_t mqttReconnectIntervalMs;
+    uint32_t networkStabilityTimeMs;
+    uint8_t maxConnectRetries;
+    float temperatureOffset;
+    bool enableSensorFiltering;
+    uint32_t sensorReadIntervalMs;
+    bool enableHeartbeat;
+    uint32_t heartbeatIntervalMs;
+    bool enableWatchdog;
+    uint8_t reserved[64];
+    uint32_t crc32;                    // CRC32 of everything before it
+};
+
+static_assert(sizeof(LegacyMonitorConfig) == 344, "Legacy MonitorConfig image layout changed");
+
+// Settings in RAM; each field is its own config log record (bindFields)
 struct MonitorConfig {
-    uint32_t magic;                    // Magic number for validation
-    
     // Syslog Configuration
     char syslogServer[64];             // Syslog server IP/hostname
     uint16_t syslogPort;               // Syslog UDP port (514)
@@ -46,11 +154,18 @@ struct MonitorConfig {
     uint32_t heartbeatIntervalMs;      // Heartbeat transmission interval
     bool enableWatchdog;               // Enable watchdog timer
     
-    // Reserved for future expansion
-    uint8_t reserved[64];              // Reserved bytes for future features
+    // Report-by-exception deadbands (zeroed = off)
+    DeadbandSetting deadband[DEADBAND_TOPIC_COUNT];
     
-    // CRC32 checksum (must be last field)
-    uint32_t crc32;                    // Configuration integrity checksum
+    // Controller sample rate policy (zeroed = defaults)
+    RatePolicy ratePolicy;
+    
+    // Fast WiFi reconnect: last good lease and an optional static profile (zeroed = none)
+    WiFiLease wifiLease;
+    IpSettings staticIp;
+    uint8_t staticIpEnabled;
+    uint8_t topicNamespace;            // MQTT topics under "<hostname>/" (zeroed = off)
+    uint8_t wifiUnused[2];
 };
 
 class MonitorConfigManager {
@@ -61,15 +176,14 @@ private:
     
     // Validation helpers
     bool isValidConfig(const MonitorConfig& data);
-    void updateCRC(MonitorConfig& data);
     
-    // CRC32 calculation helpers
-    uint32_t calculateCRC32(const MonitorConfig& data);
-    bool validateCRC(const MonitorConfig& data);
+    // CRC32 of the legacy fixed image
+    uint32_t calculateCRC32(const LegacyMonitorConfig& data);
+    bool validateCRC(const LegacyMonitorConfig& data);
     
-    // EEPROM helpers
-    bool writeToEEPROM(const MonitorConfig& data);
-    bool readFromEEPROM(MonitorConfig& data);
+    // Config log helpers
+    void bindFields();
+    bool loadLegacy();
     
 public:
     MonitorConfigManager() = default;
@@ -77,8 +191,8 @@ public:
     // Initialization
     bool begin();
     
-    // Load/Save
-    bool load();
+    // Load/Save (save() only queues changed settings, the config task writes them)
+    uint8_t load();                    // Settings read from the config log
     bool save();
     bool saveIfChanged();
     
@@ -146,6 +260,27 @@ public:
     void setEnableHeartbeat(bool enable) { config.enableHeartbeat = enable; markAsChanged(); }
     void setHeartbeatIntervalMs(uint32_t interval) { config.heartbeatIntervalMs = interval; markAsChanged(); }
     void setEnableWatchdog(bool enable) { config.enableWatchdog = enable; markAsChanged(); }
+    
+    // Deadband Configuration
+    const DeadbandSetting& getDeadband(DeadbandTopic topic) const { return config.deadband[topic]; }
+    bool setDeadband(DeadbandTopic topic, float threshold, bool percent, uint16_t maxSilenceS);
+    
+    static const char* getDeadbandTopicName(uint8_t topic);
+    
+    // Controller Sample Rate Policy (range checks are the decoder's)
+    const RatePolicy& getRatePolicy() const { return config.ratePolicy; }
+    void setRatePolicy(uint8_t minHz, uint8_t maxHz, uint8_t burst);
+    static int8_t findDeadbandTopic(const char* name);  // -1 if unknown
+    
+    // WiFi lease (learned by NetworkManager) and static IP profile
+    const WiFiLease& getWiFiLease() const { return config.wifiLease; }
+    void setWiFiLease(const WiFiLease& lease) { config.wifiLease = lease; markAsChanged(); }
+    const IpSettings* getStaticIp() const { return config.staticIpEnabled ? &config.staticIp : nullptr; }
+    void setStaticIp(const IpSettings* settings);      // nullptr = DHCP
+    
+    // MQTT topic namespace (NetworkManager::setTopicNamespace, applied at boot)
+    bool isTopicNamespaced() const { return config.topicNamespace != 0; }
+    void setTopicNamespace(bool enabled) { config.topicNamespace = enabled ? 1 : 0; markAsChanged(); }
 
 private:
     void setDefaults();
@@ -6,6 +6,10 @@
 #include "ina219_sensor.h"
 #include "mcp3421_sensor.h"
 #include "tca9548a_multiplexer.h"
+#include "i2c_scheduler.h"
+#include "input_monitor.h"
+#include "sensor_aggregator.h"
+#include "monitor_config.h"
 
 class MonitorSystem {
 public:
@@ -43,6 +47,10 @@ public:
     bool saveWeightCalibration();
     bool loadWeightCalibration();
     
+    // NAU7802 acquisition (conversion rate and decimation)
+    bool setWeightAcquisition(uint8_t rate, uint8_t decimation);
+    NAU7802Sensor* getWeightSensor() { return &weightSensor; }
+    
     // Weight configuration access
     long getWeightZeroPoint() const;
     float getWeightScale() const;
@@ -60,11 +68,15 @@ public:
     // MCP3421 ADC functions
     float getAdcVoltage();
     int32_t getAdcRawValue();
-    float getFilteredAdcVoltage(uint8_t samples = 5);
+    float getFilteredAdcVoltage();
     bool isAdcSensorReady();
     void getAdcSensorStatus(char* buffer, size_t bufferSize);
     MCP3421_Sensor* getAdcSensor(); // Access to sensor for configuration
     
+    // I2C sample scheduling
+    I2CScheduler* getI2CScheduler(); // Access to per-sensor sample periods and statistics
+    SensorAggregator* getAggregator() { return &aggregator; }  // Window summaries of every sample
+    
     // System monitoring
     unsigned long getUptime() const;
     unsigned long getFreeMemory() const;
@@ -75,6 +87,9 @@ public:
     void getStatusString(char* buffer, size_t bufferSize);
     void publishStatus();
     void publishHeartbeat();
+    void publishDigest();
+    void publishSnapshot();
+    void publishWindow(uint8_t window, unsigned long windowMs);
     
     // Digital I/O
     bool getDigitalInput(uint8_t pin) const;
@@ -85,10 +100,31 @@ public:
     void setHeartbeatInterval(unsigned long interval);
     unsigned long getPublishInterval() const;
     unsigned long getHeartbeatInterval() const;
+    void setTelemetryFormat(uint8_t format);    // TELEMETRY_PROTOBUF and/or TELEMETRY_TEXT
+    uint8_t getTelemetryFormat() const { return telemetryFormat; }
+    uint32_t getSnapshotCount() const { return snapshotSequence; }
+    uint32_t getDeadbandSuppressed() const { return deadbandSuppressed; }
+    void resetDeadbands();  // Next sample of every value is published
     
     // I2C Health Monitoring
     void checkI2CHealth();
     bool verifyAllSensorsPresent();
+    
+    // Known I2C device map, probed at begin() instead of a full bus scan
+    enum KnownDevice : uint8_t {
+        DEVICE_TEMPERATURE,
+        DEVICE_WEIGHT,
+        DEVICE_POWER,
+        DEVICE_ADC,
+        DEVICE_LCD,
+        DEVICE_COUNT
+    };
+    bool isDevicePresent(KnownDevice device) const { return devicesPresent & (1 << device); }
+    void getDeviceMap(ResponseSink& out) const;
+    uint32_t getSampleCount() const;    // I2C samples collected since boot
+    
+    // Watch pin edges, debounce and queue statistics
+    void getInputStatistics(ResponseSink& out) { inputMonitor.getStatistics(out); }
 
 private:
     // System state
@@ -111,7 +147,9 @@ private:
     float currentWeight;
     long currentRawWeight;
     float fuelGallons;  // Calculated fuel volume in gallons
-    unsigned long lastWeightRead;
+    unsigned long lastWeightRead;       // Last MQTT publish
+    unsigned long lastWeightSampleMs;   // Last conversion, for stall detection
+    bool weightSensorConnected;
     
     // INA219 Power Monitor Sensor
     mutable INA219_Sensor powerSensor;
@@ -133,21 +171,61 @@ private:
     unsigned long heartbeatInterval;
     unsigned long lastStatusPublish;
     unsigned long lastHeartbeat;
-    
-    // Digital I/O states
+    unsigned long lastDigestPublish;
+    
+    // Sensor telemetry format and MonitorSnapshot publishing
+    uint8_t telemetryFormat;
+    unsigned long lastSnapshotPublish;
+    uint32_t snapshotSequence;
+    uint32_t statsSequence;
+    
+    // Window aggregation of every sample (channel ids follow monitor.StatsChannel)
+    enum AggregateChannel : uint8_t {
+        AGG_LOCAL_TEMPERATURE,
+        AGG_REMOTE_TEMPERATURE,
+        AGG_WEIGHT,
+        AGG_BUS_VOLTAGE,
+        AGG_CURRENT,
+        AGG_POWER,
+        AGG_ADC_VOLTAGE
+    };
+    SensorAggregator aggregator;
+    
+    // Report-by-exception: last published value per reported value
+    static const uint8_t REPORT_MEMORY = AGG_ADC_VOLTAGE + 1;    // Free RAM (not aggregated)
+    static const uint8_t REPORT_VALUE_COUNT = REPORT_MEMORY + 1;
+    DeadbandTrack textTracks[REPORT_VALUE_COUNT];
+    DeadbandTrack snapshotTracks[REPORT_VALUE_COUNT];
+    DeadbandTrack windowTracks[AGG_WINDOW_COUNT][REPORT_VALUE_COUNT];
+    uint32_t deadbandSuppressed;
+    
+    static const DeadbandSetting& deadbandFor(uint8_t value);
+    bool textDue(uint8_t value, float current, unsigned long now);
+    bool snapshotDue(unsigned long now) const;
+    
+    bool publishText() const { return telemetryFormat & TELEMETRY_TEXT; }
+    
+    // Digital I/O states (inputs follow the debounced edges of inputMonitor)
+    DigitalInputMonitor inputMonitor;
     bool digitalInputStates[8];
     bool digitalOutputStates[8];
     
-    // I2C Multiplexer
-    mutable TCA9548A_Multiplexer i2cMux;
+    // I2C Multiplexer (shared, owned by main.cpp)
+    TCA9548A_Multiplexer& i2cMux;
+    
+    // Conversion-aware sample scheduling over the mux
+    I2CScheduler i2cScheduler;
     
     // I2C Health Tracking
     unsigned long lastHealthCheck;
+    unsigned long lastBusRecovery;
     uint8_t temperatureSensorFailures;
     uint8_t weightSensorFailures;
     uint8_t powerSensorFailures;
     uint8_t adcSensorFailures;
     bool i2cBusError;
+    bool muxPresent;
+    uint8_t devicesPresent;             // Bit n = KnownDevice n answered at boot
     
     // Multiplexer channel assignments
     static const uint8_t MCP9600_CHANNEL = 0;    // Temperature sensor
@@ -155,14 +233,20 @@ private:
     static const uint8_t LCD_CHANNEL = 7;        // LCD display
     static const uint8_t INA219_CHANNEL = 2;     // Power monitor
     static const uint8_t MCP3421_CHANNEL = 3;    // ADC sensor
+    static const unsigned long MUX_SETTLE_MS = 10; // Channel settle time before first transaction
     
     // Helper functions
     void initializePins();
+    void probeDevices();
     void readAnalogSensors();
     void readDigitalInputs();
+    void onInputChange(const DigitalInputMonitor::Change& change);
     void readTemperatureSensor();
-    void readWeightSensor();
-    void readPowerSensor();
-    void readAdcSensor();
+    I2CScheduler::Result readWeightSensor();
+    I2CScheduler::Result readPowerSensor();
+    I2CScheduler::Result readAdcSensor();
+    void registerI2CDevices();
+    void registerAggregateChannels();
+    void storeStatusSamples();
     void updateLCDDisplay();
 };
\ No newline at end of file
@@ -4,6 +4,33 @@
 #include <Wire.h>
 #include "SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h"
 #include "constants.h"
+#include "stream_filter.h"
+
+#define NAU7802_FILTER_MAX_SAMPLES 16   // Moving-average capacity
+#define NAU7802_MEDIAN_SAMPLES     3    // Glitch rejection ahead of the average
+
+// Continuous acquisition: every conversion is read and block-averaged
+// (decimated) before filtering, so the filter sees low-noise samples
+#define NAU7802_DEFAULT_SAMPLE_RATE NAU7802_SPS_80
+#define NAU7802_DEFAULT_DECIMATION  8      // 80 SPS / 8 = 10 filtered samples per second
+#define NAU7802_MAX_DECIMATION      64
+
+// Calibration as persisted in the config log (CONFIG_KEY_WEIGHT_CALIBRATION);
+// the record CRC replaces the magic and checksum of NAU7802CalibrationData
+struct NAU7802Calibration {
+    float calibrationFactor;
+    int32_t zeroOffset;
+    uint8_t gain;
+    uint8_t sampleRate;
+    uint8_t unused[2];
+};
+
+// Result of reading one conversion
+enum NAU7802Sample {
+    NAU7802_SAMPLE_NONE,        // No conversion ready
+    NAU7802_SAMPLE_ACCUMULATED, // Conversion added to the current decimation block
+    NAU7802_SAMPLE_READY        // Block complete - raw, weight and filtered weight updated
+};
 
 enum NAU7802Status {
     NAU7802_OK,
@@ -36,8 +63,8 @@ public:
     float getFilteredWeight();
     bool dataAvailable();
     
-    // Update function (non-const)
-    void updateReading();
+    // Read one conversion if ready and run it through the decimator
+    NAU7802Sample updateReading();
     
     // Configuration
     void setGain(uint8_t gain);
@@ -45,6 +72,14 @@ public:
     void setSampleRate(uint8_t rate);
     uint8_t getSampleRate() const;
     
+    // Acquisition: conversion rate plus block size; recalibrates the AFE
+    bool setAcquisition(uint8_t rate, uint8_t decimation);
+    uint8_t getDecimation() const { return decimation; }
+    unsigned long getConversionIntervalMs() const { return conversionIntervalMs(currentSampleRate); }
+    uint32_t getConversionCount() const { return conversionCount; }
+    static uint16_t sampleRateSps(uint8_t rate);
+    static unsigned long conversionIntervalMs(uint8_t rate);
+    
     // Zero and tare functions
     void tareScale();
     void setZeroOffset(long offset);
@@ -52,7 +87,6 @@ public:
     
     // Statistics and filtering
     void enableFiltering(bool enable, uint8_t samples = 10);
-    float getAverageReading(uint8_t samples = 10);
     void resetStatistics();
     
     // Status and diagnostics
@@ -65,7 +99,7 @@ public:
     void powerDown();
     bool isPoweredUp();
     
-    // EEPROM calibration storage
+    // Calibration storage (config log; save only queues the write)
     bool saveCalibration();
     bool loadCalibration();
     void clearCalibration();
@@ -78,23 +112,28 @@ private:
     float calibrationFactor;
     long zeroOffset;
     bool isCalibrated;
+    NAU7802Calibration storedCalibration;   // Bound to the config log
     
     // Cached readings
     mutable long lastRawReading;
     mutable float lastWeight;
     mutable float lastFilteredWeight;
     
-    // Filtering variables
+    // Filtering: median of 3 drops single-sample glitches, then a moving average
     bool filteringEnabled;
-    uint8_t filterSamples;
-    float* filterBuffer;
-    uint8_t filterIndex;
-    bool filterBufferFull;
+    SlidingMedian<float, NAU7802_MEDIAN_SAMPLES> glitchFilter;
+    MovingAverage<float, NAU7802_FILTER_MAX_SAMPLES> weightFilter;
     
     // Configuration
     uint8_t currentGain;
     uint8_t currentSampleRate;
     
+    // Decimator state
+    uint8_t decimation;
+    uint8_t decimationCount;
+    int32_t decimationSum;      // 24-bit conversions x NAU7802_MAX_DECIMATION fits
+    uint32_t conversionCount;
+    
     // Statistics
     unsigned long totalReadings;
     float minReading;
@@ -102,13 +141,15 @@ private:
     
     // Helper functions
     void initializeDefaults();
+    bool loadLegacyCalibration();
+    void applyStoredCalibration();
     float applyCalibration(long rawValue);
-    void updateFilter(float value);
     void logError(NAU7802Status error, const char* function);
 };
 
-// Constants for calibration storage in EEPROM
-const int NAU7802_CALIBRATION_ADDR = 100;  // Start after monitor config
+// Legacy fixed calibration image, only read to migrate an older install
+// (it overlapped the MonitorConfig image at 32+, so it rarely survived)
+const int NAU7802_CALIBRATION_ADDR = 100;
 const uint32_t NAU7802_CALIBRATION_MAGIC = 0x4E415538; // 'NAU8'
 
 struct NAU7802CalibrationData {
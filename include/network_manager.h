@@ -4,6 +4,9 @@
 #include <ArduinoMqttClient.h>
 #include <WiFiUdp.h>
 #include "constants.h"
+#include "stream_filter.h"
+
+class ResponseSink;
 
 // Network connection states
 enum class WiFiState {
@@ -20,6 +23,64 @@ enum class MQTTState {
     FAILED
 };
 
+// IPv4 addressing in persisted form (MonitorConfig stores these as bytes)
+struct IpSettings {
+    uint8_t ip[4];
+    uint8_t gateway[4];
+    uint8_t subnet[4];
+    uint8_t dns[4];
+};
+
+/**
+ * Last DHCP join: the AP it joined and the lease it got. Joins within
+ * WIFI_LEASE_MAX_AGE_MS of that DHCP join reuse the lease (no DHCP round
+ * trip). WiFiS3 does not report the lease time, and the time spent powered
+ * off is unknown, so a lease loaded at boot is kept for `show wifi` only.
+ */
+struct WiFiLease {
+    IpSettings address;
+    uint8_t bssid[6];
+    uint8_t unused;                 // Was a reuse count, rewritten on every join
+    uint8_t valid;
+};
+
+/**
+ * Client wrapper that lets NetworkManager open the broker socket itself
+ *
+ * MqttClient::connect() opens the TCP connection and waits for CONNACK in
+ * one call. NetworkManager splits that: open() makes the TCP connect as its
+ * own bounded step, and connected() stays false until MqttClient::connect()
+ * calls connect(), which then adopts the open socket instead of dialling
+ * again (MqttClient stops a client that already reports connected).
+ */
+class HandoverClient : public Client {
+public:
+    explicit HandoverClient(Client& transport) : transport(transport), opened(false), handedOver(false) {}
+
+    bool open(IPAddress ip, uint16_t port);
+    bool isOpen() { return opened && transport.connected(); }
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    uint8_t connected() override { return handedOver && transport.connected(); }
+    void stop() override;
+    operator bool() override { return connected(); }
+
+    int available() override { return transport.available(); }
+    int read() override { return transport.read(); }
+    int read(uint8_t* buf, size_t size) override { return transport.read(buf, size); }
+    int peek() override { return transport.peek(); }
+    void flush() override { transport.flush(); }
+    size_t write(uint8_t c) override { return transport.write(c); }
+    size_t write(const uint8_t* buf, size_t size) override { return transport.write(buf, size); }
+    using Print::write;
+
+private:
+    Client& transport;
+    bool opened;        // open() succeeded, not yet handed over
+    bool handedOver;    // MqttClient owns the connection
+};
+
 class NetworkManager {
 public:
     NetworkManager();
@@ -27,6 +88,12 @@ public:
     void begin();
     void update();
     
+    // First WiFi join, held back by begin(): WiFiS3's WiFi.begin() blocks the
+    // scheduler for the whole join, so main.cpp starts it after the first
+    // monitor pass. update() does nothing until then.
+    void startJoin();
+    bool isJoinStarted() const { return joinStarted; }
+    
     // Connection status
     bool isWiFiConnected() const;
     bool isMQTTConnected() const;
@@ -34,19 +101,53 @@ public:
     bool isConnected() const;
     bool isStable() const;
     
-    // Publishing
+    // Publishing - publish()/publishWithRetain() enqueue (coalescing by topic)
+    // and are sent from update(); publishBinary() is sent immediately.
+    // publishImmediate() sends ahead of the queue, replacing a queued value
+    // for the same topic (safety and error topics).
     bool publish(const char* topic, const char* payload);
     bool publishWithRetain(const char* topic, const char* payload);
-    bool publishBinary(const char* topic, uint8_t* data, size_t length);  // NEW: Binary protobuf
+    bool publishImmediate(const char* topic, const char* payload);
+    bool publishBinary(const char* topic, const uint8_t* data, size_t length);  // NEW: Binary protobuf
+    
+    // Outbound queue control
+    void flushPublishQueue();               // Send everything queued now (blocking)
+    void setPackedMode(bool enabled);       // One JSON doc per subsystem instead of scalar topics
+    bool isPackedMode() const { return packedMode; }
+    uint8_t getQueueDepth() const { return queueCount; }
+    uint32_t getCoalescedCount() const { return queueCoalesced; }
+    uint32_t getQueueOverflows() const { return queueOverflows; }
+    unsigned long getDrainLatencyMs() const { return drainLatencyEwma8 / 8; }   // Recent enqueue -> send
     
-    // Syslog functionality
+    // Commands from monitor/control - the MQTT callback only stores the line,
+    // the console task runs it and streams the reply back in parts
+    bool takeControlCommand(char* buffer, size_t bufferSize);
+    bool publishControlResponse(const char* data, size_t length, uint16_t part, bool final);
+    
+    // Extra subscriptions whose messages are handed over as raw bytes, one
+    // per slot; the callback runs inside mqttClient.poll(). A nullptr topic
+    // unsubscribes the slot. The topic string must stay valid.
+    enum RawSubscription : uint8_t {
+        RAW_SUB_BENCH,              // Bridge bench echo
+        RAW_SUB_COMMAND,            // Controller commands (TOPIC_CONTROLLER_COMMAND)
+        RAW_SUB_COUNT
+    };
+    typedef void (*RawMessageFn)(void* context, const uint8_t* data, size_t length);
+    bool setRawSubscription(uint8_t slot, const char* topic, RawMessageFn callback, void* context);
+    
+    // Syslog functionality - Logger queues LOG_* output and sends it in batches;
+    // sendSyslog() sends one message right away (tests, reconfiguration)
     bool sendSyslog(const char* message, int level = 6);  // Default to INFO level
+    bool canSendSyslog() const;
+    int formatSyslogLine(char* buffer, size_t bufferSize, int level, unsigned long timestamp, const char* message) const;
+    bool sendSyslogDatagram(const char* data, size_t length);
     void setSyslogServer(const char* server, int port = 514);  // Standard syslog port
     
-    // MQTT broker configuration
+    // MQTT broker configuration - keeps the current credentials
     void setMQTTBroker(const char* broker, int port = 1883);  // Standard MQTT port
     
-    // Live reconfiguration methods
+    // Live reconfiguration methods. reconfigureMQTT() stores the broker and
+    // restarts the connect sequence; update() makes the connection.
     bool reconfigureMQTT(const char* brokerHost, int brokerPort, const char* username, const char* password);
     bool reconfigureSyslog(const char* server, int port);
     bool reconfigureWiFi(const char* ssid, const char* password);
@@ -57,17 +158,35 @@ public:
     
     // Status reporting
     void getHealthString(char* buffer, size_t bufferSize);
+    void getResolverString(char* buffer, size_t bufferSize);
     unsigned long getConnectionUptime() const;
     uint16_t getDisconnectCount() const;
     uint16_t getFailedPublishCount() const;
     
+    // Fast reconnect - the saved lease and optional static profile come from
+    // MonitorConfig; the callback hands back a changed lease to persist
+    typedef void (*WiFiLeaseFn)(void* context, const WiFiLease& lease);
+    void setWiFiLease(const WiFiLease& lease);
+    void setStaticIp(const IpSettings* settings);      // nullptr = DHCP / lease reuse
+    void setWiFiLeaseCallback(WiFiLeaseFn callback, void* context);
+    void getWiFiStatistics(ResponseSink& out);
+    
     // Hostname configuration
     void setHostname(const char* hostname);
     const char* getHostname() const;
+    
+    // Topic namespace "<hostname>/" in front of every published and
+    // subscribed topic. Set before begin(): the prefix is built once there, so
+    // a later hostname change only reaches the topics after a reboot.
+    void setTopicNamespace(bool enabled) { topicNamespace = enabled; }
+    bool isTopicNamespaced() const { return topicPrefixLength > 0; }
+    const char* getTopicPrefix() const { return topicPrefix; }
+    long getRSSI() const;
 
 private:
     // WiFi and MQTT clients
     WiFiClient wifiClient;
+    HandoverClient mqttTransport;
     MqttClient mqttClient;
     WiFiUDP udpClient;
     
@@ -77,14 +196,88 @@ private:
     
     // Connection management
     void startWiFiConnection();
-    void startMQTTConnection();
     void updateConnectionHealth();
     void onMqttMessage(int messageSize);
     
     // Retry logic
     unsigned long lastConnectAttempt;
     uint8_t wifiRetries;
-    uint8_t mqttRetries;
+    
+    // How a WiFi join gets its address
+    enum class WiFiJoin : uint8_t {
+        DHCP,
+        LEASE,          // Reused wifiLease, falls back to DHCP on timeout
+        STATIC
+    };
+    WiFiJoin wifiJoin;
+    WiFiLease wifiLease;
+    IpSettings staticIp;
+    bool staticIpEnabled;
+    bool addressPinned;             // WiFi.config() may hold a fixed address
+    bool leaseRejected;             // Lease join failed this outage, use DHCP
+    bool leaseFresh;                // wifiLease came from a DHCP join since boot
+    unsigned long leaseObtainedAt;  // millis() of that DHCP join
+    bool joinStarted;
+    unsigned long wifiAttemptStart;
+    WiFiLeaseFn leaseCallback;
+    void* leaseContext;
+    void applyAddressing();
+    void learnLease();
+    
+    // Reconnect timing, from link loss (or boot) to associated with an address
+    unsigned long wifiDownSince;
+    bool wifiTiming;
+    unsigned long lastReconnectMs;
+    uint16_t joinCounts[3];         // By WiFiJoin
+    uint16_t leaseFallbacks;
+    LatencyHistogram<WIFI_RECONNECT_HISTOGRAM_OCTAVES> reconnectMs;
+    
+    // Broker settings (arduino_secrets.h until reconfigureMQTT())
+    char brokerHost[64];
+    uint16_t brokerPort;
+    char brokerUser[32];
+    char brokerPass[32];
+    
+    // Resolved syslog server and broker addresses. Send and connect paths
+    // use the IP only; update() does the lookups, one per pass, so a log
+    // line never waits for the WiFi module's resolver.
+    struct ResolvedHost {
+        IPAddress address;
+        unsigned long expiresAt;    // Lookup due (never for a dotted quad)
+        unsigned long retryAt;      // Earliest lookup after a failure
+        bool valid;                 // address usable, possibly past expiry
+        bool literal;               // Host is an IP address
+    };
+    ResolvedHost syslogAddress;
+    ResolvedHost brokerAddress;
+    uint32_t dnsLookups;
+    uint32_t dnsFailures;
+    void invalidateHost(ResolvedHost& entry, const char* host);
+    bool lookupDue(const ResolvedHost& entry, const char* host, unsigned long now) const;
+    bool resolveHost(ResolvedHost& entry, const char* host, unsigned long now);
+    bool serviceResolver(unsigned long now);
+    int describeHost(char* buffer, size_t bufferSize, const char* name, const char* host,
+                     const ResolvedHost& entry, unsigned long now) const;
+    
+    // MQTT connect sequence, one bounded step per update() so a dead broker
+    // costs one timeout per attempt instead of stalling the loop
+    enum class MqttPhase : uint8_t {
+        IDLE,           // Waiting for WiFi or the backoff deadline
+        TCP_CONNECT,    // Open the socket (MQTT_TCP_CONNECT_TIMEOUT_MS)
+        MQTT_CONNECT,   // CONNECT / CONNACK (MQTT_CONNACK_TIMEOUT_MS)
+        SUBSCRIBE,      // One subscription per pass, SUBACK bounded the same way
+        ONLINE
+    };
+    MqttPhase mqttPhase;
+    uint8_t mqttAttempts;               // Failed attempts in a row, drives the backoff
+    uint8_t subscribeStep;
+    unsigned long mqttNextAttempt;
+    unsigned long mqttBackoffMs;        // Delay chosen for the pending retry
+    void serviceMqttConnection(unsigned long now);
+    bool subscribeNext();
+    void failMqttConnection(unsigned long now, const char* stage);
+    void scheduleMqttRetry(unsigned long now);
+    void stopMqtt();
     
     // Health tracking
     unsigned long connectionUptime;
@@ -98,8 +291,63 @@ private:
     bool lastSyslogSuccess;
     unsigned long lastSyslogAttempt;
     
-    // Hostname
+    // Hostname, and the MQTT client id built from it in begin()
     char hostname[32];
+    char mqttClientId[40];          // "<hostname>-<MAC suffix>"
+    bool begun;
+    void buildDeviceIdentity();
+    
+    // Topic namespace (setTopicNamespace); empty prefix = off
+    bool topicNamespace;
+    char topicPrefix[MQTT_TOPIC_PREFIX_SIZE];
+    uint8_t topicPrefixLength;
+    char wireTopicBuffer[MQTT_TOPIC_PREFIX_SIZE + TOPIC_BUFFER_SIZE];
+    void buildTopicPrefix();
+    const char* wireTopic(const char* topic);
+    
+    // Last command received on monitor/control, until the console task takes it
+    char controlCommand[COMMAND_BUFFER_SIZE];
+    bool controlPending;
+    
+    // Raw subscriptions (setRawSubscription)
+    struct RawSubscriber {
+        const char* topic;
+        RawMessageFn callback;
+        void* context;
+    };
+    RawSubscriber rawSubscribers[RAW_SUB_COUNT];
+    
+    // Outbound publish queue (slot array, oldest entry sent first)
+    struct QueuedPublish {
+        char topic[MQTT_QUEUE_TOPIC_SIZE];
+        char payload[MQTT_QUEUE_PAYLOAD_SIZE];
+        unsigned long enqueuedAt;
+        uint32_t order;             // Enqueue order for FIFO draining
+        bool retain;
+        bool used;
+    };
+    QueuedPublish publishQueue[MQTT_QUEUE_DEPTH];
+    uint8_t queueCount;
+    uint32_t queueOrder;
+    bool packedMode;
+    
+    // Queue statistics
+    uint8_t queuePeak;
+    uint32_t queueCoalesced;        // Publishes merged into an already queued topic
+    uint32_t queueOverflows;        // Publishes that forced an early send of the oldest entry
+    uint32_t queueSent;
+    uint32_t packedDocs;
+    unsigned long drainLatencyMaxMs;
+    unsigned long drainLatencyTotalMs;
+    uint32_t drainLatencyEwma8;     // Smoothed drain latency x 8 (1/8 weight per send)
+    
+    bool enqueuePublish(const char* topic, const char* payload, bool retain);
+    int8_t findOldestQueued() const;
+    void drainPublishQueue(unsigned long budgetMs);
+    bool sendQueued(uint8_t index);
+    bool sendPackedGroup(uint8_t index);
+    void releaseQueued(uint8_t index);
+    bool publishNow(const char* topic, const char* payload, bool retain);
     
     // Allow access to onMqttMessage from static callback
     friend void onMqttMessageStatic(int messageSize);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Arduino.h>
+
+class NetworkManager; // Forward declaration
+class ResponseSink;
+
+// Profiler configuration
+#define PERF_MAX_PROBES         12
+#define PERF_INVALID_PROBE      -1
+#define PERF_HISTOGRAM_BUCKETS  16      // Bucket 0: <1 us, bucket n: 2^(n-1)..2^n-1 us, last: open ended
+#define PERF_CPU_MHZ            48      // RA4M1 core clock (cycles per microsecond)
+#define PERF_PUBLISH_INTERVAL_MS 60000  // Summary round to TOPIC_PERF_PREFIX<probe>
+
+// MQTT topics (one JSON summary per probe)
+#define TOPIC_PERF_PREFIX       "monitor/perf/"
+
+// Cortex-M4 debug registers (DWT cycle counter)
+#define PERF_DEMCR              (*(volatile uint32_t*)0xE000EDFCUL)
+#define PERF_DEMCR_TRCENA       (1UL << 24)
+#define PERF_DWT_CTRL           (*(volatile uint32_t*)0xE0001000UL)
+#define PERF_DWT_CTRL_CYCCNTENA (1UL << 0)
+#define PERF_DWT_CTRL_NOCYCCNT  (1UL << 25)
+#define PERF_DWT_CYCCNT         (*(volatile uint32_t*)0xE0001004UL)
+
+/**
+ * Cycle-accurate section profiler
+ *
+ * Code under test is bracketed with a start stamp and record():
+ *
+ *     uint32_t start = PerfProfiler::now();
+ *     networkManager.update();
+ *     perfProfiler.record(probe, start);
+ *
+ * Stamps come from the DWT cycle counter, so a record costs a register read
+ * and a few adds. The counter wraps after about 89 s at 48 MHz, far longer
+ * than any section. Where there is no cycle counter (host builds, a core
+ * without DWT) micros() is scaled to cycles instead.
+ *
+ * Each probe keeps count, min/avg/max and a log2 histogram of microseconds,
+ * so an occasional long run stands out from the average. The task scheduler
+ * only reports per-task totals; probes can cover a single call inside a task
+ * (each sensor read, for one).
+ */
+class PerfProfiler {
+public:
+    struct Probe {
+        const char* name;
+        uint32_t count;
+        uint32_t minCycles;
+        uint32_t maxCycles;
+        uint64_t totalCycles;
+        uint32_t histogram[PERF_HISTOGRAM_BUCKETS];
+    };
+
+    PerfProfiler();
+
+    /**
+     * Enable the cycle counter - call once early in setup()
+     */
+    void begin();
+
+    /**
+     * Register a probe
+     * @param name Short probe name, used in the MQTT topic (must outlive the profiler)
+     * @return Probe id, or PERF_INVALID_PROBE if the table is full
+     */
+    int8_t addProbe(const char* name);
+
+    static inline uint32_t now() {
+#ifdef NATIVE_BUILD
+        return (uint32_t)micros() * PERF_CPU_MHZ;
+#else
+        return cycleCounter ? PERF_DWT_CYCCNT : (uint32_t)micros() * PERF_CPU_MHZ;
+#endif
+    }
+
+    /**
+     * Account the time since startCycles (from now()) to a probe
+     * @return Elapsed microseconds
+     */
+    uint32_t record(int8_t probe, uint32_t startCycles);
+
+    // Status
+    uint8_t getProbeCount() const { return probeCount; }
+    const Probe* getProbe(uint8_t index) const { return index < probeCount ? &probes[index] : nullptr; }
+    bool hasCycleCounter() const { return cycleCounter; }
+    void resetStatistics();
+    void getStatistics(ResponseSink& out);
+
+    /**
+     * Publish one JSON summary per probe to monitor/perf/<name> every
+     * PERF_PUBLISH_INTERVAL_MS, one probe per call so a round never fills
+     * the publish queue - call from a periodic task
+     */
+    void publish(NetworkManager* network);
+
+private:
+    Probe probes[PERF_MAX_PROBES];
+    uint8_t probeCount;
+
+    unsigned long lastRoundMs;
+    uint8_t publishIndex;               // Next probe of the round (probeCount = round done)
+
+    static bool cycleCounter;
+
+    static uint8_t bucketFor(uint32_t us);
+    static uint32_t percentileUs(const Probe& probe, uint8_t percent);
+};
+
+extern PerfProfiler* g_perfProfiler;
@@ -7,6 +7,41 @@
 // #include "controller_telemetry.pb.h"
 
 class NetworkManager; // Forward declaration
+class ResponseSink;
+
+// Controller message types 0x10-0x17 (see docs/TELEMETRY_API.md)
+#define PROTOBUF_FIRST_MESSAGE_TYPE 0x10
+#define PROTOBUF_MESSAGE_TYPE_COUNT 8
+
+// Sequence tracking configuration
+#define SEQ_LOSS_BUCKETS       6        // Rolling loss window = buckets x bucket width
+#define SEQ_LOSS_BUCKET_MS     10000    // 6 x 10s = 60 second rolling loss rate
+#define SEQ_RESYNC_BACKSTEP_MS 1000     // Controller timestamp stepping back this far = controller restart
+
+// Adaptive rate limiting of sampled topics (pressure, system status)
+#define DECODER_RATE_MIN_HZ          1      // Defaults for a zeroed policy
+#define DECODER_RATE_MAX_HZ          20
+#define DECODER_RATE_BURST           10     // Token credit a quiet stream builds up
+#define DECODER_RATE_LIMIT_HZ        100    // Highest accepted policy rate / burst
+#define DECODER_RATE_BUCKETS         8      // Streams tracked (4 pressure pins + status + spare)
+#define DECODER_RATE_PAYLOAD_SIZE    12     // Largest sampled payload (System Status)
+#define DECODER_RATE_ADAPT_MS        1000   // Rate adjustment period
+#define DECODER_RATE_LATENCY_HIGH_MS 250    // Queue drain latency that halves the rate
+#define DECODER_RATE_LATENCY_LOW_MS  50     // Below this the rate climbs 1 Hz per period
+
+// Controller commands over Serial1 TX, same framing as telemetry (see docs/TELEMETRY_API.md)
+#define CONTROLLER_COMMAND_TYPE      0x20   // Monitor -> Controller: [id u16][len][text]
+#define CONTROLLER_RESPONSE_TYPE     0x21   // Controller -> Monitor: [id u16][status][len][text]
+#define COMMAND_FRAME_SIZE           33     // SIZE byte + 32, the largest frame either side accepts
+#define COMMAND_TEXT_MAX             23     // 32 - header(6) - id(2) - len(1)
+#define COMMAND_MAX_IN_FLIGHT        4      // Commands awaiting a response
+#define COMMAND_TIMEOUT_MS           1000   // No response by then = failed
+#define COMMAND_REF_SIZE             12     // Requester tag echoed in the response
+#define COMMAND_RESULT_QUEUE         4      // Results waiting for service() to publish them
+
+// MQTT topics: text commands in, one JSON result per command out
+#define TOPIC_CONTROLLER_COMMAND     "monitor/controller/cmd"
+#define TOPIC_CONTROLLER_RESPONSE    "monitor/controller/resp"
 
 /**
  * @brief ProtobufDecoder class for decoding LogSplitter Controller telemetry data
@@ -22,6 +57,8 @@ class NetworkManager; // Forward declaration
  * - System health (uptime, memory, errors)
  * 
  * Features:
+ * - Table-driven dispatch: payload layout and per-pin topics are compile-time
+ *   constants, so decoding does no heap allocation or topic formatting
  * - Efficient binary protobuf decoding with nanopb
  * - Individual MQTT topic publishing for each data type
  * - Data validation and error handling
@@ -32,28 +69,79 @@ class ProtobufDecoder {
 private:
     NetworkManager* networkManager;
     
+    bool dryRun;                    // Decode and format, but publish nothing
+    bool immediate;                 // Publish past the NetworkManager queue (critical and event frames)
+    
     // Message processing statistics
     uint32_t messagesReceived;
     uint32_t messagesDecoded;
     uint32_t decodingErrors;
     uint32_t publishErrors;
-    uint32_t lastSequenceNumber;
     
-    // Decoding buffers - sized for Arduino memory constraints
+    // Per message type SEQUENCE_ID tracking (rolling uint8 counter per type)
+    struct SequenceTrack {
+        bool seen;
+        uint8_t lastSequence;
+        uint32_t lastTimestamp;     // Controller timestamp of the newest frame
+        uint32_t received;
+        uint32_t gaps;              // Gap events (one or more frames missing)
+        uint32_t lost;              // Frames missing, less late arrivals
+        uint32_t duplicates;
+        uint32_t reordered;         // Frames older than the newest seen
+        uint32_t resyncs;           // Counter restarts (controller reboot)
+    };
+    SequenceTrack sequenceTracks[PROTOBUF_MESSAGE_TYPE_COUNT];
+    
+    // Rolling loss window: expected/lost frames per time bucket
+    uint32_t lossBucketExpected[SEQ_LOSS_BUCKETS];
+    uint32_t lossBucketLost[SEQ_LOSS_BUCKETS];
+    uint8_t lossBucketIndex;
+    unsigned long lossBucketStart;
+    
+    void rotateLossBuckets();
+    
+    // Messages are decoded in place from the caller's buffer (no working copy)
     static const size_t MAX_PROTOBUF_SIZE = 512;    // Maximum expected protobuf message size
-    uint8_t decodingBuffer[MAX_PROTOBUF_SIZE];
     
-    // Rate limiting for individual topic publishing
-    unsigned long lastPressurePublish;
-    unsigned long lastRelayPublish;
-    unsigned long lastSequencePublish;
-    unsigned long lastSystemPublish;
-    static const unsigned long MIN_PUBLISH_INTERVAL_MS = 1000;  // Minimum between topic updates
+    // Token bucket per sampled stream (message type, and sensor pin for
+    // pressure). Events are never limited: a dropped edge would leave a
+    // stale state on the broker.
+    struct RateBucket {
+        uint16_t key;                   // Message type << 8 | pin
+        bool used;
+        bool pending;                   // Newest throttled sample, published when a token frees up
+        uint32_t milliTokens;
+        unsigned long lastRefill;
+        unsigned long lastUse;
+        uint8_t sequence;
+        uint8_t payloadLength;
+        uint32_t timestamp;
+        uint8_t payload[DECODER_RATE_PAYLOAD_SIZE];
+    };
+    RateBucket rateBuckets[DECODER_RATE_BUCKETS];
+    
+    // Rate policy; rateHz moves between min and max with publish health (AIMD)
+    uint8_t rateMinHz;
+    uint8_t rateMaxHz;
+    uint8_t rateBurst;
+    uint8_t rateHz;
+    unsigned long lastRateAdapt;
+    uint16_t lastFailedPublishes;
+    uint32_t lastQueueOverflows;
+    uint32_t samplesAdmitted;
+    uint32_t samplesThrottled;      // Superseded before a token was available
+    uint32_t samplesFlushed;        // Held back, then published late
+    uint32_t rateDecreases;
+    
+    RateBucket& findBucket(uint16_t key, unsigned long now);
+    bool takeToken(RateBucket& bucket, unsigned long now);
+    void publishHeld(RateBucket& bucket);
+    void adaptRate(unsigned long now);
     
     // Data validation helpers
     bool validatePressureData(float a1_psi, float a5_psi);
     bool validateRelayData(bool r1_state, bool r2_state);
-    bool validateSequenceData(const String& state);
+    bool validateSequenceData(const char* state);
     bool validateTimestamp(uint64_t timestamp);
     
     // Individual data type publishers
@@ -77,25 +165,29 @@ public:
     // Initialization
     void begin(NetworkManager* network);
     
+    // Bridge bench frames go through the whole decode without reaching MQTT
+    void setDryRun(bool enabled) { dryRun = enabled; }
+    void setImmediate(bool enabled) { immediate = enabled; }
+    
     // Core decoding method - called by SerialBridge
-    bool decodeProtobufMessage(uint8_t* data, size_t length);
+    bool decodeProtobufMessage(const uint8_t* data, size_t length);
     
     // Decode and publish to individual MQTT topics
-    bool decodeAndPublish(uint8_t* data, size_t length);
+    bool decodeAndPublish(const uint8_t* data, size_t length);
     
     // Individual message type decoders
-    bool decodeTelemetryMessage(uint8_t* data, size_t length);
-    bool decodeCommandResponse(uint8_t* data, size_t length);
+    bool decodeTelemetryMessage(const uint8_t* data, size_t length);
+    bool decodeCommandResponse(const uint8_t* data, size_t length);
     
     // Binary message decoders (0x10-0x17)
-    bool decodeDigitalInput(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodeDigitalOutput(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodeRelayEvent(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodePressure(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodeSystemError(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodeSafetyEvent(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodeSystemStatus(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
-    bool decodeSequenceEvent(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeDigitalInput(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeDigitalOutput(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeRelayEvent(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodePressure(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeSystemError(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeSafetyEvent(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeSystemStatus(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
+    bool decodeSequenceEvent(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp);
     
     // Statistics and diagnostics
     void getStatistics(char* buffer, size_t bufferSize);
@@ -104,28 +196,50 @@ public:
     uint32_t getDecodingErrors() const { return decodingErrors; }
     uint32_t getPublishErrors() const { return publishErrors; }
     
-    // Rate limiting checks
-    bool canPublishPressure() const;
-    bool canPublishRelay() const;
-    bool canPublishSequence() const;
-    bool canPublishSystem() const;
+    // Sequence gap detection - called for every framed message, connected or not
+    void trackSequence(const uint8_t* data, size_t length);
+    void resetSequenceStatistics();
+    uint32_t getSequenceReceived() const;
+    uint32_t getSequenceLost() const;
+    float getLossRate() const;              // Lifetime loss, percent of expected frames
+    float getRollingLossRate();             // Loss over the last SEQ_LOSS_BUCKETS buckets, percent
+    void getSequenceStatistics(ResponseSink& out);
+    void getSequenceSummaryJson(char* buffer, size_t bufferSize, uint32_t forwardDrops);
+    
+    // Sampled topic rate limiting; service() publishes held-back samples
+    // and adapts the rate, call it every bridge pass
+    bool setRatePolicy(uint8_t minHz, uint8_t maxHz, uint8_t burst);
+    void service();
+    uint8_t getRateHz() const { return rateHz; }
+    void getRateStatistics(ResponseSink& out);
     
     // === API INTEGRATION METHODS ===
     // These work with the Controller's existing protobuf API
     
     /**
-     * @brief Send command to Controller via protobuf
-     * @param commandType Command type string
-     * @param parameters Command parameters
-     * @return true if command was encoded and sent successfully
+     * @brief Send a text command to the Controller as a 0x20 frame
+     *
+     * The frame goes straight to the Serial1 TX buffer; it is never queued
+     * behind telemetry. Up to COMMAND_MAX_IN_FLIGHT commands can await their
+     * response at once, matched back by command id. The result (response or
+     * timeout) is published to TOPIC_CONTROLLER_RESPONSE with the ref tag.
+     *
+     * @param command Controller command text, e.g. "relay R1 ON" (COMMAND_TEXT_MAX chars)
+     * @param ref Requester tag echoed in the result, or nullptr
+     * @return Command id, 0 if the command was not sent
      */
-    bool sendControllerCommand(const String& commandType, const String& parameters);
+    uint16_t sendControllerCommand(const char* command, const char* ref);
     
     /**
-     * @brief Process incoming command responses from Controller
-     * @param data Binary protobuf response data
-     * @param length Data length in bytes
-     * @return true if response was successfully processed
+     * @brief MQTT command topic handler: "[#ref ]command", result published either way
+     */
+    void onMqttCommand(const uint8_t* data, size_t length);
+    
+    /**
+     * @brief Process a 0x21 response frame from the Controller
+     * @param data Complete frame, size byte first
+     * @param length Frame length in bytes
+     * @return true if the response matched a command in flight
      */
     bool processCommandResponse(const uint8_t* data, size_t length);
     
@@ -140,6 +254,9 @@ public:
      * @param enabled True to enable bidirectional communication
      */
     void setCommandsEnabled(bool enabled);
+    bool areCommandsEnabled() const { return commandsEnabled; }
+    uint8_t getCommandsInFlight() const;
+    void getCommandStatistics(ResponseSink& out);
     
     /**
      * @brief Get last Controller telemetry timestamp
@@ -162,9 +279,49 @@ private:
     unsigned long lastTelemetryTime;
     uint32_t missedTelemetryCount;
     
+    // Commands awaiting a response, by id (id 0 = free slot)
+    struct PendingCommand {
+        uint16_t id;
+        uint32_t sentUs;
+        char ref[COMMAND_REF_SIZE];
+    };
+    PendingCommand pendingCommands[COMMAND_MAX_IN_FLIGHT];
+    uint8_t commandSequence;
+    uint8_t commandFrame[COMMAND_FRAME_SIZE];   // Encoded in place, no heap
+    
+    // Command statistics (round trip in microseconds)
+    uint32_t commandsSent;
+    uint32_t commandsAcked;         // Response with status OK
+    uint32_t commandsFailed;        // Response with an error status
+    uint32_t commandsTimedOut;
+    uint32_t commandsRejected;      // Not sent: disabled, pipeline full, TX busy, too long
+    uint32_t responsesUnmatched;    // Unknown id (late after a timeout, or a stray frame)
+    uint32_t rttMinUs;
+    uint32_t rttMaxUs;
+    uint64_t rttTotalUs;
+    
     // Command encoding helpers (for sending to Controller)
-    bool encodeCommand(const String& commandType, const String& parameters, uint8_t* buffer, size_t* length);
+    size_t encodeCommand(uint16_t id, const char* command, uint8_t* buffer, size_t bufferSize);
     bool sendBinaryCommand(const uint8_t* data, size_t length);
+    void expireCommands();
+    
+    // Results are published from service(), never from inside the MQTT
+    // callback, and sent ahead of the queue so they are not coalesced by topic
+    struct CommandResult {
+        uint16_t id;                // 0 = rejected before it was sent
+        bool ok;
+        const char* key;            // "msg" or "err"
+        uint32_t rttUs;
+        char ref[COMMAND_REF_SIZE];
+        char message[COMMAND_TEXT_MAX + 1];
+    };
+    CommandResult commandResults[COMMAND_RESULT_QUEUE];
+    uint8_t resultHead;
+    uint8_t resultCount;
+    uint32_t resultsDropped;
+    void queueCommandResult(uint16_t id, const char* ref, bool ok, uint32_t rttUs,
+                            const char* key, const char* message);
+    void publishCommandResults();
     
     // Telemetry parsing helpers
     bool extractPressureReadings(const void* telemetry_pb, float* a1_psi, float* a5_psi);
@@ -173,10 +330,10 @@ private:
     bool extractSystemHealth(const void* telemetry_pb, String* systemMode, bool* safetyActive);
     
     // Placeholder decoding (until nanopb headers available)
-    bool decodeProtobufPlaceholder(uint8_t* data, size_t length);
+    bool decodeProtobufPlaceholder(const uint8_t* data, size_t length);
     
     // Error handling and logging
-    void logDecodingError(const String& context, const String& details = "");
-    void logApiActivity(const String& activity, const String& details = "");
+    void logDecodingError(const char* context, const char* format, ...);
+    void logApiActivity(const char* activity, const char* format, ...);
     void updateTelemetryStats(bool success, size_t messageSize);
 };
\ No newline at end of file
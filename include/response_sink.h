@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <string.h>
+#include "constants.h"
+
+// Command response chunking
+#define RESPONSE_CHUNK_SIZE         SHARED_BUFFER_SIZE  // Bytes held before a chunk is sent
+
+/**
+ * Chunked command response writer
+ *
+ * Command handlers print into one fixed chunk. When the next piece does not
+ * fit, the chunk is handed to the emit callback (telnet client, Serial, MQTT
+ * publish) and reused, so a response is not limited by a buffer size and the
+ * command path never needs more than one chunk of RAM.
+ *
+ * The callback gets each chunk NUL-terminated, with its part number (from 1)
+ * and whether it is the last one. Chunks are only sent early when more
+ * output follows, so finish() always sends the final part; a transport that
+ * frames parts (MQTT) can tell a one-part reply from the end of a long one.
+ */
+class ResponseSink {
+public:
+    typedef void (*EmitFn)(void* context, const char* data, size_t length, uint16_t part, bool final);
+
+    ResponseSink(EmitFn emit, void* context);
+
+    void print(const char* text);
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));  // At most one chunk per call
+
+    /**
+     * Let a buffer-filling function (getStatistics() style) write straight
+     * into the chunk; pending output is sent first so it gets the whole chunk
+     * @param fn Called as fn(char* buffer, size_t bufferSize)
+     */
+    template <typename Fn>
+    void fill(Fn fn) {
+        if (length > 0) emitChunk(false);
+        chunk[0] = '\0';
+        fn(chunk, sizeof(chunk));
+        chunk[RESPONSE_CHUNK_SIZE] = '\0';
+        length = strlen(chunk);
+        if (length > 0) closed = false;
+    }
+
+    /**
+     * Send whatever is pending as the final part
+     */
+    void finish();
+
+    bool isEmpty() const { return parts == 0 && length == 0; }
+    uint16_t getParts() const { return parts; }
+    size_t getTotalBytes() const { return sent + length; }
+
+private:
+    EmitFn emit;
+    void* context;
+
+    char chunk[RESPONSE_CHUNK_SIZE + 1];
+    size_t length;
+    size_t sent;
+    uint16_t parts;
+    bool closed;                // Last emitted part was final
+
+    void emitChunk(bool final);
+};
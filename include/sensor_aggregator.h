@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+#include "stream_filter.h"
+
+class ResponseSink;
+
+// Windowed sensor aggregation configuration
+#define AGG_MAX_CHANNELS        8
+#define AGG_WINDOW_COUNT        3
+#define AGG_INVALID_ID          -1
+#define AGG_MIN_WINDOW_MS       100
+#define AGG_MAX_WINDOW_MS       3600000UL
+#define AGG_DEFAULT_WINDOW_1_MS 1000
+#define AGG_DEFAULT_WINDOW_2_MS 10000
+#define AGG_DEFAULT_WINDOW_3_MS 60000
+
+/**
+ * Per-channel windowed aggregation of sensor samples
+ *
+ * Every raw sample of a channel goes into one RunningStats per window, so a
+ * window summary (count, min, max, mean, standard deviation, last value)
+ * covers everything sampled in it - a current spike between two publishes
+ * still shows up as the window maximum. Publishing is driven by window
+ * close, not by sample rate: the I2C sample periods can be raised without
+ * adding MQTT traffic.
+ *
+ * service() closes every window whose period has elapsed and hands it to the
+ * window callback, which reads getStats() for each channel; the window's
+ * statistics are reset right after. Windows keep their phase but never try
+ * to catch up after a stall.
+ */
+class SensorAggregator {
+public:
+    typedef void (*WindowFn)(void* context, uint8_t window, unsigned long windowMs);
+
+    SensorAggregator();
+
+    void setWindowCallback(WindowFn callback, void* context);
+
+    /**
+     * Register a channel
+     * @param name Short channel name (must outlive the aggregator)
+     * @return Channel id, or AGG_INVALID_ID if the table is full
+     */
+    int8_t addChannel(const char* name);
+
+    void addSample(int8_t channel, float value);
+
+    /**
+     * Close elapsed windows (call from the monitor task)
+     */
+    void service(unsigned long now);
+
+    bool setWindow(uint8_t window, unsigned long windowMs);
+    unsigned long getWindowMs(uint8_t window) const { return window < AGG_WINDOW_COUNT ? windowMs[window] : 0; }
+
+    uint8_t getChannelCount() const { return channelCount; }
+    const char* getChannelName(uint8_t channel) const { return channel < channelCount ? channels[channel].name : ""; }
+    const RunningStats& getStats(uint8_t channel, uint8_t window) const { return channels[channel].windows[window]; }
+
+    void getStatistics(ResponseSink& out);
+
+private:
+    struct Channel {
+        const char* name;
+        RunningStats windows[AGG_WINDOW_COUNT];
+    };
+
+    Channel channels[AGG_MAX_CHANNELS];
+    uint8_t channelCount;
+
+    unsigned long windowMs[AGG_WINDOW_COUNT];
+    unsigned long windowStart[AGG_WINDOW_COUNT];
+    uint32_t windowsClosed[AGG_WINDOW_COUNT];
+
+    WindowFn onWindow;
+    void* context;
+};
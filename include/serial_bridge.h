@@ -5,12 +5,22 @@
 #include "network_manager.h"
 #include "logger.h"
 #include "protobuf_decoder.h"
+#include "bridge_bench.h"
+#include "bridge_lanes.h"
+#include "bridge_metrics.h"
 
 // Serial bridge configuration
 #define SERIAL_BRIDGE_BAUD 115200
-#define BRIDGE_BUFFER_SIZE 512
 #define MAX_MESSAGE_LENGTH 256
 #define BRIDGE_TIMEOUT_MS 1000
+#define BRIDGE_LOSS_PUBLISH_INTERVAL_MS 30000   // Sequence loss stats to TOPIC_BRIDGE_LOSS
+#define BRIDGE_METRICS_WINDOW_S 60              // Window of the retained TOPIC_BRIDGE_METRICS summary
+
+// Receive ring buffer (must be a power of two). At 115200 baud the controller
+// can deliver ~11.5 bytes/ms, so 1024 bytes covers ~90ms of continuous burst
+// while the main loop is busy with I2C polls or a slow MQTT publish.
+#define BRIDGE_RX_RING_SIZE 1024
+#define BRIDGE_RX_RING_MASK (BRIDGE_RX_RING_SIZE - 1)
 // Per TELEMETRY_API.md: SIZE byte = header(6) + payload length
 // Min: 6 bytes (header only), Max: 6 + 27 = 33 bytes (System Error with 24-char description)
 #define PROTOBUF_MIN_MESSAGE_SIZE 6     // Minimum: 6-byte header only
@@ -48,6 +58,11 @@ public:
     void begin();
     void update();
     
+    // Move pending bytes from the Serial1 FIFO into the receive ring.
+    // Cheap and safe to call from anywhere (between I2C transactions, inside
+    // wait loops) to keep the core's small UART buffer from overflowing.
+    void pollReceive();
+    
     // Configuration
     void setNetworkManager(NetworkManager* network);
     
@@ -55,13 +70,37 @@ public:
     bool isConnected() const { return bridgeConnected; }
     unsigned long getMessagesReceived() const { return messagesReceived; }
     unsigned long getMessagesForwarded() const { return messagesForwarded; }
-    unsigned long getWindowedReceived() const { return windowedReceived; }
-    unsigned long getWindowedForwarded() const { return windowedForwarded; }
     unsigned long getLastMessageTime() const { return lastMessageTime; }
+    unsigned long getRxOverruns() const { return rxOverruns; }
     TelemetryState getTelemetryState() const { return telemetryState; }
     
     // Statistics
     void getStatistics(char* buffer, size_t bufferSize);
+    void getSequenceStatistics(ResponseSink& out);
+    void resetSequenceStatistics();
+    void getLaneStatistics(ResponseSink& out) { lanes.getReport(out); }
+    
+    // Sliding-window rates, drops and publish latency (see BridgeMetrics)
+    void getMetricsReport(ResponseSink& out) { metrics.getReport(out, millis()); }
+    void getMetricsSummary(uint16_t seconds, BridgeMetrics::Summary& summary) { metrics.summarize(seconds, millis(), summary); }
+    uint8_t getBackPressure() const;    // Fullest outbound queue in percent, 100 while MQTT is down
+    
+    // Decoded sampled topics (pressure, status): adaptive token bucket policy
+    bool setRatePolicy(uint8_t minHz, uint8_t maxHz, uint8_t burst) { return protobufDecoder.setRatePolicy(minHz, maxHz, burst); }
+    void getRateStatistics(ResponseSink& out) { protobufDecoder.getRateStatistics(out); }
+    
+    // Text commands to the controller over Serial1 TX (see ProtobufDecoder::sendControllerCommand)
+    uint16_t sendControllerCommand(const char* command, const char* ref) { return protobufDecoder.sendControllerCommand(command, ref); }
+    void setCommandsEnabled(bool enabled) { protobufDecoder.setCommandsEnabled(enabled); }
+    bool areCommandsEnabled() const { return protobufDecoder.areCommandsEnabled(); }
+    void getCommandStatistics(ResponseSink& out) { protobufDecoder.getCommandStatistics(out); }
+    
+    // Self-test: synthetic frames through the parse path (see BridgeBench)
+    bool startBench(uint16_t rateHz, uint16_t seconds);
+    bool startBenchRamp();
+    void stopBench();
+    bool isBenchRunning() const { return bench.isRunning(); }
+    void getBenchReport(ResponseSink& out) { bench.getReport(out); }
 
     /*
      * OPERATION MODE: Binary Pass-Through
@@ -93,27 +132,53 @@ private:
     unsigned long criticalMessages;
     unsigned long parseErrors;
     unsigned long messagesDropped;  // Rate limited messages
+    unsigned long lastLossPublish;
     
-    // 5-minute windowed statistics
-    unsigned long windowedReceived;
-    unsigned long windowedForwarded;
-    unsigned long windowStartTime;
-    static const unsigned long WINDOW_DURATION_MS = 5 * 60 * 1000; // 5 minutes
+    // Per-second traffic ring behind the rates and latency percentiles
+    BridgeMetrics metrics;
+    unsigned long lastMetricsPublish;
     
     // Rate limiting
     unsigned long lastPublishTime;
     unsigned long burstStartTime;
     int burstCount;
     
-    // Message buffer
-    char messageBuffer[BRIDGE_BUFFER_SIZE];
-    size_t bufferIndex;
-    uint8_t expectedMessageSize;  // Expected size for current message being received
+    // Receive ring buffer. The first PROTOBUF_MAX_MESSAGE_SIZE bytes are
+    // mirrored past the end so any frame starting in the ring can be handed
+    // out as one contiguous pointer/length view without copying.
+    uint8_t rxRing[BRIDGE_RX_RING_SIZE + PROTOBUF_MAX_MESSAGE_SIZE];
+    volatile uint16_t rxHead;       // Next write position (producer)
+    uint16_t rxTail;                // Start of the frame being assembled (consumer)
+    uint16_t rxHighWater;           // Peak ring occupancy in bytes
+    unsigned long rxOverruns;       // Bytes lost because the ring was full
+    unsigned long rxFifoSaturations; // Polls that found the UART FIFO (nearly) full
+    unsigned long partialFrameStart; // millis() when the pending partial frame was first seen
+    
+    uint16_t rxAvailable() const { return (uint16_t)((rxHead - rxTail) & BRIDGE_RX_RING_MASK); }
+    void processReceivedFrames();
+    bool ringWrite(const uint8_t* data, size_t length);
+    
+    // Bridge bench: ring offsets of injected frames not yet parsed
+    BridgeBench bench;
+    uint16_t benchStarts[BENCH_MAX_CATCHUP];
+    uint8_t benchPending;
+    bool beginBench();
+    void injectBenchFrames();
+    void processBenchFrame(const uint8_t* data, size_t length);
+    void endBench();
+    
+    // Outbound priority lanes for controller/protobuff (see BridgeLanes)
+    BridgeLanes lanes;
+    void queueFrame(BridgeLane lane, const uint8_t* data, size_t length);
+    void sendQueuedFrame(uint8_t slot);
+    LaneOutcome forwardFrame(BridgeLane lane, const uint8_t* data, size_t length);
+    void drainLanes();
     
     // Message processing
-    void processProtobufMessage(uint8_t* data, size_t length);  // NEW: Protobuf handler
+    void processProtobufMessage(const uint8_t* data, size_t length);  // NEW: Protobuf handler
     void processMessage(const String& message);                 // LEGACY: Text handler
-    void checkAndResetWindow();                                 // Window management
+    void publishLossStatistics();
+    void publishMetrics();
     bool parseStructuredMessage(const String& message, unsigned long& timestamp, 
                                String& level, String& content);
     void handleTelemetryMessage(unsigned long timestamp, const String& level, 
@@ -139,7 +204,6 @@ private:
     
     // Utility functions
     String extractValue(const String& text, const String& prefix, const String& suffix = "");
-    void logBridgeActivity(LogLevel level, const char* format, ...);
     
     // Rate limiting
     bool shouldPublishMessage(const String& level);
@@ -163,4 +227,6 @@ private:
 #define TOPIC_BRIDGE_INPUT_PIN6    "controller/input/pin6"
 #define TOPIC_BRIDGE_INPUT_PIN12   "controller/input/pin12"
 #define TOPIC_BRIDGE_SYSTEM        "controller/system/status"
-#define TOPIC_BRIDGE_STATUS        "monitor/bridge/status"
\ No newline at end of file
+#define TOPIC_BRIDGE_STATUS        "monitor/bridge/status"
+#define TOPIC_BRIDGE_LOSS          "monitor/bridge/loss"
+#define TOPIC_BRIDGE_METRICS       "monitor/bridge/metrics"
\ No newline at end of file
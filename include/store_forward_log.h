@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+class NetworkManager; // Forward declaration
+
+// Store-and-forward log configuration
+// Region sits above both config log banks
+// (CONFIG_LOG_EEPROM_START + 2 * CONFIG_LOG_BANK_SIZE; see config_log.h)
+#define SFLOG_EEPROM_START      1024
+#define SFLOG_EEPROM_END        8192    // UNO R4 WiFi emulated EEPROM size
+#define SFLOG_RECORD_SIZE       48      // Fixed-size slots, one record each
+#define SFLOG_HEADER_SIZE       12
+#define SFLOG_DATA_SIZE         (SFLOG_RECORD_SIZE - SFLOG_HEADER_SIZE)
+#define SFLOG_STAGING_RECORDS   8       // RAM staging between append() and flash
+#define SFLOG_WRITE_SLICE_BYTES 8       // Data flash bytes written per service() call
+#define SFLOG_REPLAY_INTERVAL_MS 100    // Replay at most 10 records/second
+
+// Record kinds
+#define SFLOG_KIND_CONTROLLER_FRAME 1   // Raw size-prefixed controller frame
+#define SFLOG_KIND_MONITOR_SAMPLE   2   // "topic\0payload" Monitor sensor sample
+
+// Replay destinations
+#define TOPIC_SFLOG_CONTROLLER_REPLAY "controller/protobuff"
+#define TOPIC_SFLOG_MONITOR_REPLAY    "monitor/replay"
+
+/**
+ * Persistent store-and-forward log for MQTT outages
+ *
+ * Circular log of fixed 48-byte records in data flash (EEPROM emulation).
+ * append() only copies into a small RAM staging ring; service() moves a few
+ * bytes per call into flash so the hot path never waits on a flash write.
+ * Writing round-robin through the whole region spreads wear evenly, and
+ * EEPROM.update() skips bytes that already hold the right value.
+ *
+ * Record layout:
+ *   [0]     state (0xA5 pending, 0x00 replayed, other = empty/partial)
+ *   [1]     kind
+ *   [2]     data length
+ *   [3]     CRC-8 over bytes 1..2 and 4..(12+len)
+ *   [4..7]  record sequence number (uint32, monotonically increasing)
+ *   [8..11] millis() at capture
+ *   [12..]  data (controller frames keep their own timestamp and sequence ID)
+ *
+ * Once MQTT is connected, pending records are replayed oldest first at
+ * SFLOG_REPLAY_INTERVAL_MS: controller frames unchanged to controller/protobuff
+ * and Monitor samples as JSON to monitor/replay.
+ */
+class StoreForwardLog {
+public:
+    StoreForwardLog();
+
+    /**
+     * Scan the flash region and rebuild head/tail/backlog
+     * @param network Network manager used for replay
+     */
+    void begin(NetworkManager* network);
+
+    /**
+     * Queue a record for persistence (non-blocking, RAM copy only)
+     * @return false if the record was dropped (staging full or too large)
+     */
+    bool append(uint8_t kind, const uint8_t* data, size_t length);
+    bool appendFrame(const uint8_t* frame, size_t length);
+    bool appendSample(const char* topic, const char* payload);
+
+    /**
+     * Advance flash writes and replay - call frequently (scheduler task)
+     */
+    void service();
+
+    // Status
+    uint16_t getBacklog() const { return pendingRecords + stagedCount; }
+    uint16_t getCapacity() const { return slotCount; }
+    bool isReplaying() const { return replayActive; }
+    void getStatistics(char* buffer, size_t bufferSize);
+
+private:
+    NetworkManager* networkManager;
+    bool initialized;
+
+    // Flash ring state
+    uint16_t slotCount;
+    uint16_t headSlot;              // Next slot to write
+    uint16_t tailSlot;              // Oldest pending slot
+    uint16_t pendingRecords;        // Records in flash not yet replayed
+    uint32_t nextSequence;
+
+    // RAM staging ring
+    uint8_t staging[SFLOG_STAGING_RECORDS][SFLOG_RECORD_SIZE];
+    uint8_t stagedHead;
+    uint8_t stagedTail;
+    uint8_t stagedCount;
+    int16_t writeOffset;            // Progress through the record being written (-1 = idle)
+
+    // Replay state
+    bool replayActive;
+    unsigned long lastReplayTime;
+
+    // Statistics
+    uint32_t recordsStored;
+    uint32_t recordsReplayed;
+    uint32_t recordsOverwritten;    // Oldest pending records lost to a full log
+    uint32_t recordsDropped;        // append() calls rejected (staging full or record too large)
+    uint32_t corruptRecords;        // CRC failures found while replaying
+
+    int slotAddress(uint16_t slot) const { return SFLOG_EEPROM_START + slot * SFLOG_RECORD_SIZE; }
+    void serviceWrite();
+    void serviceReplay();
+    bool replaySlot(uint16_t slot);
+    void advanceTail();
+    static uint8_t crc8(const uint8_t* data, size_t length, uint8_t crc = 0);
+    static uint8_t recordCrc(const uint8_t* record);
+};
+
+extern StoreForwardLog* g_storeForward;
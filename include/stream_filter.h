@@ -0,0 +1,350 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Streaming sensor filters
+ *
+ * Allocation-free filters shared by the sensor drivers. Every buffer is
+ * sized by a template argument at compile time; the active window can be
+ * shortened at runtime up to that capacity. Each update costs a constant
+ * amount of work, so a filtered value is ready as soon as a reading comes in
+ * and nothing has to take a blocking burst of extra samples.
+ *
+ * Integer types (the drivers' fixed-point units) are preferred: running sums
+ * are exact. With float the moving-average sum is rebuilt once per window to
+ * stop rounding drift, which keeps the amortised cost O(1).
+ */
+
+/**
+ * Running-sum moving average over the last `window` samples
+ * SumT must hold Capacity samples (e.g. int64_t for nanovolts)
+ */
+template <typename T, uint8_t Capacity, typename SumT = T>
+class MovingAverage {
+    static_assert(Capacity > 0, "MovingAverage needs at least one slot");
+
+public:
+    MovingAverage() : window(Capacity) { reset(); }
+
+    bool setWindow(uint8_t samples) {
+        if (samples == 0 || samples > Capacity) return false;
+        window = samples;
+        reset();
+        return true;
+    }
+
+    void reset() {
+        head = 0;
+        count = 0;
+        sum = 0;
+    }
+
+    T update(T value) {
+        if (count == window) {
+            sum -= history[head];
+        } else {
+            count++;
+        }
+        history[head] = value;
+        sum += value;
+
+        if (++head >= window) {
+            head = 0;
+            if (!EXACT_SUM && count == window) resum();
+        }
+        return average();
+    }
+
+    T average() const { return count ? (T)(sum / (SumT)count) : (T)0; }
+    uint8_t getCount() const { return count; }
+    uint8_t getWindow() const { return window; }
+    bool isFull() const { return count == window; }
+
+private:
+    static constexpr bool EXACT_SUM = (SumT)0.5 == (SumT)0;  // Integer sums never drift
+
+    T history[Capacity];
+    SumT sum;
+    uint8_t window;
+    uint8_t head;
+    uint8_t count;
+
+    void resum() {
+        SumT total = 0;
+        for (uint8_t i = 0; i < window; i++) {
+            total += history[i];
+        }
+        sum = total;
+    }
+};
+
+/**
+ * Exponential moving average with alpha = 1 / 2^Shift
+ * The state keeps Shift extra fraction bits, so integer inputs settle
+ * exactly; StateT needs Shift bits of headroom over T.
+ */
+template <typename T, uint8_t Shift, typename StateT = T>
+class ExponentialAverage {
+    static_assert(Shift > 0 && Shift < 16, "ExponentialAverage shift out of range");
+
+public:
+    ExponentialAverage() : state(0), primed(false) {}
+
+    void reset() { primed = false; }
+
+    T update(T value) {
+        if (!primed) {
+            state = (StateT)value * SCALE;   // Start at the first sample, not at zero
+            primed = true;
+        } else {
+            state += (StateT)value - state / SCALE;
+        }
+        return average();
+    }
+
+    T average() const { return primed ? (T)(state / SCALE) : (T)0; }
+    bool isPrimed() const { return primed; }
+
+private:
+    static constexpr StateT SCALE = (StateT)(1L << Shift);
+
+    StateT state;
+    bool primed;
+};
+
+/**
+ * Sliding median of the last Window samples
+ * Kept as a sorted copy of the window, so an update moves at most Window
+ * entries - a small compile-time bound, independent of the sample count.
+ */
+template <typename T, uint8_t Window>
+class SlidingMedian {
+    static_assert(Window % 2 == 1 && Window <= 15, "SlidingMedian window must be small and odd");
+
+public:
+    SlidingMedian() { reset(); }
+
+    void reset() {
+        head = 0;
+        count = 0;
+    }
+
+    T update(T value) {
+        if (count == Window) {
+            removeSorted(history[head]);
+        } else {
+            count++;
+        }
+        history[head] = value;
+        head = (head + 1) % Window;
+        insertSorted(value);
+        return median();
+    }
+
+    T median() const { return count ? sorted[(count - 1) / 2] : (T)0; }
+    uint8_t getCount() const { return count; }
+
+private:
+    T history[Window];
+    T sorted[Window];       // First `count` entries, ascending
+    uint8_t head;
+    uint8_t count;
+
+    // Called with the window full; leaves Window - 1 sorted entries
+    void removeSorted(T value) {
+        uint8_t i = 0;
+        while (i < Window - 1 && sorted[i] != value) i++;
+        for (; i < Window - 1; i++) {
+            sorted[i] = sorted[i + 1];
+        }
+    }
+
+    // Called with count already covering the new sample
+    void insertSorted(T value) {
+        uint8_t i = count - 1;
+        while (i > 0 && sorted[i - 1] > value) {
+            sorted[i] = sorted[i - 1];
+            i--;
+        }
+        sorted[i] = value;
+    }
+};
+
+/**
+ * Spike rejection against the last accepted sample
+ * A sample further than `threshold` away is dropped, unless `confirm`
+ * outliers arrive in a row - then the level really changed and the new
+ * sample is taken.
+ */
+template <typename T>
+class SpikeFilter {
+public:
+    SpikeFilter(T threshold, uint8_t confirm)
+        : threshold(threshold)
+        , confirm(confirm)
+        , last(0)
+        , primed(false)
+        , outliers(0)
+        , rejected(0) {}
+
+    void reset() {
+        primed = false;
+        outliers = 0;
+    }
+
+    // True if the sample was accepted; value() is the last accepted sample
+    bool accept(T value) {
+        T diff = value > last ? value - last : last - value;
+        if (primed && diff > threshold && ++outliers < confirm) {
+            rejected++;
+            return false;
+        }
+        last = value;
+        primed = true;
+        outliers = 0;
+        return true;
+    }
+
+    T value() const { return last; }
+    uint32_t getRejected() const { return rejected; }
+
+private:
+    T threshold;
+    uint8_t confirm;
+    T last;
+    bool primed;
+    uint8_t outliers;
+    uint32_t rejected;
+};
+
+/**
+ * Running count/min/max/mean/variance (Welford) over an open-ended window
+ * One update is a handful of float operations and no history is kept, so
+ * a window may take any number of samples; reset() starts the next one.
+ */
+class RunningStats {
+public:
+    RunningStats() { reset(); }
+
+    void reset() {
+        count = 0;
+        mean = 0;
+        m2 = 0;
+        minimum = 0;
+        maximum = 0;
+        last = 0;
+    }
+
+    void update(float value) {
+        count++;
+        if (count == 1) {
+            minimum = value;
+            maximum = value;
+        } else {
+            if (value < minimum) minimum = value;
+            if (value > maximum) maximum = value;
+        }
+        last = value;
+
+        float delta = value - mean;
+        mean += delta / (float)count;
+        m2 += delta * (value - mean);
+    }
+
+    uint32_t getCount() const { return count; }
+    float getMin() const { return minimum; }
+    float getMax() const { return maximum; }
+    float getMean() const { return mean; }
+    float getLast() const { return last; }
+    float variance() const { return count > 1 ? m2 / (float)(count - 1) : 0.0f; }  // Sample variance
+    float stddev() const { return sqrtf(variance()); }
+
+private:
+    uint32_t count;
+    float mean;
+    float m2;               // Sum of squared differences from the running mean
+    float minimum;
+    float maximum;
+    float last;
+};
+
+/**
+ * Log-scale histogram of microsecond durations for percentiles
+ * Four buckets per power of two (values within +-12% of a bucket's
+ * midpoint), counts saturate; values past the last bucket land in it.
+ * 4 + 4 * (Octaves - 2) buckets of uint16_t, no samples are kept.
+ */
+template <uint8_t Octaves>
+class LatencyHistogram {
+    static_assert(Octaves >= 3 && Octaves <= 32, "LatencyHistogram covers 2^3 to 2^32 us");
+
+public:
+    static const uint8_t BUCKETS = 4 + 4 * (Octaves - 2);
+
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        count = 0;
+        total = 0;
+        maximum = 0;
+    }
+
+    void update(uint32_t us) {
+        uint8_t bucket = bucketOf(us);
+        if (counts[bucket] < UINT16_MAX) counts[bucket]++;
+        count++;
+        total += us;
+        if (us > maximum) maximum = us;
+    }
+
+    /**
+     * Value below which `percent` of the samples fall (bucket midpoint)
+     */
+    uint32_t percentile(uint8_t percent) const {
+        if (count == 0) return 0;
+        uint32_t seen = 0;
+        uint32_t target = (uint32_t)(((uint64_t)saturated() * percent + 99) / 100);
+        if (target == 0) target = 1;
+        for (uint8_t b = 0; b < BUCKETS; b++) {
+            seen += counts[b];
+            if (seen >= target) {
+                uint32_t low = lowerBound(b);
+                uint32_t high = b + 1 < BUCKETS ? lowerBound(b + 1) : maximum + 1;
+                if (high > maximum + 1) high = maximum + 1;
+                return low + (high > low ? (high - 1 - low) / 2 : 0);
+            }
+        }
+        return maximum;
+    }
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMax() const { return maximum; }
+    uint32_t getMean() const { return count ? (uint32_t)(total / count) : 0; }
+
+private:
+    uint16_t counts[BUCKETS];
+    uint32_t count;
+    uint64_t total;
+    uint32_t maximum;
+
+    static uint8_t bucketOf(uint32_t us) {
+        if (us < 4) return (uint8_t)us;
+        uint8_t octave = 31 - __builtin_clz(us);
+        if (octave >= Octaves) return BUCKETS - 1;
+        return (uint8_t)((octave - 1) * 4 + ((us >> (octave - 2)) & 3));
+    }
+
+    static uint32_t lowerBound(uint8_t bucket) {
+        if (bucket < 4) return bucket;
+        uint8_t octave = bucket / 4 + 1;
+        return (uint32_t)(4 + bucket % 4) << (octave - 2);
+    }
+
+    uint32_t saturated() const {
+        uint32_t sum = 0;
+        for (uint8_t b = 0; b < BUCKETS; b++) sum += counts[b];
+        return sum;
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Arduino.h>
+
+class ResponseSink;
+
+// Scheduler configuration
+#define SCHEDULER_MAX_TASKS 12
+#define SCHEDULER_INVALID_TASK -1
+
+typedef void (*TaskCallback)(void* context);
+
+/**
+ * Cooperative deadline scheduler
+ *
+ * Replaces the delay()-paced main loop with a fixed task table. Each task has
+ * a period, a next-run deadline and an optional runtime budget. Every pass
+ * runs the due tasks earliest-deadline-first; a task that has to wait for
+ * hardware (mux settle, ADC conversion) calls resumeAfter() and returns
+ * instead of busy waiting, so the serial bridge and MQTT client keep running.
+ *
+ * Blocking code paths that cannot be split (calibration, interactive
+ * commands) use cooperativeDelay(), which keeps the idle hook (Serial1
+ * drain) running while it waits.
+ */
+class TaskScheduler {
+public:
+    struct Task {
+        const char* name;
+        TaskCallback callback;
+        void* context;
+        unsigned long periodMs;     // 0 = run on every pass
+        unsigned long nextRunMs;    // Deadline for the next run
+        unsigned long budgetUs;     // 0 = no budget
+        bool enabled;
+
+        // Statistics
+        uint32_t runCount;
+        uint32_t overBudgetCount;   // Runs that exceeded budgetUs
+        uint32_t missedPeriods;     // Deadlines skipped because the task ran too late
+        uint32_t lastRunUs;
+        uint32_t maxRunUs;
+        uint64_t totalRunUs;
+        uint32_t maxLatenessMs;     // Worst start time past the deadline
+        uint32_t totalLatenessMs;
+    };
+
+    TaskScheduler();
+
+    /**
+     * Register a task
+     * @param name Short task name (must outlive the scheduler)
+     * @param callback Function to run
+     * @param context Opaque pointer passed to callback
+     * @param periodMs Run period in milliseconds (0 = every pass)
+     * @param budgetUs Expected worst-case runtime (0 = unchecked)
+     * @return Task id, or SCHEDULER_INVALID_TASK if the table is full
+     */
+    int8_t addTask(const char* name, TaskCallback callback, void* context,
+                   unsigned long periodMs, unsigned long budgetUs = 0);
+
+    void setEnabled(int8_t taskId, bool enabled);
+    void setPeriod(int8_t taskId, unsigned long periodMs);
+
+    /**
+     * Run all due tasks once, earliest deadline first
+     */
+    void run();
+
+    /**
+     * Called from inside a running task: next run happens after delayMs
+     * instead of the normal period (one-shot override).
+     */
+    void resumeAfter(unsigned long delayMs);
+
+    /**
+     * Hook run repeatedly while cooperativeDelay() waits
+     */
+    void setIdleHook(TaskCallback callback, void* context);
+
+    /**
+     * Wait without starving the idle hook (use only where a state split is impractical)
+     */
+    void cooperativeDelay(unsigned long ms);
+
+    // Statistics
+    void resetStatistics();
+    void getStatistics(ResponseSink& out);
+    uint8_t getTaskCount() const { return taskCount; }
+    int8_t getCurrentTask() const { return currentTask; }
+    const Task* getTask(uint8_t index) const { return index < taskCount ? &tasks[index] : nullptr; }
+    uint32_t getPassCount() const { return passCount; }
+    uint32_t getMaxPassUs() const { return maxPassUs; }
+
+private:
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t taskCount;
+    int8_t currentTask;             // Task being run, or SCHEDULER_INVALID_TASK
+    bool resumeRequested;
+    unsigned long resumeDelayMs;
+
+    TaskCallback idleHook;
+    void* idleContext;
+    bool inIdleHook;
+
+    uint32_t passCount;
+    uint32_t maxPassUs;
+
+    void runTask(uint8_t index, unsigned long now);
+};
+
+extern TaskScheduler* g_scheduler;
+
+/**
+ * Delay that keeps the Serial1 drain running; falls back to delay() if no
+ * scheduler is installed.
+ */
+void cooperativeDelay(unsigned long ms);
@@ -6,33 +6,110 @@
 
 extern TwoWire Wire1;
 
+// Approximate Wire1 time of one control register write at 100kHz
+// (address + data byte, start/stop), used for the bus time saved estimate
+#define TCA9548A_WRITE_US 200
+
+// Bus clock profiles
+#define I2C_CLOCK_STANDARD          100000UL    // Default for channels without a profile
+#define I2C_CLOCK_FAST              400000UL    // Mux control register and fast-mode devices
+
+// Bus recovery (stuck SDA): clock SCL until the slave lets go, then a STOP
+#define I2C_RECOVERY_CLOCK_PULSES   9
+#define I2C_RECOVERY_HALF_PERIOD_US 5           // 100 kHz bit-banged clock
+
+// Wire1 is the Qwiic connector on the UNO R4 WiFi
+#ifdef WIRE1_SCL_PIN
+#define I2C_RECOVERY_SCL_PIN        WIRE1_SCL_PIN
+#define I2C_RECOVERY_SDA_PIN        WIRE1_SDA_PIN
+#else
+#define I2C_RECOVERY_SCL_PIN        26
+#define I2C_RECOVERY_SDA_PIN        27
+#endif
+
 /**
  * @class TCA9548A_Multiplexer
  * @brief Class for managing TCA9548A I2C multiplexer
- * 
+ *
  * The TCA9548A is an 8-channel I2C multiplexer that allows multiple devices
  * with the same I2C address to be connected to a single I2C bus.
+ *
+ * This class is the only writer of the control register. It caches the
+ * enabled channel mask, so a select that would not change anything is
+ * skipped, and it remembers when the mask last changed so callers only
+ * wait for the settle time after a real switch. Devices with distinct
+ * addresses on different channels can be enabled together with
+ * selectChannels() and read without switching in between.
+ *
+ * Each channel can have its own bus clock (setChannelClock()). A select
+ * runs the bus at the slowest clock of the enabled channels; the control
+ * register write itself goes out at a clock both the old and the new set
+ * of channels accept, since every enabled device sees it. Wire1.setClock()
+ * is only called when the clock actually changes.
+ *
+ * recoverBus() frees a bus held by a slave that stopped mid-byte with SDA
+ * low: it clocks SCL by hand until SDA is released, sends a STOP and
+ * restarts Wire1. The cached mask is dropped, so the next select rewrites it.
  */
 class TCA9548A_Multiplexer {
 public:
     // Constructor
     TCA9548A_Multiplexer(uint8_t address = 0x70);
-    
+
     // Initialization
     bool begin();
-    
-    // Channel selection (0-7)
+
+    // Channel selection (0-7) - exactly this channel enabled
     bool selectChannel(uint8_t channel);
-    
+
+    // Select, then cooperatively wait settleMs if the mask actually changed
+    bool selectChannel(uint8_t channel, unsigned long settleMs);
+
+    // Enable a set of channels at once (bit n = channel n, 0 = none)
+    bool selectChannels(uint8_t mask);
+    bool selectChannels(uint8_t mask, unsigned long settleMs);
+
     // Disable all channels
     bool disableAllChannels();
-    
-    // Get current channel selection
+
+    // Get current channel selection (NO_CHANNEL unless exactly one is enabled)
     uint8_t getCurrentChannel();
-    
+    uint8_t getChannelMask() const { return _channelMask; }
+    bool isChannelEnabled(uint8_t channel) const;
+
+    // True if the last select wrote the control register
+    bool lastSelectChanged() const { return _lastSelectChanged; }
+
+    // Time left until the last switch has settled (0 = settled)
+    unsigned long getSettleRemaining(unsigned long settleMs) const;
+
+    // Forget the cached mask and clock so the next select writes both (bus reset, power glitch)
+    void invalidate();
+
+    // Bus clock for a channel's devices (default I2C_CLOCK_STANDARD)
+    void setChannelClock(uint8_t channel, uint32_t hz);
+    uint32_t getChannelClock(uint8_t channel) const { return channel <= 7 ? _channelClock[channel] : 0; }
+    uint32_t getBusClock() const { return _busClock; }
+
+    /**
+     * Release a stuck bus (SCL pulses, STOP) and restart Wire1
+     * @return true if SDA and SCL were both high afterwards
+     */
+    bool recoverBus();
+
     // Check if multiplexer is responding
     bool isConnected();
-    
+
+    // Statistics
+    uint32_t getSelectCount() const { return _selectCount; }
+    uint32_t getCacheHits() const { return _cacheHits; }
+    uint32_t getWriteCount() const { return _writeCount; }
+    uint32_t getWriteErrors() const { return _writeErrors; }
+    uint32_t getClockChanges() const { return _clockChanges; }
+    uint32_t getRecoveries() const { return _recoveries; }
+    void resetStatistics();
+    void getStatistics(char* buffer, size_t bufferSize);
+
     // Channel management constants
     static const uint8_t MUX_CHANNEL_0 = 0;
     static const uint8_t MUX_CHANNEL_1 = 1;
@@ -46,8 +123,28 @@ public:
 
 private:
     uint8_t _address;
-    uint8_t _currentChannel;
+    uint8_t _channelMask;
+    bool _maskValid;                // False until written, or after a failed write
+    bool _lastSelectChanged;
+    unsigned long _lastChangeMs;
     bool _initialized;
+    uint32_t _channelClock[8];
+    uint32_t _busClock;             // Clock Wire1 runs at now (0 = unknown)
+
+    // Statistics
+    uint32_t _selectCount;
+    uint32_t _cacheHits;
+    uint32_t _writeCount;
+    uint32_t _writeErrors;
+    uint32_t _clockChanges;
+    uint32_t _recoveries;
+    uint32_t _recoveryFailures;     // SDA still low after the recovery sequence
+
+    bool writeMask(uint8_t mask);
+    uint32_t clockFor(uint8_t mask) const;
+    void applyClock(uint32_t hz);
 };
 
-#endif // TCA9548A_MULTIPLEXER_H
\ No newline at end of file
+extern TCA9548A_Multiplexer* g_i2cMux;
+
+#endif // TCA9548A_MULTIPLEXER_H
@@ -3,40 +3,114 @@
 #include <WiFiS3.h>
 #include "constants.h"
 
+class ResponseSink;
+
+// Telnet server configuration
+#define TELNET_MAX_SESSIONS     3       // Concurrent clients (technician + logging script + spare)
+#define TELNET_OUTPUT_RING      512     // Output bytes queued per session (power of two)
+#define TELNET_DRAIN_BYTES      128     // Bytes written per session per update()
+#define TELNET_INPUT_BYTES      64      // Bytes read per session per update()
+#define TELNET_REPLY_WAIT_MS    1000    // How long a command reply may wait for queue space
+#define TELNET_DROP_MARK        "\r\n[output dropped]\r\n"
+
+/**
+ * Multi-session telnet console
+ *
+ * Up to TELNET_MAX_SESSIONS clients are served at once. Every session has a
+ * fixed line buffer and an output ring; update() reads and writes at most a
+ * few bytes per session, so a slow client (full TCP window) costs a bounded
+ * amount of loop time instead of blocking the serial bridge.
+ *
+ * Output that does not fit a session's ring is dropped whole and replaced by
+ * TELNET_DROP_MARK once there is room again. A command reply may wait up to
+ * TELNET_REPLY_WAIT_MS for space; while it waits it drains its own session
+ * and yields to the Serial1 idle hook through cooperativeDelay().
+ */
 class TelnetServer {
 public:
+    static const uint8_t NO_SESSION = 0xFF;
+
     TelnetServer();
     
     void begin(int port = 23);
     void update();
     void stop();
     
-    bool isConnected();
-    bool hasData();
+    bool isConnected() const { return sessionCount > 0; }
+    uint8_t getSessionCount() const { return sessionCount; }
     
-    // Output functions
+    // Output - per session, or to every session
+    bool write(uint8_t session, const char* data, size_t length, unsigned long waitMs = 0);
+    void print(uint8_t session, const char* str);
     void print(const char* str);
     void println(const char* str);
-    void printf(const char* fmt, ...);
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
     
-    // Input functions
-    String readLine();
-    void flushInput();
+    /**
+     * Take the next complete input line, sessions served in turn
+     * @param session Set to the session the line came from
+     * @return false if no session has a complete line
+     */
+    bool readLine(char* buffer, size_t bufferSize, uint8_t& session);
     
     // Connection info
     void setConnectionInfo(const char* hostname, const char* version);
-    void showWelcomeMessage();
+    void showWelcomeMessage(uint8_t session);
+    
+    void getStatistics(ResponseSink& out);
 
 private:
+    enum TelnetState : uint8_t {
+        TELNET_DATA,
+        TELNET_IAC,         // Got IAC, command byte next
+        TELNET_OPTION       // Got WILL/WONT/DO/DONT, option byte next
+    };
+    
+    struct Session {
+        WiFiClient client;
+        bool active;
+        
+        // Line assembly
+        char line[COMMAND_BUFFER_SIZE];
+        uint8_t lineLength;
+        bool lineReady;             // Complete line waiting for readLine()
+        TelnetState telnetState;
+        
+        // Output ring
+        char output[TELNET_OUTPUT_RING];
+        uint16_t head;
+        uint16_t tail;
+        bool markPending;           // Output was dropped, TELNET_DROP_MARK not queued yet
+        
+        // Statistics
+        unsigned long connectedAt;
+        uint32_t bytesSent;
+        uint32_t droppedBytes;
+        uint16_t peakQueued;
+    };
+    
     WiFiServer server;
-    WiFiClient client;
-    bool clientConnected;
-    String inputBuffer;
+    Session sessions[TELNET_MAX_SESSIONS];
+    uint8_t sessionCount;
+    uint8_t nextReadSession;
+    
+    uint32_t accepted;
+    uint32_t rejected;
     
     // Connection info
     char hostname[32];
     char version[16];
     
-    void handleNewConnection();
-    void handleClientDisconnection();
+    void acceptConnections();
+    void closeSession(uint8_t index);
+    void readInput(Session& session);
+    void drainOutput(Session& session);
+    bool enqueue(Session& session, const char* data, size_t length);
+    
+    static uint16_t queued(const Session& session) {
+        return (session.head - session.tail) & (TELNET_OUTPUT_RING - 1);
+    }
+    static uint16_t space(const Session& session) {
+        return TELNET_OUTPUT_RING - 1 - queued(session);
+    }
 };
@@ -0,0 +1,72 @@
+#include "bench_counters.h"
+#include <string.h>
+
+BenchCounters benchCounters = { 0, 0, 0, 0, 0 };
+bool benchCounting = false;
+
+static inline void countCopy(size_t bytes) {
+    if (!benchCounting) return;
+    benchCounters.copies++;
+    benchCounters.copiedBytes += bytes;
+}
+
+extern "C" {
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t count, size_t size);
+    void* __real_realloc(void* ptr, size_t size);
+    void __real_free(void* ptr);
+    void* __real_memcpy(void* dest, const void* src, size_t length);
+    void* __real_memmove(void* dest, const void* src, size_t length);
+    char* __real_strcpy(char* dest, const char* src);
+    char* __real_strncpy(char* dest, const char* src, size_t length);
+
+    void* __wrap_malloc(size_t size) {
+        if (benchCounting) {
+            benchCounters.allocations++;
+            benchCounters.allocatedBytes += size;
+        }
+        return __real_malloc(size);
+    }
+
+    void* __wrap_calloc(size_t count, size_t size) {
+        if (benchCounting) {
+            benchCounters.allocations++;
+            benchCounters.allocatedBytes += count * size;
+        }
+        return __real_calloc(count, size);
+    }
+
+    void* __wrap_realloc(void* ptr, size_t size) {
+        // String growth: every realloc is a potential move to a new block
+        if (benchCounting && size > 0) {
+            benchCounters.allocations++;
+            benchCounters.allocatedBytes += size;
+        }
+        return __real_realloc(ptr, size);
+    }
+
+    void __wrap_free(void* ptr) {
+        if (benchCounting && ptr) benchCounters.frees++;
+        __real_free(ptr);
+    }
+
+    void* __wrap_memcpy(void* dest, const void* src, size_t length) {
+        countCopy(length);
+        return __real_memcpy(dest, src, length);
+    }
+
+    void* __wrap_memmove(void* dest, const void* src, size_t length) {
+        countCopy(length);
+        return __real_memmove(dest, src, length);
+    }
+
+    char* __wrap_strcpy(char* dest, const char* src) {
+        countCopy(strlen(src) + 1);
+        return __real_strcpy(dest, src);
+    }
+
+    char* __wrap_strncpy(char* dest, const char* src, size_t length) {
+        countCopy(length);      // strncpy always writes the full length
+        return __real_strncpy(dest, src, length);
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Heap and copy traffic of the code under test
+ *
+ * Filled by the linker-wrapped malloc/calloc/realloc/free and
+ * memcpy/memmove/strcpy/strncpy in bench_counters.cpp (see the
+ * -Wl,--wrap and -fno-builtin flags of env:native) while counting is on.
+ * Copies made inside the C library itself (printf and friends) are not seen.
+ */
+struct BenchCounters {
+    uint64_t allocations;           // malloc/calloc and growing realloc
+    uint64_t allocatedBytes;
+    uint64_t frees;
+    uint64_t copies;                // Calls of the wrapped copy functions
+    uint64_t copiedBytes;
+};
+
+extern BenchCounters benchCounters;
+extern bool benchCounting;
@@ -0,0 +1,232 @@
+// Replay benchmark for the Serial1 -> MQTT hot path (env:native)
+//
+// Replays controller byte streams through the real SerialBridge,
+// ProtobufDecoder, NetworkManager publish queue, Logger and store-and-forward
+// log, with Serial1/MQTT/UDP/EEPROM replaced by the shims in native/shims.
+// Bytes arrive at wire speed on the virtual clock; the time reported is host
+// time spent in SerialBridge::update(), so frames/sec is only comparable
+// between runs on the same machine.
+//
+// Usage: program [--reps N] [capture.bin ...]
+
+#include <Arduino.h>
+#include <chrono>
+#include "serial_bridge.h"
+#include "network_manager.h"
+#include "store_forward_log.h"
+#include "logger.h"
+#include "response_sink.h"
+#include "capture.h"
+#include "bench_counters.h"
+
+#define BENCH_DEFAULT_REPS      20
+#define BENCH_SCENARIO_FRAMES   2000
+#define BENCH_BYTE_US           87      // 10 bits per byte at 115200 baud
+#define BENCH_CONNECT_TIMEOUT_MS 60000
+
+// Globals the firmware sources expect from main.cpp
+bool g_debugEnabled = false;
+StoreForwardLog* g_storeForward = nullptr;
+
+void (debugPrintf)(const char* fmt, ...) {
+    if (!g_debugEnabled) return;
+
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+static NetworkManager network;
+static StoreForwardLog storeForward;
+static SerialBridge bridge;
+
+// Deterministic chunking, so the same capture splits the same way every run
+static uint32_t rngState = 0x2545F491;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+struct ReplayResult {
+    uint64_t bytes;
+    uint64_t frames;                // Framed by the bridge
+    uint64_t forwarded;
+    uint64_t bridgeNs;
+    uint64_t mqttMessages;
+    uint64_t coalesced;
+    BenchCounters counters;
+};
+
+// One main loop pass of the parts under test, as the scheduler tasks would run them
+static void runLoop(ReplayResult& result) {
+    auto start = std::chrono::steady_clock::now();
+    bridge.update();
+    auto end = std::chrono::steady_clock::now();
+    result.bridgeNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    network.update();
+    Logger::service();
+    storeForward.service();
+}
+
+static bool connect() {
+    for (unsigned long waited = 0; waited < BENCH_CONNECT_TIMEOUT_MS; waited += 100) {
+        network.update();
+        if (network.isMQTTConnected()) return true;
+        delay(100);
+    }
+    return false;
+}
+
+static void replay(const Capture& capture, ReplayResult& result) {
+    const std::vector<uint8_t>& bytes = capture.getBytes();
+    const std::vector<Capture::Pause>& pauses = capture.getPauses();
+    size_t nextPause = 0;
+    size_t offset = 0;
+
+    while (offset < bytes.size()) {
+        size_t chunk = 1 + nextRandom() % NATIVE_SERIAL_FIFO_SIZE;
+        if (chunk > bytes.size() - offset) chunk = bytes.size() - offset;
+        if (nextPause < pauses.size() && pauses[nextPause].offset > offset &&
+            pauses[nextPause].offset - offset < chunk) {
+            chunk = pauses[nextPause].offset - offset;
+        }
+
+        size_t accepted = Serial1.inject(&bytes[offset], chunk);
+        nativeAdvanceMicros((uint64_t)accepted * BENCH_BYTE_US);
+        offset += accepted;
+        runLoop(result);
+
+        // Line silence: let the clock run past it with an idle pass
+        while (nextPause < pauses.size() && pauses[nextPause].offset <= offset) {
+            delay(pauses[nextPause].ms);
+            runLoop(result);
+            nextPause++;
+        }
+    }
+    result.bytes += bytes.size();
+}
+
+static void runScenario(const Capture& capture, int reps, bool brokerDown) {
+    if (capture.getBytes().empty()) return;
+
+    if (brokerDown) {
+        nativeNetwork.brokerUp = false;
+        network.update();
+    }
+
+    ReplayResult result;
+    memset(&result, 0, sizeof(result));
+
+    unsigned long received = bridge.getMessagesReceived();
+    unsigned long forwarded = bridge.getMessagesForwarded();
+    uint32_t messages = nativeNetwork.mqttMessages;
+    uint32_t coalesced = network.getCoalescedCount();
+
+    memset(&benchCounters, 0, sizeof(benchCounters));
+    benchCounting = true;
+    for (int rep = 0; rep < reps; rep++) {
+        replay(capture, result);
+    }
+    benchCounting = false;
+
+    result.frames = bridge.getMessagesReceived() - received;
+    result.forwarded = bridge.getMessagesForwarded() - forwarded;
+    result.mqttMessages = nativeNetwork.mqttMessages - messages;
+    result.coalesced = network.getCoalescedCount() - coalesced;
+    result.counters = benchCounters;
+
+    double frames = result.frames > 0 ? (double)result.frames : 1.0;
+    double seconds = (double)result.bridgeNs / 1e9;
+    printf("%-16s %9llu %8llu %8llu %11.0f %9.1f %8.2f %9.2f %8.2f\n",
+        capture.getName(),
+        (unsigned long long)result.bytes,
+        (unsigned long long)result.frames,
+        (unsigned long long)result.forwarded,
+        seconds > 0 ? (double)result.frames / seconds : 0.0,
+        (double)result.counters.copiedBytes / frames,
+        (double)result.counters.allocations / frames,
+        (double)(result.mqttMessages + result.coalesced) / frames,
+        (double)result.mqttMessages / frames);
+
+    if (brokerDown) {
+        nativeNetwork.brokerUp = true;
+        if (!connect()) printf("warning: MQTT did not reconnect after %s\n", capture.getName());
+    }
+}
+
+int main(int argc, char** argv) {
+    int reps = BENCH_DEFAULT_REPS;
+    std::vector<Capture*> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+            if (reps < 1) reps = 1;
+            continue;
+        }
+        Capture* capture = new Capture(argv[i]);
+        if (!capture->load(argv[i])) {
+            fprintf(stderr, "cannot read capture %s\n", argv[i]);
+            return 1;
+        }
+        files.push_back(capture);
+    }
+
+    nativeAdvanceMicros((uint64_t)MQTT_RECONNECT_INTERVAL_MS * 1000);
+    Logger::begin(&network);
+    network.begin();
+    network.startJoin();
+    storeForward.begin(&network);
+    g_storeForward = &storeForward;
+    bridge.setNetworkManager(&network);
+    bridge.begin();
+
+    if (!connect()) {
+        fprintf(stderr, "MQTT shim did not connect\n");
+        return 1;
+    }
+
+    Capture burst("burst");
+    Capture pressure("pressure");
+    Capture corrupt("corrupt-sizes");
+    Capture partial("partial-frames");
+    Capture outage("broker-outage");
+    buildMixedBurst(burst, BENCH_SCENARIO_FRAMES);
+    buildPressureStream(pressure, BENCH_SCENARIO_FRAMES);
+    buildCorruptSizes(corrupt, BENCH_SCENARIO_FRAMES);
+    buildPartialFrames(partial, BENCH_SCENARIO_FRAMES);
+    buildMixedBurst(outage, BENCH_SCENARIO_FRAMES);
+
+    printf("%d reps per scenario; per-frame columns are averages over frames framed by the bridge\n", reps);
+    printf("%-16s %9s %8s %8s %11s %9s %8s %9s %8s\n",
+        "scenario", "bytes", "frames", "fwd", "frames/s", "copied/f", "allocs/f", "publish/f", "mqtt/f");
+
+    runScenario(burst, reps, false);
+    runScenario(pressure, reps, false);
+    runScenario(corrupt, reps, false);
+    runScenario(partial, reps, false);
+    for (Capture* capture : files) {
+        runScenario(*capture, reps, false);
+    }
+    runScenario(outage, reps, true);
+
+    char stats[512];
+    bridge.getStatistics(stats, sizeof(stats));
+    printf("\n%s\n", stats);
+    storeForward.getStatistics(stats, sizeof(stats));
+    printf("%s\n\n", stats);
+    ResponseSink lanes([](void*, const char* data, size_t, uint16_t, bool) { fputs(data, stdout); }, nullptr);
+    bridge.getLaneStatistics(lanes);
+    lanes.finish();
+    printf("\n");
+
+    for (Capture* capture : files) {
+        delete capture;
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "capture.h"
+#include <stdio.h>
+#include <string.h>
+
+// Frame header: SIZE, type, sequence, timestamp u32 (SIZE excludes itself)
+#define FRAME_HEADER_BYTES  7
+#define FRAME_TIMESTAMP_STEP_MS 5
+
+Capture::Capture(const char* name)
+    : name(name)
+    , validFrames(0)
+    , timestamp(100000) {
+    memset(sequence, 0, sizeof(sequence));
+}
+
+size_t Capture::header(uint8_t type, uint8_t length, uint8_t* out) {
+    out[0] = (uint8_t)(FRAME_HEADER_BYTES - 1 + length);
+    out[1] = type;
+    out[2] = sequence[type]++;
+    out[3] = (uint8_t)timestamp;
+    out[4] = (uint8_t)(timestamp >> 8);
+    out[5] = (uint8_t)(timestamp >> 16);
+    out[6] = (uint8_t)(timestamp >> 24);
+    timestamp += FRAME_TIMESTAMP_STEP_MS;
+    return FRAME_HEADER_BYTES;
+}
+
+void Capture::frame(uint8_t type, const uint8_t* payload, uint8_t length) {
+    uint8_t head[FRAME_HEADER_BYTES];
+    header(type, length, head);
+    bytes.insert(bytes.end(), head, head + FRAME_HEADER_BYTES);
+    bytes.insert(bytes.end(), payload, payload + length);
+    validFrames++;
+}
+
+void Capture::truncatedFrame(uint8_t type, const uint8_t* payload, uint8_t length, size_t keep) {
+    uint8_t whole[FRAME_HEADER_BYTES + 255];
+    header(type, length, whole);
+    memcpy(whole + FRAME_HEADER_BYTES, payload, length);
+    if (keep > FRAME_HEADER_BYTES + (size_t)length) keep = FRAME_HEADER_BYTES + length;
+    bytes.insert(bytes.end(), whole, whole + keep);
+}
+
+void Capture::raw(const uint8_t* data, size_t length) {
+    bytes.insert(bytes.end(), data, data + length);
+}
+
+void Capture::pause(unsigned long ms) {
+    pauses.push_back({ bytes.size(), ms });
+}
+
+bool Capture::load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + count);
+    }
+    fclose(file);
+    return true;
+}
+
+// ===== Payloads (layouts as in protobuf_decoder.cpp MESSAGE_LAYOUTS) =====
+
+static void putU16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t value) {
+    putU16(p, (uint16_t)value);
+    putU16(p + 2, (uint16_t)(value >> 16));
+}
+
+static uint8_t buildPayload(uint8_t type, uint32_t n, uint8_t* payload) {
+    switch (type) {
+        case 0x10:                                      // Digital input
+            payload[0] = (uint8_t)(n % 13);
+            payload[1] = (uint8_t)((n & 1) | ((5 + n % 2) << 2));
+            putU16(payload + 2, 50);
+            return 4;
+        case 0x11:                                      // Digital output
+            payload[0] = (uint8_t)(n % 8);
+            payload[1] = (uint8_t)((n & 1) | (1 << 1) | ((n % 4) << 4));
+            payload[2] = 0;
+            return 3;
+        case 0x12:                                      // Relay event
+            payload[0] = (uint8_t)(1 + n % 2);
+            payload[1] = (uint8_t)((n & 1) | ((1 + n % 2) << 3));
+            payload[2] = 0;
+            return 3;
+        case 0x13: {                                    // Pressure
+            float psi = 200.0f + (float)(n % 400) * 0.5f;
+            payload[0] = (n & 1) ? 5 : 1;
+            payload[1] = (uint8_t)(1 << 1);
+            putU16(payload + 2, (uint16_t)(n % 1024));
+            memcpy(payload + 4, &psi, sizeof(psi));
+            return 8;
+        }
+        case 0x14: {                                    // System error
+            static const char description[] = "PRESSURE SENSOR A1";
+            payload[0] = 0x21;
+            payload[1] = (uint8_t)((n & 1) << 1 | (2 << 2));
+            payload[2] = (uint8_t)(sizeof(description) - 1);
+            memcpy(payload + 3, description, sizeof(description) - 1);
+            return (uint8_t)(3 + sizeof(description) - 1);
+        }
+        case 0x15:                                      // Safety event
+            payload[0] = (uint8_t)(n % 6);
+            payload[1] = (uint8_t)(n & 1);
+            payload[2] = 0;
+            return 3;
+        case 0x16:                                      // System status
+            putU32(payload, 100000 + n * 1000);
+            putU16(payload + 4, 950);
+            putU16(payload + 6, 4100);
+            payload[8] = 0;
+            payload[9] = (uint8_t)((n % 7) << 2);
+            putU16(payload + 10, 0);
+            return 12;
+        default:                                        // 0x17 sequence event
+            payload[0] = (uint8_t)(n % 7);
+            payload[1] = (uint8_t)(n % 4);
+            putU16(payload + 2, (uint16_t)(n * 40));
+            return 4;
+    }
+}
+
+void buildMixedBurst(Capture& capture, uint32_t frames) {
+    uint8_t payload[32];
+    for (uint32_t n = 0; n < frames; n++) {
+        uint8_t type = (uint8_t)(0x10 + n % 8);
+        capture.frame(type, payload, buildPayload(type, n, payload));
+    }
+}
+
+void buildPressureStream(Capture& capture, uint32_t frames) {
+    uint8_t payload[32];
+    for (uint32_t n = 0; n < frames; n++) {
+        capture.frame(0x13, payload, buildPayload(0x13, n, payload));
+    }
+}
+
+void buildCorruptSizes(Capture& capture, uint32_t frames) {
+    static const uint8_t badSizes[] = { 0x00, 0x02, 0x05, 0x21, 0x7F, 0xFF };
+    uint8_t payload[32];
+
+    for (uint32_t n = 0; n < frames; n++) {
+        uint8_t type = (uint8_t)(0x10 + n % 8);
+        capture.frame(type, payload, buildPayload(type, n, payload));
+
+        switch (n % 4) {
+            case 0:                                     // Line noise: out-of-range size byte
+                capture.raw(&badSizes[(n / 4) % sizeof(badSizes)], 1);
+                break;
+            case 1: {                                   // Well framed, unknown type
+                uint8_t unknown[] = { 0x09, 0x30, 0x00, 0x10, 0x27, 0x00, 0x00, 0xAA, 0xBB, 0xCC };
+                capture.raw(unknown, sizeof(unknown));
+                break;
+            }
+            case 2: {                                   // Pressure frame with its payload missing
+                uint8_t shortFrame[] = { 0x07, 0x13, 0x00, 0x10, 0x27, 0x00, 0x00, 0x01 };
+                capture.raw(shortFrame, sizeof(shortFrame));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void buildPartialFrames(Capture& capture, uint32_t frames) {
+    uint8_t payload[32];
+
+    for (uint32_t n = 0; n < frames; n++) {
+        uint8_t type = (uint8_t)(0x10 + n % 8);
+        uint8_t length = buildPayload(type, n, payload);
+
+        if (n % 16 == 15) {
+            // Controller reset mid-frame: the tail never arrives
+            capture.truncatedFrame(type, payload, length, 1 + n % (FRAME_HEADER_BYTES + length - 1));
+            capture.pause(1500);
+        } else {
+            capture.frame(type, payload, length);
+        }
+    }
+}
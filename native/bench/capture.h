@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/**
+ * Controller byte stream to replay into Serial1
+ *
+ * Either loaded from a raw capture of the controller's TX line or built
+ * from size-prefixed frames (docs/TELEMETRY_API.md) with deliberate damage
+ * mixed in. Pauses are line silence at a byte offset, long enough for the
+ * bridge's partial-frame timeout when the scenario needs it.
+ */
+class Capture {
+public:
+    struct Pause {
+        size_t offset;
+        unsigned long ms;
+    };
+
+    explicit Capture(const char* name);
+
+    // Complete frame; sequence IDs count per type, timestamps step 5ms
+    void frame(uint8_t type, const uint8_t* payload, uint8_t length);
+    // Same frame cut after keep bytes (size byte included)
+    void truncatedFrame(uint8_t type, const uint8_t* payload, uint8_t length, size_t keep);
+    void raw(const uint8_t* data, size_t length);
+    void pause(unsigned long ms);
+
+    bool load(const char* path);
+
+    const char* getName() const { return name; }
+    const std::vector<uint8_t>& getBytes() const { return bytes; }
+    const std::vector<Pause>& getPauses() const { return pauses; }
+    // Frames the bridge should forward (0 = unknown, e.g. a loaded capture)
+    uint32_t getValidFrames() const { return validFrames; }
+
+private:
+    const char* name;
+    std::vector<uint8_t> bytes;
+    std::vector<Pause> pauses;
+    uint32_t validFrames;
+    uint8_t sequence[256];
+    uint32_t timestamp;
+
+    size_t header(uint8_t type, uint8_t length, uint8_t* out);
+};
+
+// Synthetic scenarios
+void buildMixedBurst(Capture& capture, uint32_t frames);        // 0x10-0x17 round robin
+void buildPressureStream(Capture& capture, uint32_t frames);    // 0x13 A1/A5 only
+void buildCorruptSizes(Capture& capture, uint32_t frames);      // Bad size bytes and unknown types between frames
+void buildPartialFrames(Capture& capture, uint32_t frames);     // Frames cut off by line silence
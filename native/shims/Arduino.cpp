@@ -0,0 +1,255 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Wire.h>
+
+// ===== Virtual clock =====
+
+static uint64_t clockUs = 0;
+
+// Both wrap at 32 bits like the RA4M1 core, so overflow handling is exercised
+unsigned long millis() { return (unsigned long)(uint32_t)(clockUs / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)clockUs; }
+void delay(unsigned long ms) { clockUs += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { clockUs += us; }
+
+void nativeAdvanceMicros(uint64_t us) { clockUs += us; }
+uint64_t nativeNowMicros() { return clockUs; }
+
+// ===== Random =====
+
+static uint32_t randomState = 1;
+
+long random(long max) {
+    if (max <= 0) return 0;
+    randomState = randomState * 1103515245u + 12345u;
+    return (long)((randomState >> 1) % (uint32_t)max);
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+// The bench keeps the fixed default seed; firmware reseeds from micros()
+void randomSeed(unsigned long) {}
+
+// ===== String =====
+// Heap-backed like the core's String, so its allocations show up in the bench
+
+String::String(const char* text) : buffer(nullptr), len(0), capacity(0) {
+    assign(text ? text : "", text ? strlen(text) : 0);
+}
+
+String::String(const String& other) : buffer(nullptr), len(0), capacity(0) {
+    assign(other.buffer, other.len);
+}
+
+String::String(char c) : buffer(nullptr), len(0), capacity(0) {
+    assign(&c, 1);
+}
+
+String::String(int value, unsigned char base) : buffer(nullptr), len(0), capacity(0) {
+    char text[34];
+    snprintf(text, sizeof(text), base == HEX ? "%x" : "%d", value);
+    assign(text, strlen(text));
+}
+
+String::String(unsigned long value, unsigned char base) : buffer(nullptr), len(0), capacity(0) {
+    char text[34];
+    snprintf(text, sizeof(text), base == HEX ? "%lx" : "%lu", value);
+    assign(text, strlen(text));
+}
+
+String::~String() {
+    free(buffer);
+}
+
+String& String::operator=(const String& other) {
+    if (this != &other) assign(other.buffer, other.len);
+    return *this;
+}
+
+String& String::operator=(const char* text) {
+    assign(text ? text : "", text ? strlen(text) : 0);
+    return *this;
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+void String::reserve(size_t length) {
+    if (buffer && length <= capacity) return;
+    char* grown = (char*)realloc(buffer, length + 1);
+    if (!grown) return;
+    buffer = grown;
+    capacity = (unsigned int)length;
+}
+
+void String::assign(const char* text, size_t length) {
+    reserve(length);
+    if (!buffer) return;
+    memmove(buffer, text, length);
+    buffer[length] = '\0';
+    len = (unsigned int)length;
+}
+
+void String::append(const char* text, size_t length) {
+    reserve(len + length);
+    if (!buffer) return;
+    memmove(buffer + len, text, length);
+    len += (unsigned int)length;
+    buffer[len] = '\0';
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    if (from >= len) return -1;
+    const char* found = strchr(buffer + from, c);
+    return found ? (int)(found - buffer) : -1;
+}
+
+int String::indexOf(const String& text, unsigned int from) const {
+    if (from >= len) return -1;
+    const char* found = strstr(buffer + from, text.buffer);
+    return found ? (int)(found - buffer) : -1;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return prefix.len <= len && strncmp(buffer, prefix.buffer, prefix.len) == 0;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        unsigned int swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from > len) from = len;
+    if (to > len) to = len;
+
+    String result;
+    result.assign(buffer + from, to - from);
+    return result;
+}
+
+void String::trim() {
+    unsigned int start = 0;
+    while (start < len && isspace((unsigned char)buffer[start])) start++;
+    unsigned int end = len;
+    while (end > start && isspace((unsigned char)buffer[end - 1])) end--;
+    len = end - start;
+    memmove(buffer, buffer + start, len);
+    buffer[len] = '\0';
+}
+
+bool IPAddress::fromString(const char* text) {
+    unsigned int part[4];
+    char tail;
+    if (sscanf(text, "%u.%u.%u.%u%c", &part[0], &part[1], &part[2], &part[3], &tail) != 4) return false;
+    for (int i = 0; i < 4; i++) {
+        if (part[i] > 255) return false;
+        octets[i] = (uint8_t)part[i];
+    }
+    return true;
+}
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(text);
+}
+
+// ===== Print / Client =====
+
+size_t Print::write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (length--) written += write(*data++);
+    return written;
+}
+
+size_t Print::print(long value, int base) {
+    char text[34];
+    snprintf(text, sizeof(text), base == HEX ? "%lx" : "%ld", value);
+    return write(text);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char text[34];
+    snprintf(text, sizeof(text), base == HEX ? "%lx" : "%lu", value);
+    return write(text);
+}
+
+size_t Print::print(double value, int digits) {
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return write(text);
+}
+
+int Client::read(uint8_t* buf, size_t size) {
+    size_t count = 0;
+    while (count < size && available() > 0) buf[count++] = (uint8_t)read();
+    return (int)count;
+}
+
+// ===== Serial ports =====
+
+NativeSerial Serial("Serial");
+NativeSerial Serial1("Serial1");
+
+NativeSerial::NativeSerial(const char* name)
+    : name(name)
+    , baud(0)
+    , echo(false)
+    , rxHead(0)
+    , rxCount(0)
+    , txBytes(0) {
+}
+
+int NativeSerial::read() {
+    if (rxCount == 0) return -1;
+    uint8_t value = rx[rxHead];
+    rxHead = (rxHead + 1) % NATIVE_SERIAL_FIFO_SIZE;
+    rxCount--;
+    return value;
+}
+
+size_t NativeSerial::write(uint8_t c) {
+    txBytes++;
+    if (echo) fputc(c, stdout);
+    return 1;
+}
+
+size_t NativeSerial::write(const uint8_t* data, size_t length) {
+    txBytes += length;
+    if (echo) fwrite(data, 1, length, stdout);
+    return length;
+}
+
+size_t NativeSerial::inject(const uint8_t* data, size_t length) {
+    size_t accepted = 0;
+    while (accepted < length && rxCount < NATIVE_SERIAL_FIFO_SIZE) {
+        rx[(rxHead + rxCount) % NATIVE_SERIAL_FIFO_SIZE] = data[accepted++];
+        rxCount++;
+    }
+    return accepted;
+}
+
+// ===== EEPROM and I2C =====
+
+EEPROMClass EEPROM;
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (!inRange(address)) return;
+    cells[address] = value;
+    writes++;
+}
+
+TwoWire Wire;
+TwoWire Wire1;
@@ -0,0 +1,192 @@
+#pragma once
+
+// Host (native) stand-in for the Arduino core - just the parts the bridge,
+// decoder, network manager, logger and store-and-forward sources use.
+// Time is virtual: millis()/micros() only move when the bench (or delay())
+// advances them, so replays are reproducible and rate limits see wire time.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+
+#define DEC 10
+#define HEX 16
+
+// Flat address space, nothing to place in flash
+#define PROGMEM
+#define F(text) (text)
+
+// UNO R4 WiFi I2C header pins
+#define SDA 18
+#define SCL 19
+
+// Core-side Serial RX FIFO (same fallback the bridge assumes)
+#define NATIVE_SERIAL_FIFO_SIZE 64
+
+// ===== Virtual clock =====
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void yield() {}
+
+void nativeAdvanceMicros(uint64_t us);
+uint64_t nativeNowMicros();
+
+// Fixed default seed like the core's, so runs stay reproducible
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// ===== String =====
+
+class String {
+public:
+    String(const char* text = "");
+    String(const String& other);
+    explicit String(char c);
+    explicit String(int value, unsigned char base = DEC);
+    explicit String(unsigned long value, unsigned char base = DEC);
+    ~String();
+
+    String& operator=(const String& other);
+    String& operator=(const char* text);
+
+    String& operator+=(const String& other) { append(other.buffer, other.len); return *this; }
+    String& operator+=(const char* text) { append(text, strlen(text)); return *this; }
+    String& operator+=(char c) { append(&c, 1); return *this; }
+
+    friend String operator+(const String& lhs, const String& rhs);
+    friend String operator+(const String& lhs, const char* rhs);
+
+    bool operator==(const String& other) const { return strcmp(buffer, other.buffer) == 0; }
+    bool operator==(const char* text) const { return strcmp(buffer, text) == 0; }
+    bool operator!=(const String& other) const { return !(*this == other); }
+    bool operator!=(const char* text) const { return !(*this == text); }
+
+    unsigned int length() const { return len; }
+    const char* c_str() const { return buffer; }
+    char operator[](unsigned int index) const { return index < len ? buffer[index] : '\0'; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& text, unsigned int from = 0) const;
+    bool startsWith(const String& prefix) const;
+    String substring(unsigned int from) const { return substring(from, len); }
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    long toInt() const { return atol(buffer); }
+
+private:
+    char* buffer;
+    unsigned int len;
+    unsigned int capacity;
+
+    void assign(const char* text, size_t length);
+    void append(const char* text, size_t length);
+    void reserve(size_t length);
+};
+
+// ===== Print / Stream =====
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length);
+
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+    size_t println() { return write("\r\n"); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    bool fromString(const char* text);
+    String toString() const;
+
+    uint8_t operator[](int index) const { return octets[index]; }
+
+    bool operator==(const IPAddress& other) const { return memcmp(octets, other.octets, 4) == 0; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+private:
+    uint8_t octets[4];
+};
+
+// Same virtual interface as the core's Client, with do-nothing defaults
+class Client : public Stream {
+public:
+    virtual int connect(IPAddress, uint16_t) { return 0; }
+    virtual int connect(const char*, uint16_t) { return 0; }
+    virtual uint8_t connected() { return 0; }
+    virtual void stop() {}
+    virtual operator bool() { return connected(); }
+    virtual int read(uint8_t* buf, size_t size);
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+    using Stream::read;
+};
+
+/**
+ * Serial port with a byte FIFO standing in for the core's interrupt buffer
+ *
+ * inject() plays the UART RX interrupt: it accepts bytes up to the FIFO
+ * capacity and returns how many it took (the rest would have been lost on
+ * hardware). Output is counted and dropped unless echo is on.
+ */
+class NativeSerial : public Stream {
+public:
+    explicit NativeSerial(const char* name);
+
+    void begin(unsigned long baud) { this->baud = baud; }
+    void end() {}
+    operator bool() const { return true; }
+
+    int available() override { return (int)rxCount; }
+    int read() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+    int availableForWrite() const { return NATIVE_SERIAL_FIFO_SIZE; }     // TX completes at once
+
+    size_t inject(const uint8_t* data, size_t length);
+    void setEcho(bool enabled) { echo = enabled; }
+    unsigned long getBaud() const { return baud; }
+    uint32_t getBytesWritten() const { return txBytes; }
+
+private:
+    const char* name;
+    unsigned long baud;
+    bool echo;
+    uint8_t rx[NATIVE_SERIAL_FIFO_SIZE];
+    size_t rxHead;
+    size_t rxCount;
+    uint32_t txBytes;
+};
+
+extern NativeSerial Serial;
+extern NativeSerial Serial1;
@@ -0,0 +1,60 @@
+#pragma once
+
+// Host stand-in for ArduinoMqttClient: messages are counted into
+// nativeNetwork instead of going to a broker. connect() and connected()
+// go through the Client it was built with, as in the library.
+// Messages on a subscribed topic come back through poll(), like a broker
+// echoing a client's own publishes.
+
+#include <WiFiS3.h>
+#include <string>
+#include <vector>
+#include <deque>
+
+class MqttClient : public Client {
+public:
+    explicit MqttClient(Client& transport) : transport(transport) {}
+
+    void onMessage(void (*callback)(int)) { this->callback = callback; }
+    void setId(const char*) {}
+    void setUsernamePassword(const char*, const char*) {}
+    void setConnectionTimeout(unsigned long) {}
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    uint8_t connected() override;
+    void stop() override;
+    void poll();
+    int subscribe(const char* topic);
+    int unsubscribe(const char* topic);
+
+    int beginMessage(const char* topic, bool retain = false, uint8_t qos = 0, bool dup = false);
+    int endMessage();
+    String messageTopic() const { return String(incomingTopic.c_str()); }
+
+    int available() override { return (int)(incoming.size() - incomingRead); }
+    int read() override { return incomingRead < incoming.size() ? incoming[incomingRead++] : -1; }
+    size_t write(uint8_t) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+
+private:
+    struct Message {
+        std::string topic;
+        std::vector<uint8_t> payload;
+    };
+
+    Client& transport;
+    void (*callback)(int) = nullptr;
+    bool session = false;
+    bool building = false;
+    size_t messageBytes = 0;
+
+    std::vector<std::string> subscriptions;
+    bool echoing = false;               // Current message goes to a subscribed topic
+    Message outgoing;
+    std::deque<Message> echoes;
+    std::string incomingTopic;
+    std::vector<uint8_t> incoming;
+    size_t incomingRead = 0;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+// Host stand-in for the UNO R4 WiFi EEPROM emulation (8KB data flash)
+
+#include <Arduino.h>
+
+#define NATIVE_EEPROM_SIZE 8192
+
+class EEPROMClass {
+public:
+    EEPROMClass() { memset(cells, 0xFF, sizeof(cells)); }
+
+    uint8_t read(int address) const { return inRange(address) ? cells[address] : 0xFF; }
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value) { if (read(address) != value) write(address, value); }
+    uint16_t length() const { return NATIVE_EEPROM_SIZE; }
+
+    uint32_t getWrites() const { return writes; }
+
+private:
+    uint8_t cells[NATIVE_EEPROM_SIZE];
+    uint32_t writes = 0;
+
+    static bool inRange(int address) { return address >= 0 && address < NATIVE_EEPROM_SIZE; }
+};
+
+extern EEPROMClass EEPROM;
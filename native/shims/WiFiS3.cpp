@@ -0,0 +1,141 @@
+#include <WiFiS3.h>
+#include <WiFiUdp.h>
+#include <ArduinoMqttClient.h>
+
+NativeWiFi WiFi;
+NativeNetwork nativeNetwork = { true, true, 0, 0, 0, 0 };
+
+int WiFiClient::open() {
+    session = nativeNetwork.wifiUp && nativeNetwork.brokerUp;
+    return session ? 1 : 0;
+}
+
+uint8_t WiFiClient::connected() {
+    if (!nativeNetwork.wifiUp || !nativeNetwork.brokerUp) session = false;
+    return session ? 1 : 0;
+}
+
+int NativeWiFi::begin(const char*, const char*) {
+    return status();
+}
+
+int NativeWiFi::status() {
+    return nativeNetwork.wifiUp ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+void NativeWiFi::disconnect() {
+}
+
+uint8_t* NativeWiFi::BSSID(uint8_t* bssid) {
+    static const uint8_t AP[6] = { 0x0A, 0xCE, 0x42, 0x10, 0x00, 0x01 };
+    for (uint8_t i = 0; i < 6; i++) bssid[i] = AP[5 - i];
+    return bssid;
+}
+
+uint8_t* NativeWiFi::macAddress(uint8_t* mac) {
+    static const uint8_t STA[6] = { 0x34, 0x85, 0x18, 0x5C, 0x2D, 0x70 };
+    for (uint8_t i = 0; i < 6; i++) mac[i] = STA[5 - i];
+    return mac;
+}
+
+// Every name resolves to the same LAN address
+int NativeWiFi::hostByName(const char*, IPAddress& address) {
+    if (!nativeNetwork.wifiUp) return 0;
+    address = IPAddress(192, 168, 1, 10);
+    return 1;
+}
+
+int WiFiUDP::endPacket() {
+    size_t length = pending;
+    pending = 0;
+    if (!nativeNetwork.wifiUp) return 0;
+    nativeNetwork.syslogDatagrams++;
+    nativeNetwork.syslogBytes += length;
+    return 1;
+}
+
+int MqttClient::connect(IPAddress ip, uint16_t port) {
+    // Like the library: drop a client that reports connected, then dial
+    if (transport.connected()) transport.stop();
+    session = transport.connect(ip, port) > 0;
+    return session ? 1 : 0;
+}
+
+int MqttClient::connect(const char* host, uint16_t port) {
+    if (transport.connected()) transport.stop();
+    session = transport.connect(host, port) > 0;
+    return session ? 1 : 0;
+}
+
+uint8_t MqttClient::connected() {
+    if (!transport.connected()) session = false;
+    return session ? 1 : 0;
+}
+
+void MqttClient::stop() {
+    session = false;
+    transport.stop();
+}
+
+int MqttClient::subscribe(const char* topic) {
+    if (!connected()) return 0;
+    subscriptions.push_back(topic);
+    return 1;
+}
+
+int MqttClient::unsubscribe(const char* topic) {
+    for (size_t i = 0; i < subscriptions.size(); i++) {
+        if (subscriptions[i] == topic) {
+            subscriptions.erase(subscriptions.begin() + i);
+            break;
+        }
+    }
+    return connected();
+}
+
+void MqttClient::poll() {
+    while (callback && !echoes.empty() && connected()) {
+        incomingTopic = echoes.front().topic;
+        incoming = echoes.front().payload;
+        incomingRead = 0;
+        echoes.pop_front();
+        callback((int)incoming.size());
+    }
+}
+
+int MqttClient::beginMessage(const char* topic, bool, uint8_t, bool) {
+    if (!connected()) return 0;
+    building = true;
+    messageBytes = strlen(topic);
+
+    echoing = false;
+    for (const std::string& subscription : subscriptions) {
+        if (subscription == topic) echoing = true;
+    }
+    if (echoing) {
+        outgoing.topic = topic;
+        outgoing.payload.clear();
+    }
+    return 1;
+}
+
+int MqttClient::endMessage() {
+    if (!building) return 0;
+    building = false;
+    if (!connected()) return 0;
+    nativeNetwork.mqttMessages++;
+    nativeNetwork.mqttBytes += messageBytes;
+    if (echoing) echoes.push_back(outgoing);
+    return 1;
+}
+
+size_t MqttClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t MqttClient::write(const uint8_t* data, size_t length) {
+    if (!building) return 0;
+    messageBytes += length;
+    if (echoing) outgoing.payload.insert(outgoing.payload.end(), data, data + length);
+    return length;
+}
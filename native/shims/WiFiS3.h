@@ -0,0 +1,69 @@
+#pragma once
+
+// Host stand-in for the WiFiS3 library: the radio is always associated
+// unless the bench takes it down with nativeNetwork.wifiUp = false.
+
+#include <Arduino.h>
+
+enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+};
+
+// The broker socket: connects while nativeNetwork.wifiUp and brokerUp are set
+class WiFiClient : public Client {
+public:
+    int connect(IPAddress, uint16_t) override { return open(); }
+    int connect(const char*, uint16_t) override { return open(); }
+    uint8_t connected() override;
+    void stop() override { session = false; }
+    void setConnectionTimeout(int) {}
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+
+private:
+    bool session = false;
+    int open();
+};
+
+class NativeWiFi {
+public:
+    int begin(const char* ssid, const char* pass);
+    int status();
+    void disconnect();
+    IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+    IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+    IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+    IPAddress dnsIP(int = 0) { return IPAddress(192, 168, 1, 1); }
+    uint8_t* BSSID(uint8_t* bssid);
+    uint8_t* macAddress(uint8_t* mac);
+    long RSSI() { return -60; }
+    void config(IPAddress) {}
+    void config(IPAddress, IPAddress, IPAddress, IPAddress) {}
+    int hostByName(const char* host, IPAddress& address);
+    void setHostname(const char*) {}
+};
+
+/**
+ * Network conditions and traffic seen by the shims
+ */
+struct NativeNetwork {
+    bool wifiUp;
+    bool brokerUp;
+
+    uint32_t mqttMessages;          // endMessage() calls while connected
+    uint32_t mqttBytes;             // Topic + payload bytes
+    uint32_t syslogDatagrams;
+    uint32_t syslogBytes;
+};
+
+extern NativeWiFi WiFi;
+extern NativeNetwork nativeNetwork;
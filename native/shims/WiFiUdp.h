@@ -0,0 +1,19 @@
+#pragma once
+
+// Host stand-in for WiFiUDP: datagrams are counted, not sent
+
+#include <WiFiS3.h>
+
+class WiFiUDP : public Print {
+public:
+    uint8_t begin(uint16_t) { return 1; }
+    int beginPacket(const char*, uint16_t) { return nativeNetwork.wifiUp ? 1 : 0; }
+    int beginPacket(IPAddress, uint16_t) { return nativeNetwork.wifiUp ? 1 : 0; }
+    int endPacket();
+    size_t write(uint8_t) override { pending++; return 1; }
+    size_t write(const uint8_t*, size_t length) override { pending += length; return length; }
+    using Print::write;
+
+private:
+    size_t pending = 0;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+// Host stand-in for TwoWire: an empty bus, every address NACKs.
+// Enough for sensor drivers to build and take their "not found" paths.
+
+#include <Arduino.h>
+
+class TwoWire : public Stream {
+public:
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t) {}
+    uint8_t endTransmission(bool = true) { return 2; }     // Address NACK
+    uint8_t requestFrom(uint8_t, size_t, bool = true) { return 0; }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,56 @@
+#include "boot_timeline.h"
+#include "response_sink.h"
+#include "logger.h"
+#include <string.h>
+
+static const char* const BOOT_MILESTONE_NAMES[BOOT_MILESTONE_COUNT] = {
+    "loop", "first sample", "wifi", "mqtt"
+};
+
+BootTimeline::BootTimeline()
+    : stageCount(0)
+    , reached(0) {
+
+    memset(stages, 0, sizeof(stages));
+    memset(milestoneMs, 0, sizeof(milestoneMs));
+}
+
+void BootTimeline::stage(const char* name) {
+    if (stageCount >= BOOT_MAX_STAGES) return;
+
+    stages[stageCount].name = name;
+    stages[stageCount].endMs = millis();
+    stageCount++;
+}
+
+void BootTimeline::reach(BootMilestone milestone) {
+    if (milestone >= BOOT_MILESTONE_COUNT || isReached(milestone)) return;
+
+    milestoneMs[milestone] = millis();
+    reached |= 1 << milestone;
+    LOG_INFO("Boot: %s after %lu ms", BOOT_MILESTONE_NAMES[milestone], (unsigned long)milestoneMs[milestone]);
+}
+
+unsigned long BootTimeline::getSetupMs() const {
+    return stageCount > 0 ? stages[stageCount - 1].endMs : 0;
+}
+
+void BootTimeline::getReport(ResponseSink& out) const {
+    out.printf("boot: setup %lu ms", getSetupMs());
+
+    out.print("\r\nstage          ms    at");
+    uint32_t startMs = 0;
+    for (uint8_t i = 0; i < stageCount; i++) {
+        out.printf("\r\n%-12s %5lu %5lu", stages[i].name,
+            (unsigned long)(stages[i].endMs - startMs), (unsigned long)stages[i].endMs);
+        startMs = stages[i].endMs;
+    }
+
+    for (uint8_t m = 0; m < BOOT_MILESTONE_COUNT; m++) {
+        if (isReached((BootMilestone)m)) {
+            out.printf("\r\n%-12s       %5lu", BOOT_MILESTONE_NAMES[m], (unsigned long)milestoneMs[m]);
+        } else {
+            out.printf("\r\n%-12s       pending", BOOT_MILESTONE_NAMES[m]);
+        }
+    }
+}
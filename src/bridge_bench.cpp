@@ -0,0 +1,211 @@
+#include "bridge_bench.h"
+#include "response_sink.h"
+#include <string.h>
+
+static const uint16_t BENCH_RAMP_RATES[BENCH_MAX_STEPS] = { 10, 20, 50, 100, 200, 300, 500, 750, 1000 };
+
+static const char* const BENCH_STAGE_NAMES[BENCH_STAGE_COUNT] = { "wait", "forward", "decode", "echo" };
+
+// Wrap-safe "time reached" test for micros() values
+static inline bool reached(unsigned long now, unsigned long deadline) {
+    return (long)(now - deadline) >= 0;
+}
+
+BridgeBench::BridgeBench()
+    : phase(PHASE_IDLE)
+    , ramp(false)
+    , stepCount(0)
+    , stepIndex(0)
+    , stepMs(0)
+    , phaseStartMs(0)
+    , periodUs(0)
+    , nextDueUs(0)
+    , sequence(0) {
+
+    memset(steps, 0, sizeof(steps));
+}
+
+bool BridgeBench::start(uint16_t rateHz, uint16_t seconds) {
+    if (rateHz < BENCH_MIN_RATE_HZ || rateHz > BENCH_MAX_RATE_HZ ||
+        seconds == 0 || seconds > BENCH_MAX_SECONDS) {
+        return false;
+    }
+
+    ramp = false;
+    stepCount = 1;
+    stepMs = (unsigned long)seconds * 1000;
+    beginStep(0, rateHz);
+    return true;
+}
+
+void BridgeBench::startRamp() {
+    ramp = true;
+    stepCount = 0;
+    stepMs = BENCH_RAMP_STEP_MS;
+    beginStep(0, BENCH_RAMP_RATES[0]);
+}
+
+void BridgeBench::stop() {
+    if (isRunning()) phase = PHASE_DONE;
+}
+
+void BridgeBench::beginStep(uint8_t index, uint16_t rateHz) {
+    stepIndex = index;
+    if (index >= stepCount) stepCount = index + 1;
+
+    memset(&steps[index], 0, sizeof(steps[index]));
+    steps[index].rateHz = rateHz;
+    for (uint8_t s = 0; s < BENCH_STAGE_COUNT; s++) {
+        stages[s].reset();
+    }
+
+    periodUs = 1000000UL / rateHz;
+    nextDueUs = micros();
+    phaseStartMs = millis();
+    phase = PHASE_RUNNING;
+}
+
+uint8_t BridgeBench::framesDue(unsigned long nowUs) {
+    if (phase != PHASE_RUNNING) return 0;
+
+    uint8_t due = 0;
+    while (due < BENCH_MAX_CATCHUP && reached(nowUs, nextDueUs)) {
+        nextDueUs += periodUs;
+        due++;
+    }
+
+    // Still behind: the loop cannot keep this rate, skip ahead
+    if (reached(nowUs, nextDueUs)) {
+        unsigned long behind = (nowUs - nextDueUs) / periodUs + 1;
+        step().missed += behind;
+        nextDueUs += behind * periodUs;
+    }
+    return due;
+}
+
+void BridgeBench::buildFrame(uint8_t* frame, unsigned long nowUs) {
+    uint32_t stamp = (uint32_t)nowUs;
+    float psi = 1000.0f + sequence;
+
+    // [SIZE][TYPE][SEQ][TIMESTAMP u32][pin][flags][raw u16][psi f32]
+    frame[0] = BENCH_FRAME_LENGTH - 1;
+    frame[1] = BENCH_FRAME_TYPE;
+    frame[2] = sequence++;
+    frame[3] = (uint8_t)stamp;
+    frame[4] = (uint8_t)(stamp >> 8);
+    frame[5] = (uint8_t)(stamp >> 16);
+    frame[6] = (uint8_t)(stamp >> 24);
+    frame[7] = BENCH_STEP_MARKER + stepIndex;
+    frame[8] = 0;
+    frame[9] = frame[2];
+    frame[10] = 0;
+    memcpy(frame + 11, &psi, sizeof(psi));
+}
+
+bool BridgeBench::isBenchFrame(const uint8_t* data, size_t length) const {
+    return length == BENCH_FRAME_LENGTH && data[0] == BENCH_FRAME_LENGTH - 1 &&
+           data[1] == BENCH_FRAME_TYPE && (uint8_t)(data[7] - BENCH_STEP_MARKER) < BENCH_MAX_STEPS;
+}
+
+uint32_t BridgeBench::injectedAt(const uint8_t* data) const {
+    return (uint32_t)data[3] | ((uint32_t)data[4] << 8) | ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 24);
+}
+
+void BridgeBench::recordForward(bool success, uint32_t us) {
+    stages[BENCH_STAGE_FORWARD].update(us);
+    if (!success) step().forwardFailures++;
+}
+
+void BridgeBench::onEcho(const uint8_t* data, size_t length) {
+    if (!isRunning() || !isBenchFrame(data, length)) return;
+
+    // Echoes of an earlier step arrived after its settle time: lost for that step
+    if (data[7] != BENCH_STEP_MARKER + stepIndex) return;
+
+    stages[BENCH_STAGE_ECHO].update((uint32_t)micros() - injectedAt(data));
+    step().echoed++;
+}
+
+bool BridgeBench::isClean(const StepResult& result) const {
+    return result.injected > 0 &&
+           result.deferred == 0 && result.missed == 0 && result.forwardFailures == 0 &&
+           (uint64_t)result.echoed * 100 >= (uint64_t)result.injected * BENCH_CLEAN_ECHO_PERCENT;
+}
+
+uint16_t BridgeBench::maxCleanRate() const {
+    uint16_t best = 0;
+    for (uint8_t i = 0; i < stepCount; i++) {
+        if (isClean(steps[i]) && steps[i].rateHz > best) best = steps[i].rateHz;
+    }
+    return best;
+}
+
+bool BridgeBench::service(unsigned long nowMs) {
+    if (phase == PHASE_RUNNING && nowMs - phaseStartMs >= stepMs) {
+        phase = PHASE_SETTLING;
+        phaseStartMs = nowMs;
+        return false;
+    }
+
+    if (phase != PHASE_SETTLING || nowMs - phaseStartMs < BENCH_SETTLE_MS) return false;
+
+    StepResult& result = step();
+    result.echoP50Us = stages[BENCH_STAGE_ECHO].percentile(50);
+    result.echoP99Us = stages[BENCH_STAGE_ECHO].percentile(99);
+
+    if (ramp && isClean(result) && stepIndex + 1 < BENCH_MAX_STEPS) {
+        beginStep(stepIndex + 1, BENCH_RAMP_RATES[stepIndex + 1]);
+        return false;
+    }
+
+    phase = PHASE_DONE;
+    return true;
+}
+
+void BridgeBench::getReport(ResponseSink& out) {
+    if (phase == PHASE_IDLE) {
+        out.print("bridge bench: idle (use 'bridge bench <rate_hz> [seconds]' or 'bridge bench ramp')");
+        return;
+    }
+
+    if (isRunning()) {
+        out.printf("bridge bench: %s step %u/%u at %uHz",
+            phase == PHASE_RUNNING ? "running" : "settling",
+            stepIndex + 1, ramp ? BENCH_MAX_STEPS : 1, steps[stepIndex].rateHz);
+    } else {
+        out.print("bridge bench: done");
+    }
+
+    uint16_t best = maxCleanRate();
+    if (best > 0) {
+        out.printf(", max sustained rate %uHz", best);
+    } else {
+        out.print(", no clean step");
+    }
+
+    out.print("\r\nstep  rate  sent  deferred  missed  fwdfail  echoed  echo p50/p99 us");
+    for (uint8_t i = 0; i < stepCount; i++) {
+        const StepResult& result = steps[i];
+        out.printf("\r\n%4u %5u %5lu %9lu %7lu %8lu %7lu  %lu/%lu%s",
+            i + 1, result.rateHz, (unsigned long)result.injected, (unsigned long)result.deferred,
+            (unsigned long)result.missed, (unsigned long)result.forwardFailures,
+            (unsigned long)result.echoed, (unsigned long)result.echoP50Us,
+            (unsigned long)result.echoP99Us, isClean(result) ? "" : " *");
+    }
+
+    // Stage latencies are kept for the current (or last) step only
+    out.printf("\r\nstages at %uHz:", steps[stepIndex].rateHz);
+    for (uint8_t s = 0; s < BENCH_STAGE_COUNT; s++) {
+        const LatencyHistogram<BENCH_HISTOGRAM_OCTAVES>& stage = stages[s];
+        out.printf("\r\n%-8s n=%lu p50=%luus p99=%luus mean=%luus max=%luus",
+            BENCH_STAGE_NAMES[s], (unsigned long)stage.getCount(),
+            (unsigned long)stage.percentile(50), (unsigned long)stage.percentile(99),
+            (unsigned long)stage.getMean(), (unsigned long)stage.getMax());
+    }
+
+    // Loop time the bridge spends per frame at this rate (wait and echo are not CPU)
+    uint32_t busyUs = stages[BENCH_STAGE_FORWARD].getMean() + stages[BENCH_STAGE_DECODE].getMean();
+    uint32_t permille = (uint32_t)(((uint64_t)busyUs * steps[stepIndex].rateHz + 500) / 1000);
+    out.printf("\r\nbridge busy: %lu.%lu%% of loop time (forward + decode)",
+        (unsigned long)(permille / 10), (unsigned long)(permille % 10));
+}
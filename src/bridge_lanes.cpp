@@ -0,0 +1,147 @@
+#include "bridge_lanes.h"
+#include "protobuf_decoder.h"
+#include "response_sink.h"
+#include <string.h>
+
+// Lane per controller message type 0x10-0x17
+static const BridgeLane LANE_BY_TYPE[PROTOBUF_MESSAGE_TYPE_COUNT] = {
+    LANE_EVENT,         // 0x10 Digital Input
+    LANE_EVENT,         // 0x11 Digital Output
+    LANE_EVENT,         // 0x12 Relay Event
+    LANE_ROUTINE,       // 0x13 Pressure
+    LANE_CRITICAL,      // 0x14 System Error
+    LANE_CRITICAL,      // 0x15 Safety Event
+    LANE_ROUTINE,       // 0x16 System Status
+    LANE_EVENT          // 0x17 Sequence Event
+};
+
+static const uint8_t LANE_CAPACITY[LANE_COUNT] = { 0, BRIDGE_EVENT_LANE_SLOTS, BRIDGE_ROUTINE_LANE_SLOTS };
+
+static const char* const LANE_NAMES[LANE_COUNT] = { "critical", "event", "routine" };
+
+static const uint8_t PRESSURE_MESSAGE_TYPE = 0x13;
+
+BridgeLanes::BridgeLanes()
+    : nextOrder(0)
+    , lastRoutineSend(0) {
+
+    memset(slots, 0, sizeof(slots));
+    memset(depth, 0, sizeof(depth));
+    for (uint8_t l = 0; l < LANE_COUNT; l++) {
+        LaneStats& lane = stats[l];
+        lane.sent = lane.stored = lane.dropped = lane.coalesced = lane.early = 0;
+        lane.peak = 0;
+    }
+}
+
+BridgeLane BridgeLanes::laneOf(const uint8_t* frame, size_t length) {
+    if (length < 2) return LANE_EVENT;
+    uint8_t index = (uint8_t)(frame[1] - PROTOBUF_FIRST_MESSAGE_TYPE);
+    // Unknown types are forwarded in order, without coalescing
+    return index < PROTOBUF_MESSAGE_TYPE_COUNT ? LANE_BY_TYPE[index] : LANE_EVENT;
+}
+
+uint16_t BridgeLanes::coalesceKey(const uint8_t* frame, size_t length) {
+    uint16_t key = (uint16_t)frame[1] << 8;
+    // Pressure frames carry one sensor each: keep the latest per pin
+    if (frame[1] == PRESSURE_MESSAGE_TYPE && length > 7) key |= frame[7];
+    return key;
+}
+
+bool BridgeLanes::enqueue(BridgeLane lane, const uint8_t* frame, size_t length, uint32_t nowUs) {
+    if (lane == LANE_CRITICAL || length < 2 || length > BRIDGE_LANE_FRAME_SIZE) return false;
+
+    uint16_t key = coalesceKey(frame, length);
+    if (lane == LANE_ROUTINE) {
+        for (uint8_t i = 0; i < BRIDGE_LANE_SLOTS; i++) {
+            Slot& slot = slots[i];
+            if (slot.used && slot.lane == LANE_ROUTINE && slot.key == key) {
+                memcpy(slot.data, frame, length);
+                slot.length = (uint8_t)length;
+                slot.queuedUs = nowUs;
+                stats[LANE_ROUTINE].coalesced++;
+                return true;
+            }
+        }
+    }
+
+    if (depth[lane] >= LANE_CAPACITY[lane]) return false;
+
+    for (uint8_t i = 0; i < BRIDGE_LANE_SLOTS; i++) {
+        Slot& slot = slots[i];
+        if (!slot.used) {
+            memcpy(slot.data, frame, length);
+            slot.length = (uint8_t)length;
+            slot.lane = lane;
+            slot.used = true;
+            slot.key = key;
+            slot.order = nextOrder++;
+            slot.queuedUs = nowUs;
+            depth[lane]++;
+            if (depth[lane] > stats[lane].peak) stats[lane].peak = depth[lane];
+            return true;
+        }
+    }
+    return false;
+}
+
+int8_t BridgeLanes::oldest(BridgeLane lane) const {
+    int8_t found = -1;
+    if (depth[lane] == 0) return found;
+
+    for (uint8_t i = 0; i < BRIDGE_LANE_SLOTS; i++) {
+        if (slots[i].used && slots[i].lane == lane &&
+            (found < 0 || (int32_t)(slots[i].order - slots[found].order) < 0)) {
+            found = (int8_t)i;
+        }
+    }
+    return found;
+}
+
+int8_t BridgeLanes::due(unsigned long nowMs) const {
+    int8_t slot = oldest(LANE_EVENT);
+    if (slot >= 0) return slot;
+
+    if (nowMs - lastRoutineSend < BRIDGE_ROUTINE_INTERVAL_MS) return -1;
+    return oldest(LANE_ROUTINE);
+}
+
+void BridgeLanes::release(uint8_t slot, LaneOutcome outcome, uint32_t nowUs, unsigned long nowMs) {
+    Slot& entry = slots[slot];
+    if (!entry.used) return;
+
+    record(entry.lane, outcome, nowUs - entry.queuedUs);
+    if (entry.lane == LANE_ROUTINE && outcome == LANE_SENT) lastRoutineSend = nowMs;
+
+    entry.used = false;
+    if (depth[entry.lane] > 0) depth[entry.lane]--;
+}
+
+void BridgeLanes::record(BridgeLane lane, LaneOutcome outcome, uint32_t latencyUs) {
+    LaneStats& counters = stats[lane];
+    switch (outcome) {
+        case LANE_SENT:
+            counters.sent++;
+            counters.latency.update(latencyUs);
+            break;
+        case LANE_STORED:
+            counters.stored++;
+            break;
+        case LANE_DROPPED:
+            counters.dropped++;
+            break;
+    }
+}
+
+void BridgeLanes::getReport(ResponseSink& out) {
+    out.print("lane        sent  coalesced  early  stored  dropped  depth/peak  latency p50/p99/max us");
+    for (uint8_t l = 0; l < LANE_COUNT; l++) {
+        const LaneStats& lane = stats[l];
+        out.printf("\r\n%-8s %7lu %10lu %6lu %7lu %8lu %6u/%-4u  %lu/%lu/%lu",
+            LANE_NAMES[l], (unsigned long)lane.sent, (unsigned long)lane.coalesced,
+            (unsigned long)lane.early, (unsigned long)lane.stored, (unsigned long)lane.dropped,
+            depth[l], lane.peak,
+            (unsigned long)lane.latency.percentile(50), (unsigned long)lane.latency.percentile(99),
+            (unsigned long)lane.latency.getMax());
+    }
+}
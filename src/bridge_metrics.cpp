@@ -0,0 +1,142 @@
+#include "bridge_metrics.h"
+#include "response_sink.h"
+#include <string.h>
+
+static const char* const DROP_NAMES[DROP_COUNT] = { "publish", "offline", "parse", "overrun" };
+
+// Windows shown by getReport()
+static const uint16_t REPORT_WINDOWS[] = { 10, 60, BRIDGE_METRICS_SECONDS - 1 };
+
+BridgeMetrics::BridgeMetrics()
+    : current(0)
+    , currentSecond(0)
+    , filled(0) {
+
+    memset(buckets, 0, sizeof(buckets));
+}
+
+BridgeMetrics::Bucket& BridgeMetrics::advance(unsigned long nowMs) {
+    unsigned long second = nowMs / 1000;
+    unsigned long elapsed = second - currentSecond;
+
+    if (elapsed > 0) {
+        // Clear every bucket skipped while idle, at most the whole ring
+        uint16_t steps = elapsed < BRIDGE_METRICS_SECONDS ? (uint16_t)elapsed : BRIDGE_METRICS_SECONDS;
+        for (uint16_t i = 0; i < steps; i++) {
+            current = (uint8_t)((current + 1) % BRIDGE_METRICS_SECONDS);
+            memset(&buckets[current], 0, sizeof(Bucket));
+        }
+        filled += elapsed < BRIDGE_METRICS_SECONDS ? (uint16_t)elapsed : BRIDGE_METRICS_SECONDS;
+        if (filled > BRIDGE_METRICS_SECONDS - 1) filled = BRIDGE_METRICS_SECONDS - 1;
+        currentSecond = second;
+    }
+    return buckets[current];
+}
+
+static inline void addSaturating(uint16_t& counter, uint32_t amount) {
+    uint32_t sum = counter + amount;
+    counter = sum > UINT16_MAX ? UINT16_MAX : (uint16_t)sum;
+}
+
+void BridgeMetrics::recordFrame(size_t bytes, unsigned long nowMs) {
+    Bucket& bucket = advance(nowMs);
+    addSaturating(bucket.framesIn, 1);
+    addSaturating(bucket.bytesIn, (uint32_t)bytes);
+}
+
+void BridgeMetrics::recordPublish(uint32_t latencyUs, unsigned long nowMs) {
+    Bucket& bucket = advance(nowMs);
+    addSaturating(bucket.published, 1);
+    addSaturating(bucket.latency[latencyBucket(latencyUs)], 1);
+}
+
+void BridgeMetrics::recordDrop(BridgeDrop reason, unsigned long nowMs) {
+    if (reason >= DROP_COUNT) return;
+    addSaturating(advance(nowMs).drops[reason], 1);
+}
+
+uint8_t BridgeMetrics::latencyBucket(uint32_t us) {
+    uint8_t bucket = 0;
+    uint32_t bound = BRIDGE_METRICS_LATENCY_BASE_US;
+    while (bucket < BRIDGE_METRICS_LATENCY_BUCKETS - 1 && us >= bound) {
+        bucket++;
+        bound <<= 1;
+    }
+    return bucket;
+}
+
+uint32_t BridgeMetrics::bucketUpperUs(uint8_t bucket) {
+    return (uint32_t)BRIDGE_METRICS_LATENCY_BASE_US << bucket;
+}
+
+uint32_t BridgeMetrics::percentile(const uint32_t* histogram, uint32_t count, uint8_t percent) {
+    if (count == 0) return 0;
+
+    uint32_t target = (uint32_t)(((uint64_t)count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < BRIDGE_METRICS_LATENCY_BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen >= target) return bucketUpperUs(b);
+    }
+    return bucketUpperUs(BRIDGE_METRICS_LATENCY_BUCKETS - 1);
+}
+
+void BridgeMetrics::summarize(uint16_t seconds, unsigned long nowMs, Summary& summary) {
+    advance(nowMs);
+    memset(&summary, 0, sizeof(summary));
+
+    // The second in progress is left out: it would read as a rate dip
+    if (seconds > filled) seconds = filled;
+    summary.seconds = seconds;
+
+    uint32_t histogram[BRIDGE_METRICS_LATENCY_BUCKETS] = {};
+    uint32_t samples = 0;
+    for (uint16_t i = 1; i <= seconds; i++) {
+        const Bucket& bucket = buckets[(current + BRIDGE_METRICS_SECONDS - i) % BRIDGE_METRICS_SECONDS];
+        summary.framesIn += bucket.framesIn;
+        summary.bytesIn += bucket.bytesIn;
+        summary.published += bucket.published;
+        for (uint8_t d = 0; d < DROP_COUNT; d++) summary.drops[d] += bucket.drops[d];
+        for (uint8_t b = 0; b < BRIDGE_METRICS_LATENCY_BUCKETS; b++) {
+            histogram[b] += bucket.latency[b];
+            samples += bucket.latency[b];
+        }
+    }
+
+    if (seconds > 0) {
+        summary.inRate = (float)summary.framesIn / seconds;
+        summary.byteRate = (float)summary.bytesIn / seconds;
+        summary.publishRate = (float)summary.published / seconds;
+    }
+    summary.p50Us = percentile(histogram, samples, 50);
+    summary.p95Us = percentile(histogram, samples, 95);
+    summary.p99Us = percentile(histogram, samples, 99);
+}
+
+void BridgeMetrics::getReport(ResponseSink& out, unsigned long nowMs) {
+    out.print("window   in/s    B/s  pub/s  drops pub/off/parse/ovr  publish p50/p95/p99 us");
+    for (size_t w = 0; w < sizeof(REPORT_WINDOWS) / sizeof(REPORT_WINDOWS[0]); w++) {
+        Summary summary;
+        summarize(REPORT_WINDOWS[w], nowMs, summary);
+        out.printf("\r\n%4us %7.1f %6.0f %6.1f  %5lu/%lu/%lu/%lu  %8lu/%lu/%lu",
+            summary.seconds, summary.inRate, summary.byteRate, summary.publishRate,
+            (unsigned long)summary.drops[DROP_PUBLISH], (unsigned long)summary.drops[DROP_OFFLINE],
+            (unsigned long)summary.drops[DROP_PARSE], (unsigned long)summary.drops[DROP_OVERRUN],
+            (unsigned long)summary.p50Us, (unsigned long)summary.p95Us, (unsigned long)summary.p99Us);
+    }
+}
+
+void BridgeMetrics::getSummaryJson(char* buffer, size_t bufferSize, uint16_t seconds, unsigned long nowMs) {
+    if (!buffer || bufferSize == 0) return;
+
+    Summary summary;
+    summarize(seconds, nowMs, summary);
+    int n = snprintf(buffer, bufferSize,
+        "{\"s\":%u,\"in\":%.2f,\"bps\":%.0f,\"pub\":%.2f,\"p50\":%lu,\"p95\":%lu,\"p99\":%lu",
+        summary.seconds, summary.inRate, summary.byteRate, summary.publishRate,
+        (unsigned long)summary.p50Us, (unsigned long)summary.p95Us, (unsigned long)summary.p99Us);
+    for (uint8_t d = 0; d < DROP_COUNT && n > 0 && (size_t)n < bufferSize; d++) {
+        n += snprintf(buffer + n, bufferSize - n, ",\"%s\":%lu", DROP_NAMES[d], (unsigned long)summary.drops[d]);
+    }
+    if (n > 0 && (size_t)n < bufferSize) snprintf(buffer + n, bufferSize - n, "}");
+}
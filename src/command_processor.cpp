@@ -2,19 +2,182 @@
 #include "lcd_display.h"
 #include "logger.h"
 #include "serial_bridge.h"
+#include "task_scheduler.h"
+#include "store_forward_log.h"
+#include "memory_monitor.h"
+#include "perf_profiler.h"
+#include "boot_timeline.h"
+#include "config_log.h"
+#include "i2c_bus.h"
+#include "telnet_server.h"
 #include <ctype.h>
 #include <string.h>
 #include <Wire.h>
 
-extern void debugPrintf(const char* fmt, ...);
 extern bool g_debugEnabled;
 extern LCDDisplay* g_lcdDisplay;
 extern SerialBridge serialBridge;
+extern TelnetServer telnetServer;
+extern MonitorConfigManager* g_monitorConfig;
 
 // Static data for rate limiting
 static unsigned long lastCommandTime = 0;
 static const unsigned long COMMAND_RATE_LIMIT_MS = 100; // 10 commands/second max
 
+// Command words and sub-parameters, kept sorted for binary search. One list
+// builds both the Keyword ids and the table, so an id is its table index.
+#define KW_COMMAND      0x01    // Accepted as a top-level command
+#define KW_SET_PARAM    0x02    // Accepted as a 'set' parameter
+
+#define COMMAND_KEYWORDS(X) \
+    X(BACKLIGHT,   "backlight",   0) \
+    X(BENCH,       "bench",       0) \
+    X(BOOT,        "boot",        0) \
+    X(BOTH,        "both",        0) \
+    X(BRIDGE,      "bridge",      KW_COMMAND) \
+    X(CALIBRATE,   "calibrate",   0) \
+    X(CLEAR,       "clear",       0) \
+    X(CMD,         "cmd",         0) \
+    X(CONFIG,      "config",      0) \
+    X(DEADBAND,    "deadband",    KW_SET_PARAM) \
+    X(DEBUG,       "debug",       KW_COMMAND | KW_SET_PARAM) \
+    X(DHCP,        "dhcp",        0) \
+    X(GET,         "get",         0) \
+    X(HEARTBEAT,   "heartbeat",   KW_SET_PARAM) \
+    X(HELP,        "help",        KW_COMMAND) \
+    X(HOSTNAME,    "hostname",    KW_SET_PARAM) \
+    X(I2C,         "i2c",         KW_COMMAND) \
+    X(INFO,        "info",        0) \
+    X(INPUTS,      "inputs",      0) \
+    X(INTERVAL,    "interval",    KW_SET_PARAM) \
+    X(LANES,       "lanes",       0) \
+    X(LCD,         "lcd",         KW_COMMAND) \
+    X(LIST,        "list",        0) \
+    X(LOAD,        "load",        0) \
+    X(LOCAL,       "local",       0) \
+    X(LOCALC,      "localc",      0) \
+    X(LOGLEVEL,    "loglevel",    KW_COMMAND | KW_SET_PARAM) \
+    X(LOSS,        "loss",        0) \
+    X(MEMORY,      "memory",      0) \
+    X(METRICS,     "metrics",     0) \
+    X(MONITOR,     "monitor",     KW_COMMAND) \
+    X(MQTT,        "mqtt",        KW_SET_PARAM) \
+    X(MUX,         "mux",         0) \
+    X(NAMESPACE,   "namespace",   KW_SET_PARAM) \
+    X(NETWORK,     "network",     KW_COMMAND) \
+    X(OFF,         "off",         0) \
+    X(OFFSET,      "offset",      0) \
+    X(ON,          "on",          0) \
+    X(OUTPUT,      "output",      0) \
+    X(OUTPUTS,     "outputs",     0) \
+    X(PACKED,      "packed",      KW_SET_PARAM) \
+    X(PERF,        "perf",        0) \
+    X(PINS,        "pins",        0) \
+    X(PROTOBUF,    "protobuf",    0) \
+    X(RAMP,        "ramp",        0) \
+    X(RATE,        "rate",        0) \
+    X(RATELIMIT,   "ratelimit",   KW_SET_PARAM) \
+    X(RAW,         "raw",         0) \
+    X(READ,        "read",        0) \
+    X(READC,       "readc",       0) \
+    X(REFRESH,     "refresh",     0) \
+    X(REINIT,      "reinit",      0) \
+    X(REMOTE,      "remote",      0) \
+    X(REMOTEC,     "remotec",     0) \
+    X(RESET,       "reset",       KW_COMMAND) \
+    X(SAVE,        "save",        0) \
+    X(SCAN,        "scan",        0) \
+    X(SEND,        "send",        0) \
+    X(SENSORS,     "sensors",     0) \
+    X(SET,         "set",         KW_COMMAND) \
+    X(SHOW,        "show",        KW_COMMAND) \
+    X(SITES,       "sites",       0) \
+    X(START,       "start",       0) \
+    X(STATE,       "state",       0) \
+    X(STATIC,      "static",      0) \
+    X(STATS,       "stats",       0) \
+    X(STATUS,      "status",      KW_COMMAND) \
+    X(STOP,        "stop",        0) \
+    X(SYSLOG,      "syslog",      KW_COMMAND | KW_SET_PARAM) \
+    X(SYSTEM,      "system",      0) \
+    X(TARE,        "tare",        0) \
+    X(TASKS,       "tasks",       0) \
+    X(TELEMETRY,   "telemetry",   KW_SET_PARAM) \
+    X(TELNET,      "telnet",      0) \
+    X(TEMP,        "temp",        KW_COMMAND) \
+    X(TEMPERATURE, "temperature", KW_COMMAND) \
+    X(TEST,        "test",        KW_COMMAND) \
+    X(TEXT,        "text",        0) \
+    X(WEIGHT,      "weight",      KW_COMMAND) \
+    X(WIFI,        "wifi",        KW_SET_PARAM) \
+    X(WINDOW,      "window",      0) \
+    X(ZERO,        "zero",        0)
+
+enum Keyword : uint8_t {
+#define KEYWORD_ID(id, name, flags) KW_##id,
+    COMMAND_KEYWORDS(KEYWORD_ID)
+#undef KEYWORD_ID
+    KW_COUNT,
+    KW_NONE = 0xFF
+};
+
+struct KeywordEntry {
+    const char* name;
+    uint8_t flags;
+};
+
+static constexpr KeywordEntry KEYWORDS[KW_COUNT] = {
+#define KEYWORD_ENTRY(id, name, flags) { name, flags },
+    COMMAND_KEYWORDS(KEYWORD_ENTRY)
+#undef KEYWORD_ENTRY
+};
+
+static constexpr bool keywordsSorted() {
+    for (uint8_t i = 1; i < KW_COUNT; i++) {
+        const char* a = KEYWORDS[i - 1].name;
+        const char* b = KEYWORDS[i].name;
+        while (*a && *a == *b) { a++; b++; }
+        if ((unsigned char)*a >= (unsigned char)*b) return false;
+    }
+    return true;
+}
+static_assert(keywordsSorted(), "COMMAND_KEYWORDS must be lower case and sorted");
+
+// Case-insensitive binary search; KW_NONE for unknown words and nullptr
+static Keyword lookupKeyword(const char* word) {
+    if (!word) return KW_NONE;
+    
+    uint8_t low = 0;
+    uint8_t high = KW_COUNT;
+    while (low < high) {
+        uint8_t mid = (low + high) / 2;
+        int order = strcasecmp(word, KEYWORDS[mid].name);
+        if (order == 0) return (Keyword)mid;
+        if (order < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return KW_NONE;
+}
+
+// ON|OFF|1|0; false if the word is none of them
+static bool parseOnOff(const char* word, bool& state) {
+    if (!word) return false;
+    
+    Keyword keyword = lookupKeyword(word);
+    if (keyword == KW_ON || strcmp(word, "1") == 0) {
+        state = true;
+        return true;
+    }
+    if (keyword == KW_OFF || strcmp(word, "0") == 0) {
+        state = false;
+        return true;
+    }
+    return false;
+}
+
 CommandProcessor::CommandProcessor() :
     networkManager(nullptr),
     monitorSystem(nullptr) {
@@ -26,13 +189,10 @@ void CommandProcessor::begin(NetworkManager* network, MonitorSystem* monitor) {
     debugPrintf("CommandProcessor: Initialized\n");
 }
 
-bool CommandProcessor::processCommand(char* commandBuffer, bool fromMqtt, char* response, size_t responseSize) {
-    // Initialize response
-    response[0] = '\0';
-    
+bool CommandProcessor::processCommand(char* commandBuffer, bool fromMqtt, ResponseSink& out) {
     // Rate limiting
     if (!CommandValidator::checkRateLimit()) {
-        snprintf(response, responseSize, "rate limited");
+        out.print("rate limited");
         return false;
     }
     
@@ -60,7 +220,7 @@ bool CommandProcessor::processCommand(char* commandBuffer, bool fromMqtt, char*
     // Tokenize command
     char* cmd = strtok(commandBuffer, " ");
     if (!cmd) {
-        snprintf(response, responseSize, "empty command");
+        out.print("empty command");
         return false;
     }
     
@@ -68,104 +228,76 @@ bool CommandProcessor::processCommand(char* commandBuffer, bool fromMqtt, char*
     
     // Validate command
     if (!CommandValidator::validateCommand(cmd)) {
-        snprintf(response, responseSize, "invalid command: '%s'", cmd);
+        out.printf("invalid command: '%s'", cmd);
         return false;
     }
+    Keyword command = lookupKeyword(cmd);
     
-    // Handle specific commands
-    if (strcasecmp(cmd, "help") == 0) {
-        handleHelp(response, responseSize, fromMqtt);
-    }
-    else if (strcasecmp(cmd, "show") == 0) {
-        handleShow(response, responseSize, fromMqtt);
-    }
-    else if (strcasecmp(cmd, "status") == 0) {
-        handleStatus(response, responseSize);
-    }
-    else if (strcasecmp(cmd, "set") == 0) {
-        char* param = strtok(NULL, " ");
-        char* value = strtok(NULL, " ");
-        
-        if (CommandValidator::validateSetCommand(param, value)) {
-            handleSet(param, value, response, responseSize);
-        } else {
-            snprintf(response, responseSize, "invalid set command");
-        }
-    }
-    else if (strcasecmp(cmd, "debug") == 0) {
-        char* param = strtok(NULL, " ");
-        handleDebug(param, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "network") == 0) {
-        handleNetwork(response, responseSize);
-    }
-    else if (strcasecmp(cmd, "reset") == 0) {
-        char* param = strtok(NULL, " ");
-        handleReset(param, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "test") == 0) {
-        char* param = strtok(NULL, " ");
-        handleTest(param, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "syslog") == 0) {
-        char* param = strtok(NULL, " ");
-        handleSyslog(param, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "monitor") == 0) {
-        char* param = strtok(NULL, " ");
-        char* value = strtok(NULL, " ");
-        handleMonitor(param, value, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "weight") == 0) {
-        char* param = strtok(NULL, " ");
-        char* value = strtok(NULL, " ");
-        handleWeight(param, value, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "loglevel") == 0) {
-        char* param = strtok(NULL, " ");
-        handleLogLevel(param, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "temp") == 0 || strcasecmp(cmd, "temperature") == 0) {
-        char* param = strtok(NULL, " ");
-        char* value = strtok(NULL, " ");
-        handleTemperature(param, value, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "lcd") == 0) {
-        char* param = strtok(NULL, " ");
-        char* value = strtok(NULL, " ");
-        handleLCD(param, value, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "i2c") == 0) {
-        char* param = strtok(NULL, " ");
-        handleI2C(param, response, responseSize);
-    }
-    else if (strcasecmp(cmd, "bridge") == 0) {
-        char* param = strtok(NULL, " ");
-        handleBridge(param, response, responseSize);
-    }
-    else {
-        snprintf(response, responseSize, "unknown command: %s", cmd);
-        return false;
+    // Handlers that take more words pull them with strtok(NULL, " ")
+    char* param = strtok(NULL, " ");
+    char* value = strtok(NULL, " ");
+    
+    switch (command) {
+        case KW_HELP:       handleHelp(out, fromMqtt); break;
+        case KW_SHOW:       handleShow(param, out, fromMqtt); break;
+        case KW_STATUS:     handleStatus(out); break;
+        case KW_DEBUG:      handleDebug(param, out); break;
+        case KW_NETWORK:    handleNetwork(out); break;
+        case KW_RESET:      handleReset(param, out); break;
+        case KW_TEST:       handleTest(param, out); break;
+        case KW_SYSLOG:     handleSyslog(param, out); break;
+        case KW_MONITOR:    handleMonitor(param, value, out); break;
+        case KW_WEIGHT:     handleWeight(param, value, out); break;
+        case KW_LOGLEVEL:   handleLogLevel(param, out); break;
+        case KW_TEMP:
+        case KW_TEMPERATURE: handleTemperature(param, value, out); break;
+        case KW_LCD:        handleLCD(param, value, out); break;
+        case KW_I2C:        handleI2C(param, out); break;
+        case KW_BRIDGE:     handleBridge(param, value, out); break;
+        case KW_SET:
+            if (CommandValidator::validateSetCommand(param, value)) {
+                handleSet(param, value, out);
+            } else {
+                out.print("invalid set command");
+            }
+            break;
+        default:
+            out.printf("unknown command: %s", cmd);
+            return false;
     }
     
     return true;
 }
 
-void CommandProcessor::handleHelp(char* response, size_t responseSize, bool fromMqtt) {
-    snprintf(response, responseSize, 
+void CommandProcessor::handleHelp(ResponseSink& out, bool fromMqtt) {
+    out.print(
         "Available commands:\r\n"
         "help           - Show this help\r\n" 
         "show           - Show sensor readings\r\n"
+        "show tasks     - Show scheduler task runtime/lateness\r\n"
+        "show memory    - Show heap/stack usage and allocations\r\n"
+        "show telnet    - Show telnet sessions, queued and dropped output\r\n"
+        "show deadband  - Show publish deadbands and suppressed publishes\r\n"
+        "show ratelimit - Show controller sample rate, token buckets and link health\r\n"
+        "show wifi      - Show WiFi join mode, saved lease and reconnect times\r\n"
+        "show boot      - Show boot stage times and time to first sample/WiFi/MQTT\r\n"
+        "show config    - Show config log bank usage, queued writes and compactions\r\n"
+        "show perf      - Show loop/subsystem/sensor timing and histograms\r\n"
+        "show inputs    - Show watch pin states, interrupt/poll mode and edge counts\r\n"
         "status         - Show system status\r\n"
         "network        - Show network status\r\n"
         "debug [on|off] - Toggle debug mode\r\n"
         "loglevel [0-7] - Set logging level (0=EMERGENCY, 7=DEBUG)\r\n"
+        "loglevel sites - Rate-limited log call sites\r\n"
         "monitor start  - Start monitoring\r\n"
         "monitor stop   - Stop monitoring\r\n"
+        "monitor rate [<sensor> <ms>] - Show/set I2C sample periods\r\n"
+        "monitor window [<1-3> <ms>] - Show/set aggregation windows\r\n"
         "weight read    - Read current weight\r\n"
         "weight tare    - Tare the scale\r\n"
         "weight zero    - Zero calibration\r\n"
         "weight calibrate <weight> - Scale calibration\r\n"
+        "weight rate [<sps> [dec]] - Show/set load cell acquisition\r\n"
         "temp read      - Read temperature sensors (Fahrenheit)\r\n"
         "temp readc     - Read temperature sensors (Celsius)\r\n"
         "temp local|localc - Local temperature (F/C)\r\n"
@@ -178,69 +310,164 @@ void CommandProcessor::handleHelp(char* response, size_t responseSize, bool from
         "lcd test       - Display test pattern\r\n"
         "lcd reinit     - Reinitialize LCD\r\n"
         "lcd refresh    - Force LCD update with current data\r\n"
+        "lcd stats      - LCD refresh bus time and cell counts\r\n"
         "i2c scan       - Scan Wire1 I2C bus for devices\r\n"
         "i2c mux        - Scan through multiplexer channels\r\n"
         "i2c status     - Show I2C bus status\r\n"
-        "i2c show       - Show detected I2C devices\r\n"
-        "bridge status  - Show Serial1 bridge status\r\n"
-        "bridge stats   - Show detailed bridge statistics\r\n"
+        "i2c show       - Show the known device map probed at boot\r\n"
+        "i2c stats      - Show mux selects, cache hits and bus time saved\r\n"
+        "bridge status  - Show Serial1 bridge status and outage backlog\r\n"
+        "bridge stats   - Show detailed bridge and store-and-forward statistics\r\n"
         "bridge telemetry [on|off] - Control telemetry forwarding\r\n"
-        "bridge reset   - Reset bridge statistics\r\n"
+        "bridge loss    - Show per-type sequence gaps and frame loss\r\n"
+        "bridge lanes   - Show priority lane depth, latency and drops\r\n"
+        "bridge metrics - Show 10s/60s/119s frame rates, drops and publish p50/p95/p99\r\n"
+        "bridge reset   - Reset sequence loss statistics\r\n"
+        "bridge bench [<hz> [s]|ramp|stop] - Synthetic frame self-test and latency report\r\n"
+        "bridge cmd [on|off] - Controller command path and round-trip stats\r\n"
+        "bridge cmd send <text> - Send a command to the controller (e.g. relay R1 ON)\r\n"
         "test network   - Test network connectivity\r\n"
         "syslog test    - Send test syslog message\r\n"
+        "syslog stats   - Log queue depth, drops, lines per datagram\r\n"
+        "reset perf     - Clear profiler timings and histograms\r\n"
         "reset system   - Restart the device");
 }
 
-void CommandProcessor::handleShow(char* response, size_t responseSize, bool fromMqtt) {
+void CommandProcessor::handleShow(char* param, ResponseSink& out, bool fromMqtt) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_BOOT) {
+        if (!g_bootTimeline) {
+            out.print("boot timeline not available");
+            return;
+        }
+        g_bootTimeline->getReport(out);
+        return;
+    }
+    
+    if (sub == KW_CONFIG) {
+        if (!g_configLog) {
+            out.print("config log not available");
+            return;
+        }
+        g_configLog->getStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_PERF) {
+        if (!g_perfProfiler) {
+            out.print("profiler not available");
+            return;
+        }
+        g_perfProfiler->getStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_TASKS) {
+        if (!g_scheduler) {
+            out.print("scheduler not available");
+            return;
+        }
+        g_scheduler->getStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_MEMORY) {
+        if (!g_memoryMonitor) {
+            out.print("memory monitor not available");
+            return;
+        }
+        g_memoryMonitor->getStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_TELNET) {
+        telnetServer.getStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_RATELIMIT) {
+        serialBridge.getRateStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_WIFI) {
+        if (!networkManager) {
+            out.print("network manager not available");
+            return;
+        }
+        networkManager->getWiFiStatistics(out);
+        return;
+    }
+    
+    if (sub == KW_DEADBAND) {
+        if (!g_monitorConfig) {
+            out.print("config not available");
+            return;
+        }
+        out.printf("deadband: suppressed=%lu",
+            monitorSystem ? (unsigned long)monitorSystem->getDeadbandSuppressed() : 0UL);
+        for (uint8_t i = 0; i < DEADBAND_TOPIC_COUNT; i++) {
+            const DeadbandSetting& deadband = g_monitorConfig->getDeadband((DeadbandTopic)i);
+            if (deadband.threshold == 0.0f && deadband.maxSilenceS == 0) {
+                out.printf("\r\n%-11s off", MonitorConfigManager::getDeadbandTopicName(i));
+                continue;
+            }
+            out.printf("\r\n%-11s %g%s silence=%us", MonitorConfigManager::getDeadbandTopicName(i),
+                deadband.threshold, (deadband.flags & DEADBAND_PERCENT) ? "%" : "",
+                deadband.maxSilenceS);
+        }
+        return;
+    }
+    
     if (!monitorSystem) {
-        snprintf(response, responseSize, "monitor system not available");
+        out.print("monitor system not available");
         return;
     }
     
-    monitorSystem->getStatusString(response, responseSize);
+    if (sub == KW_INPUTS) {
+        monitorSystem->getInputStatistics(out);
+        return;
+    }
+    
+    out.fill([&](char* buffer, size_t size) { monitorSystem->getStatusString(buffer, size); });
 }
 
-void CommandProcessor::handleStatus(char* response, size_t responseSize) {
+void CommandProcessor::handleStatus(ResponseSink& out) {
     if (!monitorSystem || !networkManager) {
-        snprintf(response, responseSize, "system components not available");
+        out.print("system components not available");
         return;
     }
     
-    char networkStatus[128];
-    char monitorStatus[128];
-    
-    networkManager->getHealthString(networkStatus, sizeof(networkStatus));
-    monitorSystem->getStatusString(monitorStatus, sizeof(monitorStatus));
-    
-    snprintf(response, responseSize, "network: %s | monitor: %s", 
-        networkStatus, monitorStatus);
+    // Each part gets a whole chunk instead of sharing one buffer
+    out.print("network: ");
+    out.fill([&](char* buffer, size_t size) { networkManager->getHealthString(buffer, size); });
+    out.print(" | monitor: ");
+    out.fill([&](char* buffer, size_t size) { monitorSystem->getStatusString(buffer, size); });
 }
 
-void CommandProcessor::handleSet(char* param, char* value, char* response, size_t responseSize) {
+void CommandProcessor::handleSet(char* param, char* value, ResponseSink& out) {
     if (!param || !value) {
-        snprintf(response, responseSize, "Usage: set <param> <value>");
+        out.print("Usage: set <param> <value>");
         return;
     }
     
-    if (strcasecmp(param, "debug") == 0) {
+    Keyword sub = lookupKeyword(param);
+    if (sub == KW_DEBUG) {
         bool enabled;
-        if (strcasecmp(value, "on") == 0 || strcasecmp(value, "1") == 0) {
-            enabled = true;
-        } else if (strcasecmp(value, "off") == 0 || strcasecmp(value, "0") == 0) {
-            enabled = false;
-        } else {
-            snprintf(response, responseSize, "debug value must be ON|OFF|1|0");
+        if (!parseOnOff(value, enabled)) {
+            out.print("debug value must be ON|OFF|1|0");
             return;
         }
         
         g_debugEnabled = enabled;
-        snprintf(response, responseSize, "debug %s", enabled ? "ON" : "OFF");
+        out.printf("debug %s", enabled ? "ON" : "OFF");
     }
-    else if (strcasecmp(param, "loglevel") == 0) {
+    else if (sub == KW_LOGLEVEL) {
         if (!value) {
             // Show current log level
             LogLevel currentLevel = Logger::getLogLevel();
-            snprintf(response, responseSize, "Current log level: %d (%s)", 
+            out.printf("Current log level: %d (%s)", 
                 currentLevel, 
                 (currentLevel == LOG_EMERGENCY) ? "EMERGENCY" :
                 (currentLevel == LOG_ALERT) ? "ALERT" :
@@ -255,14 +482,14 @@ void CommandProcessor::handleSet(char* param, char* value, char* response, size_
         
         int level = atoi(value);
         if (level < 0 || level > 7) {
-            snprintf(response, responseSize, "Invalid log level. Use 0-7 (0=EMERGENCY, 7=DEBUG)");
+            out.print("Invalid log level. Use 0-7 (0=EMERGENCY, 7=DEBUG)");
             return;
         }
         
         Logger::setLogLevel(static_cast<LogLevel>(level));
-        snprintf(response, responseSize, "Log level set to %d", level);
+        out.printf("Log level set to %d", level);
     }
-    else if (strcasecmp(param, "syslog") == 0) {
+    else if (sub == KW_SYSLOG) {
         if (networkManager) {
             // Parse syslog server address and optional port
             char* portPtr = strchr(value, ':');
@@ -272,22 +499,22 @@ void CommandProcessor::handleSet(char* param, char* value, char* response, size_
                 *portPtr = '\0'; // Split the string
                 port = atoi(portPtr + 1);
                 if (port <= 0 || port > 65535) {
-                    snprintf(response, responseSize, "Invalid port number");
+                    out.print("Invalid port number");
                     return;
                 }
             }
             
             networkManager->setSyslogServer(value, port);
             if (portPtr) {
-                snprintf(response, responseSize, "syslog server set to %s:%d", value, port);
+                out.printf("syslog server set to %s:%d", value, port);
             } else {
-                snprintf(response, responseSize, "syslog server set to %s:%d", value, SYSLOG_PORT);
+                out.printf("syslog server set to %s:%d", value, SYSLOG_PORT);
             }
         } else {
-            snprintf(response, responseSize, "Network manager not available");
+            out.print("Network manager not available");
         }
     }
-    else if (strcasecmp(param, "mqtt") == 0) {
+    else if (sub == KW_MQTT) {
         if (networkManager) {
             // Parse MQTT broker address and optional port
             char valueCopy[128];
@@ -301,144 +528,313 @@ void CommandProcessor::handleSet(char* param, char* value, char* response, size_
                 *portPtr = '\0'; // Split the string
                 port = atoi(portPtr + 1);
                 if (port <= 0 || port > 65535) {
-                    snprintf(response, responseSize, "Invalid port number");
+                    out.print("Invalid port number");
                     return;
                 }
             }
             
             networkManager->setMQTTBroker(valueCopy, port);
             if (portPtr) {
-                snprintf(response, responseSize, "mqtt broker set to %s:%d", valueCopy, port);
+                out.printf("mqtt broker set to %s:%d", valueCopy, port);
             } else {
-                snprintf(response, responseSize, "mqtt broker set to %s:%d", valueCopy, port);
+                out.printf("mqtt broker set to %s:%d", valueCopy, port);
             }
         } else {
-            snprintf(response, responseSize, "Network manager not available");
+            out.print("Network manager not available");
         }
     }
-    else if (strcasecmp(param, "interval") == 0) {
+    else if (sub == KW_PACKED) {
+        if (networkManager) {
+            bool enabled;
+            if (!parseOnOff(value, enabled)) {
+                out.print("packed value must be ON|OFF|1|0");
+                return;
+            }
+            
+            networkManager->setPackedMode(enabled);
+            out.printf("packed mqtt publishing %s", enabled ? "ON" : "OFF");
+        } else {
+            out.print("Network manager not available");
+        }
+    }
+    else if (sub == KW_HOSTNAME) {
+        // Syslog and WiFi use it now; the topic namespace is built at boot
+        if (!g_monitorConfig || value[0] == '\0' || !g_monitorConfig->setSyslogHostname(value)) {
+            out.print("usage: set hostname <name> (1-31 characters)");
+            return;
+        }
+        g_monitorConfig->save();
+        if (networkManager) networkManager->setHostname(value);
+        out.printf("hostname %s (saved), topic namespace follows after a reboot", value);
+    }
+    else if (sub == KW_NAMESPACE) {
+        bool enabled;
+        if (!g_monitorConfig || !parseOnOff(value, enabled)) {
+            out.print("namespace value must be ON|OFF|1|0");
+            return;
+        }
+        
+        g_monitorConfig->setTopicNamespace(enabled);
+        g_monitorConfig->save();
+        out.printf("mqtt topic namespace %s%s (saved), applies after a reboot",
+            enabled ? "ON: " : "OFF", enabled ? g_monitorConfig->getSyslogHostname() : "");
+    }
+    else if (sub == KW_INTERVAL) {
         unsigned long interval = strtoul(value, NULL, 10);
         if (interval >= 1000 && interval <= 300000) { // 1 second to 5 minutes
             if (monitorSystem) {
                 monitorSystem->setPublishInterval(interval);
-                snprintf(response, responseSize, "publish interval set to %lu ms", interval);
+                out.printf("publish interval set to %lu ms", interval);
             } else {
-                snprintf(response, responseSize, "Monitor system not available");
+                out.print("Monitor system not available");
             }
         } else {
-            snprintf(response, responseSize, "Interval must be between 1000 and 300000 ms");
+            out.print("Interval must be between 1000 and 300000 ms");
         }
     }
-    else if (strcasecmp(param, "heartbeat") == 0) {
+    else if (sub == KW_HEARTBEAT) {
         unsigned long interval = strtoul(value, NULL, 10);
         if (interval >= 5000 && interval <= 600000) { // 5 seconds to 10 minutes
             if (monitorSystem) {
                 monitorSystem->setHeartbeatInterval(interval);
-                snprintf(response, responseSize, "heartbeat interval set to %lu ms", interval);
+                out.printf("heartbeat interval set to %lu ms", interval);
             } else {
-                snprintf(response, responseSize, "Monitor system not available");
+                out.print("Monitor system not available");
             }
         } else {
-            snprintf(response, responseSize, "Heartbeat interval must be between 5000 and 600000 ms");
+            out.print("Heartbeat interval must be between 5000 and 600000 ms");
+        }
+    }
+    else if (sub == KW_DEADBAND) {
+        // set deadband <topic> <threshold>[%]|off [max silence s]
+        char* thresholdStr = strtok(NULL, " ");
+        char* silenceStr = strtok(NULL, " ");
+        int8_t topic = MonitorConfigManager::findDeadbandTopic(value);
+        if (!g_monitorConfig || topic < 0 || !thresholdStr) {
+            out.print("usage: set deadband <temperature|weight|voltage|current|power|adc|system> <value>[%]|off [silence s]");
+            return;
+        }
+        
+        float threshold = 0.0f;
+        bool percent = false;
+        unsigned long silence = 0;
+        if (lookupKeyword(thresholdStr) != KW_OFF) {
+            char* end;
+            threshold = strtof(thresholdStr, &end);
+            percent = (*end == '%');
+            silence = silenceStr ? strtoul(silenceStr, NULL, 10) : DEADBAND_DEFAULT_SILENCE_S;
+        }
+        
+        if (silence > DEADBAND_MAX_SILENCE_S ||
+            !g_monitorConfig->setDeadband((DeadbandTopic)topic, threshold, percent, (uint16_t)silence)) {
+            out.printf("threshold must be >= 0, silence 0-%d s", DEADBAND_MAX_SILENCE_S);
+            return;
+        }
+        g_monitorConfig->save();
+        if (monitorSystem) monitorSystem->resetDeadbands();
+        
+        if (threshold == 0.0f && silence == 0) {
+            out.printf("%s deadband off (saved)", value);
+        } else {
+            out.printf("%s deadband %g%s, silence %lus (saved)", value, threshold, percent ? "%" : "", silence);
         }
     }
+    else if (sub == KW_RATELIMIT) {
+        // set ratelimit <min hz> <max hz> [burst]
+        char* maxStr = strtok(NULL, " ");
+        char* burstStr = strtok(NULL, " ");
+        unsigned long minHz = strtoul(value, NULL, 10);
+        unsigned long maxHz = maxStr ? strtoul(maxStr, NULL, 10) : 0;
+        unsigned long burst = burstStr ? strtoul(burstStr, NULL, 10) : DECODER_RATE_BURST;
+        if (!maxStr || minHz == 0 || maxHz < minHz || maxHz > DECODER_RATE_LIMIT_HZ || burst == 0 || burst > DECODER_RATE_LIMIT_HZ ||
+            !serialBridge.setRatePolicy((uint8_t)minHz, (uint8_t)maxHz, (uint8_t)burst)) {
+            out.printf("usage: set ratelimit <min hz> <max hz> [burst], 1 <= min <= max <= %d, burst 1-%d",
+                DECODER_RATE_LIMIT_HZ, DECODER_RATE_LIMIT_HZ);
+            return;
+        }
+        
+        if (g_monitorConfig) {
+            g_monitorConfig->setRatePolicy((uint8_t)minHz, (uint8_t)maxHz, (uint8_t)burst);
+            g_monitorConfig->save();
+        }
+        out.printf("controller sample rate %lu-%lu Hz per stream, burst %lu (saved)", minHz, maxHz, burst);
+    }
+    else if (sub == KW_WIFI) {
+        // set wifi static <ip> <gateway> <subnet> [dns] | set wifi dhcp
+        Keyword mode = lookupKeyword(value);
+        if (mode == KW_DHCP) {
+            if (networkManager) networkManager->setStaticIp(nullptr);
+            if (g_monitorConfig) {
+                g_monitorConfig->setStaticIp(nullptr);
+                g_monitorConfig->save();
+            }
+            out.print("wifi addressing DHCP (recent lease reused), applies on the next join (saved)");
+            return;
+        }
+        
+        const char* usage = "usage: set wifi static <ip> <gateway> <subnet> [dns] | set wifi dhcp";
+        if (mode != KW_STATIC) {
+            out.print(usage);
+            return;
+        }
+        
+        char* fields[4] = { strtok(NULL, " "), strtok(NULL, " "), strtok(NULL, " "), strtok(NULL, " ") };
+        if (!fields[3]) fields[3] = fields[1];  // DNS defaults to the gateway
+        
+        IpSettings settings;
+        uint8_t* targets[4] = { settings.ip, settings.gateway, settings.subnet, settings.dns };
+        for (uint8_t i = 0; i < 4; i++) {
+            IPAddress address;
+            if (!fields[i] || !address.fromString(fields[i])) {
+                out.print(usage);
+                return;
+            }
+            for (uint8_t b = 0; b < 4; b++) targets[i][b] = address[b];
+        }
+        if (settings.ip[0] == 0) {
+            out.print(usage);
+            return;
+        }
+        
+        if (networkManager) networkManager->setStaticIp(&settings);
+        if (g_monitorConfig) {
+            g_monitorConfig->setStaticIp(&settings);
+            g_monitorConfig->save();
+        }
+        out.printf("wifi static %s gateway %s subnet %s dns %s, applies on the next join (saved)",
+            fields[0], fields[1], fields[2], fields[3]);
+    }
+    else if (sub == KW_TELEMETRY) {
+        if (!monitorSystem) {
+            out.print("Monitor system not available");
+            return;
+        }
+        
+        Keyword format = lookupKeyword(value);
+        if (format == KW_PROTOBUF) {
+            monitorSystem->setTelemetryFormat(TELEMETRY_PROTOBUF);
+        } else if (format == KW_TEXT) {
+            monitorSystem->setTelemetryFormat(TELEMETRY_TEXT);
+        } else if (format == KW_BOTH) {
+            monitorSystem->setTelemetryFormat(TELEMETRY_PROTOBUF | TELEMETRY_TEXT);
+        } else {
+            out.print("telemetry value must be PROTOBUF|TEXT|BOTH");
+            return;
+        }
+        out.printf("sensor telemetry %s (%lu snapshots sent)", value,
+            (unsigned long)monitorSystem->getSnapshotCount());
+    }
     else {
-        snprintf(response, responseSize, "unknown parameter %s", param);
+        out.printf("unknown parameter %s", param);
     }
 }
 
-void CommandProcessor::handleDebug(char* param, char* response, size_t responseSize) {
+void CommandProcessor::handleDebug(char* param, ResponseSink& out) {
     if (!param) {
         // Show current debug status
-        snprintf(response, responseSize, "debug %s", g_debugEnabled ? "ON" : "OFF");
+        out.printf("debug %s", g_debugEnabled ? "ON" : "OFF");
         return;
     }
     
-    if (strcasecmp(param, "on") == 0 || strcasecmp(param, "1") == 0) {
-        g_debugEnabled = true;
-        snprintf(response, responseSize, "debug ON");
-    } else if (strcasecmp(param, "off") == 0 || strcasecmp(param, "0") == 0) {
-        g_debugEnabled = false;
-        snprintf(response, responseSize, "debug OFF");
+    bool enabled;
+    if (parseOnOff(param, enabled)) {
+        g_debugEnabled = enabled;
+        out.printf("debug %s", enabled ? "ON" : "OFF");
     } else {
-        snprintf(response, responseSize, "usage: debug [ON|OFF]");
+        out.print("usage: debug [ON|OFF]");
     }
 }
 
-void CommandProcessor::handleNetwork(char* response, size_t responseSize) {
+void CommandProcessor::handleNetwork(ResponseSink& out) {
     if (networkManager) {
-        networkManager->getHealthString(response, responseSize);
+        out.fill([&](char* buffer, size_t size) { networkManager->getHealthString(buffer, size); });
+        out.print("\r\ndns: ");
+        out.fill([&](char* buffer, size_t size) { networkManager->getResolverString(buffer, size); });
     } else {
-        snprintf(response, responseSize, "network manager not available");
+        out.print("network manager not available");
     }
 }
 
-void CommandProcessor::handleReset(char* param, char* response, size_t responseSize) {
+void CommandProcessor::handleReset(char* param, ResponseSink& out) {
     if (!param) {
-        snprintf(response, responseSize, "usage: reset system|network");
+        out.print("usage: reset system|network|perf");
         return;
     }
     
-    if (strcasecmp(param, "system") == 0) {
-        snprintf(response, responseSize, "system reset requested - restarting...");
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_SYSTEM) {
+        out.print("system reset requested - restarting...");
+        out.finish();
         delay(100); // Allow response to be sent
+        // Settings saved just before the reset are still queued
+        if (g_configLog) g_configLog->flush();
         // Restart the system
         NVIC_SystemReset();
-    } else if (strcasecmp(param, "network") == 0) {
+    } else if (sub == KW_PERF) {
+        if (g_perfProfiler) {
+            g_perfProfiler->resetStatistics();
+            out.print("profiler statistics cleared");
+        } else {
+            out.print("profiler not available");
+        }
+    } else if (sub == KW_NETWORK) {
         if (networkManager) {
             // Force network reconnection by setting state
-            snprintf(response, responseSize, "network reset requested");
+            out.print("network reset requested");
             // This would require exposing a reset method in NetworkManager
         } else {
-            snprintf(response, responseSize, "network manager not available");
+            out.print("network manager not available");
         }
     } else {
-        snprintf(response, responseSize, "unknown reset parameter: %s", param);
+        out.printf("unknown reset parameter: %s", param);
     }
 }
 
-void CommandProcessor::handleTest(char* param, char* response, size_t responseSize) {
+void CommandProcessor::handleTest(char* param, ResponseSink& out) {
     if (!param) {
-        snprintf(response, responseSize, "test commands: network, sensors, weight, temp, outputs, i2c, pins");
+        out.print("test commands: network, sensors, weight, temp, outputs, i2c, pins");
         return;
     }
     
-    if (strcasecmp(param, "network") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_NETWORK) {
         if (networkManager) {
             bool wifiOk = networkManager->isWiFiConnected();
             bool mqttOk = networkManager->isMQTTConnected();
-            snprintf(response, responseSize, "network test: wifi=%s mqtt=%s", 
+            out.printf("network test: wifi=%s mqtt=%s", 
                 wifiOk ? "OK" : "FAIL", mqttOk ? "OK" : "FAIL");
         } else {
-            snprintf(response, responseSize, "network manager not available");
+            out.print("network manager not available");
         }
     }
-    else if (strcasecmp(param, "sensors") == 0) {
+    else if (sub == KW_SENSORS) {
         if (monitorSystem) {
             float localTempF = monitorSystem->getLocalTemperatureF();
             float remoteTempF = monitorSystem->getRemoteTemperatureF();
-            snprintf(response, responseSize, "sensor test: local=%.1f┬░F remote=%.1f┬░F", localTempF, remoteTempF);
+            out.printf("sensor test: local=%.1f┬░F remote=%.1f┬░F", localTempF, remoteTempF);
         } else {
-            snprintf(response, responseSize, "monitor system not available");
+            out.print("monitor system not available");
         }
     }
-    else if (strcasecmp(param, "weight") == 0) {
+    else if (sub == KW_WEIGHT) {
         if (monitorSystem) {
             bool ready = monitorSystem->isWeightSensorReady();
             NAU7802Status status = monitorSystem->getWeightSensorStatus();
             float weight = monitorSystem->getWeight();
             long raw = monitorSystem->getRawWeight();
             
-            snprintf(response, responseSize, 
+            out.printf(
                 "weight test: status=%s ready=%s weight=%.3f raw=%ld",
                 (status == NAU7802_OK) ? "OK" : "ERROR",
                 ready ? "YES" : "NO",
                 weight, raw);
         } else {
-            snprintf(response, responseSize, "monitor system not available");
+            out.print("monitor system not available");
         }
     }
-    else if (strcasecmp(param, "temp") == 0 || strcasecmp(param, "temperature") == 0) {
+    else if (sub == KW_TEMP || sub == KW_TEMPERATURE) {
         if (monitorSystem) {
             bool ready = monitorSystem->isTemperatureSensorReady();
             float localTempF = monitorSystem->getLocalTemperatureF();
@@ -446,26 +842,26 @@ void CommandProcessor::handleTest(char* param, char* response, size_t responseSi
             char statusBuffer[256];
             monitorSystem->getTemperatureSensorStatus(statusBuffer, sizeof(statusBuffer));
             
-            snprintf(response, responseSize, 
+            out.printf(
                 "temp test: ready=%s local=%.2fF remote=%.2fF - %s",
                 ready ? "YES" : "NO",
                 localTempF, remoteTempF, statusBuffer);
         } else {
-            snprintf(response, responseSize, "monitor system not available");
+            out.print("monitor system not available");
         }
     }
-    else if (strcasecmp(param, "outputs") == 0) {
+    else if (sub == KW_OUTPUTS) {
         if (monitorSystem) {
             // Toggle output pins briefly for testing
             monitorSystem->setDigitalOutput(DIGITAL_OUTPUT_1, true);
-            delay(100);
+            cooperativeDelay(100);
             monitorSystem->setDigitalOutput(DIGITAL_OUTPUT_1, false);
-            snprintf(response, responseSize, "output test: toggled output pins");
+            out.print("output test: toggled output pins");
         } else {
-            snprintf(response, responseSize, "monitor system not available");
+            out.print("monitor system not available");
         }
     }
-    else if (strcasecmp(param, "i2c") == 0) {
+    else if (sub == KW_I2C) {
         // Enhanced I2C scanner with diagnostics - using Wire1 for Qwiic connector
         int deviceCount = 0;
         char deviceList[200] = "";
@@ -477,6 +873,7 @@ void CommandProcessor::handleTest(char* param, char* response, size_t responseSi
         Wire1.end();
         Wire1.begin();
         Wire1.setClock(100000); // Set to 100kHz (standard I2C speed)
+        if (g_i2cMux) g_i2cMux->invalidate();  // Mux state unknown after a bus restart
         debugPrintf("DEBUG: Wire1 bus reinitialized at 100kHz\n");
         
         // Check I2C pin states (R4 WiFi Qwiic connector)
@@ -520,14 +917,14 @@ void CommandProcessor::handleTest(char* param, char* response, size_t responseSi
         }
         
         if (deviceCount == 0) {
-            snprintf(response, responseSize, "i2c test: no devices found on Wire1 - check Qwiic connector");
+            out.print("i2c test: no devices found on Wire1 - check Qwiic connector");
             debugPrintf("DEBUG: No I2C devices detected on Wire1 (Qwiic)\n");
             debugPrintf("DEBUG: Ensure device is connected to Qwiic connector\n");
         } else {
-            snprintf(response, responseSize, "i2c test: found %d device(s) on Wire1: %s", deviceCount, deviceList);
+            out.printf("i2c test: found %d device(s) on Wire1: %s", deviceCount, deviceList);
         }
     }
-    else if (strcasecmp(param, "pins") == 0) {
+    else if (sub == KW_PINS) {
         // Test I2C pin functionality (R4 WiFi dedicated I2C pins)
         debugPrintf("DEBUG: Testing I2C pin functionality\n");
         
@@ -541,86 +938,94 @@ void CommandProcessor::handleTest(char* param, char* response, size_t responseSi
         
         digitalWrite(SDA, HIGH);
         digitalWrite(SCL, HIGH);
-        delay(10);
+        cooperativeDelay(10);
         int sda_high = digitalRead(SDA);
         int scl_high = digitalRead(SCL);
         
         digitalWrite(SDA, LOW);
         digitalWrite(SCL, LOW);
-        delay(10);
+        cooperativeDelay(10);
         int sda_low = digitalRead(SDA);
         int scl_low = digitalRead(SCL);
         
         // Restore I2C functionality
         Wire.begin();
         
-        snprintf(response, responseSize, 
+        out.printf(
             "pin test: SDA init=%d high=%d low=%d | SCL init=%d high=%d low=%d",
             sda_state, sda_high, sda_low, scl_state, scl_high, scl_low);
         
         debugPrintf("DEBUG: Pin test complete, I2C reinitialized\n");
     }
     else {
-        snprintf(response, responseSize, "unknown test parameter: %s", param);
+        out.printf("unknown test parameter: %s", param);
     }
 }
 
-void CommandProcessor::handleSyslog(char* param, char* response, size_t responseSize) {
+void CommandProcessor::handleSyslog(char* param, ResponseSink& out) {
     if (!networkManager) {
-        snprintf(response, responseSize, "network manager not initialized");
+        out.print("network manager not initialized");
         return;
     }
     
     if (!param) {
-        snprintf(response, responseSize, "syslog commands: test, status");
+        out.print("syslog commands: test, status, stats");
         return;
     }
     
-    if (strcasecmp(param, "test") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_TEST) {
         if (!networkManager->isWiFiConnected()) {
-            snprintf(response, responseSize, "WiFi not connected - cannot send syslog");
+            out.print("WiFi not connected - cannot send syslog");
             return;
         }
         
         // Send test message to syslog server
         bool result = networkManager->sendSyslog("SYSLOG TEST MESSAGE - LogSplitter Monitor");
         if (result) {
-            snprintf(response, responseSize, "syslog test message sent successfully");
+            out.print("syslog test message sent successfully");
         } else {
-            snprintf(response, responseSize, "syslog test message failed to send");
+            out.print("syslog test message failed to send");
         }
     }
-    else if (strcasecmp(param, "status") == 0) {
-        snprintf(response, responseSize, 
-            "syslog server: %s:%d, wifi: %s", 
-            SYSLOG_SERVER, SYSLOG_PORT,
+    else if (sub == KW_STATUS) {
+        out.printf(
+            "syslog server: %s:%d, wifi: %s, ", 
+            networkManager->getSyslogServer(), networkManager->getSyslogPort(),
             networkManager->isWiFiConnected() ? "connected" : "disconnected");
+        out.fill([&](char* buffer, size_t size) { networkManager->getResolverString(buffer, size); });
+    }
+    else if (sub == KW_STATS) {
+        out.fill([&](char* buffer, size_t size) { Logger::getStatistics(buffer, size); });
     }
     else {
-        snprintf(response, responseSize, "unknown syslog command: %s", param);
+        out.printf("unknown syslog command: %s", param);
     }
 }
 
-void CommandProcessor::handleMonitor(char* param, char* value, char* response, size_t responseSize) {
+void CommandProcessor::handleMonitor(char* param, char* value, ResponseSink& out) {
     if (!monitorSystem) {
-        snprintf(response, responseSize, "monitor system not available");
+        out.print("monitor system not available");
         return;
     }
     
     if (!param) {
-        snprintf(response, responseSize, "monitor commands: start, stop, state, output");
+        out.print("monitor commands: start, stop, state, output, rate, window");
         return;
     }
     
-    if (strcasecmp(param, "start") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_START) {
         monitorSystem->setSystemState(SYS_MONITORING);
-        snprintf(response, responseSize, "monitoring started");
+        out.print("monitoring started");
     }
-    else if (strcasecmp(param, "stop") == 0) {
+    else if (sub == KW_STOP) {
         monitorSystem->setSystemState(SYS_MAINTENANCE);
-        snprintf(response, responseSize, "monitoring stopped");
+        out.print("monitoring stopped");
     }
-    else if (strcasecmp(param, "state") == 0) {
+    else if (sub == KW_STATE) {
         SystemState state = monitorSystem->getSystemState();
         const char* stateStr = "";
         switch (state) {
@@ -630,11 +1035,11 @@ void CommandProcessor::handleMonitor(char* param, char* value, char* response, s
             case SYS_ERROR: stateStr = "ERROR"; break;
             case SYS_MAINTENANCE: stateStr = "MAINTENANCE"; break;
         }
-        snprintf(response, responseSize, "monitor state: %s (%d)", stateStr, (int)state);
+        out.printf("monitor state: %s (%d)", stateStr, (int)state);
     }
-    else if (strcasecmp(param, "output") == 0) {
+    else if (sub == KW_OUTPUT) {
         if (!value) {
-            snprintf(response, responseSize, "usage: monitor output <1|2> <on|off>");
+            out.print("usage: monitor output <1|2> <on|off>");
             return;
         }
         
@@ -642,156 +1047,232 @@ void CommandProcessor::handleMonitor(char* param, char* value, char* response, s
         char* stateStr = strtok(NULL, " ");
         
         if (outputNum < 1 || outputNum > 2 || !stateStr) {
-            snprintf(response, responseSize, "usage: monitor output <1|2> <on|off>");
+            out.print("usage: monitor output <1|2> <on|off>");
             return;
         }
         
-        bool state = (strcasecmp(stateStr, "on") == 0 || strcasecmp(stateStr, "1") == 0);
+        bool state = false;
+        parseOnOff(stateStr, state);
         uint8_t pin = (outputNum == 1) ? DIGITAL_OUTPUT_1 : DIGITAL_OUTPUT_2;
         
         monitorSystem->setDigitalOutput(pin, state);
-        snprintf(response, responseSize, "output %d set to %s", outputNum, state ? "ON" : "OFF");
+        out.printf("output %d set to %s", outputNum, state ? "ON" : "OFF");
+    }
+    else if (sub == KW_RATE) {
+        I2CScheduler* scheduler = monitorSystem->getI2CScheduler();
+        if (!value) {
+            scheduler->getStatistics(out);
+            return;
+        }
+        
+        char* periodStr = strtok(NULL, " ");
+        int8_t id = scheduler->findDevice(value);
+        if (id == I2C_SCHED_INVALID_ID || !periodStr) {
+            out.print("usage: monitor rate <temp|weight|power|adc|lcd> <ms>");
+            return;
+        }
+        
+        unsigned long period = strtoul(periodStr, NULL, 10);
+        if (!scheduler->setPeriod(id, period)) {
+            out.printf("period must be at least %d ms", I2C_SCHED_MIN_PERIOD_MS);
+            return;
+        }
+        out.printf("%s sample period set to %lu ms", value, period);
+    }
+    else if (sub == KW_WINDOW) {
+        SensorAggregator* aggregator = monitorSystem->getAggregator();
+        if (!value) {
+            aggregator->getStatistics(out);
+            return;
+        }
+        
+        char* lengthStr = strtok(NULL, " ");
+        int window = atoi(value);
+        if (window < 1 || window > AGG_WINDOW_COUNT || !lengthStr) {
+            out.printf("usage: monitor window <1-%d> <ms>", AGG_WINDOW_COUNT);
+            return;
+        }
+        
+        unsigned long length = strtoul(lengthStr, NULL, 10);
+        if (!aggregator->setWindow(window - 1, length)) {
+            out.printf("window must be %d to %lu ms", AGG_MIN_WINDOW_MS, AGG_MAX_WINDOW_MS);
+            return;
+        }
+        out.printf("aggregation window %d set to %lu ms", window, length);
     }
     else {
-        snprintf(response, responseSize, "unknown monitor command: %s", param);
+        out.printf("unknown monitor command: %s", param);
     }
 }
 
-void CommandProcessor::handleWeight(char* param, char* value, char* response, size_t responseSize) {
+void CommandProcessor::handleWeight(char* param, char* value, ResponseSink& out) {
     if (!monitorSystem) {
-        snprintf(response, responseSize, "monitor system not available");
+        out.print("monitor system not available");
         return;
     }
     
     if (!param) {
-        snprintf(response, responseSize, "weight commands: read, raw, tare, zero, calibrate, status");
+        out.print("weight commands: read, raw, tare, zero, calibrate, status, rate");
         return;
     }
     
-    if (strcasecmp(param, "read") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_READ) {
         float weight = monitorSystem->getWeight();
         float filtered = monitorSystem->getFilteredWeight();
-        snprintf(response, responseSize, "weight: %.3f (filtered: %.3f)", weight, filtered);
+        out.printf("weight: %.3f (filtered: %.3f)", weight, filtered);
     }
-    else if (strcasecmp(param, "raw") == 0) {
+    else if (sub == KW_RAW) {
         long rawWeight = monitorSystem->getRawWeight();
-        snprintf(response, responseSize, "raw weight: %ld", rawWeight);
+        out.printf("raw weight: %ld", rawWeight);
     }
-    else if (strcasecmp(param, "tare") == 0) {
+    else if (sub == KW_TARE) {
         monitorSystem->tareWeightSensor();
-        snprintf(response, responseSize, "weight sensor tared");
+        out.print("weight sensor tared");
     }
-    else if (strcasecmp(param, "zero") == 0) {
+    else if (sub == KW_ZERO) {
         if (monitorSystem->calibrateWeightSensorZero()) {
-            snprintf(response, responseSize, "zero calibration completed");
+            out.print("zero calibration completed");
         } else {
-            snprintf(response, responseSize, "zero calibration failed");
+            out.print("zero calibration failed");
         }
     }
-    else if (strcasecmp(param, "calibrate") == 0) {
+    else if (sub == KW_CALIBRATE) {
         if (!value) {
-            snprintf(response, responseSize, "usage: weight calibrate <known_weight>");
+            out.print("usage: weight calibrate <known_weight>");
             return;
         }
         
         float knownWeight = atof(value);
         if (knownWeight <= 0) {
-            snprintf(response, responseSize, "known weight must be positive");
+            out.print("known weight must be positive");
             return;
         }
         
         if (monitorSystem->calibrateWeightSensorScale(knownWeight)) {
-            snprintf(response, responseSize, "scale calibrated with weight %.2f", knownWeight);
+            out.printf("scale calibrated with weight %.2f", knownWeight);
         } else {
-            snprintf(response, responseSize, "scale calibration failed");
+            out.print("scale calibration failed");
         }
     }
-    else if (strcasecmp(param, "status") == 0) {
+    else if (sub == KW_STATUS) {
         NAU7802Status status = monitorSystem->getWeightSensorStatus();
         bool ready = monitorSystem->isWeightSensorReady();
         float weight = monitorSystem->getWeight();
         long raw = monitorSystem->getRawWeight();
         
-        snprintf(response, responseSize, 
+        out.printf(
             "status: %s, ready: %s, weight: %.3f, raw: %ld",
             (status == NAU7802_OK) ? "OK" : "ERROR",
             ready ? "YES" : "NO",
             weight, raw);
     }
-    else if (strcasecmp(param, "save") == 0) {
+    else if (sub == KW_SAVE) {
         if (monitorSystem->saveWeightCalibration()) {
-            snprintf(response, responseSize, "weight calibration saved to EEPROM");
+            out.print("weight calibration saved to EEPROM");
         } else {
-            snprintf(response, responseSize, "failed to save weight calibration");
+            out.print("failed to save weight calibration");
         }
     }
-    else if (strcasecmp(param, "load") == 0) {
+    else if (sub == KW_LOAD) {
         if (monitorSystem->loadWeightCalibration()) {
-            snprintf(response, responseSize, "weight calibration loaded from EEPROM");
+            out.print("weight calibration loaded from EEPROM");
         } else {
-            snprintf(response, responseSize, "failed to load weight calibration");
+            out.print("failed to load weight calibration");
+        }
+    }
+    else if (sub == KW_RATE) {
+        NAU7802Sensor* sensor = monitorSystem->getWeightSensor();
+        if (value) {
+            // Accept the rate in SPS and map it to the register code
+            unsigned long sps = strtoul(value, NULL, 10);
+            char* decimationStr = strtok(NULL, " ");
+            unsigned long decimation = decimationStr ? strtoul(decimationStr, NULL, 10) : sensor->getDecimation();
+            uint8_t rate = 0xFF;
+            for (uint8_t code = 0; code <= NAU7802_SPS_320; code++) {
+                if (sps && NAU7802Sensor::sampleRateSps(code) == sps) rate = code;
+            }
+            if (rate == 0xFF || decimation == 0 || decimation > NAU7802_MAX_DECIMATION) {
+                out.printf("usage: weight rate <10|20|40|80|320> [decimation 1-%d]",
+                    NAU7802_MAX_DECIMATION);
+                return;
+            }
+            if (!monitorSystem->setWeightAcquisition(rate, (uint8_t)decimation)) {
+                out.print("failed to set weight acquisition");
+                return;
+            }
         }
+        
+        uint16_t sps = NAU7802Sensor::sampleRateSps(sensor->getSampleRate());
+        out.printf(
+            "weight: %u SPS, decimation %u, %u.%u filtered samples/s, conversions=%lu",
+            sps, sensor->getDecimation(), sps / sensor->getDecimation(),
+            (sps * 10 / sensor->getDecimation()) % 10,
+            (unsigned long)sensor->getConversionCount());
     }
     else {
-        snprintf(response, responseSize, "unknown weight command: %s", param);
+        out.printf("unknown weight command: %s", param);
     }
 }
 
-void CommandProcessor::handleTemperature(char* param, char* value, char* response, size_t responseSize) {
+void CommandProcessor::handleTemperature(char* param, char* value, ResponseSink& out) {
     if (!monitorSystem) {
-        snprintf(response, responseSize, "monitor system not available");
+        out.print("monitor system not available");
         return;
     }
     
     if (!param) {
-        snprintf(response, responseSize, "temp commands: read, readc, local, remote, localc, remotec, status, offset");
+        out.print("temp commands: read, readc, local, remote, localc, remotec, status, offset");
         return;
     }
     
-    if (strcasecmp(param, "read") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_READ) {
         bool ready = monitorSystem->isTemperatureSensorReady();
         if (ready) {
             float localTempF = monitorSystem->getLocalTemperatureF();
             float remoteTempF = monitorSystem->getRemoteTemperatureF();
-            snprintf(response, responseSize, "local: %.2fF, remote: %.2fF", localTempF, remoteTempF);
+            out.printf("local: %.2fF, remote: %.2fF", localTempF, remoteTempF);
         } else {
-            snprintf(response, responseSize, "temperature sensor not available");
+            out.print("temperature sensor not available");
         }
     }
-    else if (strcasecmp(param, "readc") == 0) {
+    else if (sub == KW_READC) {
         bool ready = monitorSystem->isTemperatureSensorReady();
         if (ready) {
             float localTemp = monitorSystem->getLocalTemperature();
             float remoteTemp = monitorSystem->getRemoteTemperature();
-            snprintf(response, responseSize, "local: %.2fC, remote: %.2fC", localTemp, remoteTemp);
+            out.printf("local: %.2fC, remote: %.2fC", localTemp, remoteTemp);
         } else {
-            snprintf(response, responseSize, "temperature sensor not available");
+            out.print("temperature sensor not available");
         }
     }
-    else if (strcasecmp(param, "local") == 0) {
+    else if (sub == KW_LOCAL) {
         float localTempF = monitorSystem->getLocalTemperatureF();
-        snprintf(response, responseSize, "local temperature: %.2f┬░F", localTempF);
+        out.printf("local temperature: %.2f┬░F", localTempF);
     }
-    else if (strcasecmp(param, "localc") == 0) {
+    else if (sub == KW_LOCALC) {
         float localTemp = monitorSystem->getLocalTemperature();
-        snprintf(response, responseSize, "local temperature: %.2f┬░C", localTemp);
+        out.printf("local temperature: %.2f┬░C", localTemp);
     }
-    else if (strcasecmp(param, "remote") == 0) {
+    else if (sub == KW_REMOTE) {
         float remoteTempF = monitorSystem->getRemoteTemperatureF();
-        snprintf(response, responseSize, "remote temperature: %.2f┬░F", remoteTempF);
+        out.printf("remote temperature: %.2f┬░F", remoteTempF);
     }
-    else if (strcasecmp(param, "remotec") == 0) {
+    else if (sub == KW_REMOTEC) {
         float remoteTemp = monitorSystem->getRemoteTemperature();
-        snprintf(response, responseSize, "remote temperature: %.2f┬░C", remoteTemp);
+        out.printf("remote temperature: %.2f┬░C", remoteTemp);
     }
-    else if (strcasecmp(param, "status") == 0) {
+    else if (sub == KW_STATUS) {
         char statusBuffer[256];
         monitorSystem->getTemperatureSensorStatus(statusBuffer, sizeof(statusBuffer));
-        snprintf(response, responseSize, "%s", statusBuffer);
+        out.printf("%s", statusBuffer);
     }
-    else if (strcasecmp(param, "offset") == 0) {
+    else if (sub == KW_OFFSET) {
         if (!value) {
-            snprintf(response, responseSize, "usage: temp offset <local_offset> <remote_offset>");
+            out.print("usage: temp offset <local_offset> <remote_offset>");
             return;
         }
         
@@ -800,7 +1281,7 @@ void CommandProcessor::handleTemperature(char* param, char* value, char* respons
         char* remoteStr = strtok(NULL, " ");
         
         if (!remoteStr) {
-            snprintf(response, responseSize, "usage: temp offset <local_offset> <remote_offset>");
+            out.print("usage: temp offset <local_offset> <remote_offset>");
             return;
         }
         
@@ -808,11 +1289,11 @@ void CommandProcessor::handleTemperature(char* param, char* value, char* respons
         float remoteOffset = atof(remoteStr);
         
         monitorSystem->setTemperatureOffset(localOffset, remoteOffset);
-        snprintf(response, responseSize, "temperature offsets set: local=%.2f┬░C, remote=%.2f┬░C", 
+        out.printf("temperature offsets set: local=%.2f┬░C, remote=%.2f┬░C", 
                 localOffset, remoteOffset);
     }
     else {
-        snprintf(response, responseSize, "unknown temperature command: %s", param);
+        out.printf("unknown temperature command: %s", param);
     }
 }
 
@@ -820,24 +1301,14 @@ void CommandProcessor::handleTemperature(char* param, char* value, char* respons
 bool CommandValidator::isValidCommand(const char* cmd) {
     if (!cmd || strlen(cmd) == 0 || strlen(cmd) > MAX_CMD_LENGTH) return false;
     
-    // Check against whitelist
-    for (int i = 0; ALLOWED_COMMANDS[i] != nullptr; i++) {
-        if (strcasecmp(cmd, ALLOWED_COMMANDS[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    // Whitelist: keywords flagged as commands
+    Keyword keyword = lookupKeyword(cmd);
+    return keyword != KW_NONE && (KEYWORDS[keyword].flags & KW_COMMAND);
 }
 
 bool CommandValidator::isValidSetParam(const char* param) {
-    if (!param || strlen(param) == 0) return false;
-    
-    for (int i = 0; ALLOWED_SET_PARAMS[i] != nullptr; i++) {
-        if (strcasecmp(param, ALLOWED_SET_PARAMS[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    Keyword keyword = lookupKeyword(param);
+    return keyword != KW_NONE && (KEYWORDS[keyword].flags & KW_SET_PARAM);
 }
 
 bool CommandValidator::validateCommand(const char* command) {
@@ -848,7 +1319,8 @@ bool CommandValidator::validateSetCommand(const char* param, const char* value)
     if (!isValidSetParam(param) || !value) return false;
     
     // Additional parameter-specific validation
-    if (strcasecmp(param, "interval") == 0 || strcasecmp(param, "heartbeat") == 0) {
+    Keyword keyword = lookupKeyword(param);
+    if (keyword == KW_INTERVAL || keyword == KW_HEARTBEAT) {
         unsigned long val = strtoul(value, NULL, 10);
         return (val >= 1000 && val <= 600000);
     }
@@ -873,6 +1345,10 @@ void CommandValidator::sanitizeInput(char* input, size_t maxLength) {
     }
 }
 
+bool CommandValidator::isRateLimited() {
+    return millis() - lastCommandTime < COMMAND_RATE_LIMIT_MS;
+}
+
 bool CommandValidator::checkRateLimit() {
     unsigned long now = millis();
     if (now - lastCommandTime < COMMAND_RATE_LIMIT_MS) {
@@ -882,95 +1358,97 @@ bool CommandValidator::checkRateLimit() {
     return true;
 }
 
-void CommandProcessor::handleLCD(char* param, char* value, char* response, size_t responseSize) {
+// Send console changes now instead of waiting for the next scheduled LCD refresh
+static void flushLCD() {
+    if (g_i2cMux) g_i2cMux->selectChannel(TCA9548A_Multiplexer::MUX_CHANNEL_7, 50);
+    g_lcdDisplay->flush();
+}
+
+void CommandProcessor::handleLCD(char* param, char* value, ResponseSink& out) {
     if (!g_lcdDisplay) {
-        snprintf(response, responseSize, "LCD display not available");
+        out.print("LCD display not available");
         return;
     }
     
     if (!param) {
-        snprintf(response, responseSize, "LCD status: %s, backlight: %s", 
+        out.printf("LCD status: %s, backlight: %s", 
             g_lcdDisplay->isEnabled() ? "ON" : "OFF",
             g_lcdDisplay->isBacklightEnabled() ? "ON" : "OFF");
         return;
     }
     
-    if (strcasecmp(param, "on") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_ON) {
         g_lcdDisplay->setEnabled(true);
-        snprintf(response, responseSize, "LCD display enabled");
+        out.print("LCD display enabled");
     }
-    else if (strcasecmp(param, "off") == 0) {
+    else if (sub == KW_OFF) {
         g_lcdDisplay->setEnabled(false);
-        snprintf(response, responseSize, "LCD display disabled");
+        out.print("LCD display disabled");
     }
-    else if (strcasecmp(param, "clear") == 0) {
+    else if (sub == KW_CLEAR) {
         g_lcdDisplay->clear();
-        snprintf(response, responseSize, "LCD display cleared");
+        flushLCD();
+        out.print("LCD display cleared");
     }
-    else if (strcasecmp(param, "backlight") == 0) {
+    else if (sub == KW_BACKLIGHT) {
         if (!value) {
-            snprintf(response, responseSize, "LCD backlight: %s", 
+            out.printf("LCD backlight: %s", 
                 g_lcdDisplay->isBacklightEnabled() ? "ON" : "OFF");
             return;
         }
         
-        if (strcasecmp(value, "on") == 0) {
-            g_lcdDisplay->setBacklight(true);
-            snprintf(response, responseSize, "LCD backlight enabled");
-        }
-        else if (strcasecmp(value, "off") == 0) {
-            g_lcdDisplay->setBacklight(false);
-            snprintf(response, responseSize, "LCD backlight disabled");
+        bool enabled;
+        if (parseOnOff(value, enabled)) {
+            g_lcdDisplay->setBacklight(enabled);
+            out.printf("LCD backlight %s", enabled ? "enabled" : "disabled");
         }
         else {
-            snprintf(response, responseSize, "usage: lcd backlight on|off");
+            out.print("usage: lcd backlight on|off");
         }
     }
-    else if (strcasecmp(param, "info") == 0) {
+    else if (sub == KW_INFO) {
         if (value) {
             g_lcdDisplay->showInfo(value);
-            snprintf(response, responseSize, "LCD info message displayed");
+            flushLCD();
+            out.print("LCD info message displayed");
         } else {
-            snprintf(response, responseSize, "usage: lcd info <message>");
+            out.print("usage: lcd info <message>");
         }
     }
-    else if (strcasecmp(param, "test") == 0) {
+    else if (sub == KW_TEST) {
         // Test LCD by displaying test messages
         g_lcdDisplay->clear();
-        delay(100);
         g_lcdDisplay->showInfo("LCD TEST - Line 4");
-        delay(1000);
+        flushLCD();
+        cooperativeDelay(1000);
         g_lcdDisplay->showError("LCD ERROR Test");
-        delay(1000);
+        flushLCD();
+        cooperativeDelay(1000);
         g_lcdDisplay->showInfo("Display Working!");
-        snprintf(response, responseSize, "LCD test pattern displayed");
+        flushLCD();
+        out.print("LCD test pattern displayed");
     }
-    else if (strcasecmp(param, "reinit") == 0) {
+    else if (sub == KW_REINIT) {
         // Reinitialize the LCD
-        // First, select the LCD channel (7) on the multiplexer at 0x70
-        Wire1.beginTransmission(0x70);
-        Wire1.write(1 << 7);  // Select channel 7 for LCD
-        Wire1.endTransmission();
-        delay(50);  // Allow channel to stabilize
+        // First, select the LCD channel (7) on the multiplexer
+        if (g_i2cMux) g_i2cMux->selectChannel(TCA9548A_Multiplexer::MUX_CHANNEL_7, 50);
         
         bool success = g_lcdDisplay->begin();
         if (success) {
-            // Select LCD channel again before writing
-            Wire1.beginTransmission(0x70);
-            Wire1.write(1 << 7);  // Select channel 7 for LCD
-            Wire1.endTransmission();
-            delay(50);
             g_lcdDisplay->showInfo("LCD Reinitialized");
-            snprintf(response, responseSize, "LCD reinitialized successfully");
+            g_lcdDisplay->flush();
+            out.print("LCD reinitialized successfully");
         } else {
-            snprintf(response, responseSize, "LCD reinitialization failed");
+            out.print("LCD reinitialization failed");
         }
     }
-    else if (strcasecmp(param, "refresh") == 0) {
+    else if (sub == KW_REFRESH) {
         // Force an immediate LCD update with current system data
         if (monitorSystem) {
-            g_lcdDisplay->clear();
-            delay(100);
+            // Rewrite every cell, not just the ones that changed
+            g_lcdDisplay->invalidate();
             
             // Manually trigger a display update
             bool wifiConnected = networkManager && networkManager->isWiFiConnected();
@@ -996,19 +1474,25 @@ void CommandProcessor::handleLCD(char* param, char* value, char* response, size_
             float adcVoltage = monitorSystem->getAdcVoltage();
             
             g_lcdDisplay->updateAdditionalSensors(voltage, current, adcVoltage);
+            flushLCD();
             
-            snprintf(response, responseSize, "LCD refreshed: F=%.1fgal T=%.1fF", fuelGallons, localTempF);
+            out.printf("LCD refreshed: F=%.1fgal T=%.1fF", fuelGallons, localTempF);
         } else {
-            snprintf(response, responseSize, "Monitor system not available");
+            out.print("Monitor system not available");
         }
     }
+    else if (sub == KW_STATS) {
+        out.fill([&](char* buffer, size_t size) { g_lcdDisplay->getStatistics(buffer, size); });
+    }
     else {
-        snprintf(response, responseSize, "usage: lcd [on|off|clear|backlight|info|test|reinit|refresh]");
+        out.print("usage: lcd [on|off|clear|backlight|info|test|reinit|refresh|stats]");
     }
 }
 
-void CommandProcessor::handleLogLevel(const char* param, char* response, size_t responseSize) {
-    if (!param || strcasecmp(param, "get") == 0) {
+void CommandProcessor::handleLogLevel(const char* param, ResponseSink& out) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (!param || sub == KW_GET) {
         // Show current log level
         LogLevel currentLevel = Logger::getLogLevel();
         const char* levelName;
@@ -1023,14 +1507,18 @@ void CommandProcessor::handleLogLevel(const char* param, char* response, size_t
             case LOG_DEBUG: levelName = "DEBUG"; break;
             default: levelName = "UNKNOWN"; break;
         }
-        snprintf(response, responseSize, "Current log level: %d (%s)", currentLevel, levelName);
+        out.printf("Current log level: %d (%s), compiled in: 0-%d",
+            currentLevel, levelName, LOG_COMPILE_LEVEL);
+    }
+    else if (sub == KW_SITES) {
+        Logger::getSiteStatistics(out);
     }
-    else if (strcasecmp(param, "list") == 0) {
-        snprintf(response, responseSize, 
+    else if (sub == KW_LIST) {
+        out.printf(
             "Log levels: 0=EMERGENCY, 1=ALERT, 2=CRITICAL, 3=ERROR, 4=WARNING, 5=NOTICE, 6=INFO, 7=DEBUG");
     }
-    else if (strcasecmp(param, "set") == 0) {
-        snprintf(response, responseSize, "usage: loglevel set <0-7>");
+    else if (sub == KW_SET) {
+        out.print("usage: loglevel set <0-7>");
     }
     else {
         // Try to parse as log level number
@@ -1049,33 +1537,37 @@ void CommandProcessor::handleLogLevel(const char* param, char* response, size_t
                 case LOG_DEBUG: levelName = "DEBUG"; break;
                 default: levelName = "UNKNOWN"; break;
             }
-            snprintf(response, responseSize, "Log level set to %d (%s)", level, levelName);
+            if (level > LOG_COMPILE_LEVEL) {
+                out.printf("Log level set to %d (%s), but this build only has levels 0-%d",
+                    level, levelName, LOG_COMPILE_LEVEL);
+            } else {
+                out.printf("Log level set to %d (%s)", level, levelName);
+            }
         } else {
-            snprintf(response, responseSize, "usage: loglevel [get|list|<0-7>]");
+            out.print("usage: loglevel [get|list|sites|<0-7>]");
         }
     }
 }
 
-void CommandProcessor::handleI2C(char* param, char* response, size_t responseSize) {
+void CommandProcessor::handleI2C(char* param, ResponseSink& out) {
     if (!param) {
-        snprintf(response, responseSize, "i2c commands: scan, status, show");
+        out.print("i2c commands: scan, status, show, mux, stats");
         return;
     }
     
-    if (strcasecmp(param, "scan") == 0) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (sub == KW_SCAN) {
         // Perform I2C scan on Wire1
         debugPrintf("Starting I2C scan on Wire1...\n");
         
         // Disable all multiplexer channels first to scan only main bus devices
-        TCA9548A_Multiplexer i2cMux(0x70);
-        if (i2cMux.begin()) {
-            i2cMux.disableAllChannels();
-            delay(50);
+        if (g_i2cMux && g_i2cMux->disableAllChannels()) {
+            cooperativeDelay(50);
         }
         
         int deviceCount = 0;
-        char scanResult[512] = "I2C Scan Results (Wire1):\r\n";
-        char tempStr[64];
+        out.print("I2C Scan Results (Wire1):\r\n");
         
         for (uint8_t address = 1; address < 127; address++) {
             Wire1.beginTransmission(address);
@@ -1083,27 +1575,23 @@ void CommandProcessor::handleI2C(char* param, char* response, size_t responseSiz
             
             if (error == 0) {
                 deviceCount++;
-                snprintf(tempStr, sizeof(tempStr), "Device found at 0x%02X", address);
                 
                 // Add device identification
+                const char* name = "";
                 if (address == 0x2A) {
-                    strcat(tempStr, " (NAU7802 Load Cell)");
+                    name = " (NAU7802 Load Cell)";
                 } else if (address == 0x60 || address == 0x67) {
-                    strcat(tempStr, " (MCP9600 Thermocouple)");
+                    name = " (MCP9600 Thermocouple)";
                 } else if (address == 0x40 || address == 0x44 || address == 0x41 || address == 0x45) {
-                    strcat(tempStr, " (INA219 Power Monitor)");
+                    name = " (INA219 Power Monitor)";
                 } else if (address == 0x68) {
-                    strcat(tempStr, " (MCP3421 ADC)");
+                    name = " (MCP3421 ADC)";
                 } else if (address == 0x27 || address == 0x3F) {
-                    strcat(tempStr, " (LCD Display)");
+                    name = " (LCD Display)";
                 } else if (address == 0x70) {
-                    strcat(tempStr, " (TCA9548A I2C Mux)");
-                }
-                
-                strcat(tempStr, "\r\n");
-                if (strlen(scanResult) + strlen(tempStr) < sizeof(scanResult) - 1) {
-                    strcat(scanResult, tempStr);
+                    name = " (TCA9548A I2C Mux)";
                 }
+                out.printf("Device found at 0x%02X%s\r\n", address, name);
                 
                 debugPrintf("Found I2C device at 0x%02X\n", address);
             }
@@ -1113,24 +1601,17 @@ void CommandProcessor::handleI2C(char* param, char* response, size_t responseSiz
         }
         
         if (deviceCount == 0) {
-            strcat(scanResult, "No I2C devices found on Wire1\r\n");
-            strcat(scanResult, "Check connections and power");
+            out.print("No I2C devices found on Wire1\r\n");
+            out.print("Check connections and power");
             debugPrintf("No I2C devices found on Wire1\n");
         } else {
-            snprintf(tempStr, sizeof(tempStr), "Total devices found: %d", deviceCount);
-            if (strlen(scanResult) + strlen(tempStr) < sizeof(scanResult) - 1) {
-                strcat(scanResult, tempStr);
-            }
+            out.printf("Total devices found: %d", deviceCount);
             debugPrintf("I2C scan complete: %d devices found\n", deviceCount);
         }
-        
-        strncpy(response, scanResult, responseSize - 1);
-        response[responseSize - 1] = '\0';
     }
-    else if (strcasecmp(param, "status") == 0) {
+    else if (sub == KW_STATUS) {
         // Show I2C bus status
-        char statusStr[256];
-        snprintf(statusStr, sizeof(statusStr), 
+        out.printf(
             "I2C Wire1 Status:\r\n"
             "Bus: Wire1 (Arduino R4 WiFi)\r\n"
             "Clock: 100kHz\r\n"
@@ -1138,54 +1619,34 @@ void CommandProcessor::handleI2C(char* param, char* response, size_t responseSiz
             "SCL Pin: A5 (19)\r\n"
             "Bus State: %s",
             "Active"); // Could add actual bus state detection
-        
-        strncpy(response, statusStr, responseSize - 1);
-        response[responseSize - 1] = '\0';
         debugPrintf("I2C status requested\n");
     }
-    else if (strcasecmp(param, "show") == 0) {
-        // Show known I2C device configurations
-        char showStr[400];
-        snprintf(showStr, sizeof(showStr),
-            "Expected I2C Devices on Wire1:\r\n"
-            "0x2A - NAU7802 Load Cell Sensor\r\n"
-            "0x60/0x67 - MCP9600 Thermocouple\r\n"
-            "0x40-0x4F - INA219 Power Monitor\r\n"
-            "0x68 - MCP3421 ADC\r\n"
-            "0x27/0x3F - LCD Display\r\n"
-            "0x70 - TCA9548A I2C Multiplexer\r\n"
-            "\r\nUse 'i2c scan' to detect connected devices");
-        
-        strncpy(response, showStr, responseSize - 1);
-        response[responseSize - 1] = '\0';
+    else if (sub == KW_SHOW) {
+        // Known device map as probed at boot
+        if (monitorSystem) {
+            monitorSystem->getDeviceMap(out);
+            out.print("\r\n");
+        }
+        out.print("Use 'i2c scan' for a full scan of the bus");
         debugPrintf("I2C device list requested\n");
     }
-    else if (strcasecmp(param, "mux") == 0) {
-        // Scan through multiplexer channels
-        char muxResult[512] = "Scanning through TCA9548A channels:\r\n";
-        char tempStr[80];
-        
+    else if (sub == KW_MUX) {
         // Check if multiplexer is present at 0x70
-        Wire1.beginTransmission(0x70);
-        uint8_t error = Wire1.endTransmission();
-        
-        if (error != 0) {
-            snprintf(response, responseSize, "TCA9548A multiplexer not found at 0x70");
+        if (!g_i2cMux || !g_i2cMux->isConnected()) {
+            out.print("TCA9548A multiplexer not found at 0x70");
             return;
         }
         
+        // Scan through multiplexer channels
+        out.print("Scanning through TCA9548A channels:\r\n");
         debugPrintf("Scanning I2C multiplexer channels...\n");
         
         // Scan each channel (0-7)
         for (uint8_t channel = 0; channel < 8; channel++) {
             // Select channel
-            Wire1.beginTransmission(0x70);
-            Wire1.write(1 << channel);
-            Wire1.endTransmission();
-            delay(10);
+            g_i2cMux->selectChannel(channel, 10);
             
-            snprintf(tempStr, sizeof(tempStr), "Ch%d: ", channel);
-            strcat(muxResult, tempStr);
+            out.printf("Ch%d: ", channel);
             
             bool foundDevice = false;
             
@@ -1194,78 +1655,77 @@ void CommandProcessor::handleI2C(char* param, char* response, size_t responseSiz
                 if (addr == 0x70) continue; // Skip mux address
                 
                 Wire1.beginTransmission(addr);
-                error = Wire1.endTransmission();
+                uint8_t error = Wire1.endTransmission();
                 
                 if (error == 0) {
                     foundDevice = true;
-                    snprintf(tempStr, sizeof(tempStr), "0x%02X ", addr);
                     
                     // Add device name if known
-                    if (addr == 0x2A) strcat(tempStr, "(NAU7802) ");
-                    else if (addr == 0x60 || addr == 0x67) strcat(tempStr, "(MCP9600) ");
-                    else if (addr >= 0x40 && addr <= 0x4F) strcat(tempStr, "(INA219) ");
-                    else if (addr == 0x68) strcat(tempStr, "(MCP3421) ");
-                    
-                    if (strlen(muxResult) + strlen(tempStr) < sizeof(muxResult) - 10) {
-                        strcat(muxResult, tempStr);
-                    }
+                    const char* name = "";
+                    if (addr == 0x2A) name = "(NAU7802) ";
+                    else if (addr == 0x60 || addr == 0x67) name = "(MCP9600) ";
+                    else if (addr >= 0x40 && addr <= 0x4F) name = "(INA219) ";
+                    else if (addr == 0x68) name = "(MCP3421) ";
+                    out.printf("0x%02X %s", addr, name);
                     
                     debugPrintf("Found device at 0x%02X on channel %d\n", addr, channel);
                 }
             }
             
             if (!foundDevice) {
-                strcat(muxResult, "none");
+                out.print("none");
             }
-            strcat(muxResult, "\r\n");
+            out.print("\r\n");
         }
         
         // Disable all channels when done
-        Wire1.beginTransmission(0x70);
-        Wire1.write(0);
-        Wire1.endTransmission();
-        
-        strncpy(response, muxResult, responseSize - 1);
-        response[responseSize - 1] = '\0';
+        g_i2cMux->disableAllChannels();
         debugPrintf("Multiplexer channel scan complete\n");
     }
+    else if (sub == KW_STATS) {
+        if (!g_i2cMux) {
+            out.print("i2c multiplexer not available");
+            return;
+        }
+        out.fill([&](char* buffer, size_t size) { g_i2cMux->getStatistics(buffer, size); });
+        out.print("\r\n");
+        I2CBus::getStatistics(out);
+    }
     else {
-        snprintf(response, responseSize, "unknown i2c command: %s", param);
+        out.printf("unknown i2c command: %s", param);
     }
 }
 
-void CommandProcessor::handleBridge(char* param, char* response, size_t responseSize) {
-    if (!param) {
-        const char* telemetryStr = "unknown";
-        switch (serialBridge.getTelemetryState()) {
-            case TELEMETRY_ENABLED: telemetryStr = "enabled"; break;
-            case TELEMETRY_DISABLED: telemetryStr = "disabled"; break;
-            case TELEMETRY_UNKNOWN: telemetryStr = "unknown"; break;
-        }
-        snprintf(response, responseSize, "bridge status: %s, received: %lu, forwarded: %lu, telemetry: %s",
-            serialBridge.isConnected() ? "connected" : "disconnected",
-            serialBridge.getMessagesReceived(),
-            serialBridge.getMessagesForwarded(),
-            telemetryStr);
-    }
-    else if (strcasecmp(param, "status") == 0) {
+void CommandProcessor::handleBridge(char* param, char* value, ResponseSink& out) {
+    Keyword sub = lookupKeyword(param);
+    
+    if (!param || sub == KW_STATUS) {
         const char* telemetryStr = "unknown";
         switch (serialBridge.getTelemetryState()) {
             case TELEMETRY_ENABLED: telemetryStr = "enabled"; break;
             case TELEMETRY_DISABLED: telemetryStr = "disabled"; break;
             case TELEMETRY_UNKNOWN: telemetryStr = "unknown"; break;
         }
-        snprintf(response, responseSize, "bridge status: %s, received: %lu, forwarded: %lu, telemetry: %s",
+        out.printf("bridge status: %s, received: %lu, forwarded: %lu, telemetry: %s, backlog: %u/%u%s",
             serialBridge.isConnected() ? "connected" : "disconnected",
             serialBridge.getMessagesReceived(),
             serialBridge.getMessagesForwarded(),
-            telemetryStr);
+            telemetryStr,
+            g_storeForward ? (unsigned)g_storeForward->getBacklog() : 0,
+            g_storeForward ? (unsigned)g_storeForward->getCapacity() : 0,
+            (g_storeForward && g_storeForward->isReplaying()) ? " (replaying)" : "");
     }
-    else if (strcasecmp(param, "stats") == 0) {
+    else if (sub == KW_STATS) {
         // Use the getStatistics method from SerialBridge
-        serialBridge.getStatistics(response, responseSize);
+        out.fill([&](char* buffer, size_t size) { serialBridge.getStatistics(buffer, size); });
+        
+        // Append store-and-forward log state
+        if (g_storeForward) {
+            out.print("\nStore & Forward: ");
+            out.fill([&](char* buffer, size_t size) { g_storeForward->getStatistics(buffer, size); });
+        }
     }
-    else if (strcasecmp(param, "telemetry") == 0) {
+    else if (sub == KW_TELEMETRY) {
         // Note: The SerialBridge class doesn't have telemetry control methods
         // Telemetry state is read-only based on controller messages
         const char* telemetryStr = "unknown";
@@ -1274,14 +1734,80 @@ void CommandProcessor::handleBridge(char* param, char* response, size_t response
             case TELEMETRY_DISABLED: telemetryStr = "disabled"; break;
             case TELEMETRY_UNKNOWN: telemetryStr = "unknown"; break;
         }
-        snprintf(response, responseSize, "telemetry state: %s (read-only, controlled by controller)", telemetryStr);
+        out.printf("telemetry state: %s (read-only, controlled by controller)", telemetryStr);
+    }
+    else if (sub == KW_LOSS) {
+        serialBridge.getSequenceStatistics(out);
+    }
+    else if (sub == KW_LANES) {
+        serialBridge.getLaneStatistics(out);
+    }
+    else if (sub == KW_METRICS) {
+        serialBridge.getMetricsReport(out);
+    }
+    else if (sub == KW_RESET) {
+        // Message counters are managed internally; only sequence tracking restarts
+        serialBridge.resetSequenceStatistics();
+        out.print("bridge sequence loss statistics reset");
+    }
+    else if (sub == KW_BENCH) {
+        Keyword action = lookupKeyword(value);
+        if (!value) {
+            serialBridge.getBenchReport(out);
+        }
+        else if (action == KW_STOP) {
+            serialBridge.stopBench();
+            out.print("bridge bench stopped");
+        }
+        else if (serialBridge.isBenchRunning()) {
+            out.print("bridge bench already running (use 'bridge bench stop')");
+        }
+        else if (action == KW_RAMP) {
+            if (serialBridge.startBenchRamp()) {
+                out.printf("bridge bench ramp started (%u ms steps), see 'bridge bench'", BENCH_RAMP_STEP_MS);
+            } else {
+                out.print("bridge bench needs the bridge and MQTT connected");
+            }
+        }
+        else {
+            char* secondsStr = strtok(NULL, " ");
+            unsigned long rate = strtoul(value, NULL, 10);
+            unsigned long seconds = secondsStr ? strtoul(secondsStr, NULL, 10) : BENCH_DEFAULT_SECONDS;
+            if (rate < BENCH_MIN_RATE_HZ || rate > BENCH_MAX_RATE_HZ || seconds < 1 || seconds > BENCH_MAX_SECONDS) {
+                out.printf("usage: bridge bench <%d-%d hz> [1-%d s] | ramp | stop",
+                    BENCH_MIN_RATE_HZ, BENCH_MAX_RATE_HZ, BENCH_MAX_SECONDS);
+            } else if (serialBridge.startBench((uint16_t)rate, (uint16_t)seconds)) {
+                out.printf("bridge bench started: %lu Hz for %lu s, see 'bridge bench'", rate, seconds);
+            } else {
+                out.print("bridge bench needs the bridge and MQTT connected");
+            }
+        }
     }
-    else if (strcasecmp(param, "reset") == 0) {
-        // Note: The SerialBridge class doesn't have a reset method
-        // Statistics are managed internally
-        snprintf(response, responseSize, "bridge reset not supported - statistics managed internally");
+    else if (sub == KW_CMD) {
+        Keyword action = lookupKeyword(value);
+        if (!value) {
+            serialBridge.getCommandStatistics(out);
+        }
+        else if (action == KW_ON || action == KW_OFF) {
+            serialBridge.setCommandsEnabled(action == KW_ON);
+            out.printf("controller commands %s", action == KW_ON ? "enabled" : "disabled");
+        }
+        else if (action == KW_SEND) {
+            char* text = strtok(NULL, "");
+            uint16_t id = text ? serialBridge.sendControllerCommand(text, "console") : 0;
+            if (id != 0) {
+                out.printf("command #%u sent, result on %s", id, TOPIC_CONTROLLER_RESPONSE);
+            } else if (!serialBridge.areCommandsEnabled()) {
+                out.print("controller commands disabled (use 'bridge cmd on')");
+            } else {
+                out.printf("command not sent (1-%d chars, at most %d in flight)", COMMAND_TEXT_MAX, COMMAND_MAX_IN_FLIGHT);
+            }
+        }
+        else {
+            out.print("usage: bridge cmd [on|off|send <text>]");
+        }
     }
     else {
-        snprintf(response, responseSize, "unknown bridge command: %s (use status/stats/telemetry)", param);
+        out.printf("unknown bridge command: %s (use status/stats/loss/lanes/metrics/telemetry/reset/bench/cmd)", param);
     }
 }
@@ -0,0 +1,338 @@
+#include "config_log.h"
+#include "response_sink.h"
+#include "logger.h"
+#include <string.h>
+
+#define CONFIG_LOG_FREE 0xFF
+
+static const char* const CONFIG_LOG_PHASE_NAMES[] = { "idle", "write", "erase", "copy", "commit" };
+
+ConfigLog::ConfigLog()
+    : pendingKeys(0)
+    , initialized(false)
+    , activeBank(0)
+    , generation(0)
+    , tail(CONFIG_LOG_HEADER_SIZE)
+    , phase(PHASE_IDLE)
+    , writeKey(0)
+    , progress(0)
+    , copyKey(0)
+    , copyTail(CONFIG_LOG_HEADER_SIZE)
+    , compacted(false)
+    , recordsWritten(0)
+    , bytesWritten(0)
+    , compactions(0)
+    , recordsDropped(0)
+    , corruptRecords(0) {
+
+    memset(bindings, 0, sizeof(bindings));
+    memset(index, 0, sizeof(index));
+    memset(record, CONFIG_LOG_FREE, sizeof(record));
+}
+
+void ConfigLog::begin() {
+    uint16_t generations[2];
+    bool valid[2] = { readHeader(0, generations[0]), readHeader(1, generations[1]) };
+
+    if (valid[0] && valid[1]) {
+        // Wrap-safe: the bank written after the other one wins
+        activeBank = (int16_t)(generations[1] - generations[0]) > 0 ? 1 : 0;
+    } else if (valid[0] || valid[1]) {
+        activeBank = valid[0] ? 0 : 1;
+    } else {
+        // First boot: format bank 1, bank 0 still holds the legacy images
+        activeBank = 1;
+        for (uint16_t offset = 0; offset < CONFIG_LOG_BANK_SIZE; offset++) {
+            write(activeBank, offset, CONFIG_LOG_FREE);
+        }
+        generations[activeBank] = 1;
+        writeHeader(activeBank, generations[activeBank]);
+        LOG_INFO("ConfigLog: Formatted bank %u", activeBank);
+    }
+    generation = generations[activeBank];
+
+    scanBank();
+    initialized = true;
+    debugPrintf("ConfigLog: bank %u generation %u, %u bytes used\n", activeBank, generation, tail);
+}
+
+void ConfigLog::bind(uint8_t key, void* value, uint8_t size, uint8_t flags) {
+    if (key >= CONFIG_KEY_COUNT || !value || size == 0 || size > CONFIG_LOG_MAX_VALUE) return;
+
+    bindings[key].value = value;
+    bindings[key].size = size;
+    bindings[key].flags = flags;
+}
+
+bool ConfigLog::load(uint8_t key) {
+    if (!hasRecord(key) || !bindings[key].value) return false;
+
+    const Binding& binding = bindings[key];
+    uint16_t offset = index[key];
+    uint8_t length = read(activeBank, offset + 1);
+
+    // A layout change shows as a size mismatch: keep the default instead
+    if (binding.flags & CONFIG_LOG_STRING) {
+        if (length == 0 || length > binding.size) return false;
+    } else if (length != binding.size) {
+        return false;
+    }
+
+    uint8_t* value = (uint8_t*)binding.value;
+    memset(value, 0, binding.size);
+    for (uint8_t i = 0; i < length; i++) {
+        value[i] = read(activeBank, offset + CONFIG_LOG_RECORD_HEADER + i);
+    }
+    if (binding.flags & CONFIG_LOG_STRING) value[binding.size - 1] = '\0';
+    return true;
+}
+
+bool ConfigLog::commit(uint8_t key) {
+    if (!initialized || key >= CONFIG_KEY_COUNT || !bindings[key].value || !differs(key)) return false;
+
+    pendingKeys |= 1UL << key;
+    return true;
+}
+
+void ConfigLog::service() {
+    if (!initialized) return;
+
+    switch (phase) {
+        case PHASE_IDLE:
+            if (pendingKeys == 0) return;
+
+            // Lowest pending key first; the value is taken as it is now
+            for (writeKey = 0; !(pendingKeys & (1UL << writeKey)); writeKey++) {
+            }
+            buildRecord(writeKey);
+
+            if (tail + CONFIG_LOG_RECORD_HEADER + record[1] > CONFIG_LOG_BANK_SIZE) {
+                if (compacted) {
+                    // Still no room with only the newest records left
+                    pendingKeys &= ~(1UL << writeKey);
+                    recordsDropped++;
+                    compacted = false;
+                    LOG_ERROR("ConfigLog: No room for key %u after compaction", writeKey);
+                    return;
+                }
+                phase = PHASE_ERASE;
+                progress = 0;
+                return;
+            }
+
+            pendingKeys &= ~(1UL << writeKey);
+            phase = PHASE_WRITE;
+            progress = 1;   // Key byte last
+            return;
+
+        case PHASE_WRITE:
+            serviceWrite();
+            return;
+
+        case PHASE_ERASE:
+            serviceErase();
+            return;
+
+        case PHASE_COPY:
+            serviceCopy();
+            return;
+
+        case PHASE_COMMIT: {
+            // Header last: the new bank becomes the active one only now
+            uint8_t target = activeBank ^ 1;
+            generation++;
+            writeHeader(target, generation);
+            activeBank = target;
+            scanBank();
+            compactions++;
+            compacted = true;
+            phase = PHASE_IDLE;
+            debugPrintf("ConfigLog: Compacted into bank %u, %u bytes used\n", activeBank, tail);
+            return;
+        }
+    }
+}
+
+void ConfigLog::flush() {
+    while (!isIdle()) {
+        service();
+    }
+}
+
+void ConfigLog::serviceWrite() {
+    uint16_t recordEnd = CONFIG_LOG_RECORD_HEADER + record[1];
+
+    for (uint8_t n = 0; n < CONFIG_LOG_WRITE_SLICE_BYTES && progress < recordEnd; n++) {
+        write(activeBank, tail + progress, record[progress]);
+        progress++;
+    }
+    if (progress < recordEnd) return;
+
+    // Body complete - writing the key makes the record visible
+    write(activeBank, tail, record[0]);
+    index[writeKey] = tail;
+    tail += recordEnd;
+    recordsWritten++;
+    compacted = false;
+    phase = PHASE_IDLE;
+}
+
+void ConfigLog::serviceErase() {
+    // Header bytes go first, so a stale bank is never mistaken for a live one
+    uint8_t target = activeBank ^ 1;
+    uint8_t writes = 0;
+
+    for (uint8_t n = 0; n < CONFIG_LOG_ERASE_SLICE_BYTES && progress < CONFIG_LOG_BANK_SIZE; n++) {
+        if (read(target, progress) != CONFIG_LOG_FREE) {
+            if (writes == CONFIG_LOG_WRITE_SLICE_BYTES) return;
+            write(target, progress, CONFIG_LOG_FREE);
+            writes++;
+        }
+        progress++;
+    }
+    if (progress < CONFIG_LOG_BANK_SIZE) return;
+
+    phase = PHASE_COPY;
+    copyKey = 0;
+    copyTail = CONFIG_LOG_HEADER_SIZE;
+    progress = 0;
+}
+
+void ConfigLog::serviceCopy() {
+    while (copyKey < CONFIG_KEY_COUNT && index[copyKey] == 0) copyKey++;
+    if (copyKey >= CONFIG_KEY_COUNT) {
+        phase = PHASE_COMMIT;
+        return;
+    }
+
+    // Records are copied as stored, CRC included
+    uint8_t target = activeBank ^ 1;
+    uint16_t source = index[copyKey];
+    uint16_t recordEnd = CONFIG_LOG_RECORD_HEADER + read(activeBank, source + 1);
+
+    for (uint8_t n = 0; n < CONFIG_LOG_WRITE_SLICE_BYTES && progress < recordEnd; n++) {
+        write(target, copyTail + progress, read(activeBank, source + progress));
+        progress++;
+    }
+    if (progress < recordEnd) return;
+
+    copyTail += recordEnd;
+    copyKey++;
+    progress = 0;
+}
+
+void ConfigLog::write(uint8_t bank, uint16_t offset, uint8_t value) {
+    int address = bankAddress(bank) + offset;
+    if (EEPROM.read(address) == value) return;
+
+    EEPROM.write(address, value);
+    bytesWritten++;
+}
+
+bool ConfigLog::readHeader(uint8_t bank, uint16_t& bankGeneration) const {
+    uint16_t magic = read(bank, 0) | (read(bank, 1) << 8);
+    bankGeneration = read(bank, 2) | (read(bank, 3) << 8);
+    return magic == CONFIG_LOG_MAGIC;
+}
+
+void ConfigLog::writeHeader(uint8_t bank, uint16_t bankGeneration) {
+    // Generation before magic: a torn header reads as no header
+    write(bank, 2, (uint8_t)bankGeneration);
+    write(bank, 3, (uint8_t)(bankGeneration >> 8));
+    write(bank, 0, (uint8_t)CONFIG_LOG_MAGIC);
+    write(bank, 1, (uint8_t)(CONFIG_LOG_MAGIC >> 8));
+}
+
+void ConfigLog::scanBank() {
+    memset(index, 0, sizeof(index));
+
+    uint16_t offset = CONFIG_LOG_HEADER_SIZE;
+    while (offset + CONFIG_LOG_RECORD_HEADER <= CONFIG_LOG_BANK_SIZE) {
+        uint8_t key = read(activeBank, offset);
+        if (key == CONFIG_LOG_FREE) break;
+
+        uint8_t length = read(activeBank, offset + 1);
+        uint16_t recordEnd = CONFIG_LOG_RECORD_HEADER + length;
+        if (length > CONFIG_LOG_MAX_VALUE || offset + recordEnd > CONFIG_LOG_BANK_SIZE) {
+            // Length unreadable: nothing after it can be framed, append from here
+            corruptRecords++;
+            break;
+        }
+
+        uint8_t header[2] = { key, length };
+        uint8_t crc = crc8(header, sizeof(header));
+        for (uint8_t i = 0; i < length; i++) {
+            uint8_t byte = read(activeBank, offset + CONFIG_LOG_RECORD_HEADER + i);
+            crc = crc8(&byte, 1, crc);
+        }
+
+        if (crc != read(activeBank, offset + 2)) {
+            corruptRecords++;
+        } else if (key < CONFIG_KEY_COUNT) {
+            index[key] = offset;    // Keys from newer firmware are dropped at compaction
+        }
+        offset += recordEnd;
+    }
+    tail = offset;
+}
+
+uint8_t ConfigLog::valueLength(const Binding& binding) const {
+    if (binding.flags & CONFIG_LOG_STRING) {
+        return (uint8_t)strnlen((const char*)binding.value, binding.size - 1) + 1;
+    }
+    return binding.size;
+}
+
+bool ConfigLog::differs(uint8_t key) const {
+    if (!hasRecord(key)) return true;
+
+    const Binding& binding = bindings[key];
+    uint16_t offset = index[key];
+    uint8_t length = valueLength(binding);
+    if (read(activeBank, offset + 1) != length) return true;
+
+    const uint8_t* value = (const uint8_t*)binding.value;
+    for (uint8_t i = 0; i < length; i++) {
+        if (read(activeBank, offset + CONFIG_LOG_RECORD_HEADER + i) != value[i]) return true;
+    }
+    return false;
+}
+
+void ConfigLog::buildRecord(uint8_t key) {
+    const Binding& binding = bindings[key];
+    uint8_t length = valueLength(binding);
+
+    record[0] = key;
+    record[1] = length;
+    memcpy(&record[CONFIG_LOG_RECORD_HEADER], binding.value, length);
+    if (binding.flags & CONFIG_LOG_STRING) record[CONFIG_LOG_RECORD_HEADER + length - 1] = '\0';
+
+    uint8_t crc = crc8(record, 2);
+    record[2] = crc8(&record[CONFIG_LOG_RECORD_HEADER], length, crc);
+}
+
+uint8_t ConfigLog::crc8(const uint8_t* data, size_t length, uint8_t crc) {
+    // CRC-8, polynomial 0x07 (same as the store-and-forward log)
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void ConfigLog::getStatistics(ResponseSink& out) {
+    uint8_t keys = 0;
+    uint8_t pending = 0;
+    for (uint8_t key = 0; key < CONFIG_KEY_COUNT; key++) {
+        if (index[key]) keys++;
+        if (pendingKeys & (1UL << key)) pending++;
+    }
+
+    out.printf("config log: bank %u generation %u, %u/%u bytes used, %u keys, %u pending, %s",
+        activeBank, generation, tail, CONFIG_LOG_BANK_SIZE, keys, pending, CONFIG_LOG_PHASE_NAMES[phase]);
+    out.printf("\r\nrecords=%lu flash_bytes=%lu compactions=%lu dropped=%lu corrupt=%lu",
+        (unsigned long)recordsWritten, (unsigned long)bytesWritten, (unsigned long)compactions,
+        (unsigned long)recordsDropped, (unsigned long)corruptRecords);
+}
@@ -3,11 +3,77 @@
 
 ArduinoLEDMatrix matrix;
 
+// ===== Precomputed frames =====
+// The matrix takes 96 bits, row-major, MSB first: pixel (row, col) is bit
+// 31 - (row * 12 + col) % 32 of word (row * 12 + col) / 32.
+
+#define MATRIX_ROWS 8
+#define MATRIX_COLS 12
+
+struct MatrixMask {
+  uint32_t words[3];
+};
+
+static constexpr uint32_t pixelBit(uint8_t word, uint8_t row, uint8_t col) {
+  return (row * MATRIX_COLS + col) / 32 == word ? 1UL << (31 - (row * MATRIX_COLS + col) % 32) : 0;
+}
+
+// Bar two columns wide, `level` rows lit from the bottom
+static constexpr uint32_t barBits(uint8_t word, uint8_t col, uint8_t level, uint8_t row = 0) {
+  return row >= MATRIX_ROWS ? 0 :
+    ((row >= MATRIX_ROWS - level ? pixelBit(word, row, col) | pixelBit(word, row, col + 1) : 0) |
+     barBits(word, col, level, row + 1));
+}
+
+// Spinner glyph: three pixels in the top right 3x3 corner
+static constexpr uint32_t glyphBits(uint8_t word, uint8_t r0, uint8_t c0, uint8_t r1, uint8_t c1, uint8_t r2, uint8_t c2) {
+  return pixelBit(word, r0, c0) | pixelBit(word, r1, c1) | pixelBit(word, r2, c2);
+}
+
+#define GLYPH(r0, c0, r1, c1, r2, c2) { { glyphBits(0, r0, c0, r1, c1, r2, c2), \
+  glyphBits(1, r0, c0, r1, c1, r2, c2), glyphBits(2, r0, c0, r1, c1, r2, c2) } }
+
+#define BAR(col, level) { { barBits(0, col, level), barBits(1, col, level), barBits(2, col, level) } }
+#define BAR_LEVELS(col) { BAR(col, 0), BAR(col, 1), BAR(col, 2), BAR(col, 3), BAR(col, 4), \
+  BAR(col, 5), BAR(col, 6), BAR(col, 7), BAR(col, 8) }
+
+// Horizontal, falling diagonal, vertical, rising diagonal
+static constexpr MatrixMask SPINNER_FRAMES[4] = {
+  GLYPH(0, 9, 0, 10, 0, 11),
+  GLYPH(0, 11, 1, 10, 2, 9),
+  GLYPH(0, 11, 1, 11, 2, 11),
+  GLYPH(0, 9, 1, 10, 2, 11)
+};
+
+// rx at cols 0-1, tx at 3-4, back-pressure at 6-7
+static constexpr MatrixMask BAR_FRAMES[MATRIX_GAUGE_BARS][MATRIX_GAUGE_LEVELS] = {
+  BAR_LEVELS(0), BAR_LEVELS(3), BAR_LEVELS(6)
+};
+
+static constexpr bool barsClearOfSpinner(uint8_t word = 0) {
+  return word >= 3 ||
+    (((BAR_FRAMES[0][MATRIX_GAUGE_LEVELS - 1].words[word] | BAR_FRAMES[1][MATRIX_GAUGE_LEVELS - 1].words[word] |
+       BAR_FRAMES[2][MATRIX_GAUGE_LEVELS - 1].words[word]) &
+      (SPINNER_FRAMES[0].words[word] | SPINNER_FRAMES[1].words[word] |
+       SPINNER_FRAMES[2].words[word] | SPINNER_FRAMES[3].words[word])) == 0 &&
+     barsClearOfSpinner(word + 1));
+}
+static_assert(barsClearOfSpinner(), "Gauge bars must not overlap the spinner");
+static_assert(MATRIX_GAUGE_LEVELS == MATRIX_ROWS + 1, "One level per matrix row plus empty");
+
+// Frames/s needed for each lit row (log scale, about 2x per row)
+static const float RATE_STEPS[MATRIX_GAUGE_LEVELS - 1] = { 0.5f, 1.0f, 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f };
+
 HeartbeatAnimation::HeartbeatAnimation() {
   isEnabled = false;
   currentBrightness = 128;
   spinnerFrame = 0;
   lastSpinnerTime = 0;
+  memset(levels, 0, sizeof(levels));
+  memset(shownLevels, 0, sizeof(shownLevels));
+  shownSpinner = 0;
+  frameValid = false;
+  framesLoaded = 0;
 }
 
 void HeartbeatAnimation::begin() {
@@ -15,18 +81,44 @@ void HeartbeatAnimation::begin() {
   isEnabled = true;
   spinnerFrame = 0;
   lastSpinnerTime = millis();
+  frameValid = false;
 }
 
 void HeartbeatAnimation::update() {
   if (!isEnabled) return;
-  
+
   unsigned long currentTime = millis();
-  
+
   if (currentTime - lastSpinnerTime >= 1000) {
     spinnerFrame = (spinnerFrame + 1) % 4;
     lastSpinnerTime = currentTime;
-    displaySpinner();
   }
+
+  // Reload only when something visible changed
+  if (frameValid && shownSpinner == spinnerFrame &&
+      memcmp(shownLevels, levels, sizeof(levels)) == 0) {
+    return;
+  }
+  render();
+}
+
+void HeartbeatAnimation::setTraffic(float rxPerSecond, float txPerSecond, uint8_t backPressurePercent) {
+  levels[0] = rateLevel(rxPerSecond);
+  levels[1] = rateLevel(txPerSecond);
+  levels[2] = pressureLevel(backPressurePercent);
+}
+
+uint8_t HeartbeatAnimation::rateLevel(float perSecond) {
+  uint8_t level = 0;
+  while (level < MATRIX_GAUGE_LEVELS - 1 && perSecond >= RATE_STEPS[level]) {
+    level++;
+  }
+  return level;
+}
+
+uint8_t HeartbeatAnimation::pressureLevel(uint8_t percent) {
+  if (percent > 100) percent = 100;
+  return (uint8_t)((percent * (MATRIX_GAUGE_LEVELS - 1) + 99) / 100);
 }
 
 void HeartbeatAnimation::enable() {
@@ -35,6 +127,7 @@ void HeartbeatAnimation::enable() {
     isEnabled = true;
     spinnerFrame = 0;
     lastSpinnerTime = millis();
+    frameValid = false;
   }
 }
 
@@ -59,50 +152,21 @@ uint8_t HeartbeatAnimation::getBrightness() const {
 
 void HeartbeatAnimation::clear() {
   matrix.clear();
+  frameValid = false;
 }
 
-void HeartbeatAnimation::displaySpinner() {
-  uint32_t frame[3] = {0, 0, 0};
-  
-  if (spinnerFrame == 0) {
-    for (int col = 9; col <= 11; col++) {
-      int bitIndex = 0 * 12 + col;
-      int wordIndex = bitIndex / 32;
-      int bitPos = bitIndex % 32;
-      if (wordIndex < 3) {
-        frame[wordIndex] |= (1UL << (31 - bitPos));
-      }
-    }
-  } else if (spinnerFrame == 1) {
-    int positions[][2] = {{0, 11}, {1, 10}, {2, 9}};
-    for (int i = 0; i < 3; i++) {
-      int bitIndex = positions[i][0] * 12 + positions[i][1];
-      int wordIndex = bitIndex / 32;
-      int bitPos = bitIndex % 32;
-      if (wordIndex < 3) {
-        frame[wordIndex] |= (1UL << (31 - bitPos));
-      }
-    }
-  } else if (spinnerFrame == 2) {
-    for (int row = 0; row <= 2; row++) {
-      int bitIndex = row * 12 + 11;
-      int wordIndex = bitIndex / 32;
-      int bitPos = bitIndex % 32;
-      if (wordIndex < 3) {
-        frame[wordIndex] |= (1UL << (31 - bitPos));
-      }
-    }
-  } else if (spinnerFrame == 3) {
-    int positions[][2] = {{0, 9}, {1, 10}, {2, 11}};
-    for (int i = 0; i < 3; i++) {
-      int bitIndex = positions[i][0] * 12 + positions[i][1];
-      int wordIndex = bitIndex / 32;
-      int bitPos = bitIndex % 32;
-      if (wordIndex < 3) {
-        frame[wordIndex] |= (1UL << (31 - bitPos));
-      }
+void HeartbeatAnimation::render() {
+  uint32_t frame[3];
+  for (uint8_t w = 0; w < 3; w++) {
+    frame[w] = SPINNER_FRAMES[spinnerFrame].words[w];
+    for (uint8_t b = 0; b < MATRIX_GAUGE_BARS; b++) {
+      frame[w] |= BAR_FRAMES[b][levels[b]].words[w];
     }
   }
-  
+
   matrix.loadFrame(frame);
-}
\ No newline at end of file
+  memcpy(shownLevels, levels, sizeof(levels));
+  shownSpinner = spinnerFrame;
+  frameValid = true;
+  framesLoaded++;
+}
@@ -0,0 +1,39 @@
+#include "i2c_bus.h"
+#include "response_sink.h"
+
+uint32_t I2CBus::transactions = 0;
+uint32_t I2CBus::registersRead = 0;
+uint32_t I2CBus::failures = 0;
+
+bool I2CBus::readRegisters(TwoWire& wire, uint8_t address, const uint8_t* regs,
+                           const uint8_t* widths, uint8_t count, uint8_t* data) {
+    if (count == 0 || count > I2C_BUS_MAX_REGISTERS) return false;
+    transactions++;
+
+    for (uint8_t i = 0; i < count; i++) {
+        // Only the last read ends with a STOP; a failure part way releases the bus
+        bool last = i == count - 1;
+        wire.beginTransmission(address);
+        wire.write(regs[i]);
+        if (wire.endTransmission(false) != 0 ||
+            wire.requestFrom(address, (size_t)widths[i], last) != widths[i]) {
+            if (!last) {
+                wire.beginTransmission(address);
+                wire.endTransmission(true);
+            }
+            failures++;
+            return false;
+        }
+
+        for (uint8_t b = 0; b < widths[i]; b++) {
+            *data++ = (uint8_t)wire.read();
+        }
+    }
+    registersRead += count;
+    return true;
+}
+
+void I2CBus::getStatistics(ResponseSink& out) {
+    out.printf("batched reads: %lu (%lu registers), failed=%lu",
+        (unsigned long)transactions, (unsigned long)registersRead, (unsigned long)failures);
+}
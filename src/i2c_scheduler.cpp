@@ -0,0 +1,238 @@
+#include "i2c_scheduler.h"
+#include "task_scheduler.h"
+#include "perf_profiler.h"
+#include "logger.h"
+#include "response_sink.h"
+#include <string.h>
+
+// Wrap-safe "deadline reached" test for millis() values
+static inline bool reached(unsigned long now, unsigned long deadline) {
+    return (long)(now - deadline) >= 0;
+}
+
+I2CScheduler::I2CScheduler(TCA9548A_Multiplexer& mux, unsigned long settleMs)
+    : mux(mux)
+    , settleMs(settleMs)
+    , deviceCount(0)
+    , channelGroup(0)
+    , visitMask(0)
+    , visits(0)
+    , muxSwitches(0) {
+
+    memset(devices, 0, sizeof(devices));
+}
+
+int8_t I2CScheduler::addDevice(const char* name, uint8_t channel, unsigned long periodMs,
+                               unsigned long conversionMs, StartFn start, CollectFn collect,
+                               void* context) {
+    if (!collect || deviceCount >= I2C_SCHED_MAX_DEVICES) {
+        debugPrintf("I2CScheduler: Cannot add device %s (table full)\n", name ? name : "?");
+        return I2C_SCHED_INVALID_ID;
+    }
+
+    Device& device = devices[deviceCount];
+    memset(&device, 0, sizeof(device));
+    device.name = name;
+    device.channel = channel;
+    device.periodMs = periodMs < I2C_SCHED_MIN_PERIOD_MS ? I2C_SCHED_MIN_PERIOD_MS : periodMs;
+    device.conversionMs = conversionMs;
+    device.start = start;
+    device.collect = collect;
+    device.context = context;
+    device.nextStartMs = millis();
+    device.perfProbe = g_perfProfiler ? g_perfProfiler->addProbe(name) : PERF_INVALID_PROBE;
+
+    debugPrintf("I2CScheduler: Device %s added (channel=%u period=%lums conversion=%lums)\n",
+        name, channel, device.periodMs, conversionMs);
+    return (int8_t)deviceCount++;
+}
+
+int8_t I2CScheduler::findDevice(const char* name) const {
+    if (!name) return I2C_SCHED_INVALID_ID;
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (strcasecmp(devices[i].name, name) == 0) return (int8_t)i;
+    }
+    return I2C_SCHED_INVALID_ID;
+}
+
+bool I2CScheduler::setPeriod(int8_t id, unsigned long periodMs) {
+    if (id < 0 || id >= deviceCount || periodMs < I2C_SCHED_MIN_PERIOD_MS) return false;
+
+    Device& device = devices[id];
+    device.periodMs = periodMs;
+    if (!device.converting) {
+        device.nextStartMs = millis();  // Apply the new rate right away
+    }
+    return true;
+}
+
+void I2CScheduler::setConversionTime(int8_t id, unsigned long conversionMs) {
+    if (id < 0 || id >= deviceCount) return;
+    devices[id].conversionMs = conversionMs;
+}
+
+unsigned long I2CScheduler::dueAt(const Device& device) const {
+    return device.converting ? device.readyAtMs : device.nextStartMs;
+}
+
+uint8_t I2CScheduler::pickMask(unsigned long now) const {
+    uint8_t current = mux.getChannelMask();
+    uint8_t best = TCA9548A_Multiplexer::NO_CHANNEL;
+    unsigned long bestLateness = 0;
+
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        const Device& device = devices[i];
+        unsigned long due = dueAt(device);
+        if (!reached(now, due)) continue;
+
+        // Anything due on an enabled channel is served without a switch
+        if (mux.isChannelEnabled(device.channel)) return current;
+
+        unsigned long lateness = now - due;
+        if (best == TCA9548A_Multiplexer::NO_CHANNEL || lateness > bestLateness) {
+            best = device.channel;
+            bestLateness = lateness;
+        }
+    }
+
+    if (best == TCA9548A_Multiplexer::NO_CHANNEL) return 0;
+
+    uint8_t bit = 1 << best;
+    return (channelGroup & bit) ? channelGroup : bit;
+}
+
+void I2CScheduler::service() {
+    unsigned long now = millis();
+
+    if (visitMask == 0) {
+        visitMask = pickMask(now);
+        if (visitMask == 0) return;
+    }
+
+    // Cache hit if nothing (including other code) changed the mux meanwhile
+    if (!mux.selectChannels(visitMask)) {
+        // Mux unreachable: count it against every due device in the visit
+        for (uint8_t i = 0; i < deviceCount; i++) {
+            Device& device = devices[i];
+            if (!(visitMask & (1 << device.channel)) || !reached(now, dueAt(device))) continue;
+            device.failures++;
+            device.converting = false;
+            device.retries = 0;
+            device.nextStartMs = now + device.periodMs;
+        }
+        visitMask = 0;
+        return;
+    }
+    if (mux.lastSelectChanged()) muxSwitches++;
+
+    unsigned long settle = mux.getSettleRemaining(settleMs);
+    if (settle > 0) {
+        if (g_scheduler) g_scheduler->resumeAfter(settle);
+        return;
+    }
+
+    uint8_t mask = visitMask;
+    visitMask = 0;
+    runVisit(mask, now);
+}
+
+void I2CScheduler::runVisit(uint8_t mask, unsigned long now) {
+    visits++;
+
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        Device& device = devices[i];
+        if (!(mask & (1 << device.channel))) continue;
+
+        // Finished conversion first, so a restart on the same visit sees a free device
+        if (device.converting && reached(now, device.readyAtMs)) {
+            collect(device, now);
+        }
+
+        if (device.converting || !reached(now, device.nextStartMs)) continue;
+
+        // Keep the period anchored to the schedule, but never try to catch up
+        device.nextStartMs += device.periodMs;
+        if (reached(now, device.nextStartMs)) {
+            device.nextStartMs = now + device.periodMs;
+        }
+        device.retries = 0;
+
+        if (!device.start) {
+            collect(device, now);
+            continue;
+        }
+
+        if (!device.start(device.context)) {
+            device.failures++;
+            continue;
+        }
+
+        device.converting = true;
+        device.readyAtMs = now + device.conversionMs;
+        if (device.conversionMs == 0) {
+            collect(device, now);
+        }
+    }
+}
+
+void I2CScheduler::collect(Device& device, unsigned long now) {
+    uint32_t startCycles = PerfProfiler::now();
+    Result result = device.collect(device.context);
+    if (g_perfProfiler) g_perfProfiler->record(device.perfProbe, startCycles);
+
+    if (result == RESULT_RETRY && ++device.retries < I2C_SCHED_MAX_RETRIES) {
+        unsigned long retryMs = device.conversionMs / 4;
+        if (retryMs < I2C_SCHED_MIN_RETRY_MS) retryMs = I2C_SCHED_MIN_RETRY_MS;
+        device.notReady++;
+        device.converting = true;
+        device.readyAtMs = now + retryMs;
+        return;
+    }
+    
+    if (result == RESULT_PENDING) {
+        device.converting = true;
+        device.readyAtMs = now + I2C_SCHED_MIN_RETRY_MS;
+        return;
+    }
+
+    device.converting = false;
+    device.retries = 0;
+
+    if (result != RESULT_OK) {
+        device.failures++;
+        return;
+    }
+
+    if (device.samples > 0) {
+        device.lastIntervalMs = now - device.lastSampleMs;
+    }
+    device.lastSampleMs = now;
+    device.samples++;
+}
+
+void I2CScheduler::resetStatistics() {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        Device& device = devices[i];
+        device.samples = 0;
+        device.failures = 0;
+        device.notReady = 0;
+        device.lastIntervalMs = 0;
+    }
+    visits = 0;
+    muxSwitches = 0;
+}
+
+void I2CScheduler::getStatistics(ResponseSink& out) {
+    out.printf("i2c: visits=%lu switches=%lu group=0x%02X\r\n",
+        (unsigned long)visits, (unsigned long)muxSwitches, channelGroup);
+    out.fill([this](char* buffer, size_t size) { mux.getStatistics(buffer, size); });
+
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        const Device& device = devices[i];
+        out.printf(
+            "\r\n%s: ch=%u period=%lums measured=%lums conv=%lums samples=%lu fail=%lu notready=%lu",
+            device.name, device.channel, device.periodMs, device.lastIntervalMs,
+            device.conversionMs, (unsigned long)device.samples,
+            (unsigned long)device.failures, (unsigned long)device.notReady);
+    }
+}
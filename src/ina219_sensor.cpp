@@ -1,9 +1,8 @@
 #include "ina219_sensor.h"
+#include "i2c_bus.h"
 #include "logger.h"
 #include "constants.h"
 
-extern void debugPrintf(const char* fmt, ...);
-
 // Global instance pointer
 INA219_Sensor* g_ina219Sensor = nullptr;
 
@@ -18,10 +17,14 @@ INA219_Sensor::INA219_Sensor(uint8_t address) :
     initialized(false),
     debugEnabled(false),
     currentRange(INA219_Range::RANGE_32V_2A),
-    shuntResistor(0.1f),
-    currentLSB(0.1f),
+    customCalibration(false),
+    currentLsbNanoAmps(INA219_RangeTraits<INA219_Range::RANGE_32V_2A>::Calibration::CURRENT_LSB_NA),
     calibrationValue(0)
 {
+    lastReading.busVoltage_mV = 0;
+    lastReading.shuntVoltage_uV = 0;
+    lastReading.current_uA = 0;
+    lastReading.power_uW = 0;
     lastReading.valid = false;
     lastReading.timestamp = 0;
 }
@@ -76,9 +79,7 @@ bool INA219_Sensor::setRange(INA219_Range range) {
         return false;
     }
     
-    // Calculate and set calibration
-    calculateCalibration();
-    
+    // Calibration was picked with the range configuration
     if (!writeRegister(INA219_REG_CALIBRATION, calibrationValue)) {
         debugPrint("INA219: Failed to write calibration");
         return false;
@@ -89,12 +90,22 @@ bool INA219_Sensor::setRange(INA219_Range range) {
 }
 
 bool INA219_Sensor::setCalibration(float shuntResistor_ohms, float maxCurrent_A) {
-    shuntResistor = shuntResistor_ohms;
-    currentLSB = calculateCurrentLSB(maxCurrent_A);
-    calibrationValue = calculateCalibrationValue(currentLSB, shuntResistor);
+    if (shuntResistor_ohms <= 0.0f || maxCurrent_A <= 0.0f) {
+        return false;
+    }
+    
+    float currentLSB = calculateCurrentLSB(maxCurrent_A);
+    calibrationValue = calculateCalibrationValue(currentLSB, shuntResistor_ohms);
+    if (calibrationValue == 0) {
+        return false;
+    }
+    
+    // Conversions use the LSB the truncated register value actually gives
+    currentLsbNanoAmps = (uint32_t)(0.04096f / (calibrationValue * shuntResistor_ohms) * 1e9f + 0.5f);
+    customCalibration = true;
     
-    debugPrintf("INA219: Custom calibration - R=%.3f ohm, MaxI=%.2fA, LSB=%.3fmA\\n", 
-                shuntResistor, maxCurrent_A, currentLSB * 1000.0f);
+    debugPrintf("INA219: Custom calibration - R=%.3f ohm, MaxI=%.2fA, LSB=%lunA\\n", 
+                shuntResistor_ohms, maxCurrent_A, (unsigned long)currentLsbNanoAmps);
     
     return writeRegister(INA219_REG_CALIBRATION, calibrationValue);
 }
@@ -105,53 +116,86 @@ bool INA219_Sensor::takereading() {
         return false;
     }
     
-    uint16_t busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw;
+    // The pointer does not auto-increment: one pointer write per register,
+    // all four in one transaction. Power last, it clears the CNVR flag.
+    static const uint8_t REGISTERS[] = {
+        INA219_REG_BUSVOLTAGE, INA219_REG_SHUNTVOLTAGE, INA219_REG_CURRENT, INA219_REG_POWER
+    };
+    static const uint8_t WIDTHS[] = { 2, 2, 2, 2 };
+    uint8_t data[8];
     
-    // Read all registers
-    if (!readRegister(INA219_REG_BUSVOLTAGE, busVoltageRaw) ||
-        !readRegister(INA219_REG_SHUNTVOLTAGE, shuntVoltageRaw) ||
-        !readRegister(INA219_REG_CURRENT, currentRaw) ||
-        !readRegister(INA219_REG_POWER, powerRaw)) {
-        
+    if (!I2CBus::readRegisters(*wire, i2cAddress, REGISTERS, WIDTHS, 4, data)) {
         lastReading.valid = false;
         debugPrint("INA219: Failed to read registers");
         return false;
     }
     
-    // Convert raw values
-    lastReading.busVoltage_V = convertBusVoltage(busVoltageRaw);
-    lastReading.shuntVoltage_mV = convertShuntVoltage(shuntVoltageRaw);
-    lastReading.current_mA = convertCurrent(currentRaw);
-    lastReading.power_mW = convertPower(powerRaw);
+    uint16_t busVoltageRaw = I2CBus::get16(data);
+    uint16_t shuntVoltageRaw = I2CBus::get16(data + 2);
+    uint16_t currentRaw = I2CBus::get16(data + 4);
+    uint16_t powerRaw = I2CBus::get16(data + 6);
+    
+    // Integer conversion with the range LSB folded in at compile time
+    if (customCalibration) {
+        convertReading(busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw, currentLsbNanoAmps);
+    } else {
+        switch (currentRange) {
+            case INA219_Range::RANGE_32V_2A:
+            default:
+                convertReading<INA219_Range::RANGE_32V_2A>(busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw);
+                break;
+            case INA219_Range::RANGE_32V_1A:
+                convertReading<INA219_Range::RANGE_32V_1A>(busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw);
+                break;
+            case INA219_Range::RANGE_16V_2A:
+                convertReading<INA219_Range::RANGE_16V_2A>(busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw);
+                break;
+            case INA219_Range::RANGE_16V_1A:
+                convertReading<INA219_Range::RANGE_16V_1A>(busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw);
+                break;
+            case INA219_Range::RANGE_16V_400MA:
+                convertReading<INA219_Range::RANGE_16V_400MA>(busVoltageRaw, shuntVoltageRaw, currentRaw, powerRaw);
+                break;
+        }
+    }
     lastReading.timestamp = millis();
     lastReading.valid = true;
     
     if (debugEnabled) {
-        debugPrintf("INA219: V=%.3fV, I=%.1fmA, P=%.1fmW\\n", 
-                    lastReading.busVoltage_V, lastReading.current_mA, lastReading.power_mW);
+        debugPrintf("INA219: V=%ldmV, I=%lduA, P=%lduW\\n", 
+                    (long)lastReading.busVoltage_mV, (long)lastReading.current_uA,
+                    (long)lastReading.power_uW);
     }
     
     return true;
 }
 
+bool INA219_Sensor::triggerConversion() {
+    if (!initialized || !wire) return false;
+    
+    // Writing the config register in a triggered mode starts one conversion;
+    // the result registers update after INA219_CONVERSION_MS
+    return setOperatingMode(INA219_CONFIG_MODE_SANDBVOLT_TRIGGERED);
+}
+
 float INA219_Sensor::getBusVoltage() {
     if (!takereading()) return 0.0f;
-    return lastReading.busVoltage_V;
+    return lastReading.busVoltageV();
 }
 
 float INA219_Sensor::getShuntVoltage() {
     if (!takereading()) return 0.0f;
-    return lastReading.shuntVoltage_mV;
+    return lastReading.shuntVoltageMillivolts();
 }
 
 float INA219_Sensor::getCurrent() {
     if (!takereading()) return 0.0f;
-    return lastReading.current_mA;
+    return lastReading.currentMilliamps();
 }
 
 float INA219_Sensor::getPower() {
     if (!takereading()) return 0.0f;
-    return lastReading.power_mW;
+    return lastReading.powerMilliwatts();
 }
 
 bool INA219_Sensor::isConnected() {
@@ -172,8 +216,8 @@ void INA219_Sensor::getStatusString(char* buffer, size_t bufferSize) {
     unsigned long age = millis() - lastReading.timestamp;
     snprintf(buffer, bufferSize, 
         "INA219: %.2fV %.1fmA %.1fmW (addr=0x%02X, age=%lums)",
-        lastReading.busVoltage_V, lastReading.current_mA, 
-        lastReading.power_mW, i2cAddress, age);
+        lastReading.busVoltageV(), lastReading.currentMilliamps(), 
+        lastReading.powerMilliwatts(), i2cAddress, age);
 }
 
 bool INA219_Sensor::setBusVoltageRange(bool range32V) {
@@ -215,14 +259,16 @@ bool INA219_Sensor::setOperatingMode(uint8_t mode) {
 }
 
 float INA219_Sensor::calculateCurrentLSB(float maxCurrent_A) {
-    // Current LSB = Maximum Expected Current / 32767
+    // Current LSB (amps) = Maximum Expected Current / 32767
     return maxCurrent_A / 32767.0f;
 }
 
 uint16_t INA219_Sensor::calculateCalibrationValue(float currentLSB, float shuntResistor_ohms) {
-    // Calibration = 0.04096 / (currentLSB * shuntResistor)
+    // Calibration = 0.04096 / (currentLSB * shuntResistor), LSB in amps
+    if (currentLSB <= 0.0f || shuntResistor_ohms <= 0.0f) return 0;
     float calibration = 0.04096f / (currentLSB * shuntResistor_ohms);
-    return (uint16_t)calibration;
+    if (calibration > 65534.0f) calibration = 65534.0f;
+    return (uint16_t)calibration & 0xFFFE;
 }
 
 bool INA219_Sensor::testConnection() {
@@ -306,75 +352,32 @@ uint16_t INA219_Sensor::getRangeConfig(INA219_Range range) {
                       INA219_CONFIG_SADCRES_12BIT_1S |  // 12-bit shunt ADC
                       INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS; // Continuous mode
     
+    // Calibration and current LSB come from the compile-time range table
     switch (range) {
         case INA219_Range::RANGE_32V_2A:
         default:
-            config |= INA219_CONFIG_BVOLTAGERANGE_32V |
-                      INA219_CONFIG_GAIN_8_320MV;
-            shuntResistor = 0.1f;
-            currentLSB = 0.061f; // 61µA per bit for ±2A range
+            applyRange<INA219_Range::RANGE_32V_2A>(config);   // 61uA per bit
             break;
-            
         case INA219_Range::RANGE_32V_1A:
-            config |= INA219_CONFIG_BVOLTAGERANGE_32V |
-                      INA219_CONFIG_GAIN_4_160MV;
-            shuntResistor = 0.1f;
-            currentLSB = 0.0305f; // 30.5µA per bit for ±1A range
+            applyRange<INA219_Range::RANGE_32V_1A>(config);   // 30.5uA per bit
             break;
-            
         case INA219_Range::RANGE_16V_2A:
-            config |= INA219_CONFIG_BVOLTAGERANGE_16V |
-                      INA219_CONFIG_GAIN_8_320MV;
-            shuntResistor = 0.1f;
-            currentLSB = 0.061f;
+            applyRange<INA219_Range::RANGE_16V_2A>(config);
             break;
-            
         case INA219_Range::RANGE_16V_1A:
-            config |= INA219_CONFIG_BVOLTAGERANGE_16V |
-                      INA219_CONFIG_GAIN_4_160MV;
-            shuntResistor = 0.1f;
-            currentLSB = 0.0305f;
+            applyRange<INA219_Range::RANGE_16V_1A>(config);
             break;
-            
         case INA219_Range::RANGE_16V_400MA:
-            config |= INA219_CONFIG_BVOLTAGERANGE_16V |
-                      INA219_CONFIG_GAIN_1_40MV;
-            shuntResistor = 0.1f;
-            currentLSB = 0.012f; // 12µA per bit for ±400mA range
+            applyRange<INA219_Range::RANGE_16V_400MA>(config); // 12.2uA per bit
             break;
     }
+    customCalibration = false;
     
     return config;
 }
 
-void INA219_Sensor::calculateCalibration() {
-    calibrationValue = calculateCalibrationValue(currentLSB, shuntResistor);
-}
-
 void INA219_Sensor::debugPrint(const char* message) {
     if (debugEnabled) {
         debugPrintf("%s\\n", message);
     }
 }
-
-float INA219_Sensor::convertBusVoltage(uint16_t raw) {
-    // Bus voltage = (raw >> 3) * 4mV
-    return ((raw >> 3) * 4) / 1000.0f; // Convert to volts
-}
-
-float INA219_Sensor::convertShuntVoltage(uint16_t raw) {
-    // Shunt voltage = raw * 10µV (signed 16-bit)
-    int16_t signed_raw = (int16_t)raw;
-    return (signed_raw * 10) / 1000.0f; // Convert to millivolts
-}
-
-float INA219_Sensor::convertCurrent(uint16_t raw) {
-    // Current = raw * currentLSB (signed 16-bit)
-    int16_t signed_raw = (int16_t)raw;
-    return signed_raw * currentLSB * 1000.0f; // Convert to milliamps
-}
-
-float INA219_Sensor::convertPower(uint16_t raw) {
-    // Power = raw * currentLSB * 20 (unsigned 16-bit)
-    return raw * currentLSB * 20.0f * 1000.0f; // Convert to milliwatts
-}
\ No newline at end of file
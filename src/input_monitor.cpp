@@ -0,0 +1,194 @@
+#include "input_monitor.h"
+#include "constants.h"
+#include "response_sink.h"
+#include "logger.h"
+#include <string.h>
+
+static_assert((INPUT_EDGE_QUEUE_SIZE & (INPUT_EDGE_QUEUE_SIZE - 1)) == 0, "Edge queue size must be a power of two");
+static_assert(INPUT_EDGE_QUEUE_SIZE <= 256, "Edge queue indices are 8-bit");
+
+// UNO R4 pins with an ICU IRQ line; attachInterrupt() ignores the others
+static const uint8_t INTERRUPT_PINS[] = { 0, 1, 2, 3, 8, 12, 13, 15, 16, 17, 18, 19 };
+
+// Compiler barrier: publish the ring entry before the index that exposes it
+#define INPUT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+DigitalInputMonitor* DigitalInputMonitor::instance = nullptr;
+
+DigitalInputMonitor::DigitalInputMonitor()
+    : inputCount(0)
+    , changeCallback(nullptr)
+    , changeContext(nullptr)
+    , head(0)
+    , tail(0)
+    , overflows(0) {
+
+    memset(inputs, 0, sizeof(inputs));
+    memset(ring, 0, sizeof(ring));
+}
+
+bool DigitalInputMonitor::hasInterrupt(uint8_t pin) {
+    for (size_t i = 0; i < sizeof(INTERRUPT_PINS); i++) {
+        if (INTERRUPT_PINS[i] == pin) return true;
+    }
+    return false;
+}
+
+template <uint8_t INDEX>
+void DigitalInputMonitor::isr() {
+    if (instance) instance->onEdge(INDEX);
+}
+
+void (*const DigitalInputMonitor::isrTable[INPUT_MAX_PINS])() = {
+    isr<0>, isr<1>, isr<2>, isr<3>, isr<4>, isr<5>, isr<6>, isr<7>
+};
+
+void DigitalInputMonitor::begin(const uint8_t* pins, size_t count, const uint8_t* skip, size_t skipCount) {
+    instance = this;
+    inputCount = 0;
+
+    uint32_t now = micros();
+    for (size_t i = 0; i < count && inputCount < INPUT_MAX_PINS; i++) {
+        bool skipped = false;
+        for (size_t s = 0; s < skipCount; s++) {
+            if (skip[s] == pins[i]) skipped = true;
+        }
+        if (skipped) continue;
+
+        Input& input = inputs[inputCount];
+        memset(&input, 0, sizeof(input));
+        input.pin = pins[i];
+        input.interrupt = hasInterrupt(input.pin);
+        pinMode(input.pin, INPUT_PULLUP);
+
+        // Reported inactive until the first debounce, so an input that is
+        // already active at boot is published once it has settled
+        input.level = digitalRead(input.pin) == LOW;
+        input.settling = true;
+        input.burstUs = now;
+        input.lastEdgeUs = now;
+
+        // Counted first: onEdge() ignores slots past inputCount
+        inputCount++;
+        if (input.interrupt) {
+            attachInterrupt(digitalPinToInterrupt(input.pin), isrTable[inputCount - 1], CHANGE);
+        }
+    }
+
+    uint8_t interrupts = 0;
+    for (uint8_t i = 0; i < inputCount; i++) {
+        if (inputs[i].interrupt) interrupts++;
+    }
+    LOG_INFO("Inputs: %u watch pins, %u on pin-change interrupts", inputCount, interrupts);
+}
+
+void DigitalInputMonitor::setChangeCallback(ChangeCallback callback, void* context) {
+    changeCallback = callback;
+    changeContext = context;
+}
+
+void DigitalInputMonitor::onEdge(uint8_t index) {
+    // Interrupt context: read the level, queue it, nothing else
+    if (index >= inputCount) return;
+
+    uint8_t next = (head + 1) & (INPUT_EDGE_QUEUE_SIZE - 1);
+    if (next == tail) {
+        overflows++;
+        return;
+    }
+
+    Edge& edge = ring[head];
+    edge.us = micros();
+    edge.input = index;
+    edge.active = digitalRead(inputs[index].pin) == LOW;
+    INPUT_BARRIER();
+    head = next;
+}
+
+bool DigitalInputMonitor::pop(Edge& edge) {
+    uint8_t current = tail;
+    if (current == head) return false;
+
+    INPUT_BARRIER();
+    edge = ring[current];
+    INPUT_BARRIER();
+    tail = (current + 1) & (INPUT_EDGE_QUEUE_SIZE - 1);
+    return true;
+}
+
+void DigitalInputMonitor::recordEdge(Input& input, bool active, uint32_t us) {
+    input.level = active;
+    input.edges++;
+    if (input.settling) {
+        input.bounces++;
+    } else {
+        input.settling = true;
+        input.bounces = 0;
+        input.burstUs = us;
+    }
+    input.lastEdgeUs = us;
+}
+
+void DigitalInputMonitor::service() {
+    Edge edge;
+    while (pop(edge)) {
+        if (edge.input < inputCount) recordEdge(inputs[edge.input], edge.active, edge.us);
+    }
+
+    uint32_t nowUs = micros();
+    for (uint8_t i = 0; i < inputCount; i++) {
+        Input& input = inputs[i];
+
+        // Pins without an IRQ line are sampled here instead
+        if (!input.interrupt) {
+            bool active = digitalRead(input.pin) == LOW;
+            if (active != input.level) recordEdge(input, active, nowUs);
+        }
+
+        if (!input.settling || nowUs - input.lastEdgeUs < DEBOUNCE_DELAY_MS * 1000UL) continue;
+        input.settling = false;
+
+        // Read again: a dropped edge must not leave a stale state behind
+        bool active = digitalRead(input.pin) == LOW;
+        input.level = active;
+        if (active == input.state) continue;
+
+        input.state = active;
+        input.changes++;
+
+        Change change;
+        change.pin = input.pin;
+        change.active = active;
+        change.edgeUs = input.burstUs;
+        change.edgeMs = millis() - (nowUs - input.burstUs) / 1000UL;
+        change.bounces = input.bounces;
+        change.interrupt = input.interrupt;
+        input.lastChangeMs = change.edgeMs;
+
+        if (changeCallback) changeCallback(changeContext, change);
+    }
+}
+
+bool DigitalInputMonitor::isActive(uint8_t pin) const {
+    for (uint8_t i = 0; i < inputCount; i++) {
+        if (inputs[i].pin == pin) return inputs[i].state;
+    }
+    return false;
+}
+
+void DigitalInputMonitor::getStatistics(ResponseSink& out) {
+    uint8_t queued = (head - tail) & (INPUT_EDGE_QUEUE_SIZE - 1);
+    out.printf("inputs: %u pins, debounce %lu ms, queue %u/%u, overflows=%lu",
+        inputCount, DEBOUNCE_DELAY_MS, queued, INPUT_EDGE_QUEUE_SIZE - 1, (unsigned long)overflows);
+
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < inputCount; i++) {
+        const Input& input = inputs[i];
+        out.printf("\r\npin %-2u %-4s %-8s edges=%lu changes=%lu", input.pin,
+            input.interrupt ? "irq" : "poll", input.state ? "ACTIVE" : "inactive",
+            (unsigned long)input.edges, (unsigned long)input.changes);
+        if (input.changes > 0) {
+            out.printf(" last=%lus ago", (now - input.lastChangeMs) / 1000);
+        }
+    }
+}
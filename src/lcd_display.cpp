@@ -1,17 +1,18 @@
 #include "lcd_display.h"
-
-extern void debugPrintf(const char* fmt, ...);
+#include "logger.h"
+#include <string.h>
 
 LCDDisplay::LCDDisplay(uint8_t address, uint8_t cols, uint8_t rows) 
-    : i2cAddress(address), columns(cols), rows(rows), initialized(false), 
+    : i2cAddress(address), columns(cols > LCD_MAX_COLS ? LCD_MAX_COLS : cols),
+      rows(rows > LCD_MAX_ROWS ? LCD_MAX_ROWS : rows), initialized(false), 
       displayEnabled(true), backlightEnabled(true), lastUpdate(0),
-      spinnerFrame(0), lastSpinnerTime(0)
+      txLength(0), expanderMode(0xFF), cursorRow(0xFF), cursorCol(0),
+      refreshActive(false), spinnerFrame(0), lastSpinnerTime(0)
 {
-    // Initialize content strings
-    line1Content = "";
-    line2Content = "";
-    line3Content = "";
-    line4Content = "";
+    // Blank framebuffer, matching the controller after its clear command
+    memset(frame, ' ', sizeof(frame));
+    memset(dirty, 0, sizeof(dirty));
+    resetStatistics();
 }
 
 bool LCDDisplay::begin() {
@@ -70,6 +71,13 @@ bool LCDDisplay::begin() {
     sendCommand(0x01);  // Clear display
     delay(2);
     
+    // Display is blank now; anything drawn before a reinit is redrawn by the next update
+    memset(frame, ' ', sizeof(frame));
+    memset(dirty, 0, sizeof(dirty));
+    refreshActive = false;
+    passBusUs = 0;
+    passCells = 0;
+    
     initialized = true;
     debugPrintf("LCD: Initialization complete");
     return true;
@@ -91,30 +99,182 @@ void LCDDisplay::i2cWrite(uint8_t data) {
 }
 
 void LCDDisplay::write4bits(uint8_t data) {
-    uint8_t val = data | (backlightEnabled ? 0x08 : 0x00);
-    i2cWrite(val);
-    pulseEnable(val);
+    uint8_t val = data | (backlightEnabled ? LCD_BACKLIGHT : LCD_NOBACKLIGHT);
+    txBuffer[0] = val;          // Lines settle before the enable edge
+    txBuffer[1] = val | En;
+    txBuffer[2] = val & ~En;    // Latched on the falling edge
+    txLength = 3;
+    sendQueued();
+    expanderMode = 0;
 }
 
-void LCDDisplay::pulseEnable(uint8_t data) {
-    i2cWrite(data | 0x04);   // Enable high
-    delayMicroseconds(1);
-    i2cWrite(data & ~0x04);  // Enable low
-    delayMicroseconds(50);
+void LCDDisplay::sendCommand(uint8_t command) {
+    txLength = 0;
+    queueByte(command, 0);
+    sendQueued();
+    cursorRow = 0xFF;  // Clear/home/shift commands move the address counter
 }
 
-void LCDDisplay::sendCommand(uint8_t command) {
-    uint8_t highnib = command & 0xF0;
-    uint8_t lownib = (command << 4) & 0xF0;
-    write4bits(highnib);
-    write4bits(lownib);
+bool LCDDisplay::queueByte(uint8_t value, uint8_t mode) {
+    // Changing RS costs one extra byte so it is stable before the enable rises
+    uint8_t needed = (mode != expanderMode) ? 5 : 4;
+    if (txLength + needed > LCD_TX_BYTES) return false;
+    
+    uint8_t base = mode | (backlightEnabled ? LCD_BACKLIGHT : LCD_NOBACKLIGHT);
+    if (mode != expanderMode) {
+        txBuffer[txLength++] = base;
+        expanderMode = mode;
+    }
+    
+    // Each nibble: enable high with the data, then enable low to latch it.
+    // At 100kHz a byte takes ~90us, longer than the 37us the HD44780 needs
+    // per instruction, so back-to-back nibbles need no delay in between.
+    uint8_t high = (value & 0xF0) | base;
+    uint8_t low = ((value << 4) & 0xF0) | base;
+    txBuffer[txLength++] = high | En;
+    txBuffer[txLength++] = high;
+    txBuffer[txLength++] = low | En;
+    txBuffer[txLength++] = low;
+    return true;
+}
+
+bool LCDDisplay::sendQueued() {
+    Wire1.beginTransmission(i2cAddress);
+    Wire1.write(txBuffer, txLength);
+    bool ok = (Wire1.endTransmission() == 0);
+    txLength = 0;
+    transmissions++;
+    
+    if (!ok) {
+        // Partial transfer - neither the RS level nor the address is known
+        txErrors++;
+        expanderMode = 0xFF;
+        cursorRow = 0xFF;
+    }
+    return ok;
+}
+
+LCDDisplay::RefreshState LCDDisplay::refresh() {
+    if (!initialized || !displayEnabled) return REFRESH_DONE;
+    
+    uint32_t sent[LCD_MAX_ROWS] = {0};
+    uint16_t cells = 0;
+    bool full = false;
+    txLength = 0;
+    
+    for (uint8_t row = 0; row < rows && !full; row++) {
+        while (dirty[row] & ~sent[row]) {
+            uint8_t col = __builtin_ctz(dirty[row] & ~sent[row]);
+            
+            if (cursorRow != row || cursorCol != col) {
+                // Rewriting one clean cell is cheaper than a cursor command
+                bool bridge = (cursorRow == row && cursorCol + 1 == col);
+                if (bridge) {
+                    if (!queueByte((uint8_t)frame[row][cursorCol], Rs)) {
+                        full = true;
+                        break;
+                    }
+                    sent[row] |= 1UL << cursorCol;
+                    cells++;
+                } else {
+                    static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};  // HD44780 20x4 DDRAM
+                    if (!queueByte(LCD_SETDDRAMADDR | (rowOffsets[row] + col), 0)) {
+                        full = true;
+                        break;
+                    }
+                }
+                cursorRow = row;
+                cursorCol = col;
+            }
+            
+            if (!queueByte((uint8_t)frame[row][col], Rs)) {
+                full = true;
+                break;
+            }
+            sent[row] |= 1UL << col;
+            cursorCol++;
+            cells++;
+        }
+    }
+    
+    if (txLength == 0) {
+        if (!refreshActive) idleRefreshes++;
+        refreshActive = false;
+        return REFRESH_DONE;
+    }
+    
+    unsigned long startUs = micros();
+    bool ok = sendQueued();
+    passBusUs += micros() - startUs;
+    
+    if (!ok) {
+        // Cells stay dirty and are sent again on the next refresh pass
+        refreshActive = false;
+        passBusUs = 0;
+        passCells = 0;
+        return REFRESH_FAILED;
+    }
+    
+    bool pending = false;
+    for (uint8_t row = 0; row < rows; row++) {
+        dirty[row] &= ~sent[row];
+        if (dirty[row]) pending = true;
+    }
+    passCells += cells;
+    cellsWritten += cells;
+    
+    if (pending) {
+        refreshActive = true;
+        return REFRESH_PENDING;
+    }
+    
+    refreshCount++;
+    lastRefreshUs = passBusUs;
+    lastRefreshCells = passCells;
+    if (passBusUs > maxRefreshUs) maxRefreshUs = passBusUs;
+    refreshActive = false;
+    passBusUs = 0;
+    passCells = 0;
+    return REFRESH_DONE;
+}
+
+void LCDDisplay::flush() {
+    // Every pending chunk clears at least one cell, so this ends
+    while (refresh() == REFRESH_PENDING) {}
+}
+
+void LCDDisplay::invalidate() {
+    for (uint8_t row = 0; row < rows; row++) {
+        dirty[row] = (1UL << columns) - 1;
+    }
 }
 
-void LCDDisplay::sendData(uint8_t data) {
-    uint8_t highnib = (data & 0xF0) | 0x01;  // RS bit high for data
-    uint8_t lownib = ((data << 4) & 0xF0) | 0x01;
-    write4bits(highnib);
-    write4bits(lownib);
+void LCDDisplay::resetStatistics() {
+    passBusUs = 0;
+    passCells = 0;
+    refreshCount = 0;
+    idleRefreshes = 0;
+    lastRefreshUs = 0;
+    maxRefreshUs = 0;
+    lastRefreshCells = 0;
+    cellsWritten = 0;
+    transmissions = 0;
+    txErrors = 0;
+}
+
+void LCDDisplay::getStatistics(char* buffer, size_t bufferSize) {
+    if (!buffer || bufferSize == 0) return;
+    
+    uint8_t dirtyCells = 0;
+    for (uint8_t row = 0; row < rows; row++) {
+        dirtyCells += __builtin_popcount(dirty[row]);
+    }
+    
+    snprintf(buffer, bufferSize,
+        "lcd: refreshes=%lu idle=%lu last=%luus/%u cells max=%luus cells=%lu tx=%lu errors=%lu dirty=%u",
+        (unsigned long)refreshCount, (unsigned long)idleRefreshes, lastRefreshUs,
+        lastRefreshCells, maxRefreshUs, (unsigned long)cellsWritten,
+        (unsigned long)transmissions, (unsigned long)txErrors, dirtyCells);
 }
 
 void LCDDisplay::updateSystemStatus(uint8_t state, unsigned long uptime, bool wifiConnected, bool mqttConnected, bool syslogWorking) {
@@ -138,7 +298,7 @@ void LCDDisplay::updateSystemStatus(uint8_t state, unsigned long uptime, bool wi
     // Add spinner character at position 20 (index 19)
     content += getSpinnerChar();
     
-    updateLineIfChanged(0, content, line1Content);
+    setLine(0, content.c_str());
 }
 
 void LCDDisplay::updateNetworkStatus(bool wifiConnected, bool mqttConnected, const char* ipAddress) {
@@ -157,11 +317,7 @@ void LCDDisplay::updateSensorReadings(float localTemp, float fuelGallons, float
         tempContent += "---F";
     }
     
-    // Pad or truncate to exactly 20 characters
-    while (tempContent.length() < 20) tempContent += " ";
-    if (tempContent.length() > 20) tempContent = tempContent.substring(0, 20);
-    
-    updateLineIfChanged(1, tempContent, line2Content);
+    setLine(1, tempContent.c_str());
     
     // Line 3: Fuel reading in gallons
     String fuelContent = "FUEL: ";
@@ -171,17 +327,13 @@ void LCDDisplay::updateSensorReadings(float localTemp, float fuelGallons, float
         fuelContent += "--- Gal";
     }
     
-    // Pad or truncate to exactly 20 characters
-    while (fuelContent.length() < 20) fuelContent += " ";
-    if (fuelContent.length() > 20) fuelContent = fuelContent.substring(0, 20);
-    
-    updateLineIfChanged(2, fuelContent, line3Content);
+    setLine(2, fuelContent.c_str());
 }
 
-void LCDDisplay::updateAdditionalSensors(float voltage, float current, float adcVoltage, uint32_t serialMsgCount, uint32_t mqttMsgCount) {
+void LCDDisplay::updateAdditionalSensors(float voltage, float current, float adcVoltage, float serialRate, float mqttRate) {
     if (!initialized || !displayEnabled) return;
     
-    // Line 4: Power data and Serial1→MQTT traffic - "12.3V 45mA S1:123→45"
+    // Line 4: Power data and Serial1→MQTT traffic in frames/s - "12.3V 45mA S1:12/12"
     String content = "";
     
     // Bus voltage (reduced precision to save space)
@@ -202,18 +354,10 @@ void LCDDisplay::updateAdditionalSensors(float voltage, float current, float adc
         content += "---mA ";
     }
     
-    // Serial1→MQTT traffic statistics (compact format)
-    if (serialMsgCount > 0 || mqttMsgCount > 0) {
-        content += "S1:" + String(serialMsgCount) + "/" + String(mqttMsgCount);
-    } else {
-        content += "S1:0/0";
-    }
-    
-    // Pad or truncate to exactly 20 characters
-    while (content.length() < 20) content += " ";
-    if (content.length() > 20) content = content.substring(0, 20);
+    // Serial1→MQTT traffic rates (compact format, one decimal below 10/s)
+    content += "S1:" + String(serialRate, serialRate < 10.0f ? 1 : 0) + "/" + String(mqttRate, mqttRate < 10.0f ? 1 : 0);
     
-    updateLineIfChanged(3, content, line4Content);
+    setLine(3, content.c_str());
 }
 
 void LCDDisplay::showError(const char* error) {
@@ -222,53 +366,28 @@ void LCDDisplay::showError(const char* error) {
     String content = "ERR: ";
     content += error;
     
-    // Pad or truncate to exactly 20 characters
-    while (content.length() < 20) content += " ";
-    if (content.length() > 20) content = content.substring(0, 20);
-    
-    updateLineIfChanged(3, content, line4Content);
+    setLine(3, content.c_str());
 }
 
 void LCDDisplay::showInfo(const char* info) {
     if (!initialized || !displayEnabled) return;
     
-    String content = info;
-    
-    // Pad or truncate to exactly 20 characters
-    while (content.length() < 20) content += " ";
-    if (content.length() > 20) content = content.substring(0, 20);
-    
-    updateLineIfChanged(3, content, line4Content);
+    setLine(3, info);
 }
 
 void LCDDisplay::clearLine(uint8_t line) {
     if (!initialized || !displayEnabled || line >= 4) return;
     
-    setCursorToLine(line);
-    for (int i = 0; i < 20; i++) {
-        sendData(' ');
-    }
-    
-    // Update our content tracking
-    switch (line) {
-        case 0: line1Content = ""; break;
-        case 1: line2Content = ""; break;
-        case 2: line3Content = ""; break;
-        case 3: line4Content = ""; break;
-    }
+    setLine(line, "");
 }
 
 void LCDDisplay::clear() {
     if (!initialized || !displayEnabled) return;
     
-    sendCommand(0x01);  // Clear display
-    delay(2);
-    
-    // Clear our content tracking
-    line1Content = "";
-    line2Content = "";
-    line3Content = "";
-    line4Content = "";
+    // Blank the framebuffer; only cells that were showing something get rewritten
+    for (uint8_t line = 0; line < rows; line++) {
+        setLine(line, "");
+    }
 }
 
 void LCDDisplay::setEnabled(bool enabled) {
@@ -296,43 +415,28 @@ void LCDDisplay::showStartupMessage() {
     
     clear();
     
-    setCursorToLine(0);
-    printString("Log Splitter Monitor");
-    
-    setCursorToLine(1);
-    printString("System Starting...");
-    
-    setCursorToLine(2);
-    printString("Please Wait");
+    setLine(0, "Log Splitter Monitor");
+    setLine(1, "System Starting...");
+    setLine(2, "Please Wait");
+    flush();
 }
 
 void LCDDisplay::showConnectingMessage() {
     if (!initialized || !displayEnabled) return;
     
-    setCursorToLine(1);
-    printString("Connecting WiFi...  ");
-    
-    setCursorToLine(2);
-    printString("                    ");
-    
-    setCursorToLine(3);
-    printString("                    ");
+    setLine(1, "Connecting WiFi...");
+    setLine(2, "");
+    setLine(3, "");
+    flush();
 }
 
 void LCDDisplay::showCalibrationMessage(const char* step) {
     if (!initialized || !displayEnabled) return;
     
-    setCursorToLine(1);
-    printString("Calibrating Scale   ");
-    
-    setCursorToLine(2);
-    String content = step;
-    while (content.length() < 20) content += " ";
-    if (content.length() > 20) content = content.substring(0, 20);
-    printString(content);
-    
-    setCursorToLine(3);
-    printString("                    ");
+    setLine(1, "Calibrating Scale");
+    setLine(2, step);
+    setLine(3, "");
+    flush();
 }
 
 String LCDDisplay::formatUptime(unsigned long uptime) {
@@ -365,24 +469,19 @@ String LCDDisplay::formatSystemState(uint8_t state) {
     }
 }
 
-void LCDDisplay::updateLineIfChanged(uint8_t line, const String& content, String& currentContent) {
-    if (content != currentContent) {
-        setCursorToLine(line);
-        printString(content);
-        currentContent = content;
-    }
-}
-
-void LCDDisplay::setCursorToLine(uint8_t line) {
-    uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};  // HD44780 memory addresses for 20x4
-    if (line < 4) {
-        sendCommand(0x80 | rowOffsets[line]);
+void LCDDisplay::setLine(uint8_t line, const char* content) {
+    if (line >= rows) return;
+    
+    for (uint8_t col = 0; col < columns; col++) {
+        char c = (content && *content) ? *content++ : ' ';
+        setCell(line, col, c);
     }
 }
 
-void LCDDisplay::printString(const String& str) {
-    for (unsigned int i = 0; i < str.length(); i++) {
-        sendData(str.charAt(i));
+void LCDDisplay::setCell(uint8_t row, uint8_t col, char c) {
+    if (frame[row][col] != c) {
+        frame[row][col] = c;
+        dirty[row] |= 1UL << col;
     }
 }
 
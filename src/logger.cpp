@@ -1,12 +1,148 @@
 #include "logger.h"
 #include "network_manager.h"
+#include "response_sink.h"
 #include "constants.h"
 #include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
 
 // Static member definitions
 NetworkManager* Logger::networkManager = nullptr;
 LogLevel Logger::currentLogLevel = LOG_INFO;  // Default to INFO level
-char Logger::logBuffer[512];
+
+LogSite* Logger::sites = nullptr;
+uint16_t Logger::siteCount = 0;
+uint32_t Logger::suppressedTotal = 0;
+
+uint8_t Logger::ring[LOGGER_RING_BYTES];
+size_t Logger::ringHead = 0;
+size_t Logger::ringTail = 0;
+size_t Logger::ringUsed = 0;
+uint16_t Logger::queuedCount = 0;
+
+char Logger::lineBuffer[LOGGER_LINE_SIZE];
+char Logger::datagram[SYSLOG_DATAGRAM_SIZE];
+size_t Logger::datagramLength = 0;
+uint8_t Logger::datagramLines = 0;
+
+uint32_t Logger::logged = 0;
+uint32_t Logger::dropped = 0;
+uint32_t Logger::eagerFormats = 0;
+size_t Logger::peakUsed = 0;
+uint32_t Logger::linesSent = 0;
+uint32_t Logger::datagramsSent = 0;
+uint32_t Logger::sendFailures = 0;
+unsigned long Logger::maxServiceUs = 0;
+
+// Argument classes the capture understands, by printf conversion
+enum FormatArg : uint8_t {
+    ARG_NONE,           // %%
+    ARG_INT,            // d i u x X o c, with h/hh
+    ARG_LONG,           // l
+    ARG_LLONG,          // ll
+    ARG_SIZE,           // z
+    ARG_DOUBLE,         // f F e E g G a A (float is promoted)
+    ARG_STRING,         // s - copied into the record
+    ARG_POINTER,        // p
+    ARG_UNSUPPORTED     // n, L, j, t, wide chars, truncated spec
+};
+
+struct FormatSpec {
+    const char* start;  // The '%'
+    uint8_t length;
+    uint8_t stars;      // '*' width/precision, each consumes an int
+    FormatArg arg;
+};
+
+// Find the next conversion at or after p; returns the position after it,
+// or nullptr when the format has no more conversions
+static const char* nextSpec(const char* p, FormatSpec& spec) {
+    while (*p && *p != '%') p++;
+    if (!*p) return nullptr;
+
+    spec.start = p++;
+    spec.stars = 0;
+
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*') {
+        spec.stars++;
+        p++;
+    } else {
+        while (isdigit((unsigned char)*p)) p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec.stars++;
+            p++;
+        } else {
+            while (isdigit((unsigned char)*p)) p++;
+        }
+    }
+
+    uint8_t longs = 0;
+    bool sized = false;
+    bool other = false;
+    while (*p && strchr("hlLzjt", *p)) {
+        if (*p == 'l') longs++;
+        else if (*p == 'z') sized = true;
+        else if (*p != 'h') other = true;
+        p++;
+    }
+
+    char conversion = *p;
+    if (conversion) p++;
+
+    switch (conversion) {
+        case '%':
+            spec.arg = ARG_NONE;
+            break;
+        case 'c':
+            spec.arg = (longs || other) ? ARG_UNSUPPORTED : ARG_INT;
+            break;
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+            if (other) spec.arg = ARG_UNSUPPORTED;
+            else if (sized) spec.arg = ARG_SIZE;
+            else if (longs >= 2) spec.arg = ARG_LLONG;
+            else if (longs == 1) spec.arg = ARG_LONG;
+            else spec.arg = ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec.arg = other ? ARG_UNSUPPORTED : ARG_DOUBLE;
+            break;
+        case 's':
+            spec.arg = (longs || other) ? ARG_UNSUPPORTED : ARG_STRING;
+            break;
+        case 'p':
+            spec.arg = ARG_POINTER;
+            break;
+        default:
+            spec.arg = ARG_UNSUPPORTED;
+            break;
+    }
+
+    spec.length = p - spec.start;
+    return p;
+}
+
+// File name without its directory, for call site reports
+static const char* baseName(const char* path) {
+    const char* name = path;
+    for (const char* p = path; *p; p++) {
+        if (*p == '/' || *p == '\\') name = p + 1;
+    }
+    return name;
+}
+
+// Format one captured argument with the original conversion spec
+template <typename T>
+static int formatArg(char* out, size_t size, const char* spec, const int* stars, uint8_t starCount, T value) {
+    switch (starCount) {
+        case 0:  return snprintf(out, size, spec, value);
+        case 1:  return snprintf(out, size, spec, stars[0], value);
+        default: return snprintf(out, size, spec, stars[0], stars[1], value);
+    }
+}
 
 void Logger::begin(NetworkManager* netMgr) {
     networkManager = netMgr;
@@ -42,80 +178,420 @@ const char* Logger::getLevelString(LogLevel level) {
     }
 }
 
-void Logger::log(LogLevel level, const char* fmt, ...) {
-    if (!shouldLog(level)) {
-        return;  // Don't log if below threshold
+bool Logger::admit(LogSite& site) {
+    unsigned long now = millis();
+    
+    if (!site.registered) {
+        site.registered = true;
+        site.lastRefillMs = now;
+        site.next = sites;
+        sites = &site;
+        siteCount++;
     }
     
-    // Format the message
+    // Refill whole tokens only, keeping the remainder for the next call
+    if (site.tokens >= LOGGER_SITE_BURST) {
+        site.lastRefillMs = now;
+    } else {
+        unsigned long refill = (now - site.lastRefillMs) / LOGGER_SITE_REFILL_MS;
+        if (refill >= (unsigned long)(LOGGER_SITE_BURST - site.tokens)) {
+            site.tokens = LOGGER_SITE_BURST;
+            site.lastRefillMs = now;
+        } else if (refill > 0) {
+            site.tokens += refill;
+            site.lastRefillMs += refill * LOGGER_SITE_REFILL_MS;
+        }
+    }
+    
+    if (site.tokens == 0) {
+        site.suppressed++;
+        site.unreported++;
+        suppressedTotal++;
+        return false;
+    }
+    site.tokens--;
+    
+    // Say how much was lost before the first message that gets through again
+    if (site.unreported > 0) {
+        log(LOG_NOTICE, "Logger: %lu messages suppressed at %s:%u",
+            (unsigned long)site.unreported, baseName(site.file), site.line);
+        site.unreported = 0;
+    }
+    return true;
+}
+
+void Logger::log(LogLevel level, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(logBuffer, sizeof(logBuffer), fmt, args);
+    vlog(level, fmt, args);
     va_end(args);
-    
-    // Send to syslog server if network is available
-    bool syslogSent = false;
-    if (networkManager && networkManager->isWiFiConnected()) {
-        syslogSent = networkManager->sendSyslog(logBuffer, level);
+}
+
+void Logger::vlog(LogLevel level, const char* fmt, va_list args) {
+    if (!shouldLog(level)) {
+        return;  // Don't log if below threshold
     }
-    
+    vlogAlways(level, fmt, args);
+}
+
+void Logger::vlogAlways(LogLevel level, const char* fmt, va_list args) {
+    if (!fmt) return;
+
+    uint8_t record[LOGGER_MAX_RECORD];
+    RecordHeader header;
+    header.level = level;
+    header.reserved = 0;
+    header.timestamp = millis();
+    header.fmt = fmt;
+
+    uint8_t* payload = record + sizeof(RecordHeader);
+    size_t payloadSize = sizeof(record) - sizeof(RecordHeader);
+
+    va_list captureArgs;
+    va_copy(captureArgs, args);
+    size_t payloadLength = 0;
+    bool captured = capture(payload, payloadSize, fmt, captureArgs, payloadLength);
+    va_end(captureArgs);
+
+    if (!captured) {
+        // Not capturable - keep the formatted text instead of the arguments
+        int written = vsnprintf((char*)payload, payloadSize, fmt, args);
+        if (written < 0) written = 0;
+        payloadLength = ((size_t)written < payloadSize ? (size_t)written : payloadSize - 1) + 1;
+        header.fmt = nullptr;
+        eagerFormats++;
+    }
+
+    header.length = sizeof(RecordHeader) + payloadLength;
+    if (ringUsed + header.length > sizeof(ring)) {
+        dropped++;
+        return;
+    }
+
+    memcpy(record, &header, sizeof(header));
+    ringWrite(record, header.length);
+    queuedCount++;
+    logged++;
+    if (ringUsed > peakUsed) peakUsed = ringUsed;
+}
+
+// Store the arguments in format order; false if the format needs a
+// conversion that is not captured or the values do not fit the record
+bool Logger::capture(uint8_t* payload, size_t payloadSize, const char* fmt, va_list args, size_t& length) {
+    size_t used = 0;
+    FormatSpec spec;
+
+    // Copies one fixed-size value, failing the capture if it does not fit
+    #define LOGGER_PUT(type)                                        \
+        do {                                                        \
+            type value = va_arg(args, type);                        \
+            if (used + sizeof(value) > payloadSize) return false;   \
+            memcpy(payload + used, &value, sizeof(value));          \
+            used += sizeof(value);                                  \
+        } while (0)
+
+    for (const char* p = fmt; (p = nextSpec(p, spec)) != nullptr; ) {
+        for (uint8_t i = 0; i < spec.stars; i++) {
+            LOGGER_PUT(int);
+        }
+
+        switch (spec.arg) {
+            case ARG_NONE:    break;
+            case ARG_INT:     LOGGER_PUT(int); break;
+            case ARG_LONG:    LOGGER_PUT(long); break;
+            case ARG_LLONG:   LOGGER_PUT(long long); break;
+            case ARG_SIZE:    LOGGER_PUT(size_t); break;
+            case ARG_DOUBLE:  LOGGER_PUT(double); break;
+            case ARG_POINTER: LOGGER_PUT(void*); break;
+            case ARG_STRING: {
+                const char* str = va_arg(args, const char*);
+                if (!str) str = "(null)";
+                if (used >= payloadSize) return false;
+
+                // Long strings are truncated to what is left of the record
+                size_t strLength = strlen(str);
+                size_t room = payloadSize - used - 1;
+                if (strLength > room) strLength = room;
+                memcpy(payload + used, str, strLength);
+                payload[used + strLength] = '\0';
+                used += strLength + 1;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    #undef LOGGER_PUT
+    length = used;
+    return true;
+}
+
+// Rebuild the message from a captured payload, one conversion at a time
+size_t Logger::render(char* out, size_t outSize, const char* fmt, const uint8_t* payload, size_t payloadLength) {
+    if (!fmt) {
+        strncpy(out, (const char*)payload, outSize - 1);
+        out[outSize - 1] = '\0';
+        return strlen(out);
+    }
+
+    size_t written = 0;
+    size_t offset = 0;
+    const char* literal = fmt;
+    FormatSpec spec;
+
+    // Reads one fixed-size value back out of the payload
+    #define LOGGER_GET(type, var)                               \
+        type var;                                               \
+        if (offset + sizeof(var) > payloadLength) break;        \
+        memcpy(&var, payload + offset, sizeof(var));            \
+        offset += sizeof(var)
+
+    for (const char* p = fmt; (p = nextSpec(p, spec)) != nullptr && written < outSize - 1; literal = p) {
+        // Literal text before the conversion
+        size_t literalLength = spec.start - literal;
+        if (literalLength > outSize - 1 - written) literalLength = outSize - 1 - written;
+        memcpy(out + written, literal, literalLength);
+        written += literalLength;
+
+        char specText[24];
+        size_t specLength = spec.length < sizeof(specText) - 1 ? spec.length : sizeof(specText) - 1;
+        memcpy(specText, spec.start, specLength);
+        specText[specLength] = '\0';
+
+        int stars[2] = {0, 0};
+        for (uint8_t i = 0; i < spec.stars && i < 2; i++) {
+            if (offset + sizeof(int) > payloadLength) break;
+            memcpy(&stars[i], payload + offset, sizeof(int));
+            offset += sizeof(int);
+        }
+
+        char* dest = out + written;
+        size_t room = outSize - written;
+        int n = 0;
+        switch (spec.arg) {
+            case ARG_NONE:    n = snprintf(dest, room, "%%"); break;
+            case ARG_INT:     { LOGGER_GET(int, v); n = formatArg(dest, room, specText, stars, spec.stars, v); break; }
+            case ARG_LONG:    { LOGGER_GET(long, v); n = formatArg(dest, room, specText, stars, spec.stars, v); break; }
+            case ARG_LLONG:   { LOGGER_GET(long long, v); n = formatArg(dest, room, specText, stars, spec.stars, v); break; }
+            case ARG_SIZE:    { LOGGER_GET(size_t, v); n = formatArg(dest, room, specText, stars, spec.stars, v); break; }
+            case ARG_DOUBLE:  { LOGGER_GET(double, v); n = formatArg(dest, room, specText, stars, spec.stars, v); break; }
+            case ARG_POINTER: { LOGGER_GET(void*, v); n = formatArg(dest, room, specText, stars, spec.stars, v); break; }
+            case ARG_STRING: {
+                if (offset >= payloadLength) break;
+                const char* str = (const char*)payload + offset;
+                offset += strlen(str) + 1;
+                n = formatArg(dest, room, specText, stars, spec.stars, str);
+                break;
+            }
+            default:
+                break;
+        }
+        if (n > 0) written += ((size_t)n < room ? (size_t)n : room - 1);
+    }
+
+    #undef LOGGER_GET
+
+    // Text after the last conversion
+    size_t tailLength = strlen(literal);
+    if (tailLength > outSize - 1 - written) tailLength = outSize - 1 - written;
+    memcpy(out + written, literal, tailLength);
+    written += tailLength;
+    out[written] = '\0';
+    return written;
+}
+
+void Logger::ringWrite(const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    size_t first = sizeof(ring) - ringHead;
+    if (first > length) first = length;
+    memcpy(ring + ringHead, bytes, first);
+    memcpy(ring, bytes + first, length - first);
+    ringHead = (ringHead + length) % sizeof(ring);
+    ringUsed += length;
+}
+
+void Logger::ringRead(void* data, size_t length) {
+    uint8_t* bytes = (uint8_t*)data;
+    size_t first = sizeof(ring) - ringTail;
+    if (first > length) first = length;
+    memcpy(bytes, ring + ringTail, first);
+    memcpy(bytes + first, ring, length - first);
+    ringTail = (ringTail + length) % sizeof(ring);
+    ringUsed -= length;
+}
+
+void Logger::service(unsigned long budgetUs) {
+    if (ringUsed == 0) return;
+
+    unsigned long start = micros();
+    bool online = networkManager && networkManager->canSendSyslog();
+
+    while (ringUsed > 0) {
+        uint8_t record[LOGGER_MAX_RECORD];
+        RecordHeader header;
+        ringRead(&header, sizeof(header));
+        size_t payloadLength = header.length - sizeof(header);
+        ringRead(record, payloadLength);
+        queuedCount--;
+
+        // debugPrintf() formats end in a newline; batched lines are LF separated
+        size_t lineLength = render(lineBuffer, sizeof(lineBuffer), header.fmt, record, payloadLength);
+        while (lineLength > 0 && (lineBuffer[lineLength - 1] == '\n' || lineBuffer[lineLength - 1] == '\r')) {
+            lineBuffer[--lineLength] = '\0';
+        }
+        emit(header.level, header.timestamp, lineBuffer, online);
+
+        if (micros() - start >= budgetUs) break;
+    }
+
+    // Lines are not held back for a fuller packet - latency stays one task period
+    sendDatagram();
+
+    unsigned long elapsed = micros() - start;
+    if (elapsed > maxServiceUs) maxServiceUs = elapsed;
+}
+
+void Logger::emit(uint8_t level, uint32_t timestamp, const char* message, bool online) {
+    if (online) {
+        char line[LOGGER_LINE_SIZE + 64];
+        int length = networkManager->formatSyslogLine(line, sizeof(line), level, timestamp, message);
+        if (length > 0) {
+            // Separator LF included; a full datagram goes out before this line
+            size_t needed = (size_t)length + 1;
+            if (datagramLines >= SYSLOG_BATCH_MAX_LINES || datagramLength + needed >= sizeof(datagram)) {
+                sendDatagram();
+            }
+            if (datagramLines > 0) datagram[datagramLength++] = '\n';
+            size_t copy = (size_t)length < sizeof(datagram) - 1 - datagramLength ? (size_t)length : sizeof(datagram) - 1 - datagramLength;
+            memcpy(datagram + datagramLength, line, copy);
+            datagramLength += copy;
+            datagram[datagramLength] = '\0';
+            datagramLines++;
+        }
+    }
+
     // Output to Serial only in these cases:
     // 1. CRITICAL or EMERGENCY messages (always shown)
-    // 2. ERROR messages (always shown) 
-    // 3. When syslog fails AND debug is enabled (fallback for troubleshooting)
-    extern bool g_debugEnabled;
-    bool shouldShowOnSerial = (level <= LOG_ERROR) || (!syslogSent && g_debugEnabled);
-    
+    // 2. ERROR messages (always shown)
+    // 3. When syslog is unavailable AND debug is enabled (fallback for troubleshooting)
+    bool shouldShowOnSerial = (level <= LOG_ERROR) || (!online && g_debugEnabled);
+
     if (shouldShowOnSerial) {
-        unsigned long ts = millis();
         Serial.print("[");
-        Serial.print(ts);
+        Serial.print(timestamp);
         Serial.print("] [");
-        Serial.print(getLevelString(level));
+        Serial.print(getLevelString((LogLevel)level));
         Serial.print("] ");
-        if (!syslogSent) {
+        if (!online) {
             Serial.print("[SYSLOG_FAIL] ");
         }
-        Serial.println(logBuffer);
+        Serial.println(message);
+    }
+}
+
+void Logger::sendDatagram() {
+    if (datagramLines == 0) return;
+
+    if (networkManager && networkManager->sendSyslogDatagram(datagram, datagramLength)) {
+        datagramsSent++;
+        linesSent += datagramLines;
+    } else {
+        sendFailures++;
+        if (g_debugEnabled) {
+            Serial.print("[SYSLOG_FAIL] ");
+            Serial.println(datagram);
+        }
+    }
+
+    datagramLength = 0;
+    datagramLines = 0;
+}
+
+void Logger::resetStatistics() {
+    logged = 0;
+    dropped = 0;
+    eagerFormats = 0;
+    peakUsed = ringUsed;
+    linesSent = 0;
+    datagramsSent = 0;
+    sendFailures = 0;
+    maxServiceUs = 0;
+    suppressedTotal = 0;
+    for (LogSite* site = sites; site; site = site->next) {
+        site->suppressed = 0;
+    }
+}
+
+void Logger::getStatistics(char* buffer, size_t bufferSize) {
+    if (!buffer || bufferSize == 0) return;
+
+    snprintf(buffer, bufferSize,
+        "log: queued=%u (%u/%u bytes, peak %u) logged=%lu dropped=%lu eager=%lu "
+        "lines=%lu datagrams=%lu failed=%lu max=%luus suppressed=%lu",
+        queuedCount, (unsigned)ringUsed, (unsigned)sizeof(ring), (unsigned)peakUsed,
+        (unsigned long)logged, (unsigned long)dropped, (unsigned long)eagerFormats,
+        (unsigned long)linesSent, (unsigned long)datagramsSent,
+        (unsigned long)sendFailures, maxServiceUs, (unsigned long)suppressedTotal);
+}
+
+void Logger::getSiteStatistics(ResponseSink& out) {
+    out.printf("log sites: %u active, %lu suppressed (burst %u, +1 per %lums)",
+        siteCount, (unsigned long)suppressedTotal, LOGGER_SITE_BURST, LOGGER_SITE_REFILL_MS);
+    
+    // Noisiest sites first
+    const LogSite* shown = nullptr;
+    uint32_t below = UINT32_MAX;
+    while (true) {
+        const LogSite* next = nullptr;
+        for (const LogSite* site = sites; site; site = site->next) {
+            if (site->suppressed == 0 || site->suppressed > below) continue;
+            if (site->suppressed == below && site <= shown) continue;
+            if (!next || site->suppressed > next->suppressed ||
+                (site->suppressed == next->suppressed && site < next)) {
+                next = site;
+            }
+        }
+        if (!next) break;
+        
+        out.printf("\r\n%s:%u suppressed=%lu",
+            baseName(next->file), next->line, (unsigned long)next->suppressed);
+        shown = next;
+        below = next->suppressed;
     }
 }
 
 void Logger::logCritical(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(logBuffer, sizeof(logBuffer), fmt, args);
+    vlog(LOG_CRITICAL, fmt, args);
     va_end(args);
-    log(LOG_CRITICAL, "%s", logBuffer);
 }
 
 void Logger::logError(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(logBuffer, sizeof(logBuffer), fmt, args);
+    vlog(LOG_ERROR, fmt, args);
     va_end(args);
-    log(LOG_ERROR, "%s", logBuffer);
 }
 
 void Logger::logWarn(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(logBuffer, sizeof(logBuffer), fmt, args);
+    vlog(LOG_WARNING, fmt, args);
     va_end(args);
-    log(LOG_WARNING, "%s", logBuffer);
 }
 
 void Logger::logInfo(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(logBuffer, sizeof(logBuffer), fmt, args);
+    vlog(LOG_INFO, fmt, args);
     va_end(args);
-    log(LOG_INFO, "%s", logBuffer);
 }
 
 void Logger::logDebug(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(logBuffer, sizeof(logBuffer), fmt, args);
+    vlog(LOG_DEBUG, fmt, args);
     va_end(args);
-    log(LOG_DEBUG, "%s", logBuffer);
-}
\ No newline at end of file
+}
@@ -11,19 +11,44 @@
 #include "mcp9600_sensor.h"
 #include "logger.h"
 #include "serial_bridge.h"
+#include "task_scheduler.h"
+#include "store_forward_log.h"
+#include "memory_monitor.h"
+#include "perf_profiler.h"
+#include "config_log.h"
+#include "monitor_config.h"
+#include "boot_timeline.h"
+#include "heartbeat_animation.h"
 
 // Global instances
 NetworkManager networkManager;
 TelnetServer telnetServer;
+TCA9548A_Multiplexer i2cMux(0x70);  // Sole owner of the mux control register
 MonitorSystem monitorSystem;
 CommandProcessor commandProcessor;
 LCDDisplay lcdDisplay;
 SerialBridge serialBridge;
+TaskScheduler scheduler;
+StoreForwardLog storeForwardLog;
+MemoryMonitor memoryMonitor;
+PerfProfiler perfProfiler;
+ConfigLog configLog;
+MonitorConfigManager monitorConfig;
+BootTimeline bootTimeline;
+HeartbeatAnimation heartbeatAnimation;
 
 // Global pointer for external access
 NetworkManager* g_networkManager = &networkManager;
 LCDDisplay* g_lcdDisplay = &lcdDisplay;
 SerialBridge* g_serialBridge = &serialBridge;
+TaskScheduler* g_scheduler = &scheduler;
+StoreForwardLog* g_storeForward = &storeForwardLog;
+MemoryMonitor* g_memoryMonitor = &memoryMonitor;
+PerfProfiler* g_perfProfiler = &perfProfiler;
+ConfigLog* g_configLog = &configLog;
+MonitorConfigManager* g_monitorConfig = &monitorConfig;
+BootTimeline* g_bootTimeline = &bootTimeline;
+TCA9548A_Multiplexer* g_i2cMux = &i2cMux;
 MCP9600Sensor* g_mcp9600Sensor = nullptr; // Will be set by monitor system
 
 // Global debug flag
@@ -32,139 +57,169 @@ bool g_debugEnabled = false; // Disabled by default for production use
 // System state
 SystemState currentSystemState = SYS_INITIALIZING;
 unsigned long lastWatchdog = 0;
+static bool monitorPassDone = false;   // Gates the first (blocking) WiFi join
 
-// Debug printf function that sends to syslog
-void debugPrintf(const char* fmt, ...) {
+// Profiler probes around the main subsystem calls (sensor reads are added
+// by the I2C scheduler)
+static int8_t perfLoop = PERF_INVALID_PROBE;
+static int8_t perfNetwork = PERF_INVALID_PROBE;
+static int8_t perfMonitor = PERF_INVALID_PROBE;
+static int8_t perfBridge = PERF_INVALID_PROBE;
+static int8_t perfTelnet = PERF_INVALID_PROBE;
+
+// Scheduler task callbacks (defined after setup)
+static void taskWiFiStatus(void*);
+static void taskNetwork(void*);
+static void taskMonitor(void*);
+static void taskBridge(void*);
+static void taskMatrix(void*);
+static void taskStoreForward(void*);
+static void taskConfigLog(void*);
+static void taskSyslog(void*);
+static void taskConsole(void*);
+static void taskHealth(void*);
+static void idleSerialDrain(void*);
+
+// Debug output behind `debug on`, queued in the Logger ring like LOG_*:
+// sent to syslog by the syslog task, or shown on Serial while offline.
+// Sent at INFO, the severity these lines always had on the wire, and not
+// filtered by the log level: `debug on` always prints.
+// (name in parentheses: the debugPrintf() macro in logger.h wraps it)
+void (debugPrintf)(const char* fmt, ...) {
     if (!g_debugEnabled) return;
     
-    char buffer[256];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    Logger::vlogAlways(LOG_INFO, fmt, args);
     va_end(args);
-    
-    // Send to syslog server if network is available
-    if (networkManager.isWiFiConnected()) {
-        // Remove newlines for syslog
-        size_t len = strlen(buffer);
-        if (len > 0 && buffer[len-1] == '\n') {
-            buffer[len-1] = '\0';
-        }
-        networkManager.sendSyslog(buffer);
-    } else {
-        // Only send to Serial when network is NOT available and debug is enabled
-        // This allows local debugging during startup or network issues
-        Serial.print("DEBUG: ");
-        Serial.print(buffer);
-    }
 }
 
 void setup() {
-    // Initialize Serial FIRST
+    // Paint the unused stack before anything else runs deep
+    memoryMonitor.begin();
+    
+    // Initialize Serial FIRST - no wait for a monitor, 'show boot' keeps the timings
     Serial.begin(115200);
-    delay(1000); // Give time for serial monitor to connect
     
     // Essential startup banner - always show
     Serial.println("===============================================");
     Serial.println("   LogSplitter Monitor v1.0.0 - Starting");
     Serial.println("===============================================");
+    bootTimeline.stage("serial");
+    
+    // Cycle counter and the subsystem probes (sensor probes follow in monitorSystem.begin())
+    perfProfiler.begin();
+    perfLoop = perfProfiler.addProbe("loop");
+    perfNetwork = perfProfiler.addProbe("network");
+    perfMonitor = perfProfiler.addProbe("monitor");
+    perfBridge = perfProfiler.addProbe("bridge");
+    perfTelnet = perfProfiler.addProbe("telnet");
+    
+    // Persistent settings from EEPROM - loaded before the sensors and the
+    // network start, it holds calibration, the last WiFi lease and the static IP profile
+    configLog.begin();
+    monitorConfig.begin();
+    networkManager.setWiFiLease(monitorConfig.getWiFiLease());
+    networkManager.setStaticIp(monitorConfig.getStaticIp());
+    networkManager.setHostname(monitorConfig.getSyslogHostname());
+    networkManager.setTopicNamespace(monitorConfig.isTopicNamespaced());
+    networkManager.setWiFiLeaseCallback([](void* context, const WiFiLease& lease) {
+        MonitorConfigManager* config = (MonitorConfigManager*)context;
+        config->setWiFiLease(lease);
+        config->save();
+    }, &monitorConfig);
+    bootTimeline.stage("config");
     
     // Initialize I2C bus (Wire1) BEFORE any sensors try to use it
     Wire1.begin();
-    Wire1.setClock(100000); // 100kHz for better compatibility with multiple devices
-    delay(200); // Give I2C bus time to stabilize
+    // Standard mode for the boot probe; the mux then applies each channel's clock profile
+    Wire1.setClock(I2C_CLOCK_STANDARD);
     Serial.println("I2C Wire1 initialized at 100kHz");
     
-    // Scan I2C bus immediately for debugging
-    Serial.println("Scanning I2C bus (Wire1)...");
-    int deviceCount = 0;
-    for (uint8_t addr = 1; addr < 127; addr++) {
-        Wire1.beginTransmission(addr);
-        if (Wire1.endTransmission() == 0) {
-            Serial.print("  Found device at 0x");
-            if (addr < 16) Serial.print("0");
-            Serial.println(addr, HEX);
-            deviceCount++;
-        }
-    }
-    Serial.print("I2C scan complete: ");
-    Serial.print(deviceCount);
-    Serial.println(" device(s) found");
-    
-    // Try to initialize LCD IMMEDIATELY (before WiFi)
-    Serial.println("Attempting early LCD initialization...");
-    Wire1.beginTransmission(0x70);  // TCA9548A multiplexer address
-    Wire1.write(1 << 7);  // Select channel 7 for LCD
-    byte muxError = Wire1.endTransmission();
-    
-    if (muxError == 0) {
-        Serial.println("Multiplexer channel 7 selected for LCD");
-        delay(100);
-        
+    // Sensors start now, not after WiFi: the monitor task samples from its
+    // first pass and outage samples go to the store-and-forward log. Only
+    // the known device map is probed; 'i2c scan' does a full bus scan.
+    monitorSystem.begin();
+    bootTimeline.stage("sensors");
+    
+    // LCD once, on its mux channel (or the main bus without a mux)
+    if (monitorSystem.isDevicePresent(MonitorSystem::DEVICE_LCD)) {
+        i2cMux.selectChannel(TCA9548A_Multiplexer::MUX_CHANNEL_7, 100);
         if (lcdDisplay.begin()) {
-            Serial.println("LCD display initialized successfully (early init)");
+            Serial.println("LCD display initialized successfully");
             lcdDisplay.showStartupMessage();
             lcdDisplay.showConnectingMessage();
         } else {
-            Serial.println("LCD init failed - check I2C address 0x27");
+            Serial.println("WARNING: LCD display initialization failed - not responding");
         }
-        
-        // Disable multiplexer channels after LCD init
-        Wire1.beginTransmission(0x70);
-        Wire1.write(0x00);
-        Wire1.endTransmission();
+        i2cMux.disableAllChannels();
     } else {
-        Serial.print("No multiplexer found at 0x70, error: ");
-        Serial.println(muxError);
-        
-        // Try LCD directly without multiplexer
-        Serial.println("Trying LCD directly at 0x27...");
-        if (lcdDisplay.begin()) {
-            Serial.println("LCD found directly (no multiplexer)");
-        } else {
-            Serial.println("LCD not found at 0x27");
-        }
+        Serial.println("LCD not found at 0x27");
     }
     
+    // On-board LED matrix: spinner and bridge traffic gauge (no I2C)
+    heartbeatAnimation.begin();
+    bootTimeline.stage("lcd");
+    
     // Initialize command processor and network
     commandProcessor.begin(&networkManager, &monitorSystem);
     debugPrintf("Command processor initialized\n");
     
     networkManager.begin();
     debugPrintf("Network manager initialized\n");
-    
-    // Show WiFi credentials being used (masked password)
-    Serial.print("Connecting to WiFi SSID: ");
-    Serial.println(SECRET_SSID);
+    bootTimeline.stage("network");
     
     // Initialize Logger system with NetworkManager
     Logger::begin(&networkManager);
     Logger::setLogLevel(LOG_INFO);  // Default to INFO level
     debugPrintf("Logger initialized\n");
     
-    networkManager.setHostname("LogMonitor");
-    telnetServer.setConnectionInfo("LogMonitor", "1.0.0");
+    telnetServer.setConnectionInfo(networkManager.getHostname(), "1.0.0");
     
     // Initialize Serial Bridge for controller communication
     serialBridge.setNetworkManager(&networkManager);
     serialBridge.begin();
     debugPrintf("Serial bridge initialized\n");
     
+    // Recover any telemetry stored during a previous outage
+    storeForwardLog.begin(&networkManager);
+    
+    // Sample rate policy from the settings loaded above
+    const RatePolicy& ratePolicy = monitorConfig.getRatePolicy();
+    if (!serialBridge.setRatePolicy(ratePolicy.minHz, ratePolicy.maxHz, ratePolicy.burst)) {
+        LOG_WARN("Saved sample rate policy out of range, using defaults");
+        serialBridge.setRatePolicy(0, 0, 0);
+    }
+    bootTimeline.stage("services");
+    
+    // Register main loop tasks (name, callback, context, period ms, budget us)
+    scheduler.setIdleHook(idleSerialDrain, nullptr);
+    scheduler.addTask("wifi", taskWiFiStatus, nullptr, 100, 2000);
+    scheduler.addTask("network", taskNetwork, nullptr, 0, 20000);
+    scheduler.addTask("bridge", taskBridge, nullptr, 0, 5000);
+    scheduler.addTask("sflog", taskStoreForward, nullptr, 2, 3000);
+    scheduler.addTask("config", taskConfigLog, nullptr, 5, 3000);
+    scheduler.addTask("syslog", taskSyslog, nullptr, 20, LOGGER_DRAIN_BUDGET_US + 1000);
+    scheduler.addTask("monitor", taskMonitor, nullptr, 10, 20000);
+    scheduler.addTask("console", taskConsole, nullptr, 20, 10000);
+    scheduler.addTask("health", taskHealth, nullptr, 60000, 5000);
+    scheduler.addTask("matrix", taskMatrix, nullptr, MATRIX_UPDATE_INTERVAL_MS, 1000);
+    
     debugPrintf("Network initialization complete\n");
     currentSystemState = SYS_CONNECTING;
+    bootTimeline.stage("scheduler");
+    LOG_INFO("Boot: setup done in %lu ms", bootTimeline.getSetupMs());
     
     // Essential status message - always show 
     Serial.println("System ready - connecting to network...");
     Serial.println("Type 'help' for available commands");
 }
 
-void loop() {
+// ===== Scheduler tasks =====
+
+// WiFi connection status reporting
+static void taskWiFiStatus(void*) {
     unsigned long now = millis();
-    
-    // Update watchdog
-    lastWatchdog = now;
-    
-    // WiFi connection status reporting
     static unsigned long lastWifiStatusReport = 0;
     static int lastWifiStatus = -1;
     int currentWifiStatus = WiFi.status();
@@ -189,80 +244,51 @@ void loop() {
         
         // Update LCD with WiFi status if available
         if (lcdDisplay.isAvailable()) {
-            Wire1.beginTransmission(0x70);
-            Wire1.write(1 << 7);
-            Wire1.endTransmission();
-            delay(10);
+            // Skipped if channel 7 is already selected; fails harmlessly for a directly wired LCD
+            i2cMux.selectChannel(TCA9548A_Multiplexer::MUX_CHANNEL_7);
             
             if (currentWifiStatus == WL_CONNECTED) {
                 char ipStr[20];
                 snprintf(ipStr, sizeof(ipStr), "IP:%s", WiFi.localIP().toString().c_str());
                 lcdDisplay.showInfo(ipStr);
+                lcdDisplay.flush();
             } else {
                 lcdDisplay.showConnectingMessage();
             }
-            
-            Wire1.beginTransmission(0x70);
-            Wire1.write(0x00);
-            Wire1.endTransmission();
         }
     }
+}
+
+static void taskNetwork(void*) {
+    // WiFi.begin() blocks until the join completes: start it only once the
+    // monitor task has sampled, so the first readings are not held back by it
+    if (!networkManager.isJoinStarted()) {
+        if (!monitorPassDone) return;
+        Serial.print("Connecting to WiFi SSID: ");
+        Serial.println(SECRET_SSID);
+        networkManager.startJoin();
+    }
     
-    // Update network first
+    uint32_t startCycles = PerfProfiler::now();
     networkManager.update();
+    perfProfiler.record(perfNetwork, startCycles);
     
-    // Initialize sensors after network is connected (one-time initialization)
-    static bool sensorsInitialized = false;
-    if (networkManager.isWiFiConnected() && !sensorsInitialized) {
-        Serial.println("Network connected - initializing I2C sensors...");
-        
-        // Now initialize the monitor system with all sensors
-        monitorSystem.begin();
-        debugPrintf("Monitor system initialized\n");
-        
-        // Initialize LCD display last
-        Serial.println("Initializing LCD display on channel 7...");
-        
-        // Use the multiplexer from monitor system to select LCD channel
-        Wire1.beginTransmission(0x70);  // TCA9548A multiplexer address
-        Wire1.write(1 << 7);  // Select channel 7 for LCD
-        byte muxError = Wire1.endTransmission();
-        
-        if (muxError == 0) {
-            Serial.println("LCD multiplexer channel 7 selected");
-            delay(100);  // Allow channel to stabilize
-            
-            if (lcdDisplay.begin()) {
-                Serial.println("LCD display initialized successfully");
-                debugPrintf("LCD display initialized\n");
-                delay(200);  // Give LCD time to fully initialize
-                
-                // Initial LCD update with default values
-                lcdDisplay.updateSystemStatus(SYS_MONITORING, 0, true, false, false);
-                lcdDisplay.updateSensorReadings(0.0, 0.0, 0.0);  // Will be updated by monitor system
-                lcdDisplay.updateAdditionalSensors(0.0, 0.0, 0.0);
-                Serial.println("LCD test write complete - initial display set");
-            } else {
-                Serial.println("WARNING: LCD display initialization failed - not present or not responding");
-                debugPrintf("LCD display not present\n");
-            }
-        } else {
-            Serial.print("ERROR: Failed to select LCD multiplexer channel, error code: ");
-            Serial.println(muxError);
-        }
-        
-        // Disable multiplexer channels after LCD init
-        Wire1.beginTransmission(0x70);
-        Wire1.write(0x00);  // Disable all channels
-        Wire1.endTransmission();
-        
-        sensorsInitialized = true;
+    // MQTT/WiFi servicing can block; drain Serial1 before the core FIFO fills
+    serialBridge.pollReceive();
+}
+
+static void taskMonitor(void*) {
+    // Sensors were started in setup(); announce the network once it is up
+    if (networkManager.isWiFiConnected() && !bootTimeline.isReached(BOOT_WIFI)) {
+        bootTimeline.reach(BOOT_WIFI);
         monitorSystem.setSystemState(SYS_MONITORING);
         
-        debugPrintf("All sensors initialized after network connection\n");
         Serial.print("Network connected! IP: ");
         Serial.println(WiFi.localIP());
     }
+    if (networkManager.isMQTTConnected()) {
+        bootTimeline.reach(BOOT_MQTT);
+    }
     
     // Start telnet server once network is connected
     if (networkManager.isWiFiConnected() && currentSystemState == SYS_CONNECTING) {
@@ -272,39 +298,93 @@ void loop() {
         debugPrintf("Telnet server started\n");
     }
     
-    // Update monitor system (only if sensors are initialized)
-    if (sensorsInitialized) {
-        monitorSystem.update();
+    uint32_t startCycles = PerfProfiler::now();
+    monitorSystem.update();
+    perfProfiler.record(perfMonitor, startCycles);
+    perfProfiler.publish(&networkManager);
+    if (!bootTimeline.isReached(BOOT_FIRST_SAMPLE) && monitorSystem.getSampleCount() > 0) {
+        bootTimeline.reach(BOOT_FIRST_SAMPLE);
     }
-    
+    monitorPassDone = true;
+}
+
+static void taskBridge(void*) {
     // Update serial bridge (always active)
+    uint32_t startCycles = PerfProfiler::now();
     serialBridge.update();
-    
+    perfProfiler.record(perfBridge, startCycles);
+}
+
+static void taskMatrix(void*) {
+    // Bridge traffic gauge on the LED matrix: no I2C, reloaded only on change
+    BridgeMetrics::Summary recent;
+    serialBridge.getMetricsSummary(MATRIX_RATE_WINDOW_S, recent);
+    heartbeatAnimation.setTraffic(recent.inRate, recent.publishRate, serialBridge.getBackPressure());
+    heartbeatAnimation.update();
+}
+
+static void taskStoreForward(void*) {
+    // Sliced flash writes and rate-limited replay of the outage log
+    storeForwardLog.service();
+}
+
+static void taskConfigLog(void*) {
+    // Sliced appends and background compaction of queued setting writes
+    configLog.service();
+}
+
+static void taskSyslog(void*) {
+    // Format queued log records and send them as syslog datagrams
+    Logger::service(LOGGER_DRAIN_BUDGET_US);
+}
+
+// Command response outputs - each chunk is written as soon as it is full
+static void emitTelnet(void* context, const char* data, size_t length, uint16_t, bool) {
+    telnetServer.write(*(uint8_t*)context, data, length, TELNET_REPLY_WAIT_MS);
+}
+
+static void emitSerial(void*, const char* data, size_t length, uint16_t, bool) {
+    Serial.write((const uint8_t*)data, length);
+}
+
+static void emitMqtt(void*, const char* data, size_t length, uint16_t part, bool final) {
+    networkManager.publishControlResponse(data, length, part, final);
+}
+
+static void taskConsole(void*) {
     // Update telnet server
     if (networkManager.isWiFiConnected()) {
+        uint32_t startCycles = PerfProfiler::now();
         telnetServer.update();
-        // Process telnet commands
-        if (telnetServer.isConnected()) {
-            String command = telnetServer.readLine();
-            if (command.length() > 0) {
-                char commandBuffer[COMMAND_BUFFER_SIZE];
-                command.toCharArray(commandBuffer, sizeof(commandBuffer));
-                
-                char response[SHARED_BUFFER_SIZE];
-                bool success = commandProcessor.processCommand(commandBuffer, false, response, sizeof(response));
-                
-                if (strlen(response) > 0) {
-                    telnetServer.print(response);
-                    telnetServer.print("\r\n");
-                }
-                
-                // Show prompt
-                telnetServer.print("\r\n> ");
-                
-                debugPrintf("Telnet: %s -> %s\n", 
-                    commandBuffer, strlen(response) > 0 ? response : "none");
+        
+        // Process telnet commands - lines from other sessions wait out the rate limit
+        char commandBuffer[COMMAND_BUFFER_SIZE];
+        uint8_t session;
+        if (!CommandValidator::isRateLimited() &&
+            telnetServer.readLine(commandBuffer, sizeof(commandBuffer), session)) {
+            ResponseSink response(emitTelnet, &session);
+            commandProcessor.processCommand(commandBuffer, false, response);
+            response.finish();
+            
+            if (!response.isEmpty()) {
+                telnetServer.print(session, "\r\n");
             }
+            
+            // Show prompt
+            telnetServer.print(session, "\r\n> ");
+            
+            debugPrintf("Telnet[%u]: %s -> %u bytes in %u part(s)\n", session,
+                commandBuffer, (unsigned)response.getTotalBytes(), response.getParts());
         }
+        perfProfiler.record(perfTelnet, startCycles);
+    }
+    
+    // Commands received on monitor/control, answered on monitor/control/resp
+    char controlBuffer[COMMAND_BUFFER_SIZE];
+    if (networkManager.takeControlCommand(controlBuffer, sizeof(controlBuffer))) {
+        ResponseSink response(emitMqtt, nullptr);
+        commandProcessor.processCommand(controlBuffer, true, response);
+        response.finish();
     }
     
     // Handle serial commands for local debugging
@@ -316,13 +396,11 @@ void loop() {
             char commandBuffer[COMMAND_BUFFER_SIZE];
             command.toCharArray(commandBuffer, sizeof(commandBuffer));
             
-            char response[SHARED_BUFFER_SIZE];
-            bool success = commandProcessor.processCommand(commandBuffer, false, response, sizeof(response));
-            
-            if (strlen(response) > 0) {
-                Serial.print("Response: ");
-                Serial.println(response);
-            }
+            Serial.print("Response: ");
+            ResponseSink response(emitSerial, nullptr);
+            commandProcessor.processCommand(commandBuffer, false, response);
+            response.finish();
+            Serial.println();
             
             Serial.print("> ");
         }
@@ -334,29 +412,43 @@ void loop() {
         monitorSystem.setSystemState(SYS_CONNECTING);
         debugPrintf("Network disconnected, reconnecting\n");
     }
+}
+
+static void taskHealth(void*) {
+    char healthStatus[256];
+    monitorSystem.getStatusString(healthStatus, sizeof(healthStatus));
+    debugPrintf("Health: %s\n", healthStatus);
     
-    // System health check
-    static unsigned long lastHealthCheck = 0;
-    if (now - lastHealthCheck >= 60000) { // Every minute
-        lastHealthCheck = now;
-        
-        char healthStatus[256];
-        monitorSystem.getStatusString(healthStatus, sizeof(healthStatus));
-        debugPrintf("Health: %s\n", healthStatus);
-        
-        // Check memory and system health
-        unsigned long freeMemory = monitorSystem.getFreeMemory();
-        if (freeMemory < 5000) { // Less than 5KB free
-            // Critical memory warning - always show
-            Serial.print("WARNING: Low memory: ");
-            Serial.print(freeMemory);
-            Serial.println(" bytes free");
-            debugPrintf("Low memory: %lu bytes free\n", freeMemory);
-        }
+    // Publish heap/stack instrumentation (monitor/memory/*)
+    memoryMonitor.publish(&networkManager);
+    
+    // Check memory and system health
+    unsigned long freeMemory = monitorSystem.getFreeMemory();
+    if (freeMemory < 5000) { // Less than 5KB free
+        // Critical memory warning - always show
+        Serial.print("WARNING: Low memory: ");
+        Serial.print(freeMemory);
+        Serial.println(" bytes free");
+        debugPrintf("Low memory: %lu bytes free\n", freeMemory);
     }
+}
+
+static void idleSerialDrain(void*) {
+    serialBridge.pollReceive();
+}
+
+void loop() {
+    // Update watchdog
+    lastWatchdog = millis();
+    bootTimeline.reach(BOOT_LOOP);
     
-    // Prevent watchdog timeout with a small delay
-    delay(10);
+    // All periodic work runs from the task table; nothing here blocks
+    uint32_t startCycles = PerfProfiler::now();
+    scheduler.run();
+    uint32_t passUs = perfProfiler.record(perfLoop, startCycles);
+    if (passUs / 1000 > MAIN_LOOP_TIMEOUT_MS) {
+        LOG_WARN("Loop pass took %lu ms (limit %lu ms)", (unsigned long)(passUs / 1000), MAIN_LOOP_TIMEOUT_MS);
+    }
 }
 
 // Handle system interrupts and errors
@@ -1,6 +1,5 @@
 #include "max6656_sensor.h"
-
-extern void debugPrintf(const char* fmt, ...);
+#include "logger.h"
 
 MAX6656Sensor::MAX6656Sensor(uint8_t address) :
     i2cAddress(address),
@@ -9,15 +8,10 @@ MAX6656Sensor::MAX6656Sensor(uint8_t address) :
     localTempOffset(0.0),
     remoteTempOffset(0.0),
     filteringEnabled(false),
-    filterSize(5),
-    bufferIndex(0),
-    validSamples(0)
+    filterSize(5)
 {
-    // Initialize filter buffers
-    for (int i = 0; i < 10; i++) {
-        localTempBuffer[i] = 0.0;
-        remoteTempBuffer[i] = 0.0;
-    }
+    localFilter.setWindow(filterSize);
+    remoteFilter.setWindow(filterSize);
 }
 
 bool MAX6656Sensor::begin() {
@@ -99,7 +93,7 @@ float MAX6656Sensor::getLocalTemperature() {
     temperature += localTempOffset;
     
     if (filteringEnabled) {
-        temperature = applyFiltering(localTempBuffer, temperature);
+        temperature = localFilter.update(temperature);
     }
     
     return temperature;
@@ -115,7 +109,7 @@ float MAX6656Sensor::getRemoteTemperature() {
     temperature += remoteTempOffset;
     
     if (filteringEnabled) {
-        temperature = applyFiltering(remoteTempBuffer, temperature);
+        temperature = remoteFilter.update(temperature);
     }
     
     return temperature;
@@ -285,18 +279,14 @@ void MAX6656Sensor::setTemperatureOffset(float localOffset, float remoteOffset)
 
 void MAX6656Sensor::enableFiltering(bool enabled, uint8_t size) {
     filteringEnabled = enabled;
-    if (size > 0 && size <= 10) {
+    if (size > 0 && size <= MAX6656_FILTER_MAX_SAMPLES) {
         filterSize = size;
     }
     
     if (enabled) {
-        // Reset filter buffers
-        bufferIndex = 0;
-        validSamples = 0;
-        for (int i = 0; i < 10; i++) {
-            localTempBuffer[i] = 0.0;
-            remoteTempBuffer[i] = 0.0;
-        }
+        // Restart both filters with the new window
+        localFilter.setWindow(filterSize);
+        remoteFilter.setWindow(filterSize);
     }
     
     debugPrintf("MAX6656: Temperature filtering %s (size: %d)", 
@@ -347,27 +337,3 @@ float MAX6656Sensor::convertTemperature(uint8_t tempReg, uint8_t extReg) {
     
     return temperature;
 }
-
-float MAX6656Sensor::applyFiltering(float* buffer, float newValue) {
-    updateBuffer(buffer, newValue);
-    return calculateAverage(buffer, min(validSamples, filterSize));
-}
-
-void MAX6656Sensor::updateBuffer(float* buffer, float newValue) {
-    buffer[bufferIndex] = newValue;
-    bufferIndex = (bufferIndex + 1) % filterSize;
-    if (validSamples < filterSize) {
-        validSamples++;
-    }
-}
-
-float MAX6656Sensor::calculateAverage(float* buffer, uint8_t samples) {
-    if (samples == 0) return 0.0;
-    
-    float sum = 0.0;
-    for (uint8_t i = 0; i < samples; i++) {
-        sum += buffer[i];
-    }
-    
-    return sum / samples;
-}
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "mcp3421_sensor.h"
 #include "logger.h"
-
-extern void debugPrintf(const char* fmt, ...);
+#include "task_scheduler.h"
 
 MCP3421_Sensor::MCP3421_Sensor(uint8_t address) :
     i2cAddress(address),
@@ -12,13 +11,16 @@ MCP3421_Sensor::MCP3421_Sensor(uint8_t address) :
     gain(MCP3421_GAIN_1X),
     conversionMode(MCP3421_CONTINUOUS),
     configRegister(0),
-    referenceVoltage(2.048) {  // Default 2.048V reference
+    referenceVoltage(2.048),   // Default 2.048V reference
+    referenceScale(1.0f) {
     
     lastReading.rawValue = 0;
-    lastReading.voltage = 0.0;
+    lastReading.nanovolts = 0;
     lastReading.config = 0;
     lastReading.valid = false;
     lastReading.timestamp = 0;
+    
+    voltageFilter.setWindow(MCP3421_FILTER_DEFAULT_SAMPLES);
 }
 
 bool MCP3421_Sensor::begin(TwoWire& wirePort) {
@@ -126,6 +128,7 @@ bool MCP3421_Sensor::setConversionMode(MCP3421_ConversionMode mode) {
 bool MCP3421_Sensor::setReferenceVoltage(float voltage) {
     if (voltage > 0.0) {
         referenceVoltage = voltage;
+        referenceScale = voltage / (MCP3421_INTERNAL_REF_MV / 1000.0f);
         return true;
     }
     return false;
@@ -170,32 +173,29 @@ int32_t MCP3421_Sensor::getRawValue() {
     return 0;
 }
 
+int32_t MCP3421_Sensor::getNanovolts() {
+    if (lastReading.valid) {
+        return lastReading.nanovolts;
+    }
+    return 0;
+}
+
 float MCP3421_Sensor::getVoltage() {
     if (lastReading.valid) {
-        return lastReading.voltage;
+        return nanovoltsToVolts(lastReading.nanovolts);
     }
     return 0.0;
 }
 
-float MCP3421_Sensor::getFilteredVoltage(uint8_t samples) {
-    if (!initialized || samples == 0) return getVoltage();
-    
-    float sum = 0.0;
-    uint8_t validSamples = 0;
-    
-    for (uint8_t i = 0; i < samples; i++) {
-        if (takeReading() && lastReading.valid) {
-            sum += lastReading.voltage;
-            validSamples++;
-        }
-        delay(10);  // Small delay between readings
-    }
-    
-    if (validSamples > 0) {
-        return sum / validSamples;
-    }
+float MCP3421_Sensor::getFilteredVoltage() {
+    if (voltageFilter.getCount() == 0) return getVoltage();
     
-    return getVoltage();  // Return last known good reading
+    // Averaged in nV, so the full 18-bit resolution is kept
+    return nanovoltsToVolts(voltageFilter.average());
+}
+
+bool MCP3421_Sensor::setFilterSamples(uint8_t samples) {
+    return voltageFilter.setWindow(samples);
 }
 
 bool MCP3421_Sensor::isConnected() {
@@ -229,7 +229,7 @@ void MCP3421_Sensor::getStatusString(char* buffer, size_t bufferSize) {
              gainValue,
              rateStr,
              referenceVoltage,
-             lastReading.voltage);
+             getVoltage());
 }
 
 void MCP3421_Sensor::printConfiguration() {
@@ -252,7 +252,7 @@ void MCP3421_Sensor::printReading() {
     
     debugPrintf("MCP3421 Reading:\n");
     debugPrintf("  Raw Value: %ld\n", lastReading.rawValue);
-    debugPrintf("  Voltage: %.6fV\n", lastReading.voltage);
+    debugPrintf("  Voltage: %ldnV\n", (long)lastReading.nanovolts);
     debugPrintf("  Config: 0x%02X\n", lastReading.config);
     debugPrintf("  Valid: %s\n", lastReading.valid ? "Yes" : "No");
     debugPrintf("  Timestamp: %lu ms\n", lastReading.timestamp);
@@ -319,11 +319,16 @@ bool MCP3421_Sensor::readData() {
     
     // Update last reading
     lastReading.rawValue = rawValue;
-    lastReading.voltage = convertToVoltage(rawValue);
+    lastReading.nanovolts = convertToNanovolts(rawValue);
     lastReading.config = config;
     lastReading.valid = true;
     lastReading.timestamp = millis();
     
+    // RDY clear = a conversion not read before; repeats of old data are skipped
+    if (!(config & MCP3421_RDY_BIT)) {
+        voltageFilter.update(lastReading.nanovolts);
+    }
+    
     if (debugEnabled) {
         printReading();
     }
@@ -341,27 +346,37 @@ uint8_t MCP3421_Sensor::calculateConfig() {
     return config;
 }
 
-float MCP3421_Sensor::convertToVoltage(int32_t rawValue) {
-    int bits = getResolutionBits();
-    int32_t maxValue = (1 << (bits - 1)) - 1;  // Maximum positive value
-    float gainValue = 1 << gain;                // Convert gain enum to multiplier
-    
-    // Calculate voltage: (raw / max) * (Vref / gain)
-    float voltage = ((float)rawValue / (float)maxValue) * (referenceVoltage / gainValue);
-    
-    return voltage;
+int32_t MCP3421_Sensor::convertToNanovolts(int32_t rawValue) const {
+    // Scale per rate/gain pair is a compile-time constant
+    switch (sampleRate) {
+        case MCP3421_12_BIT_240_SPS:  return convertForRate<MCP3421_12_BIT_240_SPS>(gain, rawValue);
+        case MCP3421_14_BIT_60_SPS:   return convertForRate<MCP3421_14_BIT_60_SPS>(gain, rawValue);
+        case MCP3421_16_BIT_15_SPS:   return convertForRate<MCP3421_16_BIT_15_SPS>(gain, rawValue);
+        case MCP3421_18_BIT_3_75_SPS: return convertForRate<MCP3421_18_BIT_3_75_SPS>(gain, rawValue);
+        default: return 0;
+    }
 }
 
 int MCP3421_Sensor::getResolutionBits() const {
     switch (sampleRate) {
-        case MCP3421_12_BIT_240_SPS: return 12;
-        case MCP3421_14_BIT_60_SPS:  return 14;
-        case MCP3421_16_BIT_15_SPS:  return 16;
-        case MCP3421_18_BIT_3_75_SPS: return 18;
+        case MCP3421_12_BIT_240_SPS: return MCP3421_RateTraits<MCP3421_12_BIT_240_SPS>::BITS;
+        case MCP3421_14_BIT_60_SPS:  return MCP3421_RateTraits<MCP3421_14_BIT_60_SPS>::BITS;
+        case MCP3421_16_BIT_15_SPS:  return MCP3421_RateTraits<MCP3421_16_BIT_15_SPS>::BITS;
+        case MCP3421_18_BIT_3_75_SPS: return MCP3421_RateTraits<MCP3421_18_BIT_3_75_SPS>::BITS;
         default: return 16;
     }
 }
 
+unsigned long MCP3421_Sensor::getConversionTimeMs() const {
+    switch (sampleRate) {
+        case MCP3421_12_BIT_240_SPS: return MCP3421_RateTraits<MCP3421_12_BIT_240_SPS>::CONVERSION_MS;
+        case MCP3421_14_BIT_60_SPS:  return MCP3421_RateTraits<MCP3421_14_BIT_60_SPS>::CONVERSION_MS;
+        case MCP3421_16_BIT_15_SPS:  return MCP3421_RateTraits<MCP3421_16_BIT_15_SPS>::CONVERSION_MS;
+        case MCP3421_18_BIT_3_75_SPS: return MCP3421_RateTraits<MCP3421_18_BIT_3_75_SPS>::CONVERSION_MS;
+        default: return 67;
+    }
+}
+
 float MCP3421_Sensor::getMaxVoltage() {
     float gainValue = 1 << gain;
     return referenceVoltage / gainValue;
@@ -1,25 +1,22 @@
 #include "mcp9600_sensor.h"
+#include "i2c_bus.h"
 #include "logger.h"
 
-extern void debugPrintf(const char* fmt, ...);
-
 MCP9600Sensor::MCP9600Sensor(uint8_t address) :
     i2cAddress(address),
     initialized(false),
-    ambientTempOffset(0.0),
-    thermocoupleTempOffset(0.0),
+    ambientOffset_mC(0),
+    thermocoupleOffset_mC(0),
     filteringEnabled(false),
     filterLevel(4),
     debugOutputEnabled(false),
-    filterSize(5),
-    bufferIndex(0),
-    validSamples(0)
+    thermocoupleSpike(MCP9600_SPIKE_THRESHOLD_MC, MCP9600_SPIKE_CONFIRM)
 {
-    // Initialize filter buffers
-    for (int i = 0; i < MAX_FILTER_SIZE; i++) {
-        ambientTempBuffer[i] = 0.0;
-        thermocoupleTempBuffer[i] = 0.0;
-    }
+    lastReading.thermocoupleC = -999.0f;
+    lastReading.ambientC = -999.0f;
+    lastReading.status = 0;
+    lastReading.valid = false;
+    lastReading.timestamp = 0;
 }
 
 bool MCP9600Sensor::begin() {
@@ -90,6 +87,34 @@ bool MCP9600Sensor::checkConnection() {
     return (thermocoupleReading != 0xFFFF);
 }
 
+bool MCP9600Sensor::takeReading() {
+    if (!initialized) {
+        lastReading.valid = false;
+        return false;
+    }
+    
+    static const uint8_t REGISTERS[] = { MCP9600_REG_HOT_JUNCTION, MCP9600_REG_COLD_JUNCTION, MCP9600_REG_STATUS };
+    static const uint8_t WIDTHS[] = { 2, 2, 1 };
+    uint8_t data[5];
+    
+    // One immediate retry: a NACK here is usually a single disturbed transfer
+    if (!I2CBus::readRegisters(Wire1, i2cAddress, REGISTERS, WIDTHS, 3, data) &&
+        !I2CBus::readRegisters(Wire1, i2cAddress, REGISTERS, WIDTHS, 3, data)) {
+        lastReading.valid = false;
+        if (debugOutputEnabled) {
+            debugPrintf("MCP9600: ERROR - Register read failed\n");
+        }
+        return false;
+    }
+    
+    lastReading.thermocoupleC = processThermocouple(I2CBus::get16(data));
+    lastReading.ambientC = processAmbient(I2CBus::get16(data + 2));
+    lastReading.status = data[4];
+    lastReading.valid = true;
+    lastReading.timestamp = millis();
+    return true;
+}
+
 float MCP9600Sensor::getThermocoupleTemperature() {
     if (!initialized) return -999.0;
     
@@ -101,10 +126,14 @@ float MCP9600Sensor::getThermocoupleTemperature() {
         }
         return -999.0; // Read error
     }
-    
+    return processThermocouple(rawTemp);
+}
+
+float MCP9600Sensor::processThermocouple(uint16_t rawTemp) {
     // Show conversion steps
     int16_t signedRaw = (int16_t)rawTemp;
-    float temperature = signedRaw * 0.0625 + thermocoupleTempOffset;
+    int32_t temp_mC = toMilliCelsius(rawTemp) + thermocoupleOffset_mC;
+    float temperature = temp_mC * 0.001f;
     
     if (debugOutputEnabled) {
         debugPrintf("MCP9600: Raw=0x%04X (%d) -> %.3fC\n", rawTemp, signedRaw, temperature);
@@ -116,7 +145,7 @@ float MCP9600Sensor::getThermocoupleTemperature() {
     static int consecutiveZeros = 0;
     
     // Check for thermocouple disconnection or sensor issues
-    if (temperature == 0.0) {
+    if (temp_mC == 0) {
         consecutiveZeros++;
         if (consecutiveZeros > 3) {
             LOG_WARN("MCP9600: Thermocouple reading stuck at 0C - possible disconnection");
@@ -128,21 +157,8 @@ float MCP9600Sensor::getThermocoupleTemperature() {
         consecutiveZeros = 0;
     }
     
-    if (!firstReading && debugOutputEnabled) {
-        float tempChange = temperature - lastTemp;
-        debugPrintf("MCP9600: Change: %.3fC (%.3f -> %.3f)\n", tempChange, lastTemp, temperature);
-        
-        // Flag suspicious large changes
-        if (abs(tempChange) > 50.0) {
-            debugPrintf("MCP9600: *** WARNING - Large jump detected! ***\n");
-            LOG_WARN("MCP9600: Large temperature jump: %.1fC", tempChange);
-        }
-    } else if (firstReading && debugOutputEnabled) {
-        debugPrintf("MCP9600: First thermocouple reading: %.1fC\n", temperature);
-    }
-    
     // Validate thermocouple reading is within Type K range (-200C to +1372C)
-    if (temperature < -250.0 || temperature > 1400.0) {
+    if (temp_mC < -250000 || temp_mC > 1400000) {
         LOG_WARN("MCP9600: Thermocouple reading out of Type K range: %.1fC", temperature);
         if (debugOutputEnabled) {
             debugPrintf("MCP9600: *** WARNING - Reading outside Type K range ***\n");
@@ -150,8 +166,20 @@ float MCP9600Sensor::getThermocoupleTemperature() {
         return -999.0;
     }
     
+    // Single-sample jumps are glitches; a jump that persists is a real change
+    if (!thermocoupleSpike.accept(temp_mC)) {
+        LOG_WARN("MCP9600: Large temperature jump rejected: %.1fC", temperature - lastTemp);
+        return lastTemp;
+    }
+    
+    if (!firstReading && debugOutputEnabled) {
+        debugPrintf("MCP9600: Change: %.3fC (%.3f -> %.3f)\n", temperature - lastTemp, lastTemp, temperature);
+    } else if (firstReading && debugOutputEnabled) {
+        debugPrintf("MCP9600: First thermocouple reading: %.1fC\n", temperature);
+    }
+    
     if (filteringEnabled) {
-        float filteredTemp = applyFilter(temperature, thermocoupleTempBuffer);
+        float filteredTemp = thermocoupleFilter.update(temp_mC) * 0.001f;
         if (debugOutputEnabled) {
             debugPrintf("MCP9600: Filtered: %.3fC (from raw: %.3fC)\n", filteredTemp, temperature);
         }
@@ -166,8 +194,10 @@ float MCP9600Sensor::getThermocoupleTemperature() {
 
 float MCP9600Sensor::getAmbientTemperature() {
     if (!initialized) return -999.0;
-    
-    uint16_t rawTemp = readRegister16(MCP9600_REG_COLD_JUNCTION);
+    return processAmbient(readRegister16(MCP9600_REG_COLD_JUNCTION));
+}
+
+float MCP9600Sensor::processAmbient(uint16_t rawTemp) {
     LOG_DEBUG("MCP9600: Raw ambient reading from 0x%02X = 0x%04X", MCP9600_REG_COLD_JUNCTION, rawTemp);
     
     if (rawTemp == 0xFFFF) {
@@ -179,7 +209,7 @@ float MCP9600Sensor::getAmbientTemperature() {
             // Use a more realistic room temperature based on typical industrial environments
             static float estimatedTemp = 25.0; // Start with 25C (77F)
             LOG_INFO("MCP9600: Cold junction unavailable, using estimated ambient: %.1fC", estimatedTemp);
-            return estimatedTemp + ambientTempOffset;
+            return estimatedTemp + ambientOffset_mC * 0.001f;
         } else {
             // Device is not responding at all
             LOG_WARN("MCP9600: Device not responding, ambient temperature unknown");
@@ -187,20 +217,20 @@ float MCP9600Sensor::getAmbientTemperature() {
         }
     }
     
-    float temperature = convertRawToTemperature(rawTemp) + ambientTempOffset;
-    LOG_DEBUG("MCP9600: Converted ambient temperature = %.2fC", temperature);
+    int32_t temp_mC = toMilliCelsius(rawTemp) + ambientOffset_mC;
+    LOG_DEBUG("MCP9600: Converted ambient temperature = %ldmC", (long)temp_mC);
     
     // Validate ambient temperature is reasonable (typically -40C to +125C for sensor)
-    if (temperature < -50.0 || temperature > 150.0) {
-        LOG_WARN("MCP9600: Ambient temperature out of range: %.1fC", temperature);
+    if (temp_mC < -50000 || temp_mC > 150000) {
+        LOG_WARN("MCP9600: Ambient temperature out of range: %.1fC", temp_mC * 0.001f);
         return -999.0;
     }
     
     if (filteringEnabled) {
-        temperature = applyFilter(temperature, ambientTempBuffer);
+        temp_mC = ambientFilter.update(temp_mC);
     }
     
-    return temperature;
+    return temp_mC * 0.001f;
 }
 
 float MCP9600Sensor::getLocalTemperature() {
@@ -265,8 +295,8 @@ uint16_t MCP9600Sensor::getDeviceID() {
 }
 
 void MCP9600Sensor::setTemperatureOffset(float ambientOffset, float thermocoupleOffset) {
-    ambientTempOffset = ambientOffset;
-    thermocoupleTempOffset = thermocoupleOffset;
+    ambientOffset_mC = (int32_t)lroundf(ambientOffset * 1000.0f);
+    thermocoupleOffset_mC = (int32_t)lroundf(thermocoupleOffset * 1000.0f);
     debugPrintf("MCP9600: Temperature offsets set - ambient: %.2f°C, thermocouple: %.2f°C", 
                 ambientOffset, thermocoupleOffset);
 }
@@ -279,9 +309,10 @@ void MCP9600Sensor::getStatusString(char* buffer, size_t bufferSize) {
         return;
     }
     
-    float ambientTemp = getAmbientTemperature();
-    float thermocoupleTemp = getThermocoupleTemperature();
-    uint8_t status = getStatus();
+    bool read = takeReading();
+    float ambientTemp = read ? lastReading.ambientC : -999.0f;
+    float thermocoupleTemp = read ? lastReading.thermocoupleC : -999.0f;
+    uint8_t status = read ? lastReading.status : 0xFF;
     uint16_t deviceID = getDeviceID();
     
     const char* statusStr = "OK";
@@ -301,17 +332,12 @@ void MCP9600Sensor::enableFiltering(bool enabled, uint8_t filterLevel) {
     
     if (enabled) {
         if (filterLevel < 1) filterLevel = 1;
-        if (filterLevel > MAX_FILTER_SIZE) filterLevel = MAX_FILTER_SIZE;
+        if (filterLevel > MCP9600_FILTER_MAX_SAMPLES) filterLevel = MCP9600_FILTER_MAX_SAMPLES;
         
-        filterSize = filterLevel;
-        bufferIndex = 0;
-        validSamples = 0;
-        
-        // Clear filter buffers
-        for (int i = 0; i < MAX_FILTER_SIZE; i++) {
-            ambientTempBuffer[i] = 0.0;
-            thermocoupleTempBuffer[i] = 0.0;
-        }
+        this->filterLevel = filterLevel;
+        ambientFilter.setWindow(filterLevel);
+        thermocoupleFilter.setWindow(filterLevel);
+        thermocoupleSpike.reset();
         
         if (debugOutputEnabled) {
             debugPrintf("MCP9600: Temperature filtering enabled (level %d)\n", filterLevel);
@@ -339,72 +365,34 @@ bool MCP9600Sensor::checkI2CDevice(uint8_t address) {
 }
 
 uint8_t MCP9600Sensor::readRegister8(uint8_t reg) {
-    Wire1.beginTransmission(i2cAddress);
-    Wire1.write(reg);
-    uint8_t error = Wire1.endTransmission();
-    
-    if (error != 0) {
-        // Only log errors for registers other than 0x02 (ambient temp has known issues)
-        if (reg != 0x02) {
-            LOG_ERROR("MCP9600: I2C transmission error %d when reading register 0x%02X", error, reg);
-        }
-        return 0xFF;
+    static const uint8_t WIDTH = 1;
+    uint8_t value;
+    if (I2CBus::readRegisters(Wire1, i2cAddress, &reg, &WIDTH, 1, &value)) {
+        return value;
     }
     
-    Wire1.requestFrom((uint8_t)i2cAddress, (uint8_t)1);
-    if (Wire1.available()) {
-        return Wire1.read();
+    // Only log errors for registers other than 0x02 (ambient temp has known issues)
+    if (reg != 0x02) {
+        LOG_ERROR("MCP9600: I2C error when reading register 0x%02X", reg);
     }
-    
-    debugPrintf("MCP9600: No data available when reading register 0x%02X\n", reg);
     return 0xFF;
 }
 
 uint16_t MCP9600Sensor::readRegister16(uint8_t reg) {
-    // Retry logic for better I2C reliability
+    // Retried back to back; a disturbed transfer does not need a pause
+    static const uint8_t WIDTH = 2;
+    uint8_t data[2];
     for (int retry = 0; retry < 3; retry++) {
-        Wire1.beginTransmission(i2cAddress);
-        Wire1.write(reg);
-        uint8_t error = Wire1.endTransmission();
-        
-        if (error != 0) {
-            if (retry == 2) { // Last retry
-                if (reg == 0x02) {
-                    LOG_DEBUG("MCP9600: Ambient temp register 0x%02X unavailable after retries", reg);
-                } else {
-                    LOG_ERROR("MCP9600: I2C transmission error %d when reading register 0x%02X after retries", error, reg);
-                }
-            }
-            delay(1); // Small delay before retry
-            continue;
+        if (I2CBus::readRegisters(Wire1, i2cAddress, &reg, &WIDTH, 1, data)) {
+            return I2CBus::get16(data);
         }
-        
-        Wire1.requestFrom((uint8_t)i2cAddress, (uint8_t)2);
-        if (Wire1.available() >= 2) {
-            uint8_t msb = Wire1.read();
-            uint8_t lsb = Wire1.read();
-            uint16_t result = (uint16_t)(msb << 8) | lsb;
-            
-            // Additional validation for thermocouple register
-            if (reg == MCP9600_REG_HOT_JUNCTION) {
-                int16_t signed_result = (int16_t)result;
-                float temp_c = signed_result * 0.0625;
-                // Validate thermocouple reading is within reasonable range
-                if (temp_c < -200.0 || temp_c > 1800.0) {
-                    LOG_DEBUG("MCP9600: Thermocouple reading out of range: %.1fC, retrying...", temp_c);
-                    if (retry < 2) continue; // Retry if not last attempt
-                }
-            }
-            
-            return result;
-        }
-        
-        if (retry == 2) {
-            debugPrintf("MCP9600: Insufficient data when reading 16-bit register 0x%02X after retries", reg);
-        }
-        delay(1); // Small delay before retry
     }
     
+    if (reg == 0x02) {
+        LOG_DEBUG("MCP9600: Ambient temp register 0x%02X unavailable after retries", reg);
+    } else {
+        LOG_ERROR("MCP9600: I2C error when reading register 0x%02X after retries", reg);
+    }
     return 0xFFFF;
 }
 
@@ -422,34 +410,7 @@ bool MCP9600Sensor::writeRegister8(uint8_t reg, uint8_t value) {
     return true;
 }
 
-float MCP9600Sensor::convertRawToTemperature(uint16_t raw) {
-    // MCP9600 temperature format: 16-bit signed, 0.0625C resolution
-    // Convert from raw ADC counts to temperature
-    int16_t signedRaw = (int16_t)raw;
-    return signedRaw * 0.0625;
-}
-
 float MCP9600Sensor::celsiusToFahrenheit(float celsius) {
     // Convert Celsius to Fahrenheit: F = (C × 9/5) + 32
     return (celsius * 9.0 / 5.0) + 32.0;
 }
-
-float MCP9600Sensor::applyFilter(float newValue, float* buffer) {
-    if (!filteringEnabled || filterSize <= 1) return newValue;
-    
-    // Add new value to circular buffer
-    buffer[bufferIndex] = newValue;
-    bufferIndex = (bufferIndex + 1) % filterSize;
-    
-    if (validSamples < filterSize) {
-        validSamples++;
-    }
-    
-    // Calculate moving average
-    float sum = 0.0;
-    for (int i = 0; i < validSamples; i++) {
-        sum += buffer[i];
-    }
-    
-    return sum / validSamples;
-}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "memory_monitor.h"
+#include "network_manager.h"
+#include "logger.h"
+#include "response_sink.h"
+#include <malloc.h>
+#include <string.h>
+
+// Region symbols from the FSP linker script; weak so a different script
+// just disables the figure instead of breaking the link
+extern "C" {
+    extern char __HeapBase __attribute__((weak));
+    extern char __HeapLimit __attribute__((weak));
+    extern char __StackLimit __attribute__((weak));
+    extern char __StackTop __attribute__((weak));
+    char* sbrk(int increment);
+
+    // newlib-nano free list (absent with full newlib)
+    struct MallocFreeChunk {
+        long size;
+        MallocFreeChunk* next;
+    };
+    extern MallocFreeChunk* __malloc_free_list __attribute__((weak));
+}
+
+uint32_t MemoryMonitor::allocCounts[MEMORY_SUBSYSTEM_COUNT];
+uint32_t MemoryMonitor::freeCounts[MEMORY_SUBSYSTEM_COUNT];
+uint32_t MemoryMonitor::liveBytes;
+uint32_t MemoryMonitor::peakLiveBytes;
+
+static inline uint8_t currentSubsystem() {
+    if (!g_scheduler) return MEMORY_SUBSYSTEM_OTHER;
+    int8_t task = g_scheduler->getCurrentTask();
+    return task < 0 ? MEMORY_SUBSYSTEM_OTHER : (uint8_t)(task + 1);
+}
+
+MemoryMonitor::MemoryMonitor()
+    : peakHeapUsed(0)
+    , stackPainted(false) {
+}
+
+void MemoryMonitor::begin() {
+    if (&__StackLimit == nullptr || &__StackTop == nullptr) {
+        debugPrintf("MemoryMonitor: Stack region symbols not available\n");
+        return;
+    }
+
+    // Paint from the stack limit up to just below the live frame
+    uint8_t marker;
+    uintptr_t paintEnd = (uintptr_t)&marker - MEMORY_STACK_PAINT_MARGIN;
+    uint32_t* word = (uint32_t*)(((uintptr_t)&__StackLimit + 3) & ~(uintptr_t)3);
+    while ((uintptr_t)(word + 1) <= paintEnd) {
+        *word++ = MEMORY_STACK_PAINT;
+    }
+    stackPainted = true;
+
+    debugPrintf("MemoryMonitor: Stack %lu bytes, heap %lu bytes\n",
+        (unsigned long)(&__StackTop - &__StackLimit),
+        (&__HeapBase && &__HeapLimit) ? (unsigned long)(&__HeapLimit - &__HeapBase) : 0UL);
+}
+
+uint32_t MemoryMonitor::scanStackPeak() const {
+    if (!stackPainted) return 0;
+
+    // The stack grows down, so untouched paint is at the low end
+    const uint32_t* word = (const uint32_t*)(((uintptr_t)&__StackLimit + 3) & ~(uintptr_t)3);
+    const uint32_t* top = (const uint32_t*)&__StackTop;
+    while (word < top && *word == MEMORY_STACK_PAINT) {
+        word++;
+    }
+    return (uint32_t)((const char*)top - (const char*)word);
+}
+
+void MemoryMonitor::sample(Snapshot& snapshot) {
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    struct mallinfo info = mallinfo();
+    snapshot.heapUsed = info.uordblks;
+
+    // Never-claimed space between the current break and the heap limit
+    uint32_t unclaimed = 0;
+    if (&__HeapBase && &__HeapLimit) {
+        char* brk = sbrk(0);
+        snapshot.heapSize = (uint32_t)(&__HeapLimit - &__HeapBase);
+        if (brk && brk < &__HeapLimit) {
+            unclaimed = (uint32_t)(&__HeapLimit - brk);
+        }
+    }
+    snapshot.heapFree = info.fordblks + unclaimed;
+
+    // Largest block: walk the nano free list when it is available; the chunk
+    // adjoining the break merges with the unclaimed region
+    uint32_t largestChunk = 0;
+    if (&__malloc_free_list) {
+        for (MallocFreeChunk* chunk = __malloc_free_list; chunk; chunk = chunk->next) {
+            uint32_t size = (uint32_t)chunk->size;
+            if ((char*)chunk + size == sbrk(0)) {
+                size += unclaimed;
+            }
+            if (size > largestChunk) largestChunk = size;
+        }
+    }
+    snapshot.largestFree = largestChunk > unclaimed ? largestChunk : unclaimed;
+    if (snapshot.largestFree > snapshot.heapFree) {
+        snapshot.largestFree = snapshot.heapFree;
+    }
+    snapshot.fragmentation = snapshot.heapFree > 0
+        ? (uint8_t)(100 - (uint64_t)snapshot.largestFree * 100 / snapshot.heapFree)
+        : 0;
+
+    if (snapshot.heapUsed > peakHeapUsed) {
+        peakHeapUsed = snapshot.heapUsed;
+    }
+    snapshot.heapPeak = peakLiveBytes > peakHeapUsed ? peakLiveBytes : peakHeapUsed;
+
+    if (stackPainted) {
+        snapshot.stackSize = (uint32_t)(&__StackTop - &__StackLimit);
+        snapshot.stackPeak = scanStackPeak();
+    }
+}
+
+uint32_t MemoryMonitor::getFreeMemory() {
+    Snapshot snapshot;
+    sample(snapshot);
+    return snapshot.heapFree;
+}
+
+void MemoryMonitor::publish(NetworkManager* network) {
+    if (!network || !network->isMQTTConnected()) return;
+
+    Snapshot snapshot;
+    sample(snapshot);
+
+    char value[16];
+    snprintf(value, sizeof(value), "%lu", (unsigned long)snapshot.heapUsed);
+    network->publish(TOPIC_MEMORY_HEAP_USED, value);
+    snprintf(value, sizeof(value), "%lu", (unsigned long)snapshot.heapPeak);
+    network->publish(TOPIC_MEMORY_HEAP_PEAK, value);
+    snprintf(value, sizeof(value), "%lu", (unsigned long)snapshot.heapFree);
+    network->publish(TOPIC_MEMORY_HEAP_FREE, value);
+    snprintf(value, sizeof(value), "%lu", (unsigned long)snapshot.largestFree);
+    network->publish(TOPIC_MEMORY_LARGEST_FREE, value);
+    snprintf(value, sizeof(value), "%u", snapshot.fragmentation);
+    network->publish(TOPIC_MEMORY_FRAGMENTATION, value);
+
+    if (snapshot.stackSize > 0) {
+        snprintf(value, sizeof(value), "%lu", (unsigned long)snapshot.stackPeak);
+        network->publish(TOPIC_MEMORY_STACK_PEAK, value);
+        snprintf(value, sizeof(value), "%lu", (unsigned long)snapshot.stackSize);
+        network->publish(TOPIC_MEMORY_STACK_SIZE, value);
+    }
+
+    if (isTrackingAllocations()) {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++) {
+            total += allocCounts[i];
+        }
+        snprintf(value, sizeof(value), "%lu", (unsigned long)total);
+        network->publish(TOPIC_MEMORY_ALLOCATIONS, value);
+    }
+}
+
+void MemoryMonitor::getStatistics(ResponseSink& out) {
+    Snapshot snapshot;
+    sample(snapshot);
+
+    out.printf(
+        "heap: used=%lu peak=%lu free=%lu largest=%lu frag=%u%% size=%lu\r\n"
+        "stack: peak=%lu/%lu bytes",
+        (unsigned long)snapshot.heapUsed, (unsigned long)snapshot.heapPeak,
+        (unsigned long)snapshot.heapFree, (unsigned long)snapshot.largestFree,
+        snapshot.fragmentation, (unsigned long)snapshot.heapSize,
+        (unsigned long)snapshot.stackPeak, (unsigned long)snapshot.stackSize);
+
+    if (!isTrackingAllocations()) {
+        out.print("\r\nallocations: not tracked (build without MEMORY_TRACK_ALLOCATIONS)");
+        return;
+    }
+
+    // Allocation/free counts by subsystem (scheduler task)
+    for (uint8_t i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++) {
+        if (allocCounts[i] == 0 && freeCounts[i] == 0) continue;
+
+        const char* name = "other";
+        if (i != MEMORY_SUBSYSTEM_OTHER) {
+            const TaskScheduler::Task* task = g_scheduler ? g_scheduler->getTask(i - 1) : nullptr;
+            name = task ? task->name : "?";
+        }
+        out.printf("\r\n%s: alloc=%lu free=%lu", name,
+            (unsigned long)allocCounts[i], (unsigned long)freeCounts[i]);
+    }
+}
+
+void MemoryMonitor::recordAllocation(size_t bytes) {
+    allocCounts[currentSubsystem()]++;
+    liveBytes += bytes;
+    if (liveBytes > peakLiveBytes) {
+        peakLiveBytes = liveBytes;
+    }
+}
+
+void MemoryMonitor::recordRelease(size_t bytes) {
+    freeCounts[currentSubsystem()]++;
+    liveBytes = bytes > liveBytes ? 0 : liveBytes - bytes;
+}
+
+bool MemoryMonitor::isTrackingAllocations() {
+#ifdef MEMORY_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef MEMORY_TRACK_ALLOCATIONS
+// Linked in place of the C library allocator via -Wl,--wrap=<name>
+extern "C" {
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t count, size_t size);
+    void* __real_realloc(void* ptr, size_t size);
+    void __real_free(void* ptr);
+
+    void* __wrap_malloc(size_t size) {
+        void* ptr = __real_malloc(size);
+        if (ptr) MemoryMonitor::recordAllocation(malloc_usable_size(ptr));
+        return ptr;
+    }
+
+    void* __wrap_calloc(size_t count, size_t size) {
+        void* ptr = __real_calloc(count, size);
+        if (ptr) MemoryMonitor::recordAllocation(malloc_usable_size(ptr));
+        return ptr;
+    }
+
+    void* __wrap_realloc(void* ptr, size_t size) {
+        size_t oldSize = ptr ? malloc_usable_size(ptr) : 0;
+        void* result = __real_realloc(ptr, size);
+        if (result || size == 0) {
+            // String growth shows up as a release of the old block plus a new one
+            if (ptr) MemoryMonitor::recordRelease(oldSize);
+            if (result) MemoryMonitor::recordAllocation(malloc_usable_size(result));
+        }
+        return result;
+    }
+
+    void __wrap_free(void* ptr) {
+        if (ptr) MemoryMonitor::recordRelease(malloc_usable_size(ptr));
+        __real_free(ptr);
+    }
+}
+#endif
@@ -1,10 +1,10 @@
 #include "monitor_config.h"
 #include "constants.h"
 #include "network_manager.h"
+#include "logger.h"
+#include "config_log.h"
 #include <string.h>
 
-extern void debugPrintf(const char* fmt, ...);
-
 // CRC32 lookup table for efficient calculation
 static const uint32_t crc32_table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
@@ -52,10 +52,10 @@ static const uint32_t crc32_table[256] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-uint32_t MonitorConfigManager::calculateCRC32(const MonitorConfig& data) {
+uint32_t MonitorConfigManager::calculateCRC32(const LegacyMonitorConfig& data) {
     uint32_t crc = 0xFFFFFFFF;
     const uint8_t* bytes = (const uint8_t*)&data;
-    size_t length = sizeof(MonitorConfig) - sizeof(uint32_t); // Exclude CRC field itself
+    size_t length = sizeof(LegacyMonitorConfig) - sizeof(uint32_t); // Exclude CRC field itself
     
     for (size_t i = 0; i < length; i++) {
         crc = crc32_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
@@ -64,14 +64,29 @@ uint32_t MonitorConfigManager::calculateCRC32(const MonitorConfig& data) {
     return crc ^ 0xFFFFFFFF;
 }
 
-bool MonitorConfigManager::validateCRC(const MonitorConfig& data) {
+bool MonitorConfigManager::validateCRC(const LegacyMonitorConfig& data) {
     uint32_t calculatedCRC = calculateCRC32(data);
     return calculatedCRC == data.crc32;
 }
 
-void MonitorConfigManager::updateCRC(MonitorConfig& data) {
-    data.crc32 = calculateCRC32(data);
-}
+
+// Names (for 'set deadband') and defaults, in DeadbandTopic order
+static const char* const DEADBAND_TOPIC_NAMES[DEADBAND_TOPIC_COUNT] = {
+    "temperature", "weight", "voltage", "current", "power", "adc", "system"
+};
+
+static const struct {
+    float threshold;
+    bool percent;
+} DEFAULT_DEADBANDS[DEADBAND_TOPIC_COUNT] = {
+    { 0.5f,   false },  // 0.5 F
+    { 1.0f,   true  },  // 1% of the load
+    { 0.05f,  false },  // 50 mV
+    { 5.0f,   true  },  // 5% of the current
+    { 5.0f,   true  },  // 5% of the power
+    { 0.001f, false },  // 1 mV
+    { 256.0f, false },  // 256 bytes of free RAM
+};
 
 void MonitorConfigManager::setDefaults() {
     debugPrintf("MonitorConfig: Setting default configuration\n");
@@ -79,9 +94,6 @@ void MonitorConfigManager::setDefaults() {
     // Clear the structure
     memset(&config, 0, sizeof(MonitorConfig));
     
-    // Set magic number
-    config.magic = MONITOR_CONFIG_MAGIC;
-    
     // Syslog Configuration (from arduino_secrets.h)
     strncpy(config.syslogServer, SYSLOG_SERVER, sizeof(config.syslogServer) - 1);
     config.syslogPort = SYSLOG_PORT;
@@ -114,8 +126,12 @@ void MonitorConfigManager::setDefaults() {
     config.heartbeatIntervalMs = 30000;  // 30 seconds
     config.enableWatchdog = true;
     
-    // Calculate and set CRC
-    updateCRC(config);
+    // Deadbands: small enough to follow real changes, with a 5 minute keepalive
+    for (uint8_t i = 0; i < DEADBAND_TOPIC_COUNT; i++) {
+        config.deadband[i].threshold = DEFAULT_DEADBANDS[i].threshold;
+        config.deadband[i].flags = DEFAULT_DEADBANDS[i].percent ? DEADBAND_PERCENT : 0;
+        config.deadband[i].maxSilenceS = DEADBAND_DEFAULT_SILENCE_S;
+    }
     
     configValid = true;
     configChanged = true;
@@ -124,18 +140,6 @@ void MonitorConfigManager::setDefaults() {
 }
 
 bool MonitorConfigManager::isValidConfig(const MonitorConfig& data) {
-    // Check magic number
-    if (data.magic != MONITOR_CONFIG_MAGIC) {
-        debugPrintf("MonitorConfig: Invalid magic number: 0x%08X\n", data.magic);
-        return false;
-    }
-    
-    // Validate CRC
-    if (!validateCRC(data)) {
-        debugPrintf("MonitorConfig: CRC validation failed\n");
-        return false;
-    }
-    
     // Check string fields are null-terminated
     if (strnlen(data.syslogServer, sizeof(data.syslogServer)) == sizeof(data.syslogServer)) {
         debugPrintf("MonitorConfig: Syslog server string not null-terminated\n");
@@ -165,92 +169,155 @@ bool MonitorConfigManager::isValidConfig(const MonitorConfig& data) {
         return false;
     }
     
-    debugPrintf("MonitorConfig: Configuration validation passed\n");
-    return true;
-}
-
-bool MonitorConfigManager::writeToEEPROM(const MonitorConfig& data) {
-    debugPrintf("MonitorConfig: Writing configuration to EEPROM at address %d\n", MONITOR_CONFIG_EEPROM_ADDR);
-    
-    const uint8_t* bytes = (const uint8_t*)&data;
-    for (size_t i = 0; i < sizeof(MonitorConfig); i++) {
-        EEPROM.write(MONITOR_CONFIG_EEPROM_ADDR + i, bytes[i]);
+    // Validate deadbands (all zero, from before they existed, is valid: off)
+    for (uint8_t i = 0; i < DEADBAND_TOPIC_COUNT; i++) {
+        const DeadbandSetting& deadband = data.deadband[i];
+        if (!(deadband.threshold >= 0.0f) || deadband.maxSilenceS > DEADBAND_MAX_SILENCE_S) {
+            debugPrintf("MonitorConfig: Invalid deadband for %s\n", DEADBAND_TOPIC_NAMES[i]);
+            return false;
+        }
     }
     
-    // Note: Arduino Uno R4 EEPROM automatically commits changes
-    // EEPROM.commit(); // Not needed on Arduino Uno R4
+    // A static profile needs an address
+    if (data.staticIpEnabled && data.staticIp.ip[0] == 0) {
+        debugPrintf("MonitorConfig: Static IP profile has no address\n");
+        return false;
+    }
     
-    debugPrintf("MonitorConfig: Configuration written to EEPROM successfully\n");
+    debugPrintf("MonitorConfig: Configuration validation passed\n");
     return true;
 }
 
-bool MonitorConfigManager::readFromEEPROM(MonitorConfig& data) {
-    debugPrintf("MonitorConfig: Reading configuration from EEPROM at address %d\n", MONITOR_CONFIG_EEPROM_ADDR);
-    
-    uint8_t* bytes = (uint8_t*)&data;
-    for (size_t i = 0; i < sizeof(MonitorConfig); i++) {
+void MonitorConfigManager::bindFields() {
+    // Key order is flash format - see ConfigKey
+#define BIND_FIELD(key, field, flags) g_configLog->bind(key, &config.field, sizeof(config.field), flags)
+    BIND_FIELD(CONFIG_KEY_SYSLOG_SERVER,           syslogServer,            CONFIG_LOG_STRING);
+    BIND_FIELD(CONFIG_KEY_SYSLOG_PORT,             syslogPort,              0);
+    BIND_FIELD(CONFIG_KEY_SYSLOG_HOSTNAME,         syslogHostname,          CONFIG_LOG_STRING);
+    BIND_FIELD(CONFIG_KEY_MQTT_BROKER,             mqttBroker,              CONFIG_LOG_STRING);
+    BIND_FIELD(CONFIG_KEY_MQTT_PORT,               mqttPort,                0);
+    BIND_FIELD(CONFIG_KEY_MQTT_USERNAME,           mqttUsername,            CONFIG_LOG_STRING);
+    BIND_FIELD(CONFIG_KEY_MQTT_PASSWORD,           mqttPassword,            CONFIG_LOG_STRING);
+    BIND_FIELD(CONFIG_KEY_LOG_LEVEL,               logLevel,                0);
+    BIND_FIELD(CONFIG_KEY_LOG_TO_SERIAL,           logToSerial,             0);
+    BIND_FIELD(CONFIG_KEY_LOG_TO_SYSLOG,           logToSyslog,             0);
+    BIND_FIELD(CONFIG_KEY_WIFI_CONNECT_TIMEOUT,    wifiConnectTimeoutMs,    0);
+    BIND_FIELD(CONFIG_KEY_MQTT_RECONNECT_INTERVAL, mqttReconnectIntervalMs, 0);
+    BIND_FIELD(CONFIG_KEY_NETWORK_STABILITY_TIME,  networkStabilityTimeMs,  0);
+    BIND_FIELD(CONFIG_KEY_MAX_CONNECT_RETRIES,     maxConnectRetries,       0);
+    BIND_FIELD(CONFIG_KEY_TEMPERATURE_OFFSET,      temperatureOffset,       0);
+    BIND_FIELD(CONFIG_KEY_SENSOR_FILTERING,        enableSensorFiltering,   0);
+    BIND_FIELD(CONFIG_KEY_SENSOR_READ_INTERVAL,    sensorReadIntervalMs,    0);
+    BIND_FIELD(CONFIG_KEY_HEARTBEAT_ENABLE,        enableHeartbeat,         0);
+    BIND_FIELD(CONFIG_KEY_HEARTBEAT_INTERVAL,      heartbeatIntervalMs,     0);
+    BIND_FIELD(CONFIG_KEY_WATCHDOG_ENABLE,         enableWatchdog,          0);
+    BIND_FIELD(CONFIG_KEY_DEADBANDS,               deadband,                0);
+    BIND_FIELD(CONFIG_KEY_RATE_POLICY,             ratePolicy,              0);
+    BIND_FIELD(CONFIG_KEY_WIFI_LEASE,              wifiLease,               0);
+    BIND_FIELD(CONFIG_KEY_STATIC_IP,               staticIp,                0);
+    BIND_FIELD(CONFIG_KEY_STATIC_IP_ENABLED,       staticIpEnabled,         0);
+    BIND_FIELD(CONFIG_KEY_TOPIC_NAMESPACE,         topicNamespace,          0);
+#undef BIND_FIELD
+}
+
+bool MonitorConfigManager::loadLegacy() {
+    // Fixed image written before the config log; only read until the log
+    // holds settings, bank 0 compaction overwrites it later
+    LegacyMonitorConfig image;
+    uint8_t* bytes = (uint8_t*)&image;
+    for (size_t i = 0; i < sizeof(LegacyMonitorConfig); i++) {
         bytes[i] = EEPROM.read(MONITOR_CONFIG_EEPROM_ADDR + i);
     }
     
-    debugPrintf("MonitorConfig: Configuration read from EEPROM\n");
+    if (image.magic != MONITOR_CONFIG_MAGIC || !validateCRC(image)) {
+        return false;
+    }
+    
+    // Settings added since keep their defaults
+    MonitorConfig migrated = config;
+    memcpy(migrated.syslogServer, image.syslogServer, sizeof(migrated.syslogServer));
+    migrated.syslogPort = image.syslogPort;
+    memcpy(migrated.syslogHostname, image.syslogHostname, sizeof(migrated.syslogHostname));
+    memcpy(migrated.mqttBroker, image.mqttBroker, sizeof(migrated.mqttBroker));
+    migrated.mqttPort = image.mqttPort;
+    memcpy(migrated.mqttUsername, image.mqttUsername, sizeof(migrated.mqttUsername));
+    memcpy(migrated.mqttPassword, image.mqttPassword, sizeof(migrated.mqttPassword));
+    migrated.logLevel = image.logLevel;
+    migrated.logToSerial = image.logToSerial;
+    migrated.logToSyslog = image.logToSyslog;
+    migrated.wifiConnectTimeoutMs = image.wifiConnectTimeoutMs;
+    migrated.mqttReconnectIntervalMs = image.mqttReconnectIntervalMs;
+    migrated.networkStabilityTimeMs = image.networkStabilityTimeMs;
+    migrated.maxConnectRetries = image.maxConnectRetries;
+    migrated.temperatureOffset = image.temperatureOffset;
+    migrated.enableSensorFiltering = image.enableSensorFiltering;
+    migrated.sensorReadIntervalMs = image.sensorReadIntervalMs;
+    migrated.enableHeartbeat = image.enableHeartbeat;
+    migrated.heartbeatIntervalMs = image.heartbeatIntervalMs;
+    migrated.enableWatchdog = image.enableWatchdog;
+    
+    if (!isValidConfig(migrated)) {
+        return false;
+    }
+    
+    config = migrated;
     return true;
 }
 
 bool MonitorConfigManager::begin() {
     debugPrintf("MonitorConfig: Initializing configuration manager\n");
     
-    // Note: Arduino Uno R4 EEPROM doesn't need begin() with parameter
-    // EEPROM.begin(512);  // Not needed on Arduino Uno R4
-    
-    // Try to load configuration from EEPROM
-    if (load()) {
-        LOG_INFO("MonitorConfig: Configuration loaded from EEPROM");
-        return true;
-    } else {
-        LOG_WARN("MonitorConfig: Failed to load configuration, using defaults");
+    // Defaults first: a setting without a record (new, or never saved) keeps its default
+    setDefaults();
+    if (!g_configLog) {
+        LOG_WARN("MonitorConfig: No config log, using defaults");
+        return false;
+    }
+    bindFields();
+    
+    uint8_t loaded = load();
+    if (loaded > 0) {
+        if (isValidConfig(config)) {
+            LOG_INFO("MonitorConfig: %u settings loaded from the config log", loaded);
+            return true;
+        }
+        LOG_WARN("MonitorConfig: Saved configuration invalid, using defaults");
         setDefaults();
-        return save();  // Save default configuration
+    } else if (loadLegacy()) {
+        LOG_INFO("MonitorConfig: Configuration migrated from the fixed EEPROM image");
+    } else {
+        LOG_WARN("MonitorConfig: No saved configuration, using defaults");
     }
+    return save();
 }
 
-bool MonitorConfigManager::load() {
-    MonitorConfig tempConfig;
-    
-    if (!readFromEEPROM(tempConfig)) {
-        debugPrintf("MonitorConfig: Failed to read from EEPROM\n");
-        return false;
+uint8_t MonitorConfigManager::load() {
+    uint8_t loaded = 0;
+    for (uint8_t key = MONITOR_CONFIG_FIRST_KEY; key <= MONITOR_CONFIG_LAST_KEY; key++) {
+        if (g_configLog->load(key)) loaded++;
     }
     
-    if (!isValidConfig(tempConfig)) {
-        debugPrintf("MonitorConfig: Invalid configuration in EEPROM\n");
-        return false;
-    }
-    
-    // Configuration is valid, copy it
-    memcpy(&config, &tempConfig, sizeof(MonitorConfig));
     configValid = true;
     configChanged = false;
-    
-    debugPrintf("MonitorConfig: Configuration loaded successfully\n");
-    return true;
+    return loaded;
 }
 
 bool MonitorConfigManager::save() {
-    if (!configValid) {
+    if (!configValid || !g_configLog) {
         debugPrintf("MonitorConfig: Cannot save invalid configuration\n");
         return false;
     }
     
-    // Update CRC before saving
-    updateCRC(config);
-    
-    if (!writeToEEPROM(config)) {
-        LOG_ERROR("MonitorConfig: Failed to write configuration to EEPROM");
-        return false;
+    // Only changed settings are queued; the config task writes them in slices
+    uint8_t queued = 0;
+    for (uint8_t key = MONITOR_CONFIG_FIRST_KEY; key <= MONITOR_CONFIG_LAST_KEY; key++) {
+        if (g_configLog->commit(key)) queued++;
     }
     
     configChanged = false;
-    LOG_INFO("MonitorConfig: Configuration saved to EEPROM");
+    if (queued > 0) {
+        LOG_INFO("MonitorConfig: %u setting(s) queued for saving", queued);
+    }
     return true;
 }
 
@@ -340,6 +407,48 @@ bool MonitorConfigManager::setLogLevel(uint8_t level) {
     return true;
 }
 
+bool MonitorConfigManager::setDeadband(DeadbandTopic topic, float threshold, bool percent, uint16_t maxSilenceS) {
+    if (topic >= DEADBAND_TOPIC_COUNT || !(threshold >= 0.0f) || maxSilenceS > DEADBAND_MAX_SILENCE_S) {
+        return false;
+    }
+    
+    DeadbandSetting& deadband = config.deadband[topic];
+    deadband.threshold = threshold;
+    deadband.flags = percent ? DEADBAND_PERCENT : 0;
+    deadband.maxSilenceS = maxSilenceS;
+    markAsChanged();
+    return true;
+}
+
+void MonitorConfigManager::setRatePolicy(uint8_t minHz, uint8_t maxHz, uint8_t burst) {
+    config.ratePolicy.minHz = minHz;
+    config.ratePolicy.maxHz = maxHz;
+    config.ratePolicy.burst = burst;
+    markAsChanged();
+}
+
+void MonitorConfigManager::setStaticIp(const IpSettings* settings) {
+    config.staticIpEnabled = settings != nullptr;
+    if (settings) {
+        config.staticIp = *settings;
+    } else {
+        memset(&config.staticIp, 0, sizeof(config.staticIp));
+    }
+    markAsChanged();
+}
+
+const char* MonitorConfigManager::getDeadbandTopicName(uint8_t topic) {
+    return topic < DEADBAND_TOPIC_COUNT ? DEADBAND_TOPIC_NAMES[topic] : "?";
+}
+
+int8_t MonitorConfigManager::findDeadbandTopic(const char* name) {
+    if (!name) return -1;
+    for (uint8_t i = 0; i < DEADBAND_TOPIC_COUNT; i++) {
+        if (strcasecmp(DEADBAND_TOPIC_NAMES[i], name) == 0) return (int8_t)i;
+    }
+    return -1;
+}
+
 bool MonitorConfigManager::factoryReset() {
     debugPrintf("MonitorConfig: Performing factory reset\n");
     
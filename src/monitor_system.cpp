@@ -3,14 +3,28 @@
 #include "lcd_display.h"
 #include "serial_bridge.h"
 #include "logger.h"
+#include "task_scheduler.h"
+#include "store_forward_log.h"
+#include "memory_monitor.h"
+#include "response_sink.h"
 #include <Arduino.h>
 #include <WiFiS3.h>
+#include <pb_encode.h>
+#include "monitor_telemetry.pb.h"
 
-extern void debugPrintf(const char* fmt, ...);
 extern NetworkManager* g_networkManager;
 extern LCDDisplay* g_lcdDisplay;
 extern SerialBridge* g_serialBridge;
 extern MCP9600Sensor* g_mcp9600Sensor;
+extern MonitorConfigManager* g_monitorConfig;
+
+// Encoded MonitorSnapshot (every field is fixed size, so nanopb knows the bound)
+static uint8_t snapshotBuffer[monitor_MonitorSnapshot_size];
+
+// Encoded MonitorStats (channels bounded by monitor_telemetry.options)
+static uint8_t statsBuffer[monitor_MonitorStats_size];
+static_assert(sizeof(((monitor_MonitorStats*)0)->channels) / sizeof(monitor_ChannelStats) >= AGG_MAX_CHANNELS,
+              "monitor_telemetry.options channels max_count must cover AGG_MAX_CHANNELS");
 
 MonitorSystem::MonitorSystem() :
     currentState(SYS_INITIALIZING),
@@ -20,10 +34,13 @@ MonitorSystem::MonitorSystem() :
     humidity(0.0),
     lastSensorRead(0),
     lastTemperatureRead(0),
+    lastSensorAvailable(false),
     currentWeight(0.0),
     currentRawWeight(0),
     fuelGallons(0.0),
     lastWeightRead(0),
+    lastWeightSampleMs(0),
+    weightSensorConnected(true),
     currentVoltage(0.0),
     currentCurrent(0.0),
     currentPower(0.0),
@@ -37,22 +54,51 @@ MonitorSystem::MonitorSystem() :
     heartbeatInterval(HEARTBEAT_INTERVAL_MS),
     lastStatusPublish(0),
     lastHeartbeat(0),
-    lastSensorAvailable(false),
+    lastDigestPublish(0),
+    telemetryFormat(TELEMETRY_PROTOBUF),
+    lastSnapshotPublish(0),
+    snapshotSequence(0),
+    statsSequence(0),
+    deadbandSuppressed(0),
+    i2cMux(*g_i2cMux),
+    i2cScheduler(i2cMux, MUX_SETTLE_MS),
     lastHealthCheck(0),
+    lastBusRecovery(0),
     temperatureSensorFailures(0),
     weightSensorFailures(0),
     powerSensorFailures(0),
     adcSensorFailures(0),
     i2cBusError(false),
-    i2cMux(0x70) {  // TCA9548A at address 0x70
+    muxPresent(false),
+    devicesPresent(0) {
     
     // Initialize digital I/O states
     for (int i = 0; i < 8; i++) {
         digitalInputStates[i] = false;
         digitalOutputStates[i] = false;
     }
+    
+    resetDeadbands();
 }
 
+// Everything the board is wired for; begin() pings these instead of scanning
+// all 126 addresses, and only initializes the devices that answered
+struct KnownDeviceInfo {
+    const char* name;
+    uint8_t channel;
+    uint8_t address;
+    uint32_t clockHz;                   // Fastest bus clock the device accepts
+};
+
+// The PCF8574 LCD backpack is the only standard-mode (100 kHz) part
+static const KnownDeviceInfo KNOWN_DEVICES[MonitorSystem::DEVICE_COUNT] = {
+    { "temp",   0, MCP9600_ADDRESS_DEFAULT, I2C_CLOCK_FAST },
+    { "weight", 1, NAU7802_I2C_ADDRESS,     I2C_CLOCK_FAST },
+    { "power",  2, INA219_ADDRESS_DEFAULT,  I2C_CLOCK_FAST },
+    { "adc",    3, MCP3421_DEFAULT_ADDRESS, I2C_CLOCK_FAST },
+    { "lcd",    7, 0x27,                    I2C_CLOCK_STANDARD }
+};
+
 void MonitorSystem::begin() {
     systemStartTime = millis();
     initializePins();
@@ -62,7 +108,8 @@ void MonitorSystem::begin() {
     
     // Initialize I2C multiplexer first
     debugPrintf("MonitorSystem: Initializing TCA9548A I2C multiplexer...\n");
-    if (i2cMux.begin()) {
+    muxPresent = i2cMux.begin();
+    if (muxPresent) {
         LOG_INFO("MonitorSystem: TCA9548A multiplexer initialized successfully");
         debugPrintf("MonitorSystem: I2C multiplexer ready\n");
     } else {
@@ -70,10 +117,14 @@ void MonitorSystem::begin() {
         debugPrintf("MonitorSystem: I2C multiplexer NOT found - sensors may not work!\n");
     }
     
+    probeDevices();
+    
     // Initialize MCP9600 temperature sensor
     debugPrintf("MonitorSystem: Initializing MCP9600 temperature sensor on channel %d...\n", MCP9600_CHANNEL);
-    i2cMux.selectChannel(MCP9600_CHANNEL);
-    if (temperatureSensor.begin()) {
+    i2cMux.selectChannel(MCP9600_CHANNEL, MUX_SETTLE_MS);
+    if (!isDevicePresent(DEVICE_TEMPERATURE)) {
+        LOG_WARN("MonitorSystem: MCP9600 temperature sensor not found, skipped");
+    } else if (temperatureSensor.begin()) {
         LOG_INFO("MonitorSystem: MCP9600 temperature sensor initialized successfully");
         
         // Enable temperature filtering to smooth readings
@@ -91,12 +142,18 @@ void MonitorSystem::begin() {
     
     // Initialize NAU7802 weight sensor
     debugPrintf("MonitorSystem: Initializing NAU7802 weight sensor on channel %d...\n", NAU7802_CHANNEL);
-    i2cMux.selectChannel(NAU7802_CHANNEL);
-    NAU7802Status status = weightSensor.begin();
+    i2cMux.selectChannel(NAU7802_CHANNEL, MUX_SETTLE_MS);
+    NAU7802Status status = isDevicePresent(DEVICE_WEIGHT) ? weightSensor.begin() : NAU7802_NOT_FOUND;
     if (status == NAU7802_OK) {
         debugPrintf("MonitorSystem: NAU7802 weight sensor initialized successfully\n");
-        // Enable filtering for stable readings
+        // Continuous acquisition, decimated, then filtered for stable readings
+        if (!weightSensor.setAcquisition(NAU7802_DEFAULT_SAMPLE_RATE, NAU7802_DEFAULT_DECIMATION)) {
+            LOG_WARN("MonitorSystem: NAU7802 acquisition setup failed, keeping %u SPS",
+                NAU7802Sensor::sampleRateSps(weightSensor.getSampleRate()));
+        }
         weightSensor.enableFiltering(true, 10);
+    } else if (!isDevicePresent(DEVICE_WEIGHT)) {
+        LOG_WARN("MonitorSystem: NAU7802 weight sensor not found, skipped");
     } else {
         LOG_ERROR("MonitorSystem: NAU7802 weight sensor initialization failed: %s", 
             weightSensor.getStatusString());
@@ -106,8 +163,8 @@ void MonitorSystem::begin() {
     
     // Initialize INA219 power sensor
     debugPrintf("MonitorSystem: Initializing INA219 power sensor on channel %d...\n", INA219_CHANNEL);
-    i2cMux.selectChannel(INA219_CHANNEL);
-    if (powerSensor.begin()) {
+    i2cMux.selectChannel(INA219_CHANNEL, MUX_SETTLE_MS);
+    if (isDevicePresent(DEVICE_POWER) && powerSensor.begin()) {
         LOG_INFO("MonitorSystem: INA219 power sensor initialized successfully");
         powerSensorAvailable = true;
         debugPrintf("MonitorSystem: INA219 power sensor ready\n");
@@ -118,10 +175,12 @@ void MonitorSystem::begin() {
     
     // Initialize MCP3421 ADC sensor
     debugPrintf("MonitorSystem: Initializing MCP3421 ADC sensor on channel %d...\n", MCP3421_CHANNEL);
-    i2cMux.selectChannel(MCP3421_CHANNEL);
-    if (adcSensor.begin()) {
+    i2cMux.selectChannel(MCP3421_CHANNEL, MUX_SETTLE_MS);
+    if (isDevicePresent(DEVICE_ADC) && adcSensor.begin()) {
         LOG_INFO("MonitorSystem: MCP3421 ADC sensor initialized successfully");
         adcSensorAvailable = true;
+        // One-shot conversions are started and collected by the I2C scheduler
+        adcSensor.setConversionMode(MCP3421_ONE_SHOT);
         debugPrintf("MonitorSystem: MCP3421 ADC sensor ready\n");
     } else {
         LOG_WARN("MonitorSystem: MCP3421 ADC sensor initialization failed or not present");
@@ -131,10 +190,127 @@ void MonitorSystem::begin() {
     // Disable all multiplexer channels when done with initialization
     i2cMux.disableAllChannels();
     
+    registerI2CDevices();
+    registerAggregateChannels();
+    
     setSystemState(SYS_CONNECTING);
     debugPrintf("MonitorSystem: All sensors initialized\n");
 }
 
+void MonitorSystem::probeDevices() {
+    static_assert(MCP9600_CHANNEL == 0 && NAU7802_CHANNEL == 1 && INA219_CHANNEL == 2 &&
+                  MCP3421_CHANNEL == 3 && LCD_CHANNEL == 7, "KNOWN_DEVICES channels out of date");
+    
+    // One address ping per device; without a mux everything sits on the main bus
+    devicesPresent = 0;
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        if (muxPresent) i2cMux.selectChannel(KNOWN_DEVICES[i].channel, MUX_SETTLE_MS);
+        Wire1.beginTransmission(KNOWN_DEVICES[i].address);
+        if (Wire1.endTransmission() == 0) devicesPresent |= 1 << i;
+    }
+    
+    LOG_INFO("MonitorSystem: device probe found 0x%02X of 0x%02X", devicesPresent, (1 << DEVICE_COUNT) - 1);
+    
+    // Probed at standard mode; from here on each channel runs at its device's
+    // clock. Without a mux every device shares one segment, which stays at 100 kHz
+    if (muxPresent) {
+        for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+            i2cMux.setChannelClock(KNOWN_DEVICES[i].channel, KNOWN_DEVICES[i].clockHz);
+        }
+    }
+}
+
+void MonitorSystem::getDeviceMap(ResponseSink& out) const {
+    out.printf("I2C device map (probed at boot, mux 0x70 %s):", muxPresent ? "present" : "not found");
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        out.printf("\r\n%-7s ch%u 0x%02X %3lukHz %s", KNOWN_DEVICES[i].name,
+            muxPresent ? KNOWN_DEVICES[i].channel : 0, KNOWN_DEVICES[i].address,
+            (unsigned long)((muxPresent ? KNOWN_DEVICES[i].clockHz : I2C_CLOCK_STANDARD) / 1000),
+            isDevicePresent((KnownDevice)i) ? "present" : "not found");
+    }
+}
+
+uint32_t MonitorSystem::getSampleCount() const {
+    uint32_t samples = 0;
+    for (uint8_t i = 0; i < i2cScheduler.getDeviceCount(); i++) {
+        samples += i2cScheduler.getDevice(i)->samples;
+    }
+    return samples;
+}
+
+void MonitorSystem::registerAggregateChannels() {
+    static_assert((int)AGG_ADC_VOLTAGE == (int)monitor_StatsChannel_CHANNEL_ADC_VOLTAGE,
+                  "AggregateChannel must follow monitor.StatsChannel");
+    
+    // Registration order is the channel id
+    aggregator.addChannel("temperature/local");
+    aggregator.addChannel("temperature/remote");
+    aggregator.addChannel("weight");
+    aggregator.addChannel("power/voltage");
+    aggregator.addChannel("power/current");
+    aggregator.addChannel("power/watts");
+    aggregator.addChannel("adc/voltage");
+    
+    aggregator.setWindowCallback([](void* context, uint8_t window, unsigned long windowMs) {
+        static_cast<MonitorSystem*>(context)->publishWindow(window, windowMs);
+    }, this);
+}
+
+void MonitorSystem::registerI2CDevices() {
+    // Sensor addresses (0x67, 0x2A, 0x40, 0x68) never collide, so their
+    // channels can stay enabled together; only the LCD needs a switch
+    i2cScheduler.setChannelGroup((1 << MCP9600_CHANNEL) | (1 << NAU7802_CHANNEL) |
+                                 (1 << INA219_CHANNEL) | (1 << MCP3421_CHANNEL));
+    
+    // MCP9600 and NAU7802 convert continuously and are simply collected;
+    // the INA219 (triggered) and MCP3421 (one-shot) are started, then
+    // collected once their conversion time has passed
+    i2cScheduler.addDevice("temp", MCP9600_CHANNEL, TEMPERATURE_READ_INTERVAL_MS, 0, nullptr,
+        [](void* context) {
+            static_cast<MonitorSystem*>(context)->readSensors();
+            return I2CScheduler::RESULT_OK;
+        }, this);
+    
+    // Polled at the conversion rate so every conversion reaches the decimator
+    i2cScheduler.addDevice("weight", NAU7802_CHANNEL, weightSensor.getConversionIntervalMs(),
+        weightSensor.getConversionIntervalMs(),
+        nullptr,
+        [](void* context) { return static_cast<MonitorSystem*>(context)->readWeightSensor(); }, this);
+    
+    i2cScheduler.addDevice("power", INA219_CHANNEL, POWER_READ_INTERVAL_MS, INA219_CONVERSION_MS,
+        [](void* context) {
+            MonitorSystem* self = static_cast<MonitorSystem*>(context);
+            return self->powerSensorAvailable && self->powerSensor.triggerConversion();
+        },
+        [](void* context) { return static_cast<MonitorSystem*>(context)->readPowerSensor(); }, this);
+    
+    i2cScheduler.addDevice("adc", MCP3421_CHANNEL, ADC_READ_INTERVAL_MS, adcSensor.getConversionTimeMs(),
+        [](void* context) {
+            MonitorSystem* self = static_cast<MonitorSystem*>(context);
+            return self->adcSensorAvailable && self->adcSensor.startConversion();
+        },
+        [](void* context) { return static_cast<MonitorSystem*>(context)->readAdcSensor(); }, this);
+    
+    // Compose the frame once per period, then send the changed cells one
+    // Wire1 chunk per visit so the other devices keep their slots
+    i2cScheduler.addDevice("lcd", LCD_CHANNEL, LCD_UPDATE_INTERVAL_MS, 0, nullptr,
+        [](void* context) {
+            if (!g_lcdDisplay || !g_lcdDisplay->isAvailable()) return I2CScheduler::RESULT_FAILED;
+            if (!g_lcdDisplay->isRefreshing()) {
+                static_cast<MonitorSystem*>(context)->updateLCDDisplay();
+            }
+            switch (g_lcdDisplay->refresh()) {
+                case LCDDisplay::REFRESH_PENDING: return I2CScheduler::RESULT_PENDING;
+                case LCDDisplay::REFRESH_FAILED:  return I2CScheduler::RESULT_FAILED;
+                default:                          return I2CScheduler::RESULT_OK;
+            }
+        }, this);
+}
+
+I2CScheduler* MonitorSystem::getI2CScheduler() {
+    return &i2cScheduler;
+}
+
 void MonitorSystem::initializePins() {
     // Configure status LED
     pinMode(STATUS_LED_PIN, OUTPUT);
@@ -150,12 +326,12 @@ void MonitorSystem::initializePins() {
     digitalWrite(DIGITAL_OUTPUT_1, LOW);
     digitalWrite(DIGITAL_OUTPUT_2, LOW);
     
-    // Configure additional watch pins as inputs
-    for (size_t i = 0; i < WATCH_PIN_COUNT; i++) {
-        if (WATCH_PINS[i] != DIGITAL_OUTPUT_1 && WATCH_PINS[i] != DIGITAL_OUTPUT_2) {
-            pinMode(WATCH_PINS[i], INPUT_PULLUP);
-        }
-    }
+    // Watch pins: pin-change interrupts where the pin has an IRQ line
+    static const uint8_t OUTPUT_PINS[] = { DIGITAL_OUTPUT_1, DIGITAL_OUTPUT_2 };
+    inputMonitor.setChangeCallback([](void* context, const DigitalInputMonitor::Change& change) {
+        static_cast<MonitorSystem*>(context)->onInputChange(change);
+    }, this);
+    inputMonitor.begin(WATCH_PINS, WATCH_PIN_COUNT, OUTPUT_PINS, sizeof(OUTPUT_PINS));
     
     debugPrintf("MonitorSystem: Pins initialized\n");
 }
@@ -163,58 +339,35 @@ void MonitorSystem::initializePins() {
 void MonitorSystem::update() {
     unsigned long now = millis();
     
+    // Debounced watch pin changes, milliseconds after the edge
+    readDigitalInputs();
+    
     // Perform periodic I2C health check (every 5 minutes)
     checkI2CHealth();
     
-    // Round-robin I2C sensor reading: read one sensor every 10 seconds
-    // LCD updates every 5 seconds (more frequent for better responsiveness)
-    const unsigned long SENSOR_READ_INTERVAL = 10000;  // 10 seconds between sensor reads
-    const unsigned long LCD_UPDATE_INTERVAL = 5000;    // LCD updates every 5 seconds
-    static uint8_t currentSensor = 0;  // 0=temp, 1=weight, 2=power, 3=adc
-    static unsigned long lastSensorReadTime = 0;
-    static unsigned long lastLCDUpdateTime = 0;
-    static bool firstRun = true;
-    
-    // On first run, read first sensor immediately
-    if (firstRun || (now - lastSensorReadTime >= SENSOR_READ_INTERVAL)) {
-        firstRun = false;
-        
-        // Read the current sensor and publish its data
-        switch (currentSensor) {
-            case 0:
-                LOG_INFO("Polling temperature sensor (10s rotation)");
-                readSensors();  // Reads temperature sensor
-                break;
-            case 1:
-                LOG_INFO("Polling weight sensor (10s rotation)");
-                readWeightSensor();
-                break;
-            case 2:
-                LOG_INFO("Polling power sensor (10s rotation)");
-                readPowerSensor();
-                break;
-            case 3:
-                LOG_INFO("Polling ADC sensor (10s rotation)");
-                readAdcSensor();
-                break;
-        }
-        
-        // Move to next sensor in rotation
-        currentSensor = (currentSensor + 1) % 4;
-        lastSensorReadTime = now;
-    }
+    // Start/collect conversions on every I2C device at its own sample period.
+    // A channel switch resumes after MUX_SETTLE_MS instead of busy waiting,
+    // so the bridge and MQTT keep running meanwhile.
+    i2cScheduler.service();
     
-    // Update LCD every 5 seconds (independent of sensor reads)
-    if (now - lastLCDUpdateTime >= LCD_UPDATE_INTERVAL) {
-        LOG_INFO("Updating LCD display");
-        updateLCDDisplay();
-        lastLCDUpdateTime = now;
-    }
+    // Drain controller bytes that arrived during the I2C transactions
+    if (g_serialBridge) g_serialBridge->pollReceive();
     
     // Publish status periodically
     if (now - lastStatusPublish >= publishInterval) {
         publishStatus();
         lastStatusPublish = now;
+        if (g_serialBridge) g_serialBridge->pollReceive();
+    }
+    
+    // Window summaries of every sample taken since the last close
+    aggregator.service(now);
+    
+    // One binary snapshot replaces the per-sensor text topics
+    if ((telemetryFormat & TELEMETRY_PROTOBUF) &&
+        now - lastSnapshotPublish >= SNAPSHOT_PUBLISH_INTERVAL_MS) {
+        publishSnapshot();
+        lastSnapshotPublish = now;
     }
     
     // Publish heartbeat periodically
@@ -223,6 +376,12 @@ void MonitorSystem::update() {
         lastHeartbeat = now;
     }
     
+    // One retained summary per device for fleet dashboards
+    if (now - lastDigestPublish >= DIGEST_PUBLISH_INTERVAL_MS) {
+        publishDigest();
+        lastDigestPublish = now;
+    }
+    
     // Update status LED based on system state
     switch (currentState) {
         case SYS_INITIALIZING:
@@ -251,7 +410,6 @@ void MonitorSystem::update() {
 void MonitorSystem::readSensors() {
     readAnalogSensors();
     readTemperatureSensor();
-    readDigitalInputs();
 }
 
 void MonitorSystem::readAnalogSensors() {
@@ -264,11 +422,9 @@ void MonitorSystem::readAnalogSensors() {
 void MonitorSystem::readTemperatureSensor() {
     unsigned long now = millis();
     if (now - lastTemperatureRead >= 1000) { // Read every second
-        // Select MCP9600 multiplexer channel
-        i2cMux.selectChannel(MCP9600_CHANNEL);
-        delay(10); // Allow multiplexer channel to stabilize
-        
-        bool currentAvailable = temperatureSensor.isAvailable();
+        // MCP9600 channel already selected and settled by the I2C scheduler;
+        // both junctions come from one transaction, which also proves presence
+        bool currentAvailable = temperatureSensor.takeReading();
         
         // Check for sensor availability state changes
         if (lastSensorAvailable != currentAvailable) {
@@ -296,8 +452,9 @@ void MonitorSystem::readTemperatureSensor() {
                 debugPrintf("\n--- Temperature Reading Cycle ---\n");
             }
             
-            float newLocalTemp = temperatureSensor.getLocalTemperature();
-            float newRemoteTemp = temperatureSensor.getRemoteTemperature();
+            const MCP9600Reading& reading = temperatureSensor.getLastReading();
+            float newLocalTemp = reading.ambientC;
+            float newRemoteTemp = reading.thermocoupleC;
             
             // Static variables to track previous temperatures for validation
             static float lastLocalTemp = 70.0;  // Initialize to reasonable room temp
@@ -379,6 +536,9 @@ void MonitorSystem::readTemperatureSensor() {
                 lastRemoteTemp = newRemoteTemp;
             }
             
+            aggregator.addSample(AGG_LOCAL_TEMPERATURE, getLocalTemperatureF());
+            aggregator.addSample(AGG_REMOTE_TEMPERATURE, getRemoteTemperatureF());
+            
             if (tempDebugEnabled) {
                 debugPrintf("MonitorSystem: FINAL - Local: %.1fC, Remote: %.1fC\n", localTemperature, remoteTemperature);
                 debugPrintf("--- End Temperature Cycle ---\n\n");
@@ -390,161 +550,183 @@ void MonitorSystem::readTemperatureSensor() {
             // Sensor not available - use last known values but don't update timestamp
             // This will prevent stale data from being reported as current
         }
-        
-        // Disable multiplexer channel after reading to prevent conflicts
-        i2cMux.disableAllChannels();
     }
 }
 
 void MonitorSystem::readDigitalInputs() {
-    // Read all digital inputs
-    for (size_t i = 0; i < WATCH_PIN_COUNT; i++) {
-        uint8_t pin = WATCH_PINS[i];
-        // Skip output pins
-        if (pin != DIGITAL_OUTPUT_1 && pin != DIGITAL_OUTPUT_2) {
-            bool currentState = digitalRead(pin) == LOW; // Active low with pullup
-            size_t index = i < 8 ? i : 7; // Bounds check
-            
-            // Detect state change
-            if (digitalInputStates[index] != currentState) {
-                digitalInputStates[index] = currentState;
-                LOG_INFO("MonitorSystem: Digital input %d changed to %s", 
-                    pin, currentState ? "ACTIVE" : "INACTIVE");
-                
-                // Publish state change to MQTT
-                if (g_networkManager && g_networkManager->isMQTTConnected()) {
-                    char topic[64];
-                    snprintf(topic, sizeof(topic), "monitor/input/%d", pin);
-                    g_networkManager->publish(topic, currentState ? "1" : "0");
-                }
-            }
-        }
+    // Edges were queued by the pin-change interrupts; this only debounces
+    inputMonitor.service();
+}
+
+void MonitorSystem::onInputChange(const DigitalInputMonitor::Change& change) {
+    for (size_t i = 0; i < WATCH_PIN_COUNT && i < 8; i++) {
+        if (WATCH_PINS[i] == change.pin) digitalInputStates[i] = change.active;
+    }
+    
+    LOG_INFO("MonitorSystem: Digital input %d changed to %s (%u bounces)", 
+        change.pin, change.active ? "ACTIVE" : "INACTIVE", change.bounces);
+    
+    // Publish state change to MQTT
+    if (g_networkManager && g_networkManager->isMQTTConnected()) {
+        char topic[64];
+        snprintf(topic, sizeof(topic), "monitor/input/%d", change.pin);
+        g_networkManager->publish(topic, change.active ? "1" : "0");
+        
+        // Every change with its edge time; sent at once so a quick
+        // on/off pair is not coalesced into one queued value
+        char payload[96];
+        snprintf(topic, sizeof(topic), "monitor/input/%d/edge", change.pin);
+        snprintf(payload, sizeof(payload), "{\"state\":%d,\"t\":%lu,\"us\":%lu,\"bounces\":%u,\"src\":\"%s\"}",
+            change.active ? 1 : 0, change.edgeMs, (unsigned long)change.edgeUs,
+            change.bounces, change.interrupt ? "irq" : "poll");
+        g_networkManager->publishImmediate(topic, payload);
     }
 }
 
-void MonitorSystem::readWeightSensor() {
-    // Select NAU7802 multiplexer channel
-    i2cMux.selectChannel(NAU7802_CHANNEL);
-    delay(10); // Allow multiplexer channel to stabilize
+I2CScheduler::Result MonitorSystem::readWeightSensor() {
+    // NAU7802 channel already selected and settled by the I2C scheduler.
+    // Called about once per conversion: every conversion goes into the
+    // decimator, and MQTT gets the filtered value once per publish interval.
+    unsigned long now = millis();
+    NAU7802Sample sample = weightSensor.updateReading();
     
-    if (!weightSensor.isConnected()) {
-        static bool wasConnected = true;  // Track previous state
-        if (wasConnected) {
-            weightSensorFailures++;
-            LOG_CRITICAL("NAU7802 weight sensor disconnected (consecutive failures: %d)", weightSensorFailures);
-            wasConnected = false;
+    if (sample == NAU7802_SAMPLE_NONE) {
+        // Only probe the bus once conversions have stopped arriving
+        if (now - lastWeightSampleMs < NAU7802_STALL_MS) {
+            return I2CScheduler::RESULT_RETRY;  // Next conversion not finished yet
         }
-        i2cMux.disableAllChannels();
-        return;
-    } else {
-        static bool wasConnected = false;  // Track previous state
-        if (!wasConnected) {
-            LOG_INFO("NAU7802 weight sensor reconnected");
-            weightSensorFailures = 0;  // Reset failure counter
-            wasConnected = true;
+        lastWeightSampleMs = now;
+        
+        if (!weightSensor.isConnected()) {
+            if (weightSensorConnected) {
+                weightSensorFailures++;
+                LOG_CRITICAL("NAU7802 weight sensor disconnected (consecutive failures: %d)", weightSensorFailures);
+                weightSensorConnected = false;
+            }
+            return I2CScheduler::RESULT_FAILED;
         }
+        return I2CScheduler::RESULT_RETRY;
     }
     
-    if (weightSensor.dataAvailable()) {
-        weightSensorFailures = 0;  // Reset on successful read
-        weightSensor.updateReading();
-        currentRawWeight = weightSensor.getRawReading();
-        currentWeight = weightSensor.getFilteredWeight();
-        
-        // Calculate fuel gallons from weight
-        // Current calibration: weight sensor returns grams
-        // Gasoline density: ~2.8 kg/gal (6.17 lbs/gal)
-        // Container tare weight: Need to calibrate/set based on your setup
-        
-        float weightInKg = currentWeight / 1000.0;  // Convert grams to kilograms
+    lastWeightSampleMs = now;
+    if (!weightSensorConnected) {
+        LOG_INFO("NAU7802 weight sensor reconnected");
+        weightSensorConnected = true;
+    }
+    weightSensorFailures = 0;  // Reset on successful read
+    
+    if (sample != NAU7802_SAMPLE_READY) {
+        return I2CScheduler::RESULT_OK;  // Block not complete yet
+    }
+    
+    currentRawWeight = weightSensor.getRawReading();
+    currentWeight = weightSensor.getFilteredWeight();
+    aggregator.addSample(AGG_WEIGHT, currentWeight);
+    
+    // Calculate fuel gallons from weight
+    // Current calibration: weight sensor returns grams
+    // Gasoline density: ~2.8 kg/gal (6.17 lbs/gal)
+    // Container tare weight: Need to calibrate/set based on your setup
+    
+    float weightInKg = currentWeight / 1000.0;  // Convert grams to kilograms
+    
+    // Simple calculation: divide total weight by fuel density
+    // Container tare is already accounted for in zero calibration (scale zeroed with empty container)
+    // So the weight reading is the fuel weight directly
+    const float GASOLINE_DENSITY_KG_PER_GAL = 2.8;  // ~6.17 lbs/gal at 15°C
+    
+    // Weight reading is fuel weight (container tare already zeroed out)
+    float fuelWeightKg = weightInKg;
+    fuelGallons = fuelWeightKg / GASOLINE_DENSITY_KG_PER_GAL;
+    
+    // Ensure non-negative value (can't have negative fuel)
+    if (fuelGallons < 0.0) {
+        fuelGallons = 0.0;
+    }
+    
+    // Filtered samples arrive several times a second; publish at the old rate
+    if (now - lastWeightRead < NAU7802_READ_INTERVAL_MS) {
+        return I2CScheduler::RESULT_OK;
+    }
+    lastWeightRead = now;
+    
+    // Publish weight data to MQTT
+    if (publishText() && g_networkManager && g_networkManager->isMQTTConnected() &&
+        textDue(AGG_WEIGHT, currentWeight, now)) {
+        char valueBuffer[16];
         
-        // Simple calculation: divide total weight by fuel density
-        // Container tare is already accounted for in zero calibration (scale zeroed with empty container)
-        // So the weight reading is the fuel weight directly
-        const float GASOLINE_DENSITY_KG_PER_GAL = 2.8;  // ~6.17 lbs/gal at 15°C
+        // Publish filtered weight
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.3f", currentWeight);
+        g_networkManager->publish(TOPIC_NAU7802_WEIGHT, valueBuffer);
         
-        // Weight reading is fuel weight (container tare already zeroed out)
-        float fuelWeightKg = weightInKg;
-        fuelGallons = fuelWeightKg / GASOLINE_DENSITY_KG_PER_GAL;
+        // Publish raw reading
+        snprintf(valueBuffer, sizeof(valueBuffer), "%ld", currentRawWeight);
+        g_networkManager->publish(TOPIC_NAU7802_RAW, valueBuffer);
         
-        // Ensure non-negative value (can't have negative fuel)
-        if (fuelGallons < 0.0) {
-            fuelGallons = 0.0;
-        }
+        // Publish fuel gallons
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", fuelGallons);
+        g_networkManager->publish("monitor/fuel/gallons", valueBuffer);
         
-        // Publish weight data to MQTT
-        if (g_networkManager && g_networkManager->isMQTTConnected()) {
-            char valueBuffer[16];
-            
-            // Publish filtered weight
-            snprintf(valueBuffer, sizeof(valueBuffer), "%.3f", currentWeight);
-            g_networkManager->publish(TOPIC_NAU7802_WEIGHT, valueBuffer);
-            
-            // Publish raw reading
-            snprintf(valueBuffer, sizeof(valueBuffer), "%ld", currentRawWeight);
-            g_networkManager->publish(TOPIC_NAU7802_RAW, valueBuffer);
-            
-            // Publish fuel gallons
-            snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", fuelGallons);
-            g_networkManager->publish("monitor/fuel/gallons", valueBuffer);
-            
-            // Publish comprehensive weight sensor status
-            char statusBuffer[128];
-            snprintf(statusBuffer, sizeof(statusBuffer), 
-                "status: %s, ready: %s, weight: %.3f, raw: %ld",
-                weightSensor.getStatusString(),
-                weightSensor.isReady() ? "YES" : "NO",
-                currentWeight,
-                currentRawWeight);
-            g_networkManager->publish(TOPIC_NAU7802_STATUS, statusBuffer);
-        }
+        // Publish comprehensive weight sensor status
+        char statusBuffer[128];
+        snprintf(statusBuffer, sizeof(statusBuffer), 
+            "status: %s, ready: %s, weight: %.3f, raw: %ld",
+            weightSensor.getStatusString(),
+            weightSensor.isReady() ? "YES" : "NO",
+            currentWeight,
+            currentRawWeight);
+        g_networkManager->publish(TOPIC_NAU7802_STATUS, statusBuffer);
     }
     
-    // Disable multiplexer channel after reading to prevent conflicts
-    i2cMux.disableAllChannels();
+    return I2CScheduler::RESULT_OK;
 }
 
-void MonitorSystem::readPowerSensor() {
-    debugPrintf("MonitorSystem: readPowerSensor() called, available=%s\n", powerSensorAvailable ? "YES" : "NO");
-    
+I2CScheduler::Result MonitorSystem::readPowerSensor() {
     // Only attempt to read if sensor was successfully initialized
     if (!powerSensorAvailable) {
-        debugPrintf("MonitorSystem: Power sensor not available, skipping read\n");
-        return;
+        return I2CScheduler::RESULT_FAILED;
     }
     
-    // Select INA219 multiplexer channel
-    i2cMux.selectChannel(INA219_CHANNEL);
-    delay(10); // Allow multiplexer channel to stabilize
-    
-    debugPrintf("MonitorSystem: Attempting power sensor reading...\n");
-    
-    // Read power sensor values with error checking
+    // INA219 channel already selected by the I2C scheduler, and the triggered
+    // conversion has finished; one register pass reads all four values
     if (powerSensor.takereading()) {
         powerSensorFailures = 0;  // Reset on successful read
-        currentVoltage = powerSensor.getBusVoltage();
-        currentCurrent = powerSensor.getCurrent();
-        currentPower = powerSensor.getPower();
+        INA219_Reading reading = powerSensor.getLastReading();
+        currentVoltage = reading.busVoltageV();
+        currentCurrent = reading.currentMilliamps();
+        currentPower = reading.powerMilliwatts();
+        aggregator.addSample(AGG_BUS_VOLTAGE, currentVoltage);
+        aggregator.addSample(AGG_CURRENT, currentCurrent);
+        aggregator.addSample(AGG_POWER, currentPower);
         
-        debugPrintf("MonitorSystem: Power reading successful: %.3fV, %.2fmA, %.2fmW\n", 
-                   currentVoltage, currentCurrent, currentPower);
-        
-        // Publish power data to MQTT
-        if (g_networkManager && g_networkManager->isMQTTConnected()) {
-            debugPrintf("MonitorSystem: Publishing power data to MQTT\n");
+        // Publish power data to MQTT (each value only when outside its deadband)
+        if (publishText() && g_networkManager && g_networkManager->isMQTTConnected()) {
+            unsigned long now = millis();
+            bool published = false;
             char valueBuffer[16];
             
             // Publish bus voltage
-            snprintf(valueBuffer, sizeof(valueBuffer), "%.3f", currentVoltage);
-            g_networkManager->publish(TOPIC_INA219_VOLTAGE, valueBuffer);
+            if (textDue(AGG_BUS_VOLTAGE, currentVoltage, now)) {
+                snprintf(valueBuffer, sizeof(valueBuffer), "%.3f", currentVoltage);
+                g_networkManager->publish(TOPIC_INA219_VOLTAGE, valueBuffer);
+                published = true;
+            }
             
             // Publish current in mA
-            snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", currentCurrent);
-            g_networkManager->publish(TOPIC_INA219_CURRENT, valueBuffer);
+            if (textDue(AGG_CURRENT, currentCurrent, now)) {
+                snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", currentCurrent);
+                g_networkManager->publish(TOPIC_INA219_CURRENT, valueBuffer);
+                published = true;
+            }
             
             // Publish power in mW
-            snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", currentPower);
-            g_networkManager->publish(TOPIC_INA219_POWER, valueBuffer);
+            if (textDue(AGG_POWER, currentPower, now)) {
+                snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", currentPower);
+                g_networkManager->publish(TOPIC_INA219_POWER, valueBuffer);
+                published = true;
+            }
+            
+            if (!published) return I2CScheduler::RESULT_OK;
             
             // Publish comprehensive power sensor status
             char statusBuffer[128];
@@ -555,10 +737,8 @@ void MonitorSystem::readPowerSensor() {
                 currentCurrent,
                 currentPower);
             g_networkManager->publish(TOPIC_INA219_STATUS, statusBuffer);
-            debugPrintf("MonitorSystem: Power data published to MQTT successfully\n");
-        } else {
-            debugPrintf("MonitorSystem: MQTT not connected, cannot publish power data\n");
         }
+        return I2CScheduler::RESULT_OK;
     } else {
         powerSensorFailures++;
         
@@ -569,30 +749,32 @@ void MonitorSystem::readPowerSensor() {
         }
         
         debugPrintf("MonitorSystem: Power sensor reading failed\n");
+        return I2CScheduler::RESULT_FAILED;
     }
-    
-    // Disable multiplexer channel after reading to prevent conflicts
-    i2cMux.disableAllChannels();
 }
 
-void MonitorSystem::readAdcSensor() {
+I2CScheduler::Result MonitorSystem::readAdcSensor() {
     // Only attempt to read if sensor was successfully initialized
     if (!adcSensorAvailable) {
-        return;
+        return I2CScheduler::RESULT_FAILED;
     }
     
-    // Select MCP3421 multiplexer channel
-    i2cMux.selectChannel(MCP3421_CHANNEL);
-    delay(10); // Allow multiplexer channel to stabilize
-    
-    // Take ADC reading with error checking
+    // MCP3421 channel already selected by the I2C scheduler
     if (adcSensor.takeReading()) {
+        // In one-shot mode RDY stays set until the started conversion is done
+        if (adcSensor.getConversionMode() == MCP3421_ONE_SHOT &&
+            (adcSensor.getLastReading().config & MCP3421_RDY_BIT)) {
+            return I2CScheduler::RESULT_RETRY;
+        }
+        
         adcSensorFailures = 0;  // Reset on successful read
         currentAdcVoltage = adcSensor.getVoltage();
         currentAdcRaw = adcSensor.getRawValue();
+        aggregator.addSample(AGG_ADC_VOLTAGE, currentAdcVoltage);
         
         // Publish ADC data to MQTT
-        if (g_networkManager && g_networkManager->isMQTTConnected()) {
+        if (publishText() && g_networkManager && g_networkManager->isMQTTConnected() &&
+            textDue(AGG_ADC_VOLTAGE, currentAdcVoltage, millis())) {
             char valueBuffer[16];
             
             // Publish voltage reading
@@ -613,6 +795,7 @@ void MonitorSystem::readAdcSensor() {
                 adcSensor.getResolution());
             g_networkManager->publish(TOPIC_MCP3421_STATUS, statusBuffer);
         }
+        return I2CScheduler::RESULT_OK;
     } else {
         adcSensorFailures++;
         
@@ -621,40 +804,255 @@ void MonitorSystem::readAdcSensor() {
         } else if (adcSensorFailures == 1) {
             LOG_WARN("MCP3421 ADC sensor reading failed (consecutive failures: %d)", adcSensorFailures);
         }
+        return I2CScheduler::RESULT_FAILED;
     }
-    
-    // Disable multiplexer channel after reading to prevent conflicts
-    i2cMux.disableAllChannels();
 }
 
 void MonitorSystem::publishStatus() {
     if (!g_networkManager || !g_networkManager->isMQTTConnected()) {
+        storeStatusSamples();
         return;
     }
     
-    // Publish individual sensor readings
+    if (!publishText()) return;  // Carried by the MonitorSnapshot
+    
+    // Publish individual sensor readings that left their deadband
+    unsigned long now = millis();
     char valueBuffer[16];
     
     // Publish MCP9600 local temperature (in Fahrenheit)
     float localTempF = (localTemperature * 9.0 / 5.0) + 32.0;
-    snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", localTempF);
-    g_networkManager->publish(TOPIC_SENSOR_TEMPERATURE, valueBuffer);  // Backward compatibility
-    g_networkManager->publish(TOPIC_SENSOR_TEMPERATURE_LOCAL, valueBuffer);  // Explicit local topic
+    if (textDue(AGG_LOCAL_TEMPERATURE, localTempF, now)) {
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", localTempF);
+        g_networkManager->publish(TOPIC_SENSOR_TEMPERATURE, valueBuffer);  // Backward compatibility
+        g_networkManager->publish(TOPIC_SENSOR_TEMPERATURE_LOCAL, valueBuffer);  // Explicit local topic
+    }
     
     // Publish MCP9600 remote temperature (in Fahrenheit)
     float remoteTempF = (remoteTemperature * 9.0 / 5.0) + 32.0;
-    snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", remoteTempF);
-    g_networkManager->publish(TOPIC_SENSOR_TEMPERATURE_REMOTE, valueBuffer);
-    
-    snprintf(valueBuffer, sizeof(valueBuffer), "%lu", getUptime());
-    g_networkManager->publish(TOPIC_SYSTEM_UPTIME, valueBuffer);
+    if (textDue(AGG_REMOTE_TEMPERATURE, remoteTempF, now)) {
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", remoteTempF);
+        g_networkManager->publish(TOPIC_SENSOR_TEMPERATURE_REMOTE, valueBuffer);
+    }
     
-    snprintf(valueBuffer, sizeof(valueBuffer), "%lu", getFreeMemory());
-    g_networkManager->publish(TOPIC_SYSTEM_MEMORY, valueBuffer);
+    // Uptime always changes; it goes out with free memory
+    unsigned long freeMemory = getFreeMemory();
+    if (textDue(REPORT_MEMORY, (float)freeMemory, now)) {
+        snprintf(valueBuffer, sizeof(valueBuffer), "%lu", getUptime());
+        g_networkManager->publish(TOPIC_SYSTEM_UPTIME, valueBuffer);
+        
+        snprintf(valueBuffer, sizeof(valueBuffer), "%lu", freeMemory);
+        g_networkManager->publish(TOPIC_SYSTEM_MEMORY, valueBuffer);
+    }
     
     LOG_DEBUG("MonitorSystem: Status published");
 }
 
+void MonitorSystem::publishSnapshot() {
+    if (!g_networkManager || !g_networkManager->isMQTTConnected()) {
+        return;
+    }
+    
+    // Nothing left its deadband and no keepalive is due: skip this snapshot
+    unsigned long now = millis();
+    if (!snapshotDue(now)) {
+        deadbandSuppressed++;
+        return;
+    }
+    
+    monitor_MonitorSnapshot snapshot = monitor_MonitorSnapshot_init_zero;
+    snapshot.sequence = ++snapshotSequence;
+    snapshot.uptime_ms = now - systemStartTime;
+    snapshot.free_memory_bytes = getFreeMemory();
+    
+    if (lastSensorAvailable) snapshot.sensors |= monitor_SensorFlag_SENSOR_TEMPERATURE;
+    if (weightSensorConnected) snapshot.sensors |= monitor_SensorFlag_SENSOR_WEIGHT;
+    if (powerSensorAvailable) snapshot.sensors |= monitor_SensorFlag_SENSOR_POWER;
+    if (adcSensorAvailable) snapshot.sensors |= monitor_SensorFlag_SENSOR_ADC;
+    
+    snapshot.local_temperature_f = getLocalTemperatureF();
+    snapshot.remote_temperature_f = getRemoteTemperatureF();
+    snapshot.weight = currentWeight;
+    snapshot.weight_raw = currentRawWeight;
+    snapshot.fuel_gallons = fuelGallons;
+    snapshot.bus_voltage_v = currentVoltage;
+    snapshot.current_ma = currentCurrent;
+    snapshot.power_mw = currentPower;
+    snapshot.adc_voltage = currentAdcVoltage;
+    snapshot.adc_raw = currentAdcRaw;
+    
+    // Every value is sent, so every value's reference moves
+    snapshotTracks[AGG_LOCAL_TEMPERATURE].mark(snapshot.local_temperature_f, now);
+    snapshotTracks[AGG_REMOTE_TEMPERATURE].mark(snapshot.remote_temperature_f, now);
+    snapshotTracks[AGG_WEIGHT].mark(currentWeight, now);
+    snapshotTracks[AGG_BUS_VOLTAGE].mark(currentVoltage, now);
+    snapshotTracks[AGG_CURRENT].mark(currentCurrent, now);
+    snapshotTracks[AGG_POWER].mark(currentPower, now);
+    snapshotTracks[AGG_ADC_VOLTAGE].mark(currentAdcVoltage, now);
+    snapshotTracks[REPORT_MEMORY].mark((float)snapshot.free_memory_bytes, now);
+    
+    pb_ostream_t stream = pb_ostream_from_buffer(snapshotBuffer, sizeof(snapshotBuffer));
+    if (!pb_encode(&stream, monitor_MonitorSnapshot_fields, &snapshot)) {
+        LOG_ERROR("MonitorSystem: Snapshot encode failed: %s", PB_GET_ERROR(&stream));
+        return;
+    }
+    
+    g_networkManager->publishBinary(TOPIC_MONITOR_PROTOBUF, snapshotBuffer, stream.bytes_written);
+}
+
+void MonitorSystem::publishWindow(uint8_t window, unsigned long windowMs) {
+    if (!g_networkManager || !g_networkManager->isMQTTConnected()) {
+        return;  // Window summaries are live data; the outage log keeps the trend
+    }
+    
+    // A channel is reported when any sample in the window (min or max, so
+    // short spikes count) left the deadband around the last reported mean
+    unsigned long now = millis();
+    uint8_t reportMask = 0;
+    for (uint8_t i = 0; i < aggregator.getChannelCount(); i++) {
+        const RunningStats& channel = aggregator.getStats(i, window);
+        if (channel.getCount() == 0) continue;
+        
+        DeadbandTrack& track = windowTracks[window][i];
+        const DeadbandSetting& setting = deadbandFor(i);
+        if (track.due(setting, channel.getMean(), now) ||
+            track.exceeded(setting, channel.getMin()) || track.exceeded(setting, channel.getMax())) {
+            track.mark(channel.getMean(), now);
+            reportMask |= 1 << i;
+        } else {
+            deadbandSuppressed++;
+        }
+    }
+    if (reportMask == 0) return;
+    
+    if (telemetryFormat & TELEMETRY_PROTOBUF) {
+        monitor_MonitorStats stats = monitor_MonitorStats_init_zero;
+        stats.sequence = ++statsSequence;
+        stats.uptime_ms = millis() - systemStartTime;
+        stats.window_ms = windowMs;
+        
+        for (uint8_t i = 0; i < aggregator.getChannelCount(); i++) {
+            if (!(reportMask & (1 << i))) continue;
+            const RunningStats& channel = aggregator.getStats(i, window);
+            
+            monitor_ChannelStats& entry = stats.channels[stats.channels_count++];
+            entry.channel = (monitor_StatsChannel)i;
+            entry.count = channel.getCount();
+            entry.minimum = channel.getMin();
+            entry.maximum = channel.getMax();
+            entry.mean = channel.getMean();
+            entry.stddev = channel.stddev();
+            entry.last = channel.getLast();
+        }
+        
+        pb_ostream_t stream = pb_ostream_from_buffer(statsBuffer, sizeof(statsBuffer));
+        if (pb_encode(&stream, monitor_MonitorStats_fields, &stats)) {
+            g_networkManager->publishBinary(TOPIC_MONITOR_STATS_PROTOBUF, statsBuffer, stream.bytes_written);
+        } else {
+            LOG_ERROR("MonitorSystem: Stats encode failed: %s", PB_GET_ERROR(&stream));
+        }
+    }
+    
+    if (publishText()) {
+        // monitor/stats/<window>/<channel>, e.g. monitor/stats/10s/power/current
+        char label[12];
+        if (windowMs % 1000 == 0) {
+            snprintf(label, sizeof(label), "%lus", windowMs / 1000);
+        } else {
+            snprintf(label, sizeof(label), "%lums", windowMs);
+        }
+        
+        for (uint8_t i = 0; i < aggregator.getChannelCount(); i++) {
+            if (!(reportMask & (1 << i))) continue;
+            const RunningStats& channel = aggregator.getStats(i, window);
+            
+            char topic[MQTT_QUEUE_TOPIC_SIZE];
+            char payload[MQTT_QUEUE_PAYLOAD_SIZE];
+            snprintf(topic, sizeof(topic), "%s/%s/%s", TOPIC_MONITOR_STATS, label, aggregator.getChannelName(i));
+            snprintf(payload, sizeof(payload),
+                "{\"n\":%lu,\"min\":%.5g,\"max\":%.5g,\"mean\":%.5g,\"sd\":%.5g,\"last\":%.5g}",
+                (unsigned long)channel.getCount(), channel.getMin(), channel.getMax(),
+                channel.getMean(), channel.stddev(), channel.getLast());
+            g_networkManager->publish(topic, payload);
+        }
+    }
+}
+
+const DeadbandSetting& MonitorSystem::deadbandFor(uint8_t value) {
+    // Reported value -> deadband topic group
+    static const DeadbandTopic VALUE_TOPICS[REPORT_VALUE_COUNT] = {
+        DEADBAND_TEMPERATURE,   // AGG_LOCAL_TEMPERATURE
+        DEADBAND_TEMPERATURE,   // AGG_REMOTE_TEMPERATURE
+        DEADBAND_WEIGHT,        // AGG_WEIGHT
+        DEADBAND_VOLTAGE,       // AGG_BUS_VOLTAGE
+        DEADBAND_CURRENT,       // AGG_CURRENT
+        DEADBAND_POWER,         // AGG_POWER
+        DEADBAND_ADC,           // AGG_ADC_VOLTAGE
+        DEADBAND_SYSTEM         // REPORT_MEMORY
+    };
+    static const DeadbandSetting OFF = { 0.0f, 0, 0, 0 };
+    
+    if (!g_monitorConfig || value >= REPORT_VALUE_COUNT) return OFF;
+    return g_monitorConfig->getDeadband(VALUE_TOPICS[value]);
+}
+
+bool MonitorSystem::textDue(uint8_t value, float current, unsigned long now) {
+    DeadbandTrack& track = textTracks[value];
+    if (!track.due(deadbandFor(value), current, now)) {
+        deadbandSuppressed++;
+        return false;
+    }
+    track.mark(current, now);
+    return true;
+}
+
+bool MonitorSystem::snapshotDue(unsigned long now) const {
+    const float values[REPORT_VALUE_COUNT] = {
+        getLocalTemperatureF(), getRemoteTemperatureF(), currentWeight,
+        currentVoltage, currentCurrent, currentPower, currentAdcVoltage, (float)getFreeMemory()
+    };
+    for (uint8_t i = 0; i < REPORT_VALUE_COUNT; i++) {
+        if (snapshotTracks[i].due(deadbandFor(i), values[i], now)) return true;
+    }
+    return false;
+}
+
+void MonitorSystem::resetDeadbands() {
+    memset(textTracks, 0, sizeof(textTracks));
+    memset(snapshotTracks, 0, sizeof(snapshotTracks));
+    memset(windowTracks, 0, sizeof(windowTracks));
+}
+
+void MonitorSystem::storeStatusSamples() {
+    // Keep one snapshot per status interval in the outage log so the trend
+    // can be rebuilt from monitor/replay after MQTT reconnects
+    if (!g_storeForward) return;
+    
+    char valueBuffer[16];
+    
+    snprintf(valueBuffer, sizeof(valueBuffer), "%.3f", currentWeight);
+    g_storeForward->appendSample(TOPIC_NAU7802_WEIGHT, valueBuffer);
+    snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", fuelGallons);
+    g_storeForward->appendSample("monitor/fuel/gallons", valueBuffer);
+    
+    if (powerSensorAvailable) {
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.3f", currentVoltage);
+        g_storeForward->appendSample(TOPIC_INA219_VOLTAGE, valueBuffer);
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", currentCurrent);
+        g_storeForward->appendSample(TOPIC_INA219_CURRENT, valueBuffer);
+    }
+    
+    if (adcSensorAvailable) {
+        snprintf(valueBuffer, sizeof(valueBuffer), "%.6f", currentAdcVoltage);
+        g_storeForward->appendSample(TOPIC_MCP3421_VOLTAGE, valueBuffer);
+    }
+    
+    snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", (localTemperature * 9.0 / 5.0) + 32.0);
+    g_storeForward->appendSample(TOPIC_SENSOR_TEMPERATURE_LOCAL, valueBuffer);
+    snprintf(valueBuffer, sizeof(valueBuffer), "%.2f", (remoteTemperature * 9.0 / 5.0) + 32.0);
+    g_storeForward->appendSample(TOPIC_SENSOR_TEMPERATURE_REMOTE, valueBuffer);
+}
+
 void MonitorSystem::publishHeartbeat() {
     if (!g_networkManager || !g_networkManager->isMQTTConnected()) {
         return;
@@ -668,6 +1066,53 @@ void MonitorSystem::publishHeartbeat() {
     LOG_DEBUG("MonitorSystem: Heartbeat sent");
 }
 
+void MonitorSystem::publishDigest() {
+    if (!g_networkManager || !g_networkManager->isMQTTConnected()) {
+        return;
+    }
+    
+    // Without the namespace the hostname goes in the topic, so devices
+    // sharing a broker do not overwrite each other's retained digest
+    char topic[TOPIC_BUFFER_SIZE];
+    if (g_networkManager->isTopicNamespaced()) {
+        snprintf(topic, sizeof(topic), "%s", TOPIC_MONITOR_DIGEST);
+    } else {
+        snprintf(topic, sizeof(topic), "%s/%s", TOPIC_MONITOR_DIGEST, g_networkManager->getHostname());
+    }
+    
+    BridgeMetrics::Summary bridge;
+    memset(&bridge, 0, sizeof(bridge));
+    if (g_serialBridge) g_serialBridge->getMetricsSummary(BRIDGE_METRICS_WINDOW_S, bridge);
+    uint32_t drops = 0;
+    for (uint8_t d = 0; d < DROP_COUNT; d++) drops += bridge.drops[d];
+    
+    // Short keys, temperatures in Fahrenheit; a missing sensor is null.
+    // Longer than a queue slot, so it is sent straight away when due.
+    char temps[32];
+    char* cursor = temps;
+    const float readings[2] = { localTemperature, remoteTemperature };
+    const char* const keys[2] = { "t", "tr" };
+    for (uint8_t i = 0; i < 2; i++) {
+        size_t left = sizeof(temps) - (cursor - temps);
+        if (readings[i] > -100.0) {
+            cursor += snprintf(cursor, left, ",\"%s\":%.1f", keys[i], readings[i] * 9.0 / 5.0 + 32.0);
+        } else {
+            cursor += snprintf(cursor, left, ",\"%s\":null", keys[i]);
+        }
+    }
+    
+    char digest[192];
+    snprintf(digest, sizeof(digest),
+        "{\"up\":%lu,\"st\":%d,\"rssi\":%ld,\"mem\":%lu%s,\"w\":%.1f,\"fuel\":%.1f,\"v\":%.2f,\"ma\":%.0f,"
+        "\"in\":%.1f,\"pub\":%.1f,\"drop\":%lu,\"p99\":%lu}",
+        getUptime(), (int)currentState, g_networkManager->getRSSI(), getFreeMemory(), temps,
+        currentWeight, fuelGallons, currentVoltage, currentCurrent,
+        bridge.inRate, bridge.publishRate, (unsigned long)drops, (unsigned long)bridge.p99Us);
+    
+    g_networkManager->publishWithRetain(topic, digest);
+    LOG_DEBUG("MonitorSystem: Digest published to %s", topic);
+}
+
 void MonitorSystem::getStatusString(char* buffer, size_t bufferSize) {
     // Convert cached Celsius temperatures to Fahrenheit for display
     float localTempF = (localTemperature * 9.0 / 5.0) + 32.0;
@@ -703,8 +1148,10 @@ float MonitorSystem::getHumidity() const {
 }
 
 bool MonitorSystem::isTemperatureSensorReady() {
-    // Select MCP9600 multiplexer channel before checking availability
-    i2cMux.selectChannel(MCP9600_CHANNEL);
+    // Make sure the MCP9600 channel is enabled before checking availability
+    if (!i2cMux.isChannelEnabled(MCP9600_CHANNEL)) {
+        i2cMux.selectChannel(MCP9600_CHANNEL, MUX_SETTLE_MS);
+    }
     return temperatureSensor.isAvailable();
 }
 
@@ -725,9 +1172,11 @@ unsigned long MonitorSystem::getUptime() const {
 }
 
 unsigned long MonitorSystem::getFreeMemory() const {
-    // Rough estimate of free memory for Arduino
-    // This is a simplified calculation
-    return 32768 - 11000; // Assume ~11KB used, 32KB total for UNO R4
+    // Free heap (arena free list plus never-claimed heap region)
+    if (g_memoryMonitor) {
+        return g_memoryMonitor->getFreeMemory();
+    }
+    return 0;
 }
 
 SystemState MonitorSystem::getSystemState() const {
@@ -785,6 +1234,14 @@ unsigned long MonitorSystem::getHeartbeatInterval() const {
     return heartbeatInterval;
 }
 
+void MonitorSystem::setTelemetryFormat(uint8_t format) {
+    format &= TELEMETRY_PROTOBUF | TELEMETRY_TEXT;
+    if (format == 0) format = TELEMETRY_PROTOBUF;
+    telemetryFormat = format;
+    debugPrintf("MonitorSystem: Telemetry format %s%s\n",
+        (format & TELEMETRY_PROTOBUF) ? "protobuf " : "", (format & TELEMETRY_TEXT) ? "text" : "");
+}
+
 // NAU7802 Weight Sensor Functions
 float MonitorSystem::getWeight() {
     return currentWeight;
@@ -836,8 +1293,8 @@ int32_t MonitorSystem::getAdcRawValue() {
     return currentAdcRaw;
 }
 
-float MonitorSystem::getFilteredAdcVoltage(uint8_t samples) {
-    return adcSensor.getFilteredVoltage(samples);
+float MonitorSystem::getFilteredAdcVoltage() {
+    return adcSensor.getFilteredVoltage();
 }
 
 bool MonitorSystem::isAdcSensorReady() {
@@ -855,20 +1312,16 @@ MCP3421_Sensor* MonitorSystem::getAdcSensor() {
 bool MonitorSystem::calibrateWeightSensorZero() {
     debugPrintf("MonitorSystem: Starting weight sensor zero calibration\n");
     
-    // Select the correct multiplexer channel for NAU7802
-    i2cMux.selectChannel(NAU7802_CHANNEL);
-    delay(50); // Give multiplexer time to switch
+    // Select the correct multiplexer channel for NAU7802 (waits only if it switched)
+    i2cMux.selectChannel(NAU7802_CHANNEL, MUX_SETTLE_MS);
     
     NAU7802Status status = weightSensor.calibrateZero();
     if (status == NAU7802_OK) {
         debugPrintf("MonitorSystem: Weight sensor zero calibration completed\n");
         
-        // Force LCD to clear its cached content so it updates with new calibration
+        // Redraw every LCD cell on the next refresh so it shows the new calibration
         if (g_lcdDisplay) {
-            i2cMux.selectChannel(LCD_CHANNEL);
-            delay(50);
-            g_lcdDisplay->clear();
-            delay(100);
+            g_lcdDisplay->invalidate();
         }
         
         return true;
@@ -884,20 +1337,16 @@ bool MonitorSystem::calibrateWeightSensorZero() {
 bool MonitorSystem::calibrateWeightSensorScale(float knownWeight) {
     debugPrintf("MonitorSystem: Starting weight sensor scale calibration with %.2f\n", knownWeight);
     
-    // Select the correct multiplexer channel for NAU7802
-    i2cMux.selectChannel(NAU7802_CHANNEL);
-    delay(50); // Give multiplexer time to switch
+    // Select the correct multiplexer channel for NAU7802 (waits only if it switched)
+    i2cMux.selectChannel(NAU7802_CHANNEL, MUX_SETTLE_MS);
     
     NAU7802Status status = weightSensor.calibrateScale(knownWeight);
     if (status == NAU7802_OK) {
         debugPrintf("MonitorSystem: Weight sensor scale calibration completed\n");
         
-        // Force LCD to clear its cached content so it updates with new calibration
+        // Redraw every LCD cell on the next refresh so it shows the new calibration
         if (g_lcdDisplay) {
-            i2cMux.selectChannel(LCD_CHANNEL);
-            delay(50);
-            g_lcdDisplay->clear();
-            delay(100);
+            g_lcdDisplay->invalidate();
         }
         
         return true;
@@ -913,13 +1362,26 @@ bool MonitorSystem::calibrateWeightSensorScale(float knownWeight) {
 void MonitorSystem::tareWeightSensor() {
     debugPrintf("MonitorSystem: Taring weight sensor\n");
     
-    // Select the correct multiplexer channel for NAU7802
-    i2cMux.selectChannel(NAU7802_CHANNEL);
-    delay(50); // Give multiplexer time to switch
+    // Select the correct multiplexer channel for NAU7802 (waits only if it switched)
+    i2cMux.selectChannel(NAU7802_CHANNEL, MUX_SETTLE_MS);
     
     weightSensor.tareScale();
 }
 
+bool MonitorSystem::setWeightAcquisition(uint8_t rate, uint8_t decimation) {
+    i2cMux.selectChannel(NAU7802_CHANNEL, MUX_SETTLE_MS);
+    if (!weightSensor.setAcquisition(rate, decimation)) {
+        return false;
+    }
+    
+    // Keep polling at the new conversion rate
+    int8_t id = i2cScheduler.findDevice("weight");
+    unsigned long intervalMs = weightSensor.getConversionIntervalMs();
+    i2cScheduler.setConversionTime(id, intervalMs);
+    i2cScheduler.setPeriod(id, intervalMs < I2C_SCHED_MIN_PERIOD_MS ? I2C_SCHED_MIN_PERIOD_MS : intervalMs);
+    return true;
+}
+
 bool MonitorSystem::saveWeightCalibration() {
     return weightSensor.saveCalibration();
 }
@@ -940,12 +1402,7 @@ void MonitorSystem::updateLCDDisplay() {
         return;
     }
     
-    // Select LCD multiplexer channel
-    if (!i2cMux.selectChannel(LCD_CHANNEL)) {
-        debugPrintf("LCD: Failed to select mux channel %d\n", LCD_CHANNEL);
-        return;
-    }
-    delay(5);  // Small delay for channel to stabilize
+    // Only the framebuffer is written here; the I2C scheduler sends the changes
     
     // Get network status for combined display
     bool wifiConnected = false;
@@ -970,19 +1427,18 @@ void MonitorSystem::updateLCDDisplay() {
                                (remoteTemperature * 9.0 / 5.0) + 32.0 : -999.0;
     g_lcdDisplay->updateSensorReadings(displayLocalTempF, fuelGallons, displayRemoteTempF);
     
-    // Update additional sensor data (line 4) - Power sensors and Serial1→MQTT traffic (5-min window)
-    uint32_t serialMsgCount = 0;
-    uint32_t mqttMsgCount = 0;
+    // Update additional sensor data (line 4) - Power sensors and Serial1→MQTT traffic (frames/s, last 10 s)
+    float serialRate = 0.0f;
+    float mqttRate = 0.0f;
     
     if (g_serialBridge) {
-        serialMsgCount = g_serialBridge->getWindowedReceived();
-        mqttMsgCount = g_serialBridge->getWindowedForwarded();
+        BridgeMetrics::Summary recent;
+        g_serialBridge->getMetricsSummary(10, recent);
+        serialRate = recent.inRate;
+        mqttRate = recent.publishRate;
     }
     
-    g_lcdDisplay->updateAdditionalSensors(currentVoltage, currentCurrent, currentAdcVoltage, serialMsgCount, mqttMsgCount);
-    
-    // Disable multiplexer channel after LCD update
-    i2cMux.disableAllChannels();
+    g_lcdDisplay->updateAdditionalSensors(currentVoltage, currentCurrent, currentAdcVoltage, serialRate, mqttRate);
 }
 
 long MonitorSystem::getWeightZeroPoint() const {
@@ -1003,10 +1459,8 @@ bool MonitorSystem::verifyAllSensorsPresent() {
     bool allPresent = true;
     
     // Check MCP9600 temperature sensor
-    i2cMux.selectChannel(MCP9600_CHANNEL);
-    delay(10);
+    i2cMux.selectChannel(MCP9600_CHANNEL, MUX_SETTLE_MS);
     bool tempPresent = temperatureSensor.isAvailable();
-    i2cMux.disableAllChannels();
     
     if (!tempPresent) {
         LOG_ERROR("I2C BUS ERROR: MCP9600 temperature sensor missing on channel %d", MCP9600_CHANNEL);
@@ -1014,10 +1468,8 @@ bool MonitorSystem::verifyAllSensorsPresent() {
     }
     
     // Check NAU7802 weight sensor
-    i2cMux.selectChannel(NAU7802_CHANNEL);
-    delay(10);
+    i2cMux.selectChannel(NAU7802_CHANNEL, MUX_SETTLE_MS);
     bool weightPresent = weightSensor.isConnected();
-    i2cMux.disableAllChannels();
     
     if (!weightPresent) {
         LOG_ERROR("I2C BUS ERROR: NAU7802 weight sensor missing on channel %d", NAU7802_CHANNEL);
@@ -1025,10 +1477,8 @@ bool MonitorSystem::verifyAllSensorsPresent() {
     }
     
     // Check INA219 power sensor
-    i2cMux.selectChannel(INA219_CHANNEL);
-    delay(10);
+    i2cMux.selectChannel(INA219_CHANNEL, MUX_SETTLE_MS);
     bool powerPresent = powerSensorAvailable;  // Use initialization flag
-    i2cMux.disableAllChannels();
     
     if (!powerPresent) {
         LOG_ERROR("I2C BUS ERROR: INA219 power sensor missing on channel %d", INA219_CHANNEL);
@@ -1036,10 +1486,8 @@ bool MonitorSystem::verifyAllSensorsPresent() {
     }
     
     // Check MCP3421 ADC sensor
-    i2cMux.selectChannel(MCP3421_CHANNEL);
-    delay(10);
+    i2cMux.selectChannel(MCP3421_CHANNEL, MUX_SETTLE_MS);
     bool adcPresent = adcSensorAvailable;  // Use initialization flag
-    i2cMux.disableAllChannels();
     
     if (!adcPresent) {
         LOG_ERROR("I2C BUS ERROR: MCP3421 ADC sensor missing on channel %d", MCP3421_CHANNEL);
@@ -1052,6 +1500,7 @@ bool MonitorSystem::verifyAllSensorsPresent() {
 void MonitorSystem::checkI2CHealth() {
     const unsigned long HEALTH_CHECK_INTERVAL = 300000;  // 5 minutes
     const uint8_t MAX_CONSECUTIVE_FAILURES = 5;
+    const unsigned long BUS_RECOVERY_INTERVAL = 10000;  // At most one recovery per 10 s
     
     unsigned long now = millis();
     
@@ -1059,8 +1508,19 @@ void MonitorSystem::checkI2CHealth() {
     if (now - lastHealthCheck >= HEALTH_CHECK_INTERVAL) {
         LOG_INFO("Performing I2C health check");
         
+        // A mux that browned out reads back all-off; drop the cached mask so
+        // the check really writes the control register
+        i2cMux.invalidate();
         bool allSensorsPresent = verifyAllSensorsPresent();
         
+        // A slave holding SDA low makes every device look missing; free the
+        // bus and look again before declaring a hardware fault
+        if (!allSensorsPresent) {
+            i2cMux.recoverBus();
+            lastBusRecovery = now;
+            allSensorsPresent = verifyAllSensorsPresent();
+        }
+        
         if (!allSensorsPresent) {
             i2cBusError = true;
             LOG_CRITICAL("I2C BUS ERROR: One or more sensors missing - hardware fault detected");
@@ -1116,5 +1576,16 @@ void MonitorSystem::checkI2CHealth() {
         LOG_ERROR("ADC sensor: %d consecutive failures - possible I2C bus issue", 
                  adcSensorFailures);
     }
+    
+    // A stuck sensor would otherwise fail every read that follows it
+    bool busSuspect = i2cBusError ||
+                      temperatureSensorFailures >= MAX_CONSECUTIVE_FAILURES ||
+                      weightSensorFailures >= MAX_CONSECUTIVE_FAILURES ||
+                      powerSensorFailures >= MAX_CONSECUTIVE_FAILURES ||
+                      adcSensorFailures >= MAX_CONSECUTIVE_FAILURES;
+    if (busSuspect && now - lastBusRecovery >= BUS_RECOVERY_INTERVAL) {
+        lastBusRecovery = now;
+        i2cMux.recoverBus();
+    }
 }
 
@@ -1,9 +1,9 @@
 #include "nau7802_sensor.h"
 #include "logger.h"
+#include "task_scheduler.h"
+#include "config_log.h"
 #include <EEPROM.h>
 
-extern void debugPrintf(const char* fmt, ...);
-
 // Temporary debug function for serial output only (troubleshooting)
 static void debugSerial(const char* fmt, ...) {
     char buffer[256];
@@ -24,16 +24,17 @@ NAU7802Sensor::NAU7802Sensor() :
     lastWeight(0.0),
     lastFilteredWeight(0.0),
     filteringEnabled(false),
-    filterSamples(10),
-    filterBuffer(nullptr),
-    filterIndex(0),
-    filterBufferFull(false),
     currentGain(NAU7802_GAIN_128),
     currentSampleRate(NAU7802_SPS_10),
+    decimation(1),
+    decimationCount(0),
+    decimationSum(0),
+    conversionCount(0),
     totalReadings(0),
     minReading(0),
     maxReading(0) {
     
+    memset(&storedCalibration, 0, sizeof(storedCalibration));
     initializeDefaults();
 }
 
@@ -231,12 +232,21 @@ float NAU7802Sensor::getFilteredWeight() {
     return lastFilteredWeight;
 }
 
-void NAU7802Sensor::updateReading() {
+NAU7802Sample NAU7802Sensor::updateReading() {
     if (!scale.available()) {
-        return;
+        return NAU7802_SAMPLE_NONE;
     }
     
-    lastRawReading = scale.getReading();
+    // One 24-bit conversion per call; the block average is the output sample
+    decimationSum += scale.getReading();
+    conversionCount++;
+    if (++decimationCount < decimation) {
+        return NAU7802_SAMPLE_ACCUMULATED;
+    }
+    
+    lastRawReading = decimationSum / decimation;
+    decimationSum = 0;
+    decimationCount = 0;
     totalReadings++;
     
     // Update min/max tracking
@@ -248,28 +258,17 @@ void NAU7802Sensor::updateReading() {
         if (lastRawReading > maxReading) maxReading = lastRawReading;
     }
     
-    // Use the library's getWeight() method which applies its internal calibration
-    lastWeight = scale.getWeight();
+    // Computed here from the block; the library's getWeight() would take
+    // eight more blocking readings of its own
+    lastWeight = applyCalibration(lastRawReading);
     
-    if (filteringEnabled) {
-        updateFilter(lastWeight);
-        
-        // Calculate filtered weight
-        if (!filterBufferFull && filterIndex == 0) {
-            lastFilteredWeight = lastWeight;
-        } else {
-            float sum = 0;
-            uint8_t count = filterBufferFull ? filterSamples : filterIndex;
-            
-            for (uint8_t i = 0; i < count; i++) {
-                sum += filterBuffer[i];
-            }
-            
-            lastFilteredWeight = sum / count;
-        }
+    if (filteringEnabled && !isnan(lastWeight)) {
+        lastFilteredWeight = weightFilter.update(glitchFilter.update(lastWeight));
     } else {
         lastFilteredWeight = lastWeight;
     }
+    
+    return NAU7802_SAMPLE_READY;
 }
 
 void NAU7802Sensor::setGain(uint8_t gain) {
@@ -292,6 +291,45 @@ uint8_t NAU7802Sensor::getSampleRate() const {
     return currentSampleRate;
 }
 
+bool NAU7802Sensor::setAcquisition(uint8_t rate, uint8_t decimationFactor) {
+    if (sampleRateSps(rate) == 0 || decimationFactor == 0 || decimationFactor > NAU7802_MAX_DECIMATION) {
+        return false;
+    }
+    
+    setSampleRate(rate);
+    decimation = decimationFactor;
+    decimationCount = 0;
+    decimationSum = 0;
+    glitchFilter.reset();
+    weightFilter.reset();
+    
+    // The datasheet asks for an AFE calibration after a rate change
+    if (calibrateAFE() != NAU7802_OK) {
+        return false;
+    }
+    
+    debugPrintf("NAU7802: Acquisition %u SPS, decimation %u (%u.%u samples/s)\n",
+        sampleRateSps(rate), decimation,
+        sampleRateSps(rate) / decimation, (sampleRateSps(rate) * 10 / decimation) % 10);
+    return true;
+}
+
+uint16_t NAU7802Sensor::sampleRateSps(uint8_t rate) {
+    switch (rate) {
+        case NAU7802_SPS_10:  return 10;
+        case NAU7802_SPS_20:  return 20;
+        case NAU7802_SPS_40:  return 40;
+        case NAU7802_SPS_80:  return 80;
+        case NAU7802_SPS_320: return 320;
+        default: return 0;
+    }
+}
+
+unsigned long NAU7802Sensor::conversionIntervalMs(uint8_t rate) {
+    uint16_t sps = sampleRateSps(rate);
+    return sps ? (1000 + sps - 1) / sps : 100;  // Rounded up
+}
+
 void NAU7802Sensor::tareScale() {
     debugPrintf("NAU7802: Taring scale...\n");
     
@@ -299,6 +337,7 @@ void NAU7802Sensor::tareScale() {
     long currentReading = getRawReading();
     if (currentReading != 0) {
         zeroOffset = currentReading;
+        scale.setZeroOffset(zeroOffset);
         debugPrintf("NAU7802: Scale tared, new zero offset=%ld\n", zeroOffset);
         saveCalibration();
     }
@@ -306,6 +345,7 @@ void NAU7802Sensor::tareScale() {
 
 void NAU7802Sensor::setZeroOffset(long offset) {
     zeroOffset = offset;
+    scale.setZeroOffset(offset);
     debugPrintf("NAU7802: Zero offset set to %ld\n", offset);
 }
 
@@ -314,44 +354,20 @@ long NAU7802Sensor::getZeroOffset() const {
 }
 
 void NAU7802Sensor::enableFiltering(bool enable, uint8_t samples) {
-    if (enable && samples > 0 && samples <= 50) {
-        if (filterBuffer) {
-            delete[] filterBuffer;
-        }
+    if (enable && samples > 0) {
+        if (samples > NAU7802_FILTER_MAX_SAMPLES) samples = NAU7802_FILTER_MAX_SAMPLES;
         
-        filterBuffer = new float[samples];
-        filterSamples = samples;
-        filterIndex = 0;
-        filterBufferFull = false;
+        weightFilter.setWindow(samples);
+        glitchFilter.reset();
         filteringEnabled = true;
         
         debugPrintf("NAU7802: Filtering enabled with %d samples\n", samples);
     } else {
-        if (filterBuffer) {
-            delete[] filterBuffer;
-            filterBuffer = nullptr;
-        }
         filteringEnabled = false;
         debugPrintf("NAU7802: Filtering disabled\n");
     }
 }
 
-float NAU7802Sensor::getAverageReading(uint8_t samples) {
-    float sum = 0;
-    uint8_t validSamples = 0;
-    
-    for (uint8_t i = 0; i < samples; i++) {
-        if (scale.available()) {
-            float weight = getWeight();
-            sum += weight;
-            validSamples++;
-        }
-        delay(50); // Wait between readings
-    }
-    
-    return validSamples > 0 ? sum / validSamples : 0.0;
-}
-
 void NAU7802Sensor::resetStatistics() {
     totalReadings = 0;
     minReading = 0;
@@ -398,76 +414,83 @@ bool NAU7802Sensor::saveCalibration() {
     calibrationFactor = scale.getCalibrationFactor();
     zeroOffset = scale.getZeroOffset();
     
-    NAU7802CalibrationData data;
-    data.magic = NAU7802_CALIBRATION_MAGIC;
-    data.calibrationFactor = calibrationFactor;
-    data.zeroOffset = zeroOffset;
-    data.gain = currentGain;
-    data.sampleRate = currentSampleRate;
-    
-    // Calculate simple checksum
-    data.checksum = (uint32_t)data.magic + 
-                   (uint32_t)(data.calibrationFactor * 1000) + 
-                   (uint32_t)data.zeroOffset + 
-                   data.gain + data.sampleRate;
-    
-    // Write to EEPROM
-    uint8_t* dataPtr = (uint8_t*)&data;
-    for (size_t i = 0; i < sizeof(data); i++) {
-        EEPROM.write(NAU7802_CALIBRATION_ADDR + i, dataPtr[i]);
-    }
+    storedCalibration.calibrationFactor = calibrationFactor;
+    storedCalibration.zeroOffset = zeroOffset;
+    storedCalibration.gain = currentGain;
+    storedCalibration.sampleRate = currentSampleRate;
+    
+    // Queued only; the config task appends the record in the background
+    if (!g_configLog) return false;
+    g_configLog->bind(CONFIG_KEY_WEIGHT_CALIBRATION, &storedCalibration, sizeof(storedCalibration));
+    g_configLog->commit(CONFIG_KEY_WEIGHT_CALIBRATION);
     
-    debugPrintf("NAU7802: Calibration saved to EEPROM (factor=%.6f, offset=%ld)\n", 
+    debugPrintf("NAU7802: Calibration saved (factor=%.6f, offset=%ld)\n", 
         calibrationFactor, zeroOffset);
     return true;
 }
 
 bool NAU7802Sensor::loadCalibration() {
+    if (!g_configLog) return false;
+    g_configLog->bind(CONFIG_KEY_WEIGHT_CALIBRATION, &storedCalibration, sizeof(storedCalibration));
+    
+    if (g_configLog->load(CONFIG_KEY_WEIGHT_CALIBRATION)) {
+        LOG_INFO("NAU7802: Loading calibration from the config log");
+    } else if (!g_configLog->hasRecord(CONFIG_KEY_WEIGHT_CALIBRATION) && loadLegacyCalibration()) {
+        LOG_INFO("NAU7802: Calibration migrated from the fixed EEPROM image");
+        g_configLog->commit(CONFIG_KEY_WEIGHT_CALIBRATION);
+    } else {
+        LOG_WARN("NAU7802: No valid calibration saved");
+        return false;
+    }
+    
+    applyStoredCalibration();
+    
+    LOG_INFO("NAU7802: Calibration loaded successfully (factor=%.6f, offset=%ld)", 
+        calibrationFactor, zeroOffset);
+    debugSerial("Calibration loaded (factor=%.6f, offset=%ld)\n", 
+        calibrationFactor, zeroOffset);
+    return true;
+}
+
+bool NAU7802Sensor::loadLegacyCalibration() {
     NAU7802CalibrationData data;
     
-    // Read from EEPROM
     uint8_t* dataPtr = (uint8_t*)&data;
     for (size_t i = 0; i < sizeof(data); i++) {
         dataPtr[i] = EEPROM.read(NAU7802_CALIBRATION_ADDR + i);
     }
     
-    // Verify magic number
-    if (data.magic != NAU7802_CALIBRATION_MAGIC) {
-        LOG_WARN("NAU7802: No valid calibration found in EEPROM");
-        debugSerial("Invalid calibration magic in EEPROM\n");
-        return false;
-    }
-    
-    // Verify checksum
     uint32_t calculatedChecksum = (uint32_t)data.magic + 
                                  (uint32_t)(data.calibrationFactor * 1000) + 
                                  (uint32_t)data.zeroOffset + 
                                  data.gain + data.sampleRate;
-    
-    if (data.checksum != calculatedChecksum) {
-        LOG_ERROR("NAU7802: Calibration data corrupted in EEPROM");
-        debugSerial("Calibration checksum mismatch in EEPROM\n");
+    if (data.magic != NAU7802_CALIBRATION_MAGIC || data.checksum != calculatedChecksum) {
         return false;
     }
     
-    // Apply loaded calibration
-    LOG_INFO("NAU7802: Loading calibration from EEPROM");
-    debugSerial("Loading calibration from EEPROM:\n");
-    debugSerial("  Magic: 0x%08X (expected: 0x%08X)\n", data.magic, NAU7802_CALIBRATION_MAGIC);
+    storedCalibration.calibrationFactor = data.calibrationFactor;
+    storedCalibration.zeroOffset = data.zeroOffset;
+    storedCalibration.gain = data.gain;
+    storedCalibration.sampleRate = data.sampleRate;
+    return true;
+}
+
+void NAU7802Sensor::applyStoredCalibration() {
+    const NAU7802Calibration& data = storedCalibration;
     debugSerial("  Factor: %.6f\n", data.calibrationFactor);
-    debugSerial("  Zero offset: %ld\n", data.zeroOffset);
+    debugSerial("  Zero offset: %ld\n", (long)data.zeroOffset);
     debugSerial("  Gain: %d\n", data.gain);
     debugSerial("  Sample rate: %d\n", data.sampleRate);
     
     // Validate calibration factor before applying
     if (isnan(data.calibrationFactor) || isinf(data.calibrationFactor) || data.calibrationFactor == 0.0) {
-        LOG_ERROR("NAU7802: Invalid calibration factor in EEPROM: %.6f", data.calibrationFactor);
-        debugSerial("ERROR: Invalid calibration factor %.6f in EEPROM, using default\n", data.calibrationFactor);
+        LOG_ERROR("NAU7802: Invalid saved calibration factor: %.6f", data.calibrationFactor);
+        debugSerial("ERROR: Invalid calibration factor %.6f, using default\n", data.calibrationFactor);
         calibrationFactor = 1.0;
         isCalibrated = false;
     } else {
         calibrationFactor = data.calibrationFactor;
-        isCalibrated = true;
+        isCalibrated = (calibrationFactor != 1.0);  // A cleared calibration is saved as 1.0
         
         // Set the calibration factor in the library
         scale.setCalibrationFactor(calibrationFactor);
@@ -480,26 +503,19 @@ bool NAU7802Sensor::loadCalibration() {
     
     setGain(data.gain);
     setSampleRate(data.sampleRate);
-    
-    LOG_INFO("NAU7802: Calibration loaded successfully (factor=%.6f, offset=%ld)", 
-        calibrationFactor, zeroOffset);
-    debugSerial("Calibration loaded from EEPROM (factor=%.6f, offset=%ld)\n", 
-        calibrationFactor, zeroOffset);
-    return true;
 }
 
 void NAU7802Sensor::clearCalibration() {
-    // Clear EEPROM by writing zeros
-    for (size_t i = 0; i < sizeof(NAU7802CalibrationData); i++) {
-        EEPROM.write(NAU7802_CALIBRATION_ADDR + i, 0);
-    }
-    
     // Reset to defaults
     calibrationFactor = 1.0;
     zeroOffset = 0;
     isCalibrated = false;
+    scale.setCalibrationFactor(calibrationFactor);
+    scale.setZeroOffset(zeroOffset);
     
-    debugPrintf("NAU7802: Calibration cleared from EEPROM\n");
+    // The cleared values replace the saved record
+    saveCalibration();
+    debugPrintf("NAU7802: Calibration cleared\n");
 }
 
 // Private helper functions
@@ -508,8 +524,12 @@ void NAU7802Sensor::initializeDefaults() {
 }
 
 float NAU7802Sensor::applyCalibration(long rawValue) {
+    // Same as the library's getWeight(): (raw - zero) / factor, no negative weight
+    if (rawValue < zeroOffset) {
+        rawValue = zeroOffset;
+    }
     float adjustedValue = rawValue - zeroOffset;
-    float result = adjustedValue * calibrationFactor;
+    float result = adjustedValue / calibrationFactor;
     
     // Debug: Check for problematic calibration factor
     if (calibrationFactor == 0.0 || isnan(calibrationFactor) || isinf(calibrationFactor)) {
@@ -538,20 +558,6 @@ float NAU7802Sensor::applyCalibration(long rawValue) {
     return result;
 }
 
-void NAU7802Sensor::updateFilter(float value) {
-    if (!filteringEnabled || !filterBuffer) {
-        return;
-    }
-    
-    filterBuffer[filterIndex] = value;
-    filterIndex++;
-    
-    if (filterIndex >= filterSamples) {
-        filterIndex = 0;
-        filterBufferFull = true;
-    }
-}
-
 void NAU7802Sensor::logError(NAU7802Status error, const char* function) {
     debugPrintf("NAU7802 ERROR in %s: %s\n", function, getStatusString());
 }
\ No newline at end of file
@@ -1,9 +1,8 @@
 #include "network_manager.h"
-#include "arduino_secrets.h"
+#include "logger.h"
+#include "response_sink.h"
 #include <string.h>
 
-extern void debugPrintf(const char* fmt, ...);
-
 // Static instance pointer for callback
 static NetworkManager* s_instance = nullptr;
 
@@ -14,28 +13,111 @@ void onMqttMessageStatic(int messageSize) {
     }
 }
 
+bool HandoverClient::open(IPAddress ip, uint16_t port) {
+    stop();
+    opened = transport.connect(ip, port) > 0;
+    return opened;
+}
+
+int HandoverClient::connect(IPAddress ip, uint16_t port) {
+    if (!isOpen() && transport.connect(ip, port) <= 0) return 0;
+    opened = false;
+    handedOver = true;
+    return 1;
+}
+
+int HandoverClient::connect(const char* host, uint16_t port) {
+    if (!isOpen() && transport.connect(host, port) <= 0) return 0;
+    opened = false;
+    handedOver = true;
+    return 1;
+}
+
+void HandoverClient::stop() {
+    opened = false;
+    handedOver = false;
+    transport.stop();
+}
+
 NetworkManager::NetworkManager() : 
-    mqttClient(wifiClient),
+    mqttTransport(wifiClient),
+    mqttClient(mqttTransport),
     wifiState(WiFiState::DISCONNECTED),
     mqttState(MQTTState::DISCONNECTED),
     lastConnectAttempt(0),
     wifiRetries(0),
-    mqttRetries(0),
+    wifiJoin(WiFiJoin::DHCP),
+    staticIpEnabled(false),
+    addressPinned(true),            // The WiFi module may still hold the last boot's address
+    leaseRejected(false),
+    leaseFresh(false),
+    leaseObtainedAt(0),
+    joinStarted(false),
+    wifiAttemptStart(0),
+    leaseCallback(nullptr),
+    leaseContext(nullptr),
+    wifiDownSince(0),
+    wifiTiming(false),
+    lastReconnectMs(0),
+    leaseFallbacks(0),
+    brokerPort(MQTT_BROKER_PORT),
+    dnsLookups(0),
+    dnsFailures(0),
+    mqttPhase(MqttPhase::IDLE),
+    mqttAttempts(0),
+    subscribeStep(0),
+    mqttNextAttempt(0),
+    mqttBackoffMs(0),
     connectionUptime(0),
     disconnectCount(0),
     failedPublishCount(0),
     connectionStable(false),
     syslogPort(SYSLOG_PORT),
     lastSyslogSuccess(false),
-    lastSyslogAttempt(0) {
+    lastSyslogAttempt(0),
+    begun(false),
+    topicNamespace(false),
+    topicPrefixLength(0),
+    controlPending(false),
+    queueCount(0),
+    queueOrder(0),
+    packedMode(false),
+    queuePeak(0),
+    queueCoalesced(0),
+    queueOverflows(0),
+    queueSent(0),
+    packedDocs(0),
+    drainLatencyMaxMs(0),
+    drainLatencyTotalMs(0),
+    drainLatencyEwma8(0) {
+    
+    memset(publishQueue, 0, sizeof(publishQueue));
+    memset(&wifiLease, 0, sizeof(wifiLease));
+    memset(&staticIp, 0, sizeof(staticIp));
+    memset(joinCounts, 0, sizeof(joinCounts));
+    memset(rawSubscribers, 0, sizeof(rawSubscribers));
+    controlCommand[0] = '\0';
+    topicPrefix[0] = '\0';
     
     // Set default syslog server
     strncpy(syslogServer, SYSLOG_SERVER, sizeof(syslogServer) - 1);
     syslogServer[sizeof(syslogServer) - 1] = '\0';
     
-    // Set default hostname
+    // Set default hostname (begin() adds the MAC suffix)
     strncpy(hostname, SYSLOG_HOSTNAME, sizeof(hostname) - 1);
     hostname[sizeof(hostname) - 1] = '\0';
+    mqttClientId[0] = '\0';
+    
+    // Broker defaults from arduino_secrets.h
+    strncpy(brokerHost, MQTT_BROKER_HOST, sizeof(brokerHost) - 1);
+    brokerHost[sizeof(brokerHost) - 1] = '\0';
+    strncpy(brokerUser, MQTT_USER, sizeof(brokerUser) - 1);
+    brokerUser[sizeof(brokerUser) - 1] = '\0';
+    strncpy(brokerPass, MQTT_PASS, sizeof(brokerPass) - 1);
+    brokerPass[sizeof(brokerPass) - 1] = '\0';
+    
+    invalidateHost(syslogAddress, syslogServer);
+    invalidateHost(brokerAddress, brokerHost);
 }
 
 void NetworkManager::begin() {
@@ -44,9 +126,16 @@ void NetworkManager::begin() {
     // Set static instance for callback
     s_instance = this;
     
+    // Unique per device before the name reaches DHCP, syslog and topics
+    buildDeviceIdentity();
+    
     // Set hostname for easier network identification
     WiFi.setHostname(hostname);
     debugPrintf("NetworkManager: Set hostname to '%s'\n", hostname);
+    begun = true;
+    
+    // Fixed for this boot: queued, retained and subscribed topics all agree
+    buildTopicPrefix();
     
     // Initialize UDP client for syslog
     udpClient.begin(0);
@@ -54,7 +143,18 @@ void NetworkManager::begin() {
     // Set MQTT callback
     mqttClient.onMessage(onMqttMessageStatic);
     
-    // Start WiFi connection
+    // Bound each blocking step of the connect sequence
+    wifiClient.setConnectionTimeout(MQTT_TCP_CONNECT_TIMEOUT_MS);
+    mqttClient.setConnectionTimeout(MQTT_CONNACK_TIMEOUT_MS);
+    
+    // The boot join counts as a reconnect; startJoin() begins it
+    wifiDownSince = millis();
+    wifiTiming = true;
+}
+
+void NetworkManager::startJoin() {
+    if (joinStarted) return;
+    joinStarted = true;
     startWiFiConnection();
 }
 
@@ -62,37 +162,285 @@ void NetworkManager::startWiFiConnection() {
     if (wifiState == WiFiState::CONNECTING) return;
     
     wifiState = WiFiState::CONNECTING;
-    debugPrintf("NetworkManager: Connecting to WiFi SSID: %s\n", SECRET_SSID);
+    wifiAttemptStart = millis();
+    applyAddressing();
+    debugPrintf("NetworkManager: Connecting to WiFi SSID: %s (%s)\n", SECRET_SSID,
+        wifiJoin == WiFiJoin::LEASE ? "saved lease" : wifiJoin == WiFiJoin::STATIC ? "static IP" : "DHCP");
     
     WiFi.begin(SECRET_SSID, SECRET_PASS);
 }
 
-void NetworkManager::startMQTTConnection() {
-    if (mqttState == MQTTState::CONNECTING || wifiState != WiFiState::CONNECTED) return;
+static IPAddress toIPAddress(const uint8_t* octets) {
+    return IPAddress(octets[0], octets[1], octets[2], octets[3]);
+}
+
+static void fromIPAddress(uint8_t* octets, IPAddress address) {
+    for (uint8_t i = 0; i < 4; i++) octets[i] = address[i];
+}
+
+void NetworkManager::applyAddressing() {
+    if (staticIpEnabled) {
+        wifiJoin = WiFiJoin::STATIC;
+    } else if (wifiLease.valid && leaseFresh && !leaseRejected &&
+               millis() - leaseObtainedAt < WIFI_LEASE_MAX_AGE_MS) {
+        wifiJoin = WiFiJoin::LEASE;
+    } else {
+        wifiJoin = WiFiJoin::DHCP;
+    }
+    
+    if (wifiJoin == WiFiJoin::DHCP) {
+        // WiFiS3 passes the addresses to the module's WiFi.config() (ESP32
+        // core), which restarts its DHCP client when the local IP is 0.0.0.0.
+        // All four are zeroed: the one-argument form derives a gateway.
+        if (addressPinned) {
+            IPAddress none(0, 0, 0, 0);
+            WiFi.config(none, none, none, none);
+            addressPinned = false;
+        }
+        return;
+    }
+    
+    // A fixed address skips the DHCP exchange on join
+    const IpSettings& settings = wifiJoin == WiFiJoin::STATIC ? staticIp : wifiLease.address;
+    WiFi.config(toIPAddress(settings.ip), toIPAddress(settings.dns),
+                toIPAddress(settings.gateway), toIPAddress(settings.subnet));
+    addressPinned = true;
+}
+
+void NetworkManager::learnLease() {
+    // Only a DHCP join hands out a lease; its age starts now
+    if (wifiJoin != WiFiJoin::DHCP) return;
+    leaseFresh = true;
+    leaseObtainedAt = millis();
     
-    mqttState = MQTTState::CONNECTING;
-    debugPrintf("NetworkManager: Connecting to MQTT broker: %s:%d\n", MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+    WiFiLease lease;
+    memset(&lease, 0, sizeof(lease));
+    uint8_t bssid[6];
+    WiFi.BSSID(bssid);
+    
+    // BSSID() reports the bytes last to first
+    for (uint8_t i = 0; i < 6; i++) lease.bssid[i] = bssid[5 - i];
+    fromIPAddress(lease.address.ip, WiFi.localIP());
+    fromIPAddress(lease.address.gateway, WiFi.gatewayIP());
+    fromIPAddress(lease.address.subnet, WiFi.subnetMask());
+    fromIPAddress(lease.address.dns, WiFi.dnsIP());
+    lease.valid = 1;
+    
+    // Persisted only when the address or AP changed, not on every join
+    if (memcmp(&lease, &wifiLease, sizeof(lease)) == 0) return;
+    wifiLease = lease;
+    if (leaseCallback) leaseCallback(leaseContext, wifiLease);
+}
+
+void NetworkManager::setWiFiLease(const WiFiLease& lease) {
+    wifiLease = lease;
+}
+
+void NetworkManager::setStaticIp(const IpSettings* settings) {
+    staticIpEnabled = settings != nullptr;
+    if (settings) staticIp = *settings;
+}
+
+void NetworkManager::setWiFiLeaseCallback(WiFiLeaseFn callback, void* context) {
+    leaseCallback = callback;
+    leaseContext = context;
+}
+
+void NetworkManager::invalidateHost(ResolvedHost& entry, const char* host) {
+    // A dotted quad needs no lookup and never expires
+    entry.literal = entry.address.fromString(host);
+    if (!entry.literal) entry.address = IPAddress(0, 0, 0, 0);
+    entry.valid = entry.literal;
+    entry.expiresAt = millis();
+    entry.retryAt = entry.expiresAt;
+}
+
+bool NetworkManager::lookupDue(const ResolvedHost& entry, const char* host, unsigned long now) const {
+    return host[0] != '\0' && !entry.literal &&
+           (long)(now - entry.expiresAt) >= 0 && (long)(now - entry.retryAt) >= 0;
+}
+
+bool NetworkManager::resolveHost(ResolvedHost& entry, const char* host, unsigned long now) {
+    IPAddress address;
+    dnsLookups++;
     
-    mqttClient.setId("LogMonitor");
-    mqttClient.setUsernamePassword(MQTT_USER, MQTT_PASS);
+    if (WiFi.hostByName(host, address) == 1 && address != IPAddress(0, 0, 0, 0)) {
+        if (!entry.valid || entry.address != address) {
+            debugPrintf("NetworkManager: %s resolved to %s\n", host, address.toString().c_str());
+        }
+        entry.address = address;
+        entry.valid = true;
+        entry.expiresAt = now + DNS_CACHE_TTL_MS;
+        return true;
+    }
     
-    if (mqttClient.connect(MQTT_BROKER_HOST, MQTT_BROKER_PORT)) {
-        mqttState = MQTTState::CONNECTED;
-        debugPrintf("NetworkManager: MQTT connected successfully\n");
+    // Keep serving a previous address; the name may only be briefly unresolvable
+    dnsFailures++;
+    entry.retryAt = now + DNS_RETRY_INTERVAL_MS;
+    debugPrintf("NetworkManager: DNS lookup for %s failed%s\n", host,
+        entry.valid ? ", keeping cached address" : "");
+    return false;
+}
+
+bool NetworkManager::serviceResolver(unsigned long now) {
+    // At most one lookup per pass, broker first
+    if (lookupDue(brokerAddress, brokerHost, now)) {
+        resolveHost(brokerAddress, brokerHost, now);
+        return true;
+    }
+    if (lookupDue(syslogAddress, syslogServer, now)) {
+        resolveHost(syslogAddress, syslogServer, now);
+        return true;
+    }
+    return false;
+}
+
+void NetworkManager::serviceMqttConnection(unsigned long now) {
+    switch (mqttPhase) {
+        case MqttPhase::IDLE:
+            if ((long)(now - mqttNextAttempt) < 0) return;
+            
+            mqttState = MQTTState::CONNECTING;
+            mqttPhase = MqttPhase::TCP_CONNECT;
+            debugPrintf("NetworkManager: MQTT attempt %u to %s:%u\n",
+                mqttAttempts + 1, brokerHost, brokerPort);
+            return;
         
-        // Subscribe to control topic
-        mqttClient.subscribe(TOPIC_MONITOR_CONTROL);
-        debugPrintf("NetworkManager: Subscribed to %s\n", TOPIC_MONITOR_CONTROL);
+        case MqttPhase::TCP_CONNECT:
+            if (!brokerAddress.valid) {
+                failMqttConnection(now, "DNS lookup");
+                return;
+            }
+            if (!mqttTransport.open(brokerAddress.address, brokerPort)) {
+                // The broker may have moved - look the name up again first
+                if (!brokerAddress.literal) brokerAddress.expiresAt = now;
+                failMqttConnection(now, "TCP connect");
+                return;
+            }
+            mqttPhase = MqttPhase::MQTT_CONNECT;
+            return;
+        
+        case MqttPhase::MQTT_CONNECT:
+            // Socket dropped while waiting for this pass
+            if (!mqttTransport.isOpen()) {
+                failMqttConnection(now, "TCP connect");
+                return;
+            }
+            
+            mqttClient.setId(mqttClientId);
+            mqttClient.setUsernamePassword(brokerUser, brokerPass);
+            if (!mqttClient.connect(brokerAddress.address, brokerPort)) {
+                failMqttConnection(now, "CONNECT");
+                return;
+            }
+            subscribeStep = 0;
+            mqttPhase = MqttPhase::SUBSCRIBE;
+            return;
         
-        // Reset retry counter on successful connection
-        mqttRetries = 0;
+        case MqttPhase::SUBSCRIBE:
+            if (!mqttClient.connected() || !subscribeNext()) {
+                failMqttConnection(now, "SUBSCRIBE");
+                return;
+            }
+            if (mqttPhase == MqttPhase::ONLINE) {
+                mqttState = MQTTState::CONNECTED;
+                mqttAttempts = 0;
+                debugPrintf("NetworkManager: MQTT connected successfully\n");
+            }
+            return;
+        
+        case MqttPhase::ONLINE:
+            if (!mqttClient.connected()) {
+                stopMqtt();
+                disconnectCount++;
+                connectionStable = false;
+                debugPrintf("NetworkManager: MQTT disconnected\n");
+                scheduleMqttRetry(now);
+            }
+            return;
+    }
+}
+
+bool NetworkManager::subscribeNext() {
+    const char* topic = nullptr;
+    
+    if (subscribeStep == 0) {
+        topic = TOPIC_MONITOR_CONTROL;
     } else {
-        mqttState = MQTTState::FAILED;
-        debugPrintf("NetworkManager: MQTT connection failed\n");
+        // Steps 1..RAW_SUB_COUNT: raw slots, unused ones skipped
+        while (subscribeStep <= RAW_SUB_COUNT && !rawSubscribers[subscribeStep - 1].topic) {
+            subscribeStep++;
+        }
+        if (subscribeStep <= RAW_SUB_COUNT) topic = rawSubscribers[subscribeStep - 1].topic;
     }
+    
+    if (!topic) {
+        mqttPhase = MqttPhase::ONLINE;
+        return true;
+    }
+    
+    if (!mqttClient.subscribe(wireTopic(topic))) return false;
+    debugPrintf("NetworkManager: Subscribed to %s%s\n", topicPrefix, topic);
+    
+    subscribeStep++;
+    return true;
+}
+
+void NetworkManager::failMqttConnection(unsigned long now, const char* stage) {
+    stopMqtt();
+    mqttState = MQTTState::FAILED;
+    if (mqttAttempts < 255) mqttAttempts++;
+    scheduleMqttRetry(now);
+    debugPrintf("NetworkManager: MQTT %s failed (attempt %u), retry in %lums\n",
+        stage, mqttAttempts, mqttBackoffMs);
+}
+
+void NetworkManager::scheduleMqttRetry(unsigned long now) {
+    // MQTT_RECONNECT_INTERVAL_MS doubled per failed attempt, capped
+    unsigned long delayMs = MQTT_RECONNECT_INTERVAL_MS;
+    for (uint8_t i = 1; i < mqttAttempts && delayMs < MQTT_BACKOFF_MAX_MS; i++) {
+        delayMs *= 2;
+    }
+    if (delayMs > MQTT_BACKOFF_MAX_MS) delayMs = MQTT_BACKOFF_MAX_MS;
+    
+    // Jitter keeps devices that lost the same broker from retrying in step
+    unsigned long spread = delayMs * MQTT_BACKOFF_JITTER_PERCENT / 100;
+    delayMs = delayMs - spread + (unsigned long)random((long)(2 * spread + 1));
+    
+    mqttBackoffMs = delayMs;
+    mqttNextAttempt = now + delayMs;
+}
+
+void NetworkManager::stopMqtt() {
+    // Also closes the transport, opened or handed over
+    mqttClient.stop();
+    mqttPhase = MqttPhase::IDLE;
+    mqttState = MQTTState::DISCONNECTED;
+}
+
+bool NetworkManager::setRawSubscription(uint8_t slot, const char* topic, RawMessageFn callback, void* context) {
+    if (slot >= RAW_SUB_COUNT) return false;
+    
+    bool connected = mqttState == MQTTState::CONNECTED;
+    RawSubscriber& subscriber = rawSubscribers[slot];
+    
+    if (subscriber.topic && connected && (!topic || strcmp(topic, subscriber.topic) != 0)) {
+        mqttClient.unsubscribe(wireTopic(subscriber.topic));
+    }
+    
+    subscriber.topic = topic;
+    subscriber.callback = callback;
+    subscriber.context = context;
+    
+    // Otherwise the SUBSCRIBE step picks it up on the next connect
+    if (topic && connected) {
+        return mqttClient.subscribe(wireTopic(topic));
+    }
+    return true;
 }
 
 void NetworkManager::update() {
+    if (!joinStarted) return;
     unsigned long now = millis();
     bool attemptedConnection = false;
     
@@ -101,26 +449,42 @@ void NetworkManager::update() {
         if (wifiState != WiFiState::CONNECTED) {
             wifiState = WiFiState::CONNECTED;
             wifiRetries = 0;
-            debugPrintf("NetworkManager: WiFi connected - IP: %s\n", WiFi.localIP().toString().c_str());
+            leaseRejected = false;
+            joinCounts[(uint8_t)wifiJoin]++;
+            if (wifiTiming) {
+                lastReconnectMs = now - wifiDownSince;
+                reconnectMs.update(lastReconnectMs);
+                wifiTiming = false;
+            }
+            learnLease();
+            debugPrintf("NetworkManager: WiFi connected - IP: %s in %lums\n",
+                WiFi.localIP().toString().c_str(), lastReconnectMs);
+            
+            // Association time varies per device, so the MQTT backoff jitter does too
+            randomSeed(micros());
         }
     } else {
         if (wifiState == WiFiState::CONNECTED) {
             wifiState = WiFiState::DISCONNECTED;
-            mqttState = MQTTState::DISCONNECTED;
+            stopMqtt();
             disconnectCount++;
             connectionStable = false;
+            wifiDownSince = now;
+            wifiTiming = true;
             debugPrintf("NetworkManager: WiFi disconnected (total: %d)\n", disconnectCount);
         }
-    }
-    
-    // Check MQTT status
-    if (wifiState == WiFiState::CONNECTED) {
-        if (!mqttClient.connected()) {
-            if (mqttState == MQTTState::CONNECTED) {
-                mqttState = MQTTState::DISCONNECTED;
-                disconnectCount++;
-                connectionStable = false;
-                debugPrintf("NetworkManager: MQTT disconnected\n");
+        else if (wifiState == WiFiState::CONNECTING) {
+            unsigned long timeout = wifiJoin == WiFiJoin::DHCP ? WIFI_CONNECT_TIMEOUT_MS : WIFI_LEASE_CONNECT_TIMEOUT_MS;
+            if (now - wifiAttemptStart >= timeout) {
+                wifiState = WiFiState::FAILED;
+                debugPrintf("NetworkManager: WiFi join timed out after %lums\n", now - wifiAttemptStart);
+                
+                // The saved lease may be gone (other AP, expired): DHCP right away
+                if (wifiJoin == WiFiJoin::LEASE) {
+                    leaseRejected = true;
+                    leaseFallbacks++;
+                    lastConnectAttempt = now - MQTT_RECONNECT_INTERVAL_MS;
+                }
             }
         }
     }
@@ -143,24 +507,6 @@ void NetworkManager::update() {
             startWiFiConnection();
             attemptedConnection = true;
         }
-        // MQTT reconnection logic (only if WiFi is connected)
-        else if (wifiState == WiFiState::CONNECTED) {
-            if (mqttState == MQTTState::DISCONNECTED && mqttRetries < MAX_MQTT_RETRIES) {
-                lastConnectAttempt = now;
-                mqttRetries++;
-                debugPrintf("NetworkManager: MQTT attempt %d/%d\n", mqttRetries, MAX_MQTT_RETRIES);
-                startMQTTConnection();
-                attemptedConnection = true;
-            }
-            else if (mqttState == MQTTState::FAILED && mqttRetries < MAX_MQTT_RETRIES) {
-                lastConnectAttempt = now;
-                mqttRetries++;
-                debugPrintf("NetworkManager: MQTT retry %d/%d\n", mqttRetries, MAX_MQTT_RETRIES);
-                mqttState = MQTTState::DISCONNECTED;
-                startMQTTConnection();
-                attemptedConnection = true;
-            }
-        }
         
         // Reset retry counters after extended wait period
         if (!attemptedConnection && wifiRetries >= MAX_WIFI_RETRIES && 
@@ -168,11 +514,12 @@ void NetworkManager::update() {
             debugPrintf("NetworkManager: Resetting WiFi retry count after extended wait\n");
             wifiRetries = 0;
         }
-        if (!attemptedConnection && mqttRetries >= MAX_MQTT_RETRIES && 
-            now - lastConnectAttempt >= (MQTT_RECONNECT_INTERVAL_MS * 2)) {
-            debugPrintf("NetworkManager: Resetting MQTT retry count after extended wait\n");
-            mqttRetries = 0;
-        }
+    }
+    
+    // Lookups and the MQTT connect sequence (only if WiFi is connected);
+    // a pass that waited on the resolver leaves the next step for later
+    if (wifiState == WiFiState::CONNECTED && !serviceResolver(now)) {
+        serviceMqttConnection(now);
     }
     
     // Update connection health and stability
@@ -186,6 +533,9 @@ void NetworkManager::update() {
         if (pollDuration > 100) {
             debugPrintf("NetworkManager: WARNING: MQTT poll took %lums\n", pollDuration);
         }
+        
+        // Send queued publishes within the per-update time budget
+        drainPublishQueue(MQTT_QUEUE_DRAIN_BUDGET_MS);
     }
 }
 
@@ -210,6 +560,29 @@ void NetworkManager::updateConnectionHealth() {
 }
 
 bool NetworkManager::publish(const char* topic, const char* payload) {
+    return enqueuePublish(topic, payload, false);
+}
+
+bool NetworkManager::publishWithRetain(const char* topic, const char* payload) {
+    return enqueuePublish(topic, payload, true);
+}
+
+bool NetworkManager::publishImmediate(const char* topic, const char* payload) {
+    // A queued older value would otherwise go out after this one
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        QueuedPublish& entry = publishQueue[i];
+        if (entry.used && !entry.retain && strcmp(entry.topic, topic) == 0) {
+            entry.used = false;
+            queueCount--;
+            queueCoalesced++;
+            break;
+        }
+    }
+    
+    return publishNow(topic, payload, false);
+}
+
+bool NetworkManager::publishNow(const char* topic, const char* payload, bool retain) {
     if (mqttState != MQTTState::CONNECTED) {
         failedPublishCount++;
         return false;
@@ -218,7 +591,7 @@ bool NetworkManager::publish(const char* topic, const char* payload) {
     // Timeout protection - ensure publish doesn't block
     unsigned long startTime = millis();
     
-    if (mqttClient.beginMessage(topic)) {
+    if (mqttClient.beginMessage(wireTopic(topic), retain)) {
         mqttClient.print(payload);
         bool success = mqttClient.endMessage();
         
@@ -237,26 +610,208 @@ bool NetworkManager::publish(const char* topic, const char* payload) {
     }
 }
 
-bool NetworkManager::publishWithRetain(const char* topic, const char* payload) {
+bool NetworkManager::enqueuePublish(const char* topic, const char* payload, bool retain) {
     if (mqttState != MQTTState::CONNECTED) {
         failedPublishCount++;
         return false;
     }
     
-    if (mqttClient.beginMessage(topic, true)) { // true = retain
-        mqttClient.print(payload);
-        bool success = mqttClient.endMessage();
-        if (!success) {
-            failedPublishCount++;
+    // Oversized messages do not fit a slot - send them straight through
+    if (strlen(topic) >= MQTT_QUEUE_TOPIC_SIZE || strlen(payload) >= MQTT_QUEUE_PAYLOAD_SIZE) {
+        return publishNow(topic, payload, retain);
+    }
+    
+    // Last-value coalescing: a newer value for a queued topic replaces the old one
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        QueuedPublish& entry = publishQueue[i];
+        if (entry.used && entry.retain == retain && strcmp(entry.topic, topic) == 0) {
+            strcpy(entry.payload, payload);
+            queueCoalesced++;
+            return true;
         }
-        return success;
+    }
+    
+    // Queue full - send the oldest entry now to make room
+    if (queueCount >= MQTT_QUEUE_DEPTH) {
+        int8_t oldest = findOldestQueued();
+        if (oldest >= 0) {
+            sendQueued((uint8_t)oldest);
+        }
+        queueOverflows++;
+    }
+    
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        QueuedPublish& entry = publishQueue[i];
+        if (!entry.used) {
+            strcpy(entry.topic, topic);
+            strcpy(entry.payload, payload);
+            entry.enqueuedAt = millis();
+            entry.order = queueOrder++;
+            entry.retain = retain;
+            entry.used = true;
+            queueCount++;
+            if (queueCount > queuePeak) {
+                queuePeak = queueCount;
+            }
+            return true;
+        }
+    }
+    
+    // Should not happen (a slot was freed above); fall back to a direct send
+    return publishNow(topic, payload, retain);
+}
+
+int8_t NetworkManager::findOldestQueued() const {
+    int8_t oldest = -1;
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        if (publishQueue[i].used &&
+            (oldest < 0 || (int32_t)(publishQueue[i].order - publishQueue[oldest].order) < 0)) {
+            oldest = (int8_t)i;
+        }
+    }
+    return oldest;
+}
+
+void NetworkManager::releaseQueued(uint8_t index) {
+    QueuedPublish& entry = publishQueue[index];
+    unsigned long latency = millis() - entry.enqueuedAt;
+    if (latency > drainLatencyMaxMs) {
+        drainLatencyMaxMs = latency;
+    }
+    drainLatencyTotalMs += latency;
+    drainLatencyEwma8 += latency - drainLatencyEwma8 / 8;
+    queueSent++;
+    
+    entry.used = false;
+    if (queueCount > 0) {
+        queueCount--;
+    }
+}
+
+bool NetworkManager::sendQueued(uint8_t index) {
+    QueuedPublish& entry = publishQueue[index];
+    if (packedMode && !entry.retain) {
+        return sendPackedGroup(index);
+    }
+    
+    bool success = publishNow(entry.topic, entry.payload, entry.retain);
+    releaseQueued(index);
+    return success;
+}
+
+// True if the payload can be emitted as a bare JSON number: digits on both
+// sides of any decimal point and no leading zeros (".5", "1." and "01" are quoted)
+static bool isJsonNumber(const char* value) {
+    const char* p = value;
+    if (*p == '-') p++;
+    if (*p == '0') {
+        p++;
+    } else if (*p >= '1' && *p <= '9') {
+        while (*p >= '0' && *p <= '9') p++;
     } else {
-        failedPublishCount++;
         return false;
     }
+    if (*p == '.') {
+        p++;
+        if (*p < '0' || *p > '9') return false;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    return *p == '\0';
+}
+
+bool NetworkManager::sendPackedGroup(uint8_t index) {
+    // Subsystem = topic up to the last '/', e.g. monitor/power/voltage -> monitor/power
+    const char* lastSlash = strrchr(publishQueue[index].topic, '/');
+    if (!lastSlash) {
+        bool success = publishNow(publishQueue[index].topic, publishQueue[index].payload, false);
+        releaseQueued(index);
+        return success;
+    }
+    
+    size_t prefixLen = lastSlash - publishQueue[index].topic;
+    char docTopic[MQTT_QUEUE_TOPIC_SIZE + 8];
+    snprintf(docTopic, sizeof(docTopic), "%.*s%s", (int)prefixLen, publishQueue[index].topic, MQTT_PACKED_TOPIC_SUFFIX);
+    
+    char doc[MQTT_PACKED_DOC_SIZE];
+    size_t len = 0;
+    doc[len++] = '{';
+    
+    uint32_t included = 0;  // Bitmask of slots in this document
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        QueuedPublish& entry = publishQueue[i];
+        if (!entry.used || entry.retain) continue;
+        if (strncmp(entry.topic, publishQueue[index].topic, prefixLen) != 0) continue;
+        if (entry.topic[prefixLen] != '/' || strchr(entry.topic + prefixLen + 1, '/')) continue;
+        
+        const char* key = entry.topic + prefixLen + 1;
+        bool number = isJsonNumber(entry.payload);
+        
+        // Worst case: separator + quoted key + colon + fully escaped quoted value + closing brace
+        size_t needed = 1 + strlen(key) + 3 + (number ? strlen(entry.payload) : strlen(entry.payload) * 2 + 2) + 2;
+        if (len + needed >= sizeof(doc)) {
+            if (included == 0) {
+                // Single value too big for a document - send it unpacked
+                bool success = publishNow(entry.topic, entry.payload, false);
+                releaseQueued(i);
+                return success;
+            }
+            break;  // Remaining fields go in the next document
+        }
+        
+        if (included) doc[len++] = ',';
+        len += snprintf(doc + len, sizeof(doc) - len, "\"%s\":", key);
+        if (number) {
+            len += snprintf(doc + len, sizeof(doc) - len, "%s", entry.payload);
+        } else {
+            doc[len++] = '"';
+            for (const char* c = entry.payload; *c; c++) {
+                if (*c == '"' || *c == '\\') doc[len++] = '\\';
+                doc[len++] = *c;
+            }
+            doc[len++] = '"';
+        }
+        included |= (1UL << i);
+    }
+    doc[len++] = '}';
+    doc[len] = '\0';
+    
+    bool success = publishNow(docTopic, doc, false);
+    for (uint8_t i = 0; i < MQTT_QUEUE_DEPTH; i++) {
+        if (included & (1UL << i)) {
+            releaseQueued(i);
+        }
+    }
+    packedDocs++;
+    return success;
 }
 
-bool NetworkManager::publishBinary(const char* topic, uint8_t* data, size_t length) {
+void NetworkManager::drainPublishQueue(unsigned long budgetMs) {
+    unsigned long start = millis();
+    while (queueCount > 0 && mqttState == MQTTState::CONNECTED) {
+        int8_t oldest = findOldestQueued();
+        if (oldest < 0) break;
+        sendQueued((uint8_t)oldest);
+        
+        if (budgetMs > 0 && millis() - start >= budgetMs) {
+            break;  // Leave the rest for the next update()
+        }
+    }
+}
+
+void NetworkManager::flushPublishQueue() {
+    drainPublishQueue(0);
+}
+
+void NetworkManager::setPackedMode(bool enabled) {
+    if (packedMode == enabled) return;
+    
+    // Send what is queued in the old format before switching
+    flushPublishQueue();
+    packedMode = enabled;
+    debugPrintf("NetworkManager: Packed publish mode %s\n", enabled ? "enabled" : "disabled");
+}
+
+bool NetworkManager::publishBinary(const char* topic, const uint8_t* data, size_t length) {
     if (mqttState != MQTTState::CONNECTED) {
         failedPublishCount++;
         return false;
@@ -265,7 +820,7 @@ bool NetworkManager::publishBinary(const char* topic, uint8_t* data, size_t leng
     // Timeout protection for binary data
     unsigned long startTime = millis();
     
-    if (mqttClient.beginMessage(topic)) {
+    if (mqttClient.beginMessage(wireTopic(topic))) {
         // Write binary data directly
         size_t written = mqttClient.write(data, length);
         bool success = mqttClient.endMessage();
@@ -291,30 +846,45 @@ bool NetworkManager::publishBinary(const char* topic, uint8_t* data, size_t leng
 }
 
 bool NetworkManager::sendSyslog(const char* message, int level) {
-    lastSyslogAttempt = millis();
-    
-    if (!isWiFiConnected() || strlen(syslogServer) == 0) {
-        lastSyslogSuccess = false;
-        return false;
-    }
-    
+    char syslogMessage[SYSLOG_DATAGRAM_SIZE];
+    int length = formatSyslogLine(syslogMessage, sizeof(syslogMessage), level, millis(), message);
+    if (length < 0) length = 0;
+    if ((size_t)length >= sizeof(syslogMessage)) length = sizeof(syslogMessage) - 1;
+    return sendSyslogDatagram(syslogMessage, length);
+}
+
+bool NetworkManager::canSendSyslog() const {
+    return isWiFiConnected() && syslogAddress.valid;
+}
+
+int NetworkManager::formatSyslogLine(char* buffer, size_t bufferSize, int level, unsigned long timestamp, const char* message) const {
     // Validate severity level (0-7 per RFC 3164)
     if (level < 0 || level > 7) {
         level = 6; // Default to INFO if invalid
     }
     
-    // RFC 3164 syslog format: <PRI>TIMESTAMP HOSTNAME TAG: MESSAGE
+    // RFC 3164 syslog format: <PRI>HOSTNAME TAG: MESSAGE (no wall clock, so
+    // the collector stamps receipt; the message starts with the uptime in
+    // ms when it was logged, like the Serial output)
     // PRI = Facility * 8 + Severity
     // Using SYSLOG_FACILITY (16 = local0) from constants.h
     int priority = SYSLOG_FACILITY * 8 + level;
     
-    char syslogMessage[512];
-    snprintf(syslogMessage, sizeof(syslogMessage), 
-        "<%d>%s %s: %s", priority, hostname, SYSLOG_TAG, message);
+    return snprintf(buffer, bufferSize, 
+        "<%d>%s %s: [%lu] %s", priority, hostname, SYSLOG_TAG, timestamp, message);
+}
+
+bool NetworkManager::sendSyslogDatagram(const char* data, size_t length) {
+    lastSyslogAttempt = millis();
     
-    // Send UDP packet to syslog server
-    if (udpClient.beginPacket(syslogServer, syslogPort)) {
-        udpClient.print(syslogMessage);
+    if (!canSendSyslog()) {
+        lastSyslogSuccess = false;
+        return false;
+    }
+    
+    // One UDP packet; batched lines are LF separated
+    if (udpClient.beginPacket(syslogAddress.address, syslogPort)) {
+        udpClient.write((const uint8_t*)data, length);
         bool success = udpClient.endPacket();
         lastSyslogSuccess = success;
         return success;
@@ -328,57 +898,49 @@ void NetworkManager::setSyslogServer(const char* server, int port) {
     strncpy(syslogServer, server, sizeof(syslogServer) - 1);
     syslogServer[sizeof(syslogServer) - 1] = '\0';
     syslogPort = port;
+    invalidateHost(syslogAddress, syslogServer);
     debugPrintf("NetworkManager: Syslog server set to %s:%d\n", syslogServer, syslogPort);
 }
 
 void NetworkManager::setMQTTBroker(const char* broker, int port) {
-    // Use reconfigureMQTT with empty username/password to update broker
-    reconfigureMQTT(broker, port, "", "");
+    // Same credentials, new broker
+    reconfigureMQTT(broker, port, brokerUser, brokerPass);
 }
 
 bool NetworkManager::reconfigureMQTT(const char* brokerHost, int brokerPort, const char* username, const char* password) {
     debugPrintf("NetworkManager: Reconfiguring MQTT to %s:%d\n", brokerHost, brokerPort);
     
-    // Disconnect current MQTT connection
-    if (mqttState == MQTTState::CONNECTED) {
-        mqttClient.stop();
-        mqttState = MQTTState::DISCONNECTED;
+    // Disconnect current MQTT connection (or abandon a connect in progress)
+    if (mqttPhase != MqttPhase::IDLE) {
+        stopMqtt();
         debugPrintf("NetworkManager: Disconnected from current MQTT broker\n");
     }
     
-    // Reset connection state
-    mqttRetries = 0;
+    // setMQTTBroker() passes our own buffers back in
+    if (this->brokerHost != brokerHost) {
+        strncpy(this->brokerHost, brokerHost, sizeof(this->brokerHost) - 1);
+        this->brokerHost[sizeof(this->brokerHost) - 1] = '\0';
+    }
+    this->brokerPort = (uint16_t)brokerPort;
+    if (brokerUser != username) {
+        strncpy(brokerUser, username, sizeof(brokerUser) - 1);
+        brokerUser[sizeof(brokerUser) - 1] = '\0';
+    }
+    if (brokerPass != password) {
+        strncpy(brokerPass, password, sizeof(brokerPass) - 1);
+        brokerPass[sizeof(brokerPass) - 1] = '\0';
+    }
+    invalidateHost(brokerAddress, this->brokerHost);
     
-    // Update credentials (in a real implementation, these would be stored securely)
-    // For now, we'll log the configuration change
-    debugPrintf("NetworkManager: MQTT credentials updated for %s\n", brokerHost);
+    // New broker, no backoff: update() starts on the next pass
+    mqttAttempts = 0;
+    mqttNextAttempt = millis();
     
-    // Attempt new connection
-    if (isWiFiConnected()) {
-        mqttState = MQTTState::CONNECTING;
-        debugPrintf("NetworkManager: Attempting connection to new MQTT broker\n");
-        
-        mqttClient.setId("LogMonitor");
-        mqttClient.setUsernamePassword(username, password);
-        
-        if (mqttClient.connect(brokerHost, brokerPort)) {
-            mqttState = MQTTState::CONNECTED;
-            debugPrintf("NetworkManager: Successfully connected to new MQTT broker\n");
-            
-            // Re-subscribe to control topic
-            mqttClient.subscribe(TOPIC_MONITOR_CONTROL);
-            debugPrintf("NetworkManager: Re-subscribed to %s\n", TOPIC_MONITOR_CONTROL);
-            
-            return true;
-        } else {
-            mqttState = MQTTState::FAILED;
-            debugPrintf("NetworkManager: Failed to connect to new MQTT broker\n");
-            return false;
-        }
+    if (!isWiFiConnected()) {
+        debugPrintf("NetworkManager: WiFi not connected, MQTT reconfiguration deferred\n");
+        return false;
     }
-    
-    debugPrintf("NetworkManager: WiFi not connected, MQTT reconfiguration deferred\n");
-    return false;
+    return true;
 }
 
 bool NetworkManager::reconfigureSyslog(const char* server, int port) {
@@ -394,6 +956,11 @@ bool NetworkManager::reconfigureSyslog(const char* server, int port) {
         // Apply new configuration
         setSyslogServer(server, port);
         
+        // The test below needs the address now, not on a later update()
+        if (lookupDue(syslogAddress, syslogServer, millis())) {
+            resolveHost(syslogAddress, syslogServer, millis());
+        }
+        
         // Test the new configuration
         bool testResult = sendSyslog("SYSLOG RECONFIGURATION TEST - LogSplitter Monitor", 6);
         
@@ -424,23 +991,34 @@ bool NetworkManager::reconfigureWiFi(const char* ssid, const char* password) {
     }
     
     // Also disconnect MQTT since WiFi is changing
-    if (mqttState == MQTTState::CONNECTED) {
-        mqttClient.stop();
-        mqttState = MQTTState::DISCONNECTED;
+    if (mqttPhase != MqttPhase::IDLE) {
+        stopMqtt();
         debugPrintf("NetworkManager: Disconnected MQTT due to WiFi change\n");
     }
     
     // Reset connection states
     wifiState = WiFiState::DISCONNECTED;
     wifiRetries = 0;
-    mqttRetries = 0;
+    mqttAttempts = 0;
+    mqttNextAttempt = millis();
+    
+    // Names may resolve differently on the new network
+    invalidateHost(syslogAddress, syslogServer);
+    invalidateHost(brokerAddress, brokerHost);
     connectionStable = false;
     
     // Update credentials (in a real implementation, these would be stored in arduino_secrets.h)
     debugPrintf("NetworkManager: WiFi credentials updated\n");
     
+    // The saved lease belongs to the old network
+    wifiLease.valid = 0;
+    
     // Attempt connection with new credentials
     wifiState = WiFiState::CONNECTING;
+    wifiAttemptStart = millis();
+    wifiDownSince = wifiAttemptStart;
+    wifiTiming = true;
+    applyAddressing();
     debugPrintf("NetworkManager: Attempting connection to new WiFi network\n");
     
     WiFi.begin(ssid, password);
@@ -451,8 +1029,8 @@ bool NetworkManager::reconfigureWiFi(const char* ssid, const char* password) {
         delay(100);
     }
     
+    // update() completes the join (lease, reconnect time)
     if (WiFi.status() == WL_CONNECTED) {
-        wifiState = WiFiState::CONNECTED;
         debugPrintf("NetworkManager: Successfully connected to new WiFi network\n");
         debugPrintf("NetworkManager: New IP address: %s\n", WiFi.localIP().toString().c_str());
         return true;
@@ -464,9 +1042,13 @@ bool NetworkManager::reconfigureWiFi(const char* ssid, const char* password) {
 }
 
 void NetworkManager::setHostname(const char* newHostname) {
+    if (!newHostname || newHostname[0] == '\0') return;
+    
     strncpy(hostname, newHostname, sizeof(hostname) - 1);
     hostname[sizeof(hostname) - 1] = '\0';
-    WiFi.setHostname(hostname);
+    
+    // Before begin() the name is applied there, with the modem up
+    if (begun) WiFi.setHostname(hostname);
     debugPrintf("NetworkManager: Hostname set to '%s'\n", hostname);
 }
 
@@ -474,6 +1056,59 @@ const char* NetworkManager::getHostname() const {
     return hostname;
 }
 
+void NetworkManager::buildDeviceIdentity() {
+    // The broker drops a session when another client connects with the
+    // same id, and the digest topic is keyed by hostname: both must differ
+    // between monitors sharing a broker, configured or not
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    
+    // macAddress() reports the bytes last to first, like BSSID(); the last
+    // three printed bytes are the device-specific part
+    char suffix[7];
+    snprintf(suffix, sizeof(suffix), "%02X%02X%02X", mac[2], mac[1], mac[0]);
+    
+    if (strcmp(hostname, SYSLOG_HOSTNAME) == 0) {
+        snprintf(hostname, sizeof(hostname), "%s-%s", SYSLOG_HOSTNAME, suffix);
+        strncpy(mqttClientId, hostname, sizeof(mqttClientId) - 1);
+        mqttClientId[sizeof(mqttClientId) - 1] = '\0';
+    } else {
+        snprintf(mqttClientId, sizeof(mqttClientId), "%s-%s", hostname, suffix);
+    }
+    debugPrintf("NetworkManager: MQTT client id '%s'\n", mqttClientId);
+}
+
+void NetworkManager::buildTopicPrefix() {
+    topicPrefixLength = 0;
+    topicPrefix[0] = '\0';
+    if (!topicNamespace) return;
+    
+    // MQTT wildcards and level separators would split or break the namespace
+    size_t length = 0;
+    for (const char* c = hostname; *c && length < sizeof(topicPrefix) - 2; c++) {
+        bool reserved = *c == '/' || *c == '+' || *c == '#' || *c == ' ';
+        topicPrefix[length++] = reserved ? '_' : *c;
+    }
+    if (length == 0) return;
+    
+    topicPrefix[length++] = '/';
+    topicPrefix[length] = '\0';
+    topicPrefixLength = (uint8_t)length;
+    debugPrintf("NetworkManager: Topics namespaced under '%s'\n", topicPrefix);
+}
+
+const char* NetworkManager::wireTopic(const char* topic) {
+    if (topicPrefixLength == 0) return topic;
+    
+    // beginMessage()/subscribe() copy the topic, so one buffer serves every call
+    snprintf(wireTopicBuffer, sizeof(wireTopicBuffer), "%s%s", topicPrefix, topic);
+    return wireTopicBuffer;
+}
+
+long NetworkManager::getRSSI() const {
+    return isWiFiConnected() ? (long)WiFi.RSSI() : 0;
+}
+
 bool NetworkManager::isWiFiConnected() const {
     return wifiState == WiFiState::CONNECTED;
 }
@@ -487,7 +1122,7 @@ bool NetworkManager::isSyslogWorking() const {
     // 1. WiFi is connected
     // 2. Syslog server is configured
     // 3. Recent syslog attempt was successful (within last 30 seconds)
-    if (!isWiFiConnected() || strlen(syslogServer) == 0) {
+    if (!isWiFiConnected() || !syslogAddress.valid) {
         return false;
     }
     
@@ -509,14 +1144,100 @@ bool NetworkManager::isStable() const {
 
 void NetworkManager::getHealthString(char* buffer, size_t bufferSize) {
     const char* wifiStatus = isWiFiConnected() ? "OK" : "DOWN";
-    const char* mqttStatus = isMQTTConnected() ? "OK" : "DOWN";
+    const char* mqttStatus = isMQTTConnected() ? "OK" :
+                             mqttPhase == MqttPhase::IDLE ? "DOWN" : "CONNECTING";
     const char* stableStatus = isStable() ? "YES" : "NO";
     unsigned long uptimeSeconds = connectionUptime > 0 ? (millis() - connectionUptime) / 1000 : 0;
     
+    unsigned long drainAvgMs = queueSent > 0 ? drainLatencyTotalMs / queueSent : 0;
+    
+    // Backing off after failed attempts: when the next one starts
+    char retry[48] = "";
+    if (mqttPhase == MqttPhase::IDLE && mqttAttempts > 0) {
+        long waitMs = (long)(mqttNextAttempt - millis());
+        snprintf(retry, sizeof(retry), " (attempt %u, retry in %lus)",
+            mqttAttempts + 1, waitMs > 0 ? (unsigned long)(waitMs + 999) / 1000 : 0UL);
+    }
+    
     snprintf(buffer, bufferSize, 
-        "wifi=%s mqtt=%s stable=%s disconnects=%d fails=%d uptime=%lus",
-        wifiStatus, mqttStatus, stableStatus, 
-        disconnectCount, failedPublishCount, uptimeSeconds);
+        "wifi=%s mqtt=%s%s stable=%s disconnects=%d fails=%d uptime=%lus "
+        "queue=%u/%u peak=%u coalesced=%lu overflow=%lu drain=%lu/%lums%s%s%s",
+        wifiStatus, mqttStatus, retry, stableStatus, 
+        disconnectCount, failedPublishCount, uptimeSeconds,
+        queueCount, MQTT_QUEUE_DEPTH, queuePeak,
+        (unsigned long)queueCoalesced, (unsigned long)queueOverflows,
+        drainAvgMs, drainLatencyMaxMs,
+        packedMode ? " packed" : "",
+        topicPrefixLength > 0 ? " namespace=" : "", topicPrefix);
+}
+
+void NetworkManager::getWiFiStatistics(ResponseSink& out) {
+    static const char* const JOIN_NAMES[] = { "dhcp", "lease", "static" };
+    
+    if (isWiFiConnected()) {
+        out.printf("wifi: connected via %s, ip=%s rssi=%ld",
+            JOIN_NAMES[(uint8_t)wifiJoin], WiFi.localIP().toString().c_str(), (long)WiFi.RSSI());
+    } else {
+        out.printf("wifi: %s, down %lus", wifiState == WiFiState::CONNECTING ? "joining" : "disconnected",
+            wifiTiming ? (millis() - wifiDownSince) / 1000 : 0UL);
+    }
+    
+    if (staticIpEnabled) {
+        out.printf("\r\nstatic: ip=%u.%u.%u.%u gateway=%u.%u.%u.%u",
+            staticIp.ip[0], staticIp.ip[1], staticIp.ip[2], staticIp.ip[3],
+            staticIp.gateway[0], staticIp.gateway[1], staticIp.gateway[2], staticIp.gateway[3]);
+    }
+    if (wifiLease.valid) {
+        const uint8_t* b = wifiLease.bssid;
+        out.printf("\r\nlease: ip=%u.%u.%u.%u bssid=%02X:%02X:%02X:%02X:%02X:%02X",
+            wifiLease.address.ip[0], wifiLease.address.ip[1], wifiLease.address.ip[2], wifiLease.address.ip[3],
+            b[0], b[1], b[2], b[3], b[4], b[5]);
+        if (leaseFresh) {
+            out.printf(" age=%lus/%lus", (millis() - leaseObtainedAt) / 1000, WIFI_LEASE_MAX_AGE_MS / 1000);
+        } else {
+            out.print(" (saved, not reused until a DHCP join renews it)");
+        }
+    } else {
+        out.print("\r\nlease: none");
+    }
+    
+    out.printf("\r\njoins: dhcp=%u lease=%u static=%u fallbacks=%u",
+        joinCounts[(uint8_t)WiFiJoin::DHCP], joinCounts[(uint8_t)WiFiJoin::LEASE],
+        joinCounts[(uint8_t)WiFiJoin::STATIC], leaseFallbacks);
+    out.printf("\r\nreconnect: n=%lu last=%lums p50=%lums p90=%lums p99=%lums max=%lums",
+        (unsigned long)reconnectMs.getCount(), lastReconnectMs,
+        (unsigned long)reconnectMs.percentile(50), (unsigned long)reconnectMs.percentile(90),
+        (unsigned long)reconnectMs.percentile(99), (unsigned long)reconnectMs.getMax());
+}
+
+void NetworkManager::getResolverString(char* buffer, size_t bufferSize) {
+    unsigned long now = millis();
+    int length = describeHost(buffer, bufferSize, "syslog", syslogServer, syslogAddress, now);
+    if (length < 0 || (size_t)length >= bufferSize) return;
+    
+    length += describeHost(buffer + length, bufferSize - length, " broker", brokerHost, brokerAddress, now);
+    if (length < 0 || (size_t)length >= bufferSize) return;
+    
+    snprintf(buffer + length, bufferSize - length, " lookups=%lu failures=%lu",
+        (unsigned long)dnsLookups, (unsigned long)dnsFailures);
+}
+
+int NetworkManager::describeHost(char* buffer, size_t bufferSize, const char* name, const char* host,
+                                 const ResolvedHost& entry, unsigned long now) const {
+    if (entry.literal) {
+        return snprintf(buffer, bufferSize, "%s=%s", name, host);
+    }
+    if (!entry.valid) {
+        return snprintf(buffer, bufferSize, "%s=%s (unresolved)", name, host[0] ? host : "-");
+    }
+    
+    long ttlMs = (long)(entry.expiresAt - now);
+    if (ttlMs <= 0) {
+        return snprintf(buffer, bufferSize, "%s=%s->%s (stale)",
+            name, host, entry.address.toString().c_str());
+    }
+    return snprintf(buffer, bufferSize, "%s=%s->%s (ttl %lus)",
+        name, host, entry.address.toString().c_str(), (unsigned long)ttlMs / 1000);
 }
 
 unsigned long NetworkManager::getConnectionUptime() const {
@@ -534,6 +1255,28 @@ uint16_t NetworkManager::getFailedPublishCount() const {
 void NetworkManager::onMqttMessage(int messageSize) {
     // Handle incoming MQTT messages
     String topic = mqttClient.messageTopic();
+    
+    // Subscriptions are namespaced too; match on the topic without the prefix
+    if (topicPrefixLength > 0 && topic.startsWith(topicPrefix)) {
+        topic = topic.substring(topicPrefixLength);
+    }
+    
+    // Raw messages may hold NUL bytes - read them into a byte buffer
+    for (uint8_t slot = 0; slot < RAW_SUB_COUNT; slot++) {
+        const RawSubscriber& subscriber = rawSubscribers[slot];
+        if (!subscriber.topic || !subscriber.callback || topic != subscriber.topic) continue;
+        
+        uint8_t data[MQTT_RAW_MESSAGE_SIZE];
+        size_t length = 0;
+        while (mqttClient.available()) {
+            int value = mqttClient.read();
+            if (value < 0) break;
+            if (length < sizeof(data)) data[length++] = (uint8_t)value;
+        }
+        subscriber.callback(subscriber.context, data, length);
+        return;
+    }
+    
     String payload = "";
     
     while (mqttClient.available()) {
@@ -543,6 +1286,49 @@ void NetworkManager::onMqttMessage(int messageSize) {
     debugPrintf("NetworkManager: Received MQTT message on topic: %s, payload: %s\n", 
         topic.c_str(), payload.c_str());
     
-    // Process the message (this would be handled by command processor in a full implementation)
-    // For now, just log it
+    // Commands run from the console task, outside the MQTT client callback
+    if (topic == TOPIC_MONITOR_CONTROL && payload.length() > 0) {
+        if (controlPending) {
+            debugPrintf("NetworkManager: Control command '%s' replaced before it ran\n", controlCommand);
+        }
+        strncpy(controlCommand, payload.c_str(), sizeof(controlCommand) - 1);
+        controlCommand[sizeof(controlCommand) - 1] = '\0';
+        controlPending = true;
+    }
+}
+
+bool NetworkManager::takeControlCommand(char* buffer, size_t bufferSize) {
+    if (!controlPending || !buffer || bufferSize == 0) return false;
+    
+    strncpy(buffer, controlCommand, bufferSize - 1);
+    buffer[bufferSize - 1] = '\0';
+    controlPending = false;
+    return true;
+}
+
+bool NetworkManager::publishControlResponse(const char* data, size_t length, uint16_t part, bool final) {
+    if (mqttState != MQTTState::CONNECTED) {
+        failedPublishCount++;
+        return false;
+    }
+    
+    // A reply that fits one part goes out as is; longer ones are framed
+    // "[n+] " (more follows) ... "[n] " (last part)
+    char prefix[12] = "";   // "[65535+] "
+    if (part > 1 || !final) {
+        snprintf(prefix, sizeof(prefix), "[%u%s] ", part, final ? "" : "+");
+    }
+    
+    // Sent right away: queued publishes coalesce by topic and would merge the parts
+    if (!mqttClient.beginMessage(wireTopic(TOPIC_MONITOR_CONTROL_RESP))) {
+        failedPublishCount++;
+        return false;
+    }
+    mqttClient.print(prefix);
+    mqttClient.write((const uint8_t*)data, length);
+    if (!mqttClient.endMessage()) {
+        failedPublishCount++;
+        return false;
+    }
+    return true;
 }
\ No newline at end of file
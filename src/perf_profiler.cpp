@@ -0,0 +1,154 @@
+#include "perf_profiler.h"
+#include "network_manager.h"
+#include "response_sink.h"
+#include "logger.h"
+#include <string.h>
+
+bool PerfProfiler::cycleCounter = false;
+
+PerfProfiler::PerfProfiler()
+    : probeCount(0)
+    , lastRoundMs(0)
+    , publishIndex(PERF_MAX_PROBES) {
+
+    memset(probes, 0, sizeof(probes));
+}
+
+void PerfProfiler::begin() {
+#ifndef NATIVE_BUILD
+    PERF_DEMCR |= PERF_DEMCR_TRCENA;
+    if (!(PERF_DWT_CTRL & PERF_DWT_CTRL_NOCYCCNT)) {
+        PERF_DWT_CYCCNT = 0;
+        PERF_DWT_CTRL |= PERF_DWT_CTRL_CYCCNTENA;
+
+        // A debugger can hold the counter; only trust it once it moves
+        uint32_t first = PERF_DWT_CYCCNT;
+        delayMicroseconds(2);
+        cycleCounter = PERF_DWT_CYCCNT != first;
+    }
+#endif
+    if (!cycleCounter) {
+        LOG_WARN("PerfProfiler: No cycle counter, timing with micros()");
+    }
+}
+
+int8_t PerfProfiler::addProbe(const char* name) {
+    if (!name || probeCount >= PERF_MAX_PROBES) {
+        debugPrintf("PerfProfiler: Cannot add probe %s (table full)\n", name ? name : "?");
+        return PERF_INVALID_PROBE;
+    }
+
+    Probe& probe = probes[probeCount];
+    memset(&probe, 0, sizeof(probe));
+    probe.name = name;
+    probe.minCycles = UINT32_MAX;
+    return (int8_t)probeCount++;
+}
+
+uint8_t PerfProfiler::bucketFor(uint32_t us) {
+    // Number of significant bits: 0 -> 0, 1 -> 1, 2..3 -> 2, 4..7 -> 3, ...
+    uint8_t bucket = us == 0 ? 0 : (uint8_t)(32 - __builtin_clz(us));
+    return bucket < PERF_HISTOGRAM_BUCKETS ? bucket : PERF_HISTOGRAM_BUCKETS - 1;
+}
+
+uint32_t PerfProfiler::record(int8_t id, uint32_t startCycles) {
+    uint32_t cycles = now() - startCycles;
+    uint32_t us = cycles / PERF_CPU_MHZ;
+    if (id < 0 || id >= probeCount) return us;
+
+    Probe& probe = probes[id];
+    probe.count++;
+    probe.totalCycles += cycles;
+    if (cycles < probe.minCycles) probe.minCycles = cycles;
+    if (cycles > probe.maxCycles) probe.maxCycles = cycles;
+    probe.histogram[bucketFor(us)]++;
+    return us;
+}
+
+uint32_t PerfProfiler::percentileUs(const Probe& probe, uint8_t percent) {
+    if (probe.count == 0) return 0;
+
+    // Upper bound of the bucket holding the percentile; the open last bucket reports the max
+    uint32_t target = (uint32_t)(((uint64_t)probe.count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < PERF_HISTOGRAM_BUCKETS - 1; b++) {
+        seen += probe.histogram[b];
+        if (seen >= target) return b == 0 ? 0 : (1UL << b) - 1;
+    }
+    return probe.maxCycles / PERF_CPU_MHZ;
+}
+
+void PerfProfiler::resetStatistics() {
+    for (uint8_t i = 0; i < probeCount; i++) {
+        Probe& probe = probes[i];
+        probe.count = 0;
+        probe.minCycles = UINT32_MAX;
+        probe.maxCycles = 0;
+        probe.totalCycles = 0;
+        memset(probe.histogram, 0, sizeof(probe.histogram));
+    }
+}
+
+void PerfProfiler::getStatistics(ResponseSink& out) {
+    out.printf("perf: %s, %u probes", cycleCounter ? "DWT cycle counter" : "micros() fallback", probeCount);
+    out.print("\r\nprobe          count     min     avg     max     p99 (us)");
+
+    for (uint8_t i = 0; i < probeCount; i++) {
+        const Probe& probe = probes[i];
+        if (probe.count == 0) {
+            out.printf("\r\n%-10s %9lu       -       -       -       -", probe.name, 0UL);
+            continue;
+        }
+        uint32_t avgUs = (uint32_t)(probe.totalCycles / probe.count / PERF_CPU_MHZ);
+        out.printf("\r\n%-10s %9lu %7lu %7lu %7lu %7lu", probe.name,
+            (unsigned long)probe.count,
+            (unsigned long)(probe.minCycles / PERF_CPU_MHZ),
+            (unsigned long)avgUs,
+            (unsigned long)(probe.maxCycles / PERF_CPU_MHZ),
+            (unsigned long)percentileUs(probe, 99));
+    }
+
+    // Histograms: <N is the count of runs shorter than N us
+    for (uint8_t i = 0; i < probeCount; i++) {
+        const Probe& probe = probes[i];
+        if (probe.count == 0) continue;
+        out.printf("\r\n%-10s", probe.name);
+        for (uint8_t b = 0; b < PERF_HISTOGRAM_BUCKETS; b++) {
+            if (probe.histogram[b] == 0) continue;
+            if (b == PERF_HISTOGRAM_BUCKETS - 1) {
+                out.printf(" >=%lu:%lu", 1UL << (b - 1), (unsigned long)probe.histogram[b]);
+            } else {
+                out.printf(" <%lu:%lu", 1UL << b, (unsigned long)probe.histogram[b]);
+            }
+        }
+    }
+}
+
+void PerfProfiler::publish(NetworkManager* network) {
+    if (!network || !network->isMQTTConnected()) return;
+
+    if (publishIndex >= probeCount) {
+        if (millis() - lastRoundMs < PERF_PUBLISH_INTERVAL_MS) return;
+        lastRoundMs = millis();
+        publishIndex = 0;
+    }
+
+    // Skip probes that never ran, publish the next one that did
+    while (publishIndex < probeCount) {
+        const Probe& probe = probes[publishIndex++];
+        if (probe.count == 0) continue;
+
+        char topic[40];
+        char payload[96];
+        snprintf(topic, sizeof(topic), "%s%s", TOPIC_PERF_PREFIX, probe.name);
+        snprintf(payload, sizeof(payload),
+            "{\"n\":%lu,\"min\":%lu,\"avg\":%lu,\"max\":%lu,\"p99\":%lu}",
+            (unsigned long)probe.count,
+            (unsigned long)(probe.minCycles / PERF_CPU_MHZ),
+            (unsigned long)(probe.totalCycles / probe.count / PERF_CPU_MHZ),
+            (unsigned long)(probe.maxCycles / PERF_CPU_MHZ),
+            (unsigned long)percentileUs(probe, 99));
+        network->publish(topic, payload);
+        return;
+    }
+}
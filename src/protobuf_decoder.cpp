@@ -1,31 +1,176 @@
 #include "protobuf_decoder.h"
 #include "network_manager.h"
 #include "logger.h"
+#include "response_sink.h"
 #include <string.h>
+#include <stdarg.h>
 
 // Note: After nanopb installation and proto compilation, include generated protobuf headers:
 // #include "controller_telemetry.pb.h"
 // #include "pb_encode.h"
 // #include "pb_decode.h"
 
+// ===== COMPILE-TIME MESSAGE AND TOPIC TABLES =====
+
+typedef bool (ProtobufDecoder::*PayloadDecoder)(const uint8_t* payload, size_t length,
+                                                uint8_t sequence, uint32_t timestamp);
+
+// Layout flags
+#define LAYOUT_SAMPLED      0x01    // Periodic samples: rate limited by token bucket
+#define LAYOUT_PER_PIN      0x02    // One sample stream per payload[0] (sensor pin)
+
+// One entry per message type 0x10-0x17, in type order (docs/TELEMETRY_API.md)
+struct MessageLayout {
+    uint8_t type;
+    const char* name;
+    uint8_t minPayload;         // Fixed part of the payload; longer payloads are allowed
+    uint8_t flags;
+    PayloadDecoder decode;
+};
+
+static constexpr MessageLayout MESSAGE_LAYOUTS[PROTOBUF_MESSAGE_TYPE_COUNT] = {
+    { 0x10, "input",     4, 0, &ProtobufDecoder::decodeDigitalInput },   // pin, flags, debounce u16
+    { 0x11, "output",    3, 0, &ProtobufDecoder::decodeDigitalOutput },  // pin, flags, reserved
+    { 0x12, "relay",     3, 0, &ProtobufDecoder::decodeRelayEvent },     // relay, flags, reserved
+    { 0x13, "pressure",  8, LAYOUT_SAMPLED | LAYOUT_PER_PIN,
+                            &ProtobufDecoder::decodePressure },          // pin, flags, raw u16, psi f32
+    { 0x14, "error",     3, 0, &ProtobufDecoder::decodeSystemError },    // code, flags, len, desc[0-24]
+    { 0x15, "safety",    3, 0, &ProtobufDecoder::decodeSafetyEvent },    // event, flags, reserved
+    { 0x16, "status",   12, LAYOUT_SAMPLED,
+                            &ProtobufDecoder::decodeSystemStatus },      // uptime u32, hz u16, mem u16, errs, flags, rsvd u16
+    { 0x17, "sequence",  4, 0, &ProtobufDecoder::decodeSequenceEvent },  // event, step, elapsed u16
+};
+
+static constexpr bool sampledPayloadsFit(uint8_t index = 0) {
+    return index >= PROTOBUF_MESSAGE_TYPE_COUNT ||
+           ((!(MESSAGE_LAYOUTS[index].flags & LAYOUT_SAMPLED) ||
+             MESSAGE_LAYOUTS[index].minPayload <= DECODER_RATE_PAYLOAD_SIZE) && sampledPayloadsFit(index + 1));
+}
+static_assert(sampledPayloadsFit(), "Sampled payloads must fit DECODER_RATE_PAYLOAD_SIZE");
+
+static constexpr bool layoutsInTypeOrder(uint8_t index = 0) {
+    return index >= PROTOBUF_MESSAGE_TYPE_COUNT ||
+           (MESSAGE_LAYOUTS[index].type == PROTOBUF_FIRST_MESSAGE_TYPE + index && layoutsInTypeOrder(index + 1));
+}
+static_assert(layoutsInTypeOrder(), "MESSAGE_LAYOUTS must be indexed by message type - 0x10");
+
+// Per-pin topics are string literals built by the preprocessor, so the hot
+// path is a table lookup. Numbers outside the table are formatted on the stack.
+#define PROTOBUF_TOPIC_SLOTS 16
+
+struct PinTopicTable {
+    const char* prefix;
+    const char* suffix;
+    const char* topics[PROTOBUF_TOPIC_SLOTS];
+};
+
+#define PIN_TOPIC_TABLE(prefix, suffix) { prefix, suffix, { \
+    prefix "0" suffix,  prefix "1" suffix,  prefix "2" suffix,  prefix "3" suffix, \
+    prefix "4" suffix,  prefix "5" suffix,  prefix "6" suffix,  prefix "7" suffix, \
+    prefix "8" suffix,  prefix "9" suffix,  prefix "10" suffix, prefix "11" suffix, \
+    prefix "12" suffix, prefix "13" suffix, prefix "14" suffix, prefix "15" suffix } }
+
+static constexpr PinTopicTable INPUT_STATE_TOPICS    = PIN_TOPIC_TABLE("controller/input/", "/state");
+static constexpr PinTopicTable INPUT_TYPE_TOPICS     = PIN_TOPIC_TABLE("controller/input/", "/type");
+static constexpr PinTopicTable OUTPUT_STATE_TOPICS   = PIN_TOPIC_TABLE("controller/output/", "/state");
+static constexpr PinTopicTable RELAY_STATE_TOPICS    = PIN_TOPIC_TABLE("controller/relay/r", "/state");
+static constexpr PinTopicTable RELAY_MODE_TOPICS     = PIN_TOPIC_TABLE("controller/relay/r", "/mode");
+static constexpr PinTopicTable PRESSURE_TOPICS       = PIN_TOPIC_TABLE("controller/pressure/a", "");
+static constexpr PinTopicTable PRESSURE_RAW_TOPICS   = PIN_TOPIC_TABLE("controller/pressure/a", "/raw");
+static constexpr PinTopicTable PRESSURE_FAULT_TOPICS = PIN_TOPIC_TABLE("controller/pressure/a", "/fault");
+
+static const char* pinTopic(const PinTopicTable& table, uint8_t index, char* scratch, size_t scratchSize) {
+    if (index < PROTOBUF_TOPIC_SLOTS) {
+        return table.topics[index];
+    }
+    snprintf(scratch, scratchSize, "%s%u%s", table.prefix, index, table.suffix);
+    return scratch;
+}
+
+// Enumeration names (index = wire value)
+static constexpr const char* const INPUT_TYPE_NAMES[] = {
+    "UNKNOWN", "MANUAL_EXTEND", "MANUAL_RETRACT", "SAFETY_CLEAR", "SEQUENCE_START",
+    "LIMIT_EXTEND", "LIMIT_RETRACT", "SPLITTER_OPERATOR", "EMERGENCY_STOP"
+};
+static constexpr const char* const LAMP_PATTERN_NAMES[] = { "OFF", "SOLID", "SLOW_BLINK", "FAST_BLINK" };
+static constexpr const char* const RELAY_TYPE_NAMES[] = {
+    "UNKNOWN", "HYDRAULIC_EXTEND", "HYDRAULIC_RETRACT", "RESERVED", "RESERVED", "RESERVED",
+    "RESERVED", "OPERATOR_BUZZER", "ENGINE_STOP", "POWER_CONTROL"
+};
+static constexpr const char* const PRESSURE_TYPE_NAMES[] = {
+    "UNKNOWN", "SYSTEM_PRESSURE", "TANK_PRESSURE", "LOAD_PRESSURE", "AUXILIARY"
+};
+static constexpr const char* const SEVERITY_NAMES[] = { "INFO", "WARNING", "ERROR", "CRITICAL" };
+static constexpr const char* const SAFETY_EVENT_NAMES[] = {
+    "SAFETY_ACTIVATED", "SAFETY_CLEARED", "EMERGENCY_STOP_ACTIVATED",
+    "EMERGENCY_STOP_CLEARED", "LIMIT_SWITCH_TRIGGERED", "PRESSURE_SAFETY"
+};
+static constexpr const char* const SEQUENCE_STATE_NAMES[] = {
+    "IDLE", "EXTENDING", "EXTENDED", "RETRACTING", "RETRACTED", "PAUSED", "ERROR_STATE"
+};
+static constexpr const char* const SEQUENCE_EVENT_NAMES[] = {
+    "SEQUENCE_STARTED", "SEQUENCE_STEP_COMPLETE", "SEQUENCE_COMPLETE", "SEQUENCE_PAUSED",
+    "SEQUENCE_RESUMED", "SEQUENCE_ABORTED", "SEQUENCE_TIMEOUT"
+};
+
+template <size_t N>
+static constexpr const char* enumName(const char* const (&names)[N], uint8_t value) {
+    return value < N ? names[value] : "UNKNOWN";
+}
+
+static inline uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
 ProtobufDecoder::ProtobufDecoder()
     : networkManager(nullptr)
+    , dryRun(false)
+    , immediate(false)
     , messagesReceived(0)
     , messagesDecoded(0)
     , decodingErrors(0)
     , publishErrors(0)
-    , lastSequenceNumber(0)
-    , lastPressurePublish(0)
-    , lastRelayPublish(0)
-    , lastSequencePublish(0)
-    , lastSystemPublish(0)
+    , lossBucketIndex(0)
+    , lossBucketStart(0)
+    , rateMinHz(DECODER_RATE_MIN_HZ)
+    , rateMaxHz(DECODER_RATE_MAX_HZ)
+    , rateBurst(DECODER_RATE_BURST)
+    , rateHz(DECODER_RATE_MAX_HZ)
+    , lastRateAdapt(0)
+    , lastFailedPublishes(0)
+    , lastQueueOverflows(0)
+    , samplesAdmitted(0)
+    , samplesThrottled(0)
+    , samplesFlushed(0)
+    , rateDecreases(0)
     , commandsEnabled(false)
     , responseHandler(nullptr)
     , nextCommandId(1)
     , lastTelemetryTime(0)
-    , missedTelemetryCount(0) {
-    
-    memset(decodingBuffer, 0, sizeof(decodingBuffer));
+    , missedTelemetryCount(0)
+    , commandSequence(0)
+    , commandsSent(0)
+    , commandsAcked(0)
+    , commandsFailed(0)
+    , commandsTimedOut(0)
+    , commandsRejected(0)
+    , responsesUnmatched(0)
+    , rttMinUs(UINT32_MAX)
+    , rttMaxUs(0)
+    , rttTotalUs(0)
+    , resultHead(0)
+    , resultCount(0)
+    , resultsDropped(0) {
+    memset(sequenceTracks, 0, sizeof(sequenceTracks));
+    memset(lossBucketExpected, 0, sizeof(lossBucketExpected));
+    memset(lossBucketLost, 0, sizeof(lossBucketLost));
+    memset(rateBuckets, 0, sizeof(rateBuckets));
+    memset(pendingCommands, 0, sizeof(pendingCommands));
+    memset(commandResults, 0, sizeof(commandResults));
 }
 
 void ProtobufDecoder::begin(NetworkManager* network) {
@@ -35,23 +180,21 @@ void ProtobufDecoder::begin(NetworkManager* network) {
     decodingErrors = 0;
     publishErrors = 0;
     lastTelemetryTime = millis();
+    resetSequenceStatistics();
     
-    Logger::log(LOG_INFO, "ProtobufDecoder: Initialized for Controller telemetry");
+    LOG_AT(LOG_INFO, "ProtobufDecoder: Initialized for Controller telemetry");
 }
 
-bool ProtobufDecoder::decodeProtobufMessage(uint8_t* data, size_t length) {
+bool ProtobufDecoder::decodeProtobufMessage(const uint8_t* data, size_t length) {
     if (!data || length == 0 || length > MAX_PROTOBUF_SIZE) {
-        logDecodingError("Invalid message", String("Length: ") + String(length));
+        logDecodingError("Invalid message", "Length: %u", (unsigned)length);
         return false;
     }
     
     messagesReceived++;
     
-    // Copy data to working buffer
-    memcpy(decodingBuffer, data, length);
-    
-    // Decode and publish to individual topics
-    bool decodeSuccess = decodeAndPublish(decodingBuffer, length);
+    // Decode in place - the caller's buffer stays valid for the whole call
+    bool decodeSuccess = decodeAndPublish(data, length);
     
     if (decodeSuccess) {
         messagesDecoded++;
@@ -65,7 +208,7 @@ bool ProtobufDecoder::decodeProtobufMessage(uint8_t* data, size_t length) {
     }
 }
 
-bool ProtobufDecoder::decodeAndPublish(uint8_t* data, size_t length) {
+bool ProtobufDecoder::decodeAndPublish(const uint8_t* data, size_t length) {
     // Per TELEMETRY_API.md format:
     // Byte 0: SIZE (header + payload length, NOT including size byte)
     // Byte 1: Message Type (0x10-0x17)
@@ -74,87 +217,87 @@ bool ProtobufDecoder::decodeAndPublish(uint8_t* data, size_t length) {
     // Bytes 7+: Payload
     
     if (length < 7) {
-        logDecodingError("Message too short", String(length) + " bytes");
+        logDecodingError("Message too short", "%u bytes", (unsigned)length);
         return false;
     }
     
     uint8_t sizeField = data[0];
     uint8_t msgType = data[1];
     uint8_t sequence = data[2];
-    uint32_t timestamp = data[3] | (data[4] << 8) | (data[5] << 16) | (data[6] << 24);
+    uint32_t timestamp = readU32(data + 3);
     
     // Validate size field
-    if ((sizeField + 1) != length) {
-        logDecodingError("Size mismatch", String("SIZE=") + String(sizeField) + " len=" + String(length));
+    if ((size_t)(sizeField + 1) != length) {
+        logDecodingError("Size mismatch", "SIZE=%u len=%u", sizeField, (unsigned)length);
+        return false;
+    }
+    
+    uint8_t index = (uint8_t)(msgType - PROTOBUF_FIRST_MESSAGE_TYPE);
+    if (index >= PROTOBUF_MESSAGE_TYPE_COUNT) {
+        logDecodingError("Unknown message type", "0x%02X", msgType);
         return false;
     }
     
     // Extract payload (everything after 7-byte header)
-    uint8_t* payload = data + 7;
+    const MessageLayout& layout = MESSAGE_LAYOUTS[index];
+    const uint8_t* payload = data + 7;
     size_t payloadLen = length - 7;
     
-    Logger::log(LOG_DEBUG, "ProtobufDecoder: Type=0x%02X Seq=%d TS=%lu PayloadLen=%d", 
+    if (payloadLen < layout.minPayload) {
+        logDecodingError("Payload too short", "%s: %u < %u bytes", layout.name, (unsigned)payloadLen, layout.minPayload);
+        return false;
+    }
+    
+    LOG_AT(LOG_DEBUG, "ProtobufDecoder: Type=0x%02X Seq=%d TS=%lu PayloadLen=%d", 
                 msgType, sequence, timestamp, payloadLen);
     
-    // Dispatch to appropriate decoder based on message type
-    switch (msgType) {
-        case 0x10:
-            return decodeDigitalInput(payload, payloadLen, sequence, timestamp);
-        case 0x11:
-            return decodeDigitalOutput(payload, payloadLen, sequence, timestamp);
-        case 0x12:
-            return decodeRelayEvent(payload, payloadLen, sequence, timestamp);
-        case 0x13:
-            return decodePressure(payload, payloadLen, sequence, timestamp);
-        case 0x14:
-            return decodeSystemError(payload, payloadLen, sequence, timestamp);
-        case 0x15:
-            return decodeSafetyEvent(payload, payloadLen, sequence, timestamp);
-        case 0x16:
-            return decodeSystemStatus(payload, payloadLen, sequence, timestamp);
-        case 0x17:
-            return decodeSequenceEvent(payload, payloadLen, sequence, timestamp);
-        default:
-            logDecodingError("Unknown message type", String("0x") + String(msgType, HEX));
-            return false;
+    // Sampled streams spend a token per publish; without one the sample is
+    // held (replacing an older held one) until service() finds a token
+    if ((layout.flags & LAYOUT_SAMPLED) && !dryRun) {
+        unsigned long now = millis();
+        uint16_t key = (uint16_t)(msgType << 8) | ((layout.flags & LAYOUT_PER_PIN) ? payload[0] : 0);
+        RateBucket& bucket = findBucket(key, now);
+        
+        if (!takeToken(bucket, now)) {
+            if (bucket.pending) samplesThrottled++;
+            size_t keep = payloadLen < DECODER_RATE_PAYLOAD_SIZE ? payloadLen : DECODER_RATE_PAYLOAD_SIZE;
+            memcpy(bucket.payload, payload, keep);
+            bucket.payloadLength = (uint8_t)keep;
+            bucket.sequence = sequence;
+            bucket.timestamp = timestamp;
+            bucket.pending = true;
+            return true;
+        }
+        if (bucket.pending) samplesThrottled++;
+        bucket.pending = false;
+        samplesAdmitted++;
     }
+    
+    return (this->*layout.decode)(payload, payloadLen, sequence, timestamp);
 }
 
 // ===== INDIVIDUAL MESSAGE DECODERS =====
 
-bool ProtobufDecoder::decodeDigitalInput(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeDigitalInput(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: pin(1) + flags(1) + debounce_time(2) = 4 bytes
     if (length < 4) return false;
     
     uint8_t pin = payload[0];
     uint8_t flags = payload[1];
-    uint16_t debounceTime = payload[2] | (payload[3] << 8);
     
     bool state = flags & 0x01;
-    bool isDebounced = flags & 0x02;
     uint8_t inputType = (flags >> 2) & 0x3F;
+    const char* typeName = enumName(INPUT_TYPE_NAMES, inputType);
     
-    // Publish to individual topics
-    char topic[48];
-    char value[32];
-    
-    // State topic
-    snprintf(topic, sizeof(topic), "controller/input/%d/state", pin);
-    publishToMqtt(topic, state ? "ACTIVE" : "INACTIVE");
-    
-    // Type topic  
-    snprintf(topic, sizeof(topic), "controller/input/%d/type", pin);
-    static const char* inputTypes[] = {"UNKNOWN", "MANUAL_EXTEND", "MANUAL_RETRACT", "SAFETY_CLEAR", 
-                                        "SEQUENCE_START", "LIMIT_EXTEND", "LIMIT_RETRACT", 
-                                        "SPLITTER_OPERATOR", "EMERGENCY_STOP"};
-    const char* typeName = (inputType < 9) ? inputTypes[inputType] : "UNKNOWN";
-    publishToMqtt(topic, typeName);
+    char scratch[48];
+    publishToMqtt(pinTopic(INPUT_STATE_TOPICS, pin, scratch, sizeof(scratch)), state ? "ACTIVE" : "INACTIVE");
+    publishToMqtt(pinTopic(INPUT_TYPE_TOPICS, pin, scratch, sizeof(scratch)), typeName);
     
-    Logger::log(LOG_DEBUG, "DI%d: %s (%s)", pin, state ? "ACTIVE" : "INACTIVE", typeName);
+    LOG_AT(LOG_DEBUG, "DI%d: %s (%s)", pin, state ? "ACTIVE" : "INACTIVE", typeName);
     return true;
 }
 
-bool ProtobufDecoder::decodeDigitalOutput(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeDigitalOutput(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: pin(1) + flags(1) + reserved(1) = 3 bytes
     if (length < 3) return false;
     
@@ -165,22 +308,18 @@ bool ProtobufDecoder::decodeDigitalOutput(uint8_t* payload, size_t length, uint8
     uint8_t outputType = (flags >> 1) & 0x07;
     uint8_t lampPattern = (flags >> 4) & 0x0F;
     
-    char topic[48];
-    
-    snprintf(topic, sizeof(topic), "controller/output/%d/state", pin);
-    publishToMqtt(topic, state ? "HIGH" : "LOW");
+    char scratch[48];
+    publishToMqtt(pinTopic(OUTPUT_STATE_TOPICS, pin, scratch, sizeof(scratch)), state ? "HIGH" : "LOW");
     
     if (outputType == 1) { // MILL_LAMP
-        static const char* patterns[] = {"OFF", "SOLID", "SLOW_BLINK", "FAST_BLINK"};
-        const char* patternName = (lampPattern < 4) ? patterns[lampPattern] : "UNKNOWN";
-        publishToMqtt("controller/output/mill_lamp/pattern", patternName);
+        publishToMqtt("controller/output/mill_lamp/pattern", enumName(LAMP_PATTERN_NAMES, lampPattern));
     }
     
-    Logger::log(LOG_DEBUG, "DO%d: %s", pin, state ? "HIGH" : "LOW");
+    LOG_AT(LOG_DEBUG, "DO%d: %s", pin, state ? "HIGH" : "LOW");
     return true;
 }
 
-bool ProtobufDecoder::decodeRelayEvent(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeRelayEvent(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: relay_number(1) + flags(1) + reserved(1) = 3 bytes
     if (length < 3) return false;
     
@@ -189,75 +328,44 @@ bool ProtobufDecoder::decodeRelayEvent(uint8_t* payload, size_t length, uint8_t
     
     bool state = flags & 0x01;
     bool isManual = flags & 0x02;
-    bool success = flags & 0x04;
     uint8_t relayType = (flags >> 3) & 0x1F;
     
-    char topic[48];
-    
-    // State topic
-    snprintf(topic, sizeof(topic), "controller/relay/r%d/state", relayNum);
-    publishToMqtt(topic, state ? "ON" : "OFF");
+    char scratch[48];
+    publishToMqtt(pinTopic(RELAY_STATE_TOPICS, relayNum, scratch, sizeof(scratch)), state ? "ON" : "OFF");
+    publishToMqtt(pinTopic(RELAY_MODE_TOPICS, relayNum, scratch, sizeof(scratch)), isManual ? "MANUAL" : "AUTO");
     
-    // Mode topic
-    snprintf(topic, sizeof(topic), "controller/relay/r%d/mode", relayNum);
-    publishToMqtt(topic, isManual ? "MANUAL" : "AUTO");
-    
-    // Type name for logging
-    static const char* relayTypes[] = {"UNKNOWN", "HYDRAULIC_EXTEND", "HYDRAULIC_RETRACT", 
-                                        "RESERVED", "RESERVED", "RESERVED", "RESERVED",
-                                        "OPERATOR_BUZZER", "ENGINE_STOP", "POWER_CONTROL"};
-    const char* typeName = (relayType < 10) ? relayTypes[relayType] : "UNKNOWN";
-    
-    Logger::log(LOG_DEBUG, "R%d: %s (%s, %s)", relayNum, state ? "ON" : "OFF", 
-                isManual ? "MANUAL" : "AUTO", typeName);
-    
-    lastRelayPublish = millis();
+    LOG_AT(LOG_DEBUG, "R%d: %s (%s, %s)", relayNum, state ? "ON" : "OFF", 
+                isManual ? "MANUAL" : "AUTO", enumName(RELAY_TYPE_NAMES, relayType));
     return true;
 }
 
-bool ProtobufDecoder::decodePressure(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodePressure(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: sensor_pin(1) + flags(1) + raw_value(2) + pressure_psi(4) = 8 bytes
     if (length < 8) return false;
     
     uint8_t sensorPin = payload[0];
     uint8_t flags = payload[1];
-    uint16_t rawValue = payload[2] | (payload[3] << 8);
+    uint16_t rawValue = readU16(payload + 2);
     float pressurePsi;
     memcpy(&pressurePsi, payload + 4, sizeof(float));
     
     bool isFault = flags & 0x01;
     uint8_t pressureType = (flags >> 1) & 0x7F;
     
-    char topic[48];
-    char value[16];
-    
-    // Pressure value topic
-    snprintf(topic, sizeof(topic), "controller/pressure/a%d", sensorPin);
-    snprintf(value, sizeof(value), "%.2f", pressurePsi);
-    publishToMqtt(topic, value);
-    
-    // Raw ADC topic
-    snprintf(topic, sizeof(topic), "controller/pressure/a%d/raw", sensorPin);
-    publishToMqtt(topic, (uint32_t)rawValue);
+    char scratch[48];
+    publishToMqtt(pinTopic(PRESSURE_TOPICS, sensorPin, scratch, sizeof(scratch)), pressurePsi);
+    publishToMqtt(pinTopic(PRESSURE_RAW_TOPICS, sensorPin, scratch, sizeof(scratch)), (uint32_t)rawValue);
     
-    // Fault status
     if (isFault) {
-        snprintf(topic, sizeof(topic), "controller/pressure/a%d/fault", sensorPin);
-        publishToMqtt(topic, "FAULT");
+        publishToMqtt(pinTopic(PRESSURE_FAULT_TOPICS, sensorPin, scratch, sizeof(scratch)), "FAULT");
     }
     
-    static const char* pressureTypes[] = {"UNKNOWN", "SYSTEM_PRESSURE", "TANK_PRESSURE", 
-                                           "LOAD_PRESSURE", "AUXILIARY"};
-    const char* typeName = (pressureType < 5) ? pressureTypes[pressureType] : "UNKNOWN";
-    
-    Logger::log(LOG_DEBUG, "Pressure A%d: %.2f PSI (raw=%d, %s)", 
-                sensorPin, pressurePsi, rawValue, typeName);
-    
-    lastPressurePublish = millis();
+    LOG_AT(LOG_DEBUG, "Pressure A%d: %.2f PSI (raw=%d, %s)", 
+                sensorPin, pressurePsi, rawValue, enumName(PRESSURE_TYPE_NAMES, pressureType));
     return true;
 }
 
-bool ProtobufDecoder::decodeSystemError(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeSystemError(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: error_code(1) + flags(1) + desc_length(1) + description(0-24) = 3-27 bytes
     if (length < 3) return false;
     
@@ -265,9 +373,8 @@ bool ProtobufDecoder::decodeSystemError(uint8_t* payload, size_t length, uint8_t
     uint8_t flags = payload[1];
     uint8_t descLength = payload[2];
     
-    bool acknowledged = flags & 0x01;
     bool active = flags & 0x02;
-    uint8_t severity = (flags >> 2) & 0x03;
+    const char* severity = SEVERITY_NAMES[(flags >> 2) & 0x03];
     
     char description[25] = {0};
     if (descLength > 0 && length > 3) {
@@ -276,57 +383,48 @@ bool ProtobufDecoder::decodeSystemError(uint8_t* payload, size_t length, uint8_t
         memcpy(description, payload + 3, copyLen);
     }
     
-    static const char* severities[] = {"INFO", "WARNING", "ERROR", "CRITICAL"};
-    
     // Publish error info
     publishToMqtt("controller/error/code", (uint32_t)errorCode);
-    publishToMqtt("controller/error/severity", severities[severity]);
+    publishToMqtt("controller/error/severity", severity);
     publishToMqtt("controller/error/active", active);
     if (descLength > 0) {
         publishToMqtt("controller/error/description", description);
     }
     
-    Logger::log(LOG_CRITICAL, "Error 0x%02X: %s [%s] %s", 
-                errorCode, severities[severity], active ? "ACTIVE" : "cleared", description);
+    LOG_AT(LOG_CRITICAL, "Error 0x%02X: %s [%s] %s", 
+                errorCode, severity, active ? "ACTIVE" : "cleared", description);
     
     return true;
 }
 
-bool ProtobufDecoder::decodeSafetyEvent(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeSafetyEvent(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: event_type(1) + flags(1) + reserved(1) = 3 bytes
     if (length < 3) return false;
     
-    uint8_t eventType = payload[0];
-    uint8_t flags = payload[1];
-    
-    bool isActive = flags & 0x01;
-    
-    static const char* eventTypes[] = {"SAFETY_ACTIVATED", "SAFETY_CLEARED", "EMERGENCY_STOP_ACTIVATED",
-                                        "EMERGENCY_STOP_CLEARED", "LIMIT_SWITCH_TRIGGERED", "PRESSURE_SAFETY"};
-    const char* eventName = (eventType < 6) ? eventTypes[eventType] : "UNKNOWN";
+    const char* eventName = enumName(SAFETY_EVENT_NAMES, payload[0]);
+    bool isActive = payload[1] & 0x01;
     
     publishToMqtt("controller/safety/event", eventName);
     publishToMqtt("controller/safety/active", isActive);
     
-    Logger::log(LOG_CRITICAL, "Safety: %s (%s)", eventName, isActive ? "ACTIVE" : "INACTIVE");
+    LOG_AT(LOG_CRITICAL, "Safety: %s (%s)", eventName, isActive ? "ACTIVE" : "INACTIVE");
     
     return true;
 }
 
-bool ProtobufDecoder::decodeSystemStatus(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeSystemStatus(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: uptime(4) + loop_freq(2) + free_mem(2) + active_errors(1) + flags(1) + reserved(2) = 12 bytes
     if (length < 12) return false;
     
-    uint32_t uptimeMs = payload[0] | (payload[1] << 8) | (payload[2] << 16) | (payload[3] << 24);
-    uint16_t loopFreq = payload[4] | (payload[5] << 8);
-    uint16_t freeMem = payload[6] | (payload[7] << 8);
+    uint32_t uptimeMs = readU32(payload);
+    uint16_t loopFreq = readU16(payload + 4);
+    uint16_t freeMem = readU16(payload + 6);
     uint8_t activeErrors = payload[8];
     uint8_t flags = payload[9];
     
     bool safetyActive = flags & 0x01;
     bool estopActive = flags & 0x02;
-    uint8_t seqState = (flags >> 2) & 0x0F;
-    uint8_t lampPattern = (flags >> 6) & 0x03;
+    const char* stateName = enumName(SEQUENCE_STATE_NAMES, (flags >> 2) & 0x0F);
     
     // Publish system status
     publishToMqtt("controller/system/uptime", uptimeMs);
@@ -335,50 +433,37 @@ bool ProtobufDecoder::decodeSystemStatus(uint8_t* payload, size_t length, uint8_
     publishToMqtt("controller/system/error_count", (uint32_t)activeErrors);
     publishToMqtt("controller/system/safety_active", safetyActive);
     publishToMqtt("controller/system/estop_active", estopActive);
-    
-    static const char* seqStates[] = {"IDLE", "EXTENDING", "EXTENDED", "RETRACTING", 
-                                       "RETRACTED", "PAUSED", "ERROR_STATE"};
-    const char* stateName = (seqState < 7) ? seqStates[seqState] : "UNKNOWN";
     publishToMqtt("controller/system/sequence_state", stateName);
     
-    Logger::log(LOG_DEBUG, "Status: uptime=%lus, mem=%d, seq=%s", 
+    LOG_AT(LOG_DEBUG, "Status: uptime=%lus, mem=%d, seq=%s", 
                 uptimeMs/1000, freeMem, stateName);
-    
-    lastSystemPublish = millis();
     return true;
 }
 
-bool ProtobufDecoder::decodeSequenceEvent(uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
+bool ProtobufDecoder::decodeSequenceEvent(const uint8_t* payload, size_t length, uint8_t sequence, uint32_t timestamp) {
     // Payload: event_type(1) + step_number(1) + elapsed_time(2) = 4 bytes
     if (length < 4) return false;
     
-    uint8_t eventType = payload[0];
+    const char* eventName = enumName(SEQUENCE_EVENT_NAMES, payload[0]);
     uint8_t stepNumber = payload[1];
-    uint16_t elapsedMs = payload[2] | (payload[3] << 8);
-    
-    static const char* eventTypes[] = {"SEQUENCE_STARTED", "SEQUENCE_STEP_COMPLETE", "SEQUENCE_COMPLETE",
-                                        "SEQUENCE_PAUSED", "SEQUENCE_RESUMED", "SEQUENCE_ABORTED", 
-                                        "SEQUENCE_TIMEOUT"};
-    const char* eventName = (eventType < 7) ? eventTypes[eventType] : "UNKNOWN";
+    uint16_t elapsedMs = readU16(payload + 2);
     
     publishToMqtt("controller/sequence/event", eventName);
     publishToMqtt("controller/sequence/step", (uint32_t)stepNumber);
     publishToMqtt("controller/sequence/elapsed_ms", (uint32_t)elapsedMs);
     
-    Logger::log(LOG_DEBUG, "Sequence: %s step=%d elapsed=%dms", eventName, stepNumber, elapsedMs);
-    
-    lastSequencePublish = millis();
+    LOG_AT(LOG_DEBUG, "Sequence: %s step=%d elapsed=%dms", eventName, stepNumber, elapsedMs);
     return true;
 }
 
-bool ProtobufDecoder::decodeTelemetryMessage(uint8_t* data, size_t length) {
+bool ProtobufDecoder::decodeTelemetryMessage(const uint8_t* data, size_t length) {
     // TODO: Implement with actual nanopb when available
     /*
     controller_ControllerTelemetry telemetry = controller_ControllerTelemetry_init_zero;
     pb_istream_t stream = pb_istream_from_buffer(data, length);
     
     if (!pb_decode(&stream, controller_ControllerTelemetry_fields, &telemetry)) {
-        logDecodingError("Telemetry decode failed", String(PB_GET_ERROR(&stream)));
+        logDecodingError("Telemetry decode failed", "%s", PB_GET_ERROR(&stream));
         return false;
     }
     
@@ -407,12 +492,15 @@ bool ProtobufDecoder::decodeTelemetryMessage(uint8_t* data, size_t length) {
 }
 
 bool ProtobufDecoder::publishToMqtt(const char* topic, const char* payload) {
+    if (dryRun) return true;
+    
     if (!networkManager || !networkManager->isMQTTConnected()) {
         publishErrors++;
         return false;
     }
     
-    bool success = networkManager->publish(topic, payload);
+    bool success = immediate ? networkManager->publishImmediate(topic, payload)
+                             : networkManager->publish(topic, payload);
     if (!success) {
         publishErrors++;
     }
@@ -436,20 +524,136 @@ bool ProtobufDecoder::publishToMqtt(const char* topic, uint32_t value) {
     return publishToMqtt(topic, buffer);
 }
 
-bool ProtobufDecoder::canPublishPressure() const {
-    return (millis() - lastPressurePublish) >= MIN_PUBLISH_INTERVAL_MS;
+// ===== SAMPLED TOPIC RATE LIMITING =====
+
+bool ProtobufDecoder::setRatePolicy(uint8_t minHz, uint8_t maxHz, uint8_t burst) {
+    // Zero (an unset policy) means the default
+    if (minHz == 0) minHz = DECODER_RATE_MIN_HZ;
+    if (maxHz == 0) maxHz = DECODER_RATE_MAX_HZ;
+    if (burst == 0) burst = DECODER_RATE_BURST;
+    if (minHz > maxHz || maxHz > DECODER_RATE_LIMIT_HZ || burst > DECODER_RATE_LIMIT_HZ) {
+        return false;
+    }
+    
+    rateMinHz = minHz;
+    rateMaxHz = maxHz;
+    rateBurst = burst;
+    if (rateHz < rateMinHz) rateHz = rateMinHz;
+    if (rateHz > rateMaxHz) rateHz = rateMaxHz;
+    return true;
 }
 
-bool ProtobufDecoder::canPublishRelay() const {
-    return (millis() - lastRelayPublish) >= MIN_PUBLISH_INTERVAL_MS;
+ProtobufDecoder::RateBucket& ProtobufDecoder::findBucket(uint16_t key, unsigned long now) {
+    RateBucket* victim = &rateBuckets[0];
+    for (uint8_t i = 0; i < DECODER_RATE_BUCKETS; i++) {
+        RateBucket& bucket = rateBuckets[i];
+        if (bucket.used && bucket.key == key) {
+            bucket.lastUse = now;
+            return bucket;
+        }
+        // Prefer a free slot, else the stream idle the longest
+        if (!victim->used) continue;
+        if (!bucket.used || now - bucket.lastUse > now - victim->lastUse) victim = &bucket;
+    }
+    
+    // The evicted stream's held sample is its last value: publish it now
+    // rather than lose it with the slot
+    if (victim->used && victim->pending) {
+        publishHeld(*victim);
+    }
+    
+    // New stream starts with a full burst credit
+    memset(victim, 0, sizeof(*victim));
+    victim->key = key;
+    victim->used = true;
+    victim->milliTokens = (uint32_t)rateBurst * 1000;
+    victim->lastRefill = now;
+    victim->lastUse = now;
+    return *victim;
 }
 
-bool ProtobufDecoder::canPublishSequence() const {
-    return (millis() - lastSequencePublish) >= MIN_PUBLISH_INTERVAL_MS;
+bool ProtobufDecoder::takeToken(RateBucket& bucket, unsigned long now) {
+    // rateHz tokens per second = rateHz milli-tokens per ms
+    uint32_t cap = (uint32_t)rateBurst * 1000;
+    unsigned long elapsed = now - bucket.lastRefill;
+    bucket.lastRefill = now;
+    if (elapsed > cap) elapsed = cap;   // Keeps the product small; any rate >= 1 Hz fills the cap
+    bucket.milliTokens += (uint32_t)rateHz * elapsed;
+    if (bucket.milliTokens > cap) bucket.milliTokens = cap;
+    
+    if (bucket.milliTokens < 1000) return false;
+    bucket.milliTokens -= 1000;
+    return true;
 }
 
-bool ProtobufDecoder::canPublishSystem() const {
-    return (millis() - lastSystemPublish) >= MIN_PUBLISH_INTERVAL_MS;
+void ProtobufDecoder::adaptRate(unsigned long now) {
+    if (now - lastRateAdapt < DECODER_RATE_ADAPT_MS) return;
+    lastRateAdapt = now;
+    if (!networkManager) return;
+    
+    uint16_t failed = networkManager->getFailedPublishCount();
+    uint32_t overflows = networkManager->getQueueOverflows();
+    uint16_t newFailures = failed - lastFailedPublishes;
+    uint32_t newOverflows = overflows - lastQueueOverflows;
+    lastFailedPublishes = failed;
+    lastQueueOverflows = overflows;
+    
+    // Hold the rate while disconnected; failures then say nothing about load
+    if (!networkManager->isMQTTConnected()) return;
+    
+    unsigned long latency = networkManager->getDrainLatencyMs();
+    if (newFailures > 0 || newOverflows > 0 || latency > DECODER_RATE_LATENCY_HIGH_MS) {
+        uint8_t halved = rateHz / 2;
+        rateHz = halved > rateMinHz ? halved : rateMinHz;
+        rateDecreases++;
+    } else if (latency < DECODER_RATE_LATENCY_LOW_MS && rateHz < rateMaxHz) {
+        rateHz++;
+    }
+}
+
+void ProtobufDecoder::service() {
+    unsigned long now = millis();
+    adaptRate(now);
+    expireCommands();
+    publishCommandResults();
+    
+    for (uint8_t i = 0; i < DECODER_RATE_BUCKETS; i++) {
+        RateBucket& bucket = rateBuckets[i];
+        if (!bucket.used || !bucket.pending || !takeToken(bucket, now)) continue;
+        publishHeld(bucket);
+    }
+}
+
+void ProtobufDecoder::publishHeld(RateBucket& bucket) {
+    // Layout index and payload size were validated when the sample was held
+    bucket.pending = false;
+    samplesFlushed++;
+    const MessageLayout& layout = MESSAGE_LAYOUTS[(uint8_t)((bucket.key >> 8) - PROTOBUF_FIRST_MESSAGE_TYPE)];
+    (this->*layout.decode)(bucket.payload, bucket.payloadLength, bucket.sequence, bucket.timestamp);
+}
+
+void ProtobufDecoder::getRateStatistics(ResponseSink& out) {
+    out.printf("sampled topic rate: %u Hz per stream (min %u, max %u, burst %u), %lu decreases\r\n",
+        rateHz, rateMinHz, rateMaxHz, rateBurst, (unsigned long)rateDecreases);
+    out.printf("samples: admitted=%lu held+flushed=%lu superseded=%lu\r\n",
+        (unsigned long)samplesAdmitted, (unsigned long)samplesFlushed, (unsigned long)samplesThrottled);
+    if (networkManager) {
+        out.printf("link: drain latency %lu ms, failed publishes %u",
+            networkManager->getDrainLatencyMs(), networkManager->getFailedPublishCount());
+    }
+    
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < DECODER_RATE_BUCKETS; i++) {
+        const RateBucket& bucket = rateBuckets[i];
+        if (!bucket.used) continue;
+        
+        const MessageLayout& layout = MESSAGE_LAYOUTS[(uint8_t)((bucket.key >> 8) - PROTOBUF_FIRST_MESSAGE_TYPE)];
+        out.printf("\r\n%-8s", layout.name);
+        if (layout.flags & LAYOUT_PER_PIN) out.printf(" a%u", bucket.key & 0xFF);
+        out.printf(" tokens=%lu.%lu%s idle=%lus", (unsigned long)(bucket.milliTokens / 1000),
+            (unsigned long)(bucket.milliTokens % 1000 / 100), bucket.pending ? " held" : "",
+            (now - bucket.lastUse) / 1000);
+    }
 }
 
 void ProtobufDecoder::getStatistics(char* buffer, size_t bufferSize) {
@@ -472,69 +676,316 @@ void ProtobufDecoder::getStatistics(char* buffer, size_t bufferSize) {
     );
 }
 
-// === API INTEGRATION METHODS ===
+// === SEQUENCE TRACKING ===
 
-bool ProtobufDecoder::sendControllerCommand(const String& commandType, const String& parameters) {
-    if (!commandsEnabled || !networkManager) {
-        logApiActivity("Command disabled", commandType);
-        return false;
+void ProtobufDecoder::trackSequence(const uint8_t* data, size_t length) {
+    if (!data || length < 7) return;
+    
+    uint8_t msgType = data[1];
+    if (msgType < PROTOBUF_FIRST_MESSAGE_TYPE ||
+        msgType >= PROTOBUF_FIRST_MESSAGE_TYPE + PROTOBUF_MESSAGE_TYPE_COUNT) {
+        return;
     }
     
-    // TODO: Implement with actual nanopb when available
-    /*
-    controller_ControllerCommand command = controller_ControllerCommand_init_zero;
+    uint8_t sequence = data[2];
+    uint32_t timestamp = readU32(data + 3);
+    SequenceTrack& track = sequenceTracks[msgType - PROTOBUF_FIRST_MESSAGE_TYPE];
+    
+    rotateLossBuckets();
+    track.received++;
+    
+    if (!track.seen) {
+        track.seen = true;
+        track.lastSequence = sequence;
+        track.lastTimestamp = timestamp;
+        lossBucketExpected[lossBucketIndex]++;
+        return;
+    }
     
-    // Fill command structure
-    command.command_id = nextCommandId++;
-    strncpy(command.command_type, commandType.c_str(), sizeof(command.command_type) - 1);
-    command.requires_response = true;
-    command.timeout_ms = 5000;
+    // A large step back in controller time means it restarted and its
+    // counters started over - that is not loss
+    if (timestamp + SEQ_RESYNC_BACKSTEP_MS < track.lastTimestamp) {
+        track.resyncs++;
+        track.lastSequence = sequence;
+        track.lastTimestamp = timestamp;
+        lossBucketExpected[lossBucketIndex]++;
+        LOG_AT(LOG_INFO, "ProtobufDecoder: Type 0x%02X sequence resync (controller restart)", msgType);
+        return;
+    }
     
-    // Encode command to protobuf
-    uint8_t commandBuffer[256];
-    pb_ostream_t stream = pb_ostream_from_buffer(commandBuffer, sizeof(commandBuffer));
+    uint8_t delta = (uint8_t)(sequence - track.lastSequence);
     
-    if (!pb_encode(&stream, controller_ControllerCommand_fields, &command)) {
-        logApiActivity("Command encode failed", commandType);
-        return false;
+    if (delta == 0 && timestamp == track.lastTimestamp) {
+        track.duplicates++;
+        return;
     }
     
-    // Send via Serial1 to Controller
-    return sendBinaryCommand(commandBuffer, stream.bytes_written);
-    */
+    // The timestamp disambiguates the 8-bit counter: older frames are late
+    // arrivals, newer ones are ahead by delta (mod 256) frames
+    if (timestamp < track.lastTimestamp) {
+        track.reordered++;
+        if (track.lost > 0) track.lost--;
+        if (lossBucketLost[lossBucketIndex] > 0) lossBucketLost[lossBucketIndex]--;
+        return;
+    }
     
-    // Placeholder implementation
-    logApiActivity("Command sent (placeholder)", commandType + ": " + parameters);
-    return true;
+    uint32_t missing = (delta == 0) ? 255 : (uint32_t)(delta - 1);
+    if (missing > 0) {
+        track.gaps++;
+        track.lost += missing;
+        lossBucketLost[lossBucketIndex] += missing;
+        LOG_AT(LOG_DEBUG, "ProtobufDecoder: Type 0x%02X sequence gap %u -> %u (%lu lost)",
+                    msgType, track.lastSequence, sequence, (unsigned long)missing);
+    }
+    lossBucketExpected[lossBucketIndex] += 1 + missing;
+    
+    track.lastSequence = sequence;
+    track.lastTimestamp = timestamp;
 }
 
-bool ProtobufDecoder::processCommandResponse(const uint8_t* data, size_t length) {
-    if (!responseHandler) {
-        return false;  // No response handler registered
+void ProtobufDecoder::rotateLossBuckets() {
+    unsigned long now = millis();
+    if (lossBucketStart == 0) {
+        lossBucketStart = now;
+        return;
     }
     
-    // TODO: Implement with actual nanopb when available
-    /*
-    controller_ControllerResponse response = controller_ControllerResponse_init_zero;
-    pb_istream_t stream = pb_istream_from_buffer(data, length);
+    // Advance one bucket per elapsed width; idle gaps clear stale buckets
+    uint8_t steps = 0;
+    while (now - lossBucketStart >= SEQ_LOSS_BUCKET_MS && steps < SEQ_LOSS_BUCKETS) {
+        lossBucketIndex = (lossBucketIndex + 1) % SEQ_LOSS_BUCKETS;
+        lossBucketExpected[lossBucketIndex] = 0;
+        lossBucketLost[lossBucketIndex] = 0;
+        lossBucketStart += SEQ_LOSS_BUCKET_MS;
+        steps++;
+    }
+    if (now - lossBucketStart >= SEQ_LOSS_BUCKET_MS) {
+        lossBucketStart = now;
+    }
+}
+
+void ProtobufDecoder::resetSequenceStatistics() {
+    memset(sequenceTracks, 0, sizeof(sequenceTracks));
+    memset(lossBucketExpected, 0, sizeof(lossBucketExpected));
+    memset(lossBucketLost, 0, sizeof(lossBucketLost));
+    lossBucketIndex = 0;
+    lossBucketStart = 0;
+}
+
+uint32_t ProtobufDecoder::getSequenceReceived() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PROTOBUF_MESSAGE_TYPE_COUNT; i++) {
+        total += sequenceTracks[i].received;
+    }
+    return total;
+}
+
+uint32_t ProtobufDecoder::getSequenceLost() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PROTOBUF_MESSAGE_TYPE_COUNT; i++) {
+        total += sequenceTracks[i].lost;
+    }
+    return total;
+}
+
+float ProtobufDecoder::getLossRate() const {
+    uint32_t lost = getSequenceLost();
+    uint32_t expected = lost;
+    for (uint8_t i = 0; i < PROTOBUF_MESSAGE_TYPE_COUNT; i++) {
+        expected += sequenceTracks[i].received - sequenceTracks[i].duplicates;
+    }
+    return expected > 0 ? (float)lost / expected * 100.0f : 0.0f;
+}
+
+float ProtobufDecoder::getRollingLossRate() {
+    rotateLossBuckets();
+    
+    uint32_t expected = 0;
+    uint32_t lost = 0;
+    for (uint8_t i = 0; i < SEQ_LOSS_BUCKETS; i++) {
+        expected += lossBucketExpected[i];
+        lost += lossBucketLost[i];
+    }
+    return expected > 0 ? (float)lost / expected * 100.0f : 0.0f;
+}
+
+void ProtobufDecoder::getSequenceStatistics(ResponseSink& out) {
+    out.printf("sequence loss: %.2f%% (60s %.2f%%), received=%lu lost=%lu",
+        getLossRate(), getRollingLossRate(),
+        (unsigned long)getSequenceReceived(), (unsigned long)getSequenceLost());
+    
+    // One line per type that has been seen
+    for (uint8_t i = 0; i < PROTOBUF_MESSAGE_TYPE_COUNT; i++) {
+        const SequenceTrack& track = sequenceTracks[i];
+        if (!track.seen) continue;
+        out.printf(
+            "\r\n0x%02X %s: rx=%lu gaps=%lu lost=%lu dup=%lu reorder=%lu resync=%lu last=%u",
+            MESSAGE_LAYOUTS[i].type, MESSAGE_LAYOUTS[i].name,
+            (unsigned long)track.received, (unsigned long)track.gaps, (unsigned long)track.lost,
+            (unsigned long)track.duplicates, (unsigned long)track.reordered,
+            (unsigned long)track.resyncs, track.lastSequence);
+    }
+}
+
+void ProtobufDecoder::getSequenceSummaryJson(char* buffer, size_t bufferSize, uint32_t forwardDrops) {
+    if (!buffer || bufferSize == 0) return;
+    
+    uint32_t gaps = 0, duplicates = 0, reordered = 0, resyncs = 0, expected = 0;
+    for (uint8_t i = 0; i < PROTOBUF_MESSAGE_TYPE_COUNT; i++) {
+        gaps += sequenceTracks[i].gaps;
+        duplicates += sequenceTracks[i].duplicates;
+        reordered += sequenceTracks[i].reordered;
+        resyncs += sequenceTracks[i].resyncs;
+        expected += sequenceTracks[i].received - sequenceTracks[i].duplicates + sequenceTracks[i].lost;
+    }
+    
+    // End to end: frames the controller sent that never reached the broker,
+    // either lost before the decoder (UART, framing) or not forwarded
+    uint32_t lost = getSequenceLost();
+    float endToEnd = expected > 0 ? (float)(lost + forwardDrops) / expected * 100.0f : 0.0f;
     
-    if (!pb_decode(&stream, controller_ControllerResponse_fields, &response)) {
-        logApiActivity("Response decode failed", String(length) + " bytes");
+    snprintf(buffer, bufferSize,
+        "{\"rx\":%lu,\"lost\":%lu,\"gaps\":%lu,\"dup\":%lu,\"reorder\":%lu,\"resync\":%lu,"
+        "\"drop\":%lu,\"loss\":%.2f,\"loss60\":%.2f,\"e2e\":%.2f}",
+        (unsigned long)getSequenceReceived(), (unsigned long)lost,
+        (unsigned long)gaps, (unsigned long)duplicates, (unsigned long)reordered, (unsigned long)resyncs,
+        (unsigned long)forwardDrops, getLossRate(), getRollingLossRate(), endToEnd);
+}
+
+// === API INTEGRATION METHODS ===
+
+// Copy printable text that is safe inside a JSON string; stops at a space if asked
+static size_t copyCommandText(char* dest, size_t destSize, const char* src, size_t length, bool stopAtSpace) {
+    size_t n = 0;
+    for (size_t i = 0; i < length && src[i] && n + 1 < destSize; i++) {
+        char c = src[i];
+        if (stopAtSpace && c == ' ') break;
+        dest[n++] = (c < 32 || c > 126 || c == '"' || c == '\\') ? '_' : c;
+    }
+    dest[n] = '\0';
+    return n;
+}
+
+uint16_t ProtobufDecoder::sendControllerCommand(const char* command, const char* ref) {
+    size_t textLength = command ? strlen(command) : 0;
+    const char* reason = nullptr;
+    PendingCommand* slot = nullptr;
+    
+    if (!commandsEnabled) {
+        reason = "disabled";
+    } else if (textLength == 0 || textLength > COMMAND_TEXT_MAX) {
+        reason = "length";
+    } else {
+        for (uint8_t i = 0; i < COMMAND_MAX_IN_FLIGHT && !slot; i++) {
+            if (pendingCommands[i].id == 0) slot = &pendingCommands[i];
+        }
+        if (!slot) reason = "busy";
+    }
+    
+    uint16_t id = 0;
+    if (!reason) {
+        id = (uint16_t)nextCommandId++;
+        if (id == 0) id = (uint16_t)nextCommandId++;     // 0 marks a free slot
+        
+        size_t length = encodeCommand(id, command, commandFrame, sizeof(commandFrame));
+        uint32_t sentUs = micros();
+        if (length > 0 && sendBinaryCommand(commandFrame, length)) {
+            slot->id = id;
+            slot->sentUs = sentUs;
+            copyCommandText(slot->ref, sizeof(slot->ref), ref ? ref : "", COMMAND_REF_SIZE, false);
+            commandsSent++;
+            logApiActivity("Command sent", "#%u %s", id, command);
+            return id;
+        }
+        reason = "tx";
+    }
+    
+    commandsRejected++;
+    logApiActivity("Command rejected", "%s: %s", reason, command ? command : "");
+    queueCommandResult(0, ref, false, 0, "err", reason);
+    return 0;
+}
+
+void ProtobufDecoder::onMqttCommand(const uint8_t* data, size_t length) {
+    // "[#ref ]command" - the tag comes back in the result
+    const char* text = (const char*)data;
+    char ref[COMMAND_REF_SIZE] = "";
+    while (length > 0 && *text == ' ') { text++; length--; }
+    if (length > 0 && *text == '#') {
+        size_t refLength = 0;
+        while (refLength < length && text[refLength] != ' ') refLength++;
+        copyCommandText(ref, sizeof(ref), text + 1, refLength - 1, true);
+        text += refLength;
+        length -= refLength;
+        while (length > 0 && *text == ' ') { text++; length--; }
+    }
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\r' || text[length - 1] == '\n')) length--;
+    
+    // One char over the limit so an overlong command is rejected, not cut
+    char command[COMMAND_TEXT_MAX + 2];
+    copyCommandText(command, sizeof(command), text, length, false);
+    sendControllerCommand(command, ref);
+}
+
+bool ProtobufDecoder::processCommandResponse(const uint8_t* data, size_t length) {
+    // [SIZE][0x21][seq][ts u32][id u16][status][len][text]
+    if (!data || length < 11 || data[1] != CONTROLLER_RESPONSE_TYPE || 11 + (size_t)data[10] > length) {
+        logDecodingError("Command response", "Malformed, %u bytes", (unsigned)length);
         return false;
     }
     
-    // Call registered response handler
-    responseHandler(response.command_id, response.success, String(response.result_message));
-    return true;
-    */
+    uint16_t id = (uint16_t)(data[7] | (data[8] << 8));
+    bool ok = data[9] == 0;
+    PendingCommand* command = nullptr;
+    for (uint8_t i = 0; i < COMMAND_MAX_IN_FLIGHT && id != 0; i++) {
+        if (pendingCommands[i].id == id) command = &pendingCommands[i];
+    }
+    if (!command) {
+        // Late answer to a command that already timed out, or a stray frame
+        responsesUnmatched++;
+        return false;
+    }
+    
+    uint32_t rttUs = micros() - command->sentUs;
+    if (rttUs < rttMinUs) rttMinUs = rttUs;
+    if (rttUs > rttMaxUs) rttMaxUs = rttUs;
+    rttTotalUs += rttUs;
+    if (ok) commandsAcked++; else commandsFailed++;
+    
+    char message[COMMAND_TEXT_MAX + 1];
+    copyCommandText(message, sizeof(message), (const char*)data + 11, data[10], false);
+    queueCommandResult(id, command->ref, ok, rttUs, ok ? "msg" : "err", message);
+    command->id = 0;
     
-    // Placeholder implementation
     if (responseHandler) {
-        responseHandler(1, true, "Mock response processed");
+        responseHandler(id, ok, String(message));
     }
     return true;
 }
 
+uint8_t ProtobufDecoder::getCommandsInFlight() const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < COMMAND_MAX_IN_FLIGHT; i++) {
+        if (pendingCommands[i].id != 0) count++;
+    }
+    return count;
+}
+
+void ProtobufDecoder::getCommandStatistics(ResponseSink& out) {
+    out.printf("controller commands: %s, in flight %u/%u, timeout %u ms\r\n",
+        commandsEnabled ? "ENABLED" : "DISABLED", getCommandsInFlight(), COMMAND_MAX_IN_FLIGHT, COMMAND_TIMEOUT_MS);
+    out.printf("sent=%lu acked=%lu failed=%lu timeout=%lu rejected=%lu unmatched=%lu dropped=%lu",
+        (unsigned long)commandsSent, (unsigned long)commandsAcked, (unsigned long)commandsFailed,
+        (unsigned long)commandsTimedOut, (unsigned long)commandsRejected,
+        (unsigned long)responsesUnmatched, (unsigned long)resultsDropped);
+    
+    uint32_t answered = commandsAcked + commandsFailed;
+    if (answered > 0) {
+        out.printf("\r\nround trip: min %.1f ms, avg %.1f ms, max %.1f ms",
+            rttMinUs / 1000.0f, (float)(rttTotalUs / answered) / 1000.0f, rttMaxUs / 1000.0f);
+    }
+}
+
 void ProtobufDecoder::setResponseHandler(void (*handler)(uint32_t commandId, bool success, const String& message)) {
     responseHandler = handler;
     logApiActivity("Response handler registered", "");
@@ -542,7 +993,7 @@ void ProtobufDecoder::setResponseHandler(void (*handler)(uint32_t commandId, boo
 
 void ProtobufDecoder::setCommandsEnabled(bool enabled) {
     commandsEnabled = enabled;
-    logApiActivity("Commands", enabled ? "ENABLED" : "DISABLED");
+    logApiActivity("Commands", "%s", enabled ? "ENABLED" : "DISABLED");
 }
 
 uint64_t ProtobufDecoder::getLastTelemetryTime() const {
@@ -556,12 +1007,109 @@ bool ProtobufDecoder::isTelemetryCurrent(uint32_t maxAgeMs) const {
 
 // === PRIVATE HELPER METHODS ===
 
-void ProtobufDecoder::logDecodingError(const String& context, const String& details) {
-    Logger::log(LOG_ERROR, "ProtobufDecoder: %s - %s", context.c_str(), details.c_str());
+size_t ProtobufDecoder::encodeCommand(uint16_t id, const char* command, uint8_t* buffer, size_t bufferSize) {
+    size_t textLength = strlen(command);
+    size_t frameLength = 1 + 6 + 3 + textLength;
+    if (textLength > COMMAND_TEXT_MAX || frameLength > bufferSize) return 0;
+    
+    // Telemetry framing: SIZE excludes itself, timestamp little-endian
+    uint32_t timestamp = millis();
+    buffer[0] = (uint8_t)(frameLength - 1);
+    buffer[1] = CONTROLLER_COMMAND_TYPE;
+    buffer[2] = commandSequence++;
+    buffer[3] = (uint8_t)timestamp;
+    buffer[4] = (uint8_t)(timestamp >> 8);
+    buffer[5] = (uint8_t)(timestamp >> 16);
+    buffer[6] = (uint8_t)(timestamp >> 24);
+    buffer[7] = (uint8_t)id;
+    buffer[8] = (uint8_t)(id >> 8);
+    buffer[9] = (uint8_t)textLength;
+    memcpy(buffer + 10, command, textLength);
+    return frameLength;
+}
+
+bool ProtobufDecoder::sendBinaryCommand(const uint8_t* data, size_t length) {
+    // Never wait on a full TX buffer: the caller may be the MQTT callback
+    if (Serial1.availableForWrite() < (int)length) return false;
+    return Serial1.write(data, length) == length;
+}
+
+void ProtobufDecoder::expireCommands() {
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < COMMAND_MAX_IN_FLIGHT; i++) {
+        PendingCommand& command = pendingCommands[i];
+        if (command.id == 0 || now - command.sentUs < COMMAND_TIMEOUT_MS * 1000UL) continue;
+        
+        commandsTimedOut++;
+        logApiActivity("Command timeout", "#%u", command.id);
+        queueCommandResult(command.id, command.ref, false, now - command.sentUs, "err", "timeout");
+        if (responseHandler) {
+            responseHandler(command.id, false, "timeout");
+        }
+        command.id = 0;
+    }
+}
+
+void ProtobufDecoder::queueCommandResult(uint16_t id, const char* ref, bool ok, uint32_t rttUs,
+                                         const char* key, const char* message) {
+    if (resultCount >= COMMAND_RESULT_QUEUE) {
+        resultsDropped++;
+        return;
+    }
+    
+    CommandResult& result = commandResults[(resultHead + resultCount) % COMMAND_RESULT_QUEUE];
+    result.id = id;
+    result.ok = ok;
+    result.key = key;
+    result.rttUs = rttUs;
+    copyCommandText(result.ref, sizeof(result.ref), ref ? ref : "", COMMAND_REF_SIZE, false);
+    copyCommandText(result.message, sizeof(result.message), message ? message : "", COMMAND_TEXT_MAX, false);
+    resultCount++;
+}
+
+void ProtobufDecoder::publishCommandResults() {
+    while (resultCount > 0) {
+        const CommandResult& result = commandResults[resultHead];
+        resultHead = (resultHead + 1) % COMMAND_RESULT_QUEUE;
+        resultCount--;
+        if (!networkManager || !networkManager->isMQTTConnected()) continue;
+        
+        // {"id":7,"ref":"ui3","ok":true,"rtt":38.2,"msg":"R1 ON"}
+        char payload[112];
+        int n = snprintf(payload, sizeof(payload), "{\"id\":%u", result.id);
+        if (result.ref[0]) {
+            n += snprintf(payload + n, sizeof(payload) - n, ",\"ref\":\"%s\"", result.ref);
+        }
+        n += snprintf(payload + n, sizeof(payload) - n, ",\"ok\":%s", result.ok ? "true" : "false");
+        if (result.id != 0) {
+            n += snprintf(payload + n, sizeof(payload) - n, ",\"rtt\":%.1f", result.rttUs / 1000.0f);
+        }
+        snprintf(payload + n, sizeof(payload) - n, ",\"%s\":\"%s\"}", result.key, result.message);
+        
+        if (!networkManager->publishImmediate(TOPIC_CONTROLLER_RESPONSE, payload)) {
+            publishErrors++;
+        }
+    }
 }
 
-void ProtobufDecoder::logApiActivity(const String& activity, const String& details) {
-    Logger::log(LOG_INFO, "ProtobufDecoder API: %s - %s", activity.c_str(), details.c_str());
+void ProtobufDecoder::logDecodingError(const char* context, const char* format, ...) {
+    char details[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(details, sizeof(details), format, args);
+    va_end(args);
+    
+    LOG_AT(LOG_ERROR, "ProtobufDecoder: %s - %s", context, details);
+}
+
+void ProtobufDecoder::logApiActivity(const char* activity, const char* format, ...) {
+    char details[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(details, sizeof(details), format, args);
+    va_end(args);
+    
+    LOG_AT(LOG_INFO, "ProtobufDecoder API: %s - %s", activity, details);
 }
 
 void ProtobufDecoder::updateTelemetryStats(bool success, size_t messageSize) {
@@ -576,7 +1124,7 @@ void ProtobufDecoder::updateTelemetryStats(bool success, size_t messageSize) {
     if (millis() - lastStatsUpdate > 300000) {
         char statsBuffer[256];
         getStatistics(statsBuffer, sizeof(statsBuffer));
-        Logger::log(LOG_INFO, "ProtobufDecoder Stats: Success rate %.1f%%, %lu messages", 
+        LOG_AT(LOG_INFO, "ProtobufDecoder Stats: Success rate %.1f%%, %lu messages", 
                    messagesReceived > 0 ? (float)messagesDecoded / messagesReceived * 100.0f : 0.0f,
                    (unsigned long)messagesReceived);
         lastStatsUpdate = millis();
@@ -595,11 +1143,17 @@ bool ProtobufDecoder::validateRelayData(bool r1_state, bool r2_state) {
     return !(r1_state && r2_state);
 }
 
-bool ProtobufDecoder::validateSequenceData(const String& state) {
+bool ProtobufDecoder::validateSequenceData(const char* state) {
     // Validate sequence state strings
-    return (state == "IDLE" || state == "EXTEND_START" || state == "EXTENDING" || 
-            state == "EXTEND_COMPLETE" || state == "RETRACT_START" || state == "RETRACTING" ||
-            state == "RETRACT_COMPLETE" || state == "FAULT" || state == "E_STOP");
+    static constexpr const char* const VALID_STATES[] = {
+        "IDLE", "EXTEND_START", "EXTENDING", "EXTEND_COMPLETE", "RETRACT_START",
+        "RETRACTING", "RETRACT_COMPLETE", "FAULT", "E_STOP"
+    };
+    if (!state) return false;
+    for (const char* valid : VALID_STATES) {
+        if (strcmp(state, valid) == 0) return true;
+    }
+    return false;
 }
 
 bool ProtobufDecoder::validateTimestamp(uint64_t timestamp) {
@@ -0,0 +1,72 @@
+#include "response_sink.h"
+#include <stdarg.h>
+
+ResponseSink::ResponseSink(EmitFn emit, void* context)
+    : emit(emit)
+    , context(context)
+    , length(0)
+    , sent(0)
+    , parts(0)
+    , closed(true) {
+
+    chunk[0] = '\0';
+}
+
+void ResponseSink::print(const char* text) {
+    if (!text) return;
+
+    size_t remaining = strlen(text);
+    while (remaining > 0) {
+        if (length == RESPONSE_CHUNK_SIZE) emitChunk(false);
+
+        size_t count = RESPONSE_CHUNK_SIZE - length;
+        if (count > remaining) count = remaining;
+        memcpy(chunk + length, text, count);
+        length += count;
+        chunk[length] = '\0';
+        text += count;
+        remaining -= count;
+        closed = false;
+    }
+}
+
+void ResponseSink::printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(chunk + length, sizeof(chunk) - length, fmt, args);
+    va_end(args);
+
+    if (written <= 0) {
+        chunk[length] = '\0';
+        return;
+    }
+
+    if ((size_t)written > RESPONSE_CHUNK_SIZE - length && length > 0) {
+        // Did not fit behind the pending text: send that and format again
+        chunk[length] = '\0';
+        emitChunk(false);
+        va_start(args, fmt);
+        written = vsnprintf(chunk, sizeof(chunk), fmt, args);
+        va_end(args);
+        if (written <= 0) return;
+    }
+
+    length += (size_t)written > RESPONSE_CHUNK_SIZE - length ? RESPONSE_CHUNK_SIZE - length : (size_t)written;
+    closed = false;
+}
+
+void ResponseSink::finish() {
+    // An empty final part still closes a response whose last chunk went out early
+    if (length > 0 || !closed) {
+        emitChunk(true);
+    }
+}
+
+void ResponseSink::emitChunk(bool final) {
+    parts++;
+    if (emit) emit(context, chunk, length, parts, final);
+    sent += length;
+    length = 0;
+    chunk[0] = '\0';
+    closed = final;
+}
@@ -0,0 +1,93 @@
+#include "sensor_aggregator.h"
+#include "logger.h"
+#include "response_sink.h"
+
+SensorAggregator::SensorAggregator()
+    : channelCount(0)
+    , onWindow(nullptr)
+    , context(nullptr) {
+
+    windowMs[0] = AGG_DEFAULT_WINDOW_1_MS;
+    windowMs[1] = AGG_DEFAULT_WINDOW_2_MS;
+    windowMs[2] = AGG_DEFAULT_WINDOW_3_MS;
+
+    unsigned long now = millis();
+    for (uint8_t w = 0; w < AGG_WINDOW_COUNT; w++) {
+        windowStart[w] = now;
+        windowsClosed[w] = 0;
+    }
+}
+
+void SensorAggregator::setWindowCallback(WindowFn callback, void* callbackContext) {
+    onWindow = callback;
+    context = callbackContext;
+}
+
+int8_t SensorAggregator::addChannel(const char* name) {
+    if (channelCount >= AGG_MAX_CHANNELS) {
+        debugPrintf("SensorAggregator: Cannot add channel %s (table full)\n", name ? name : "?");
+        return AGG_INVALID_ID;
+    }
+
+    Channel& channel = channels[channelCount];
+    channel.name = name;
+    for (uint8_t w = 0; w < AGG_WINDOW_COUNT; w++) {
+        channel.windows[w].reset();
+    }
+    return (int8_t)channelCount++;
+}
+
+void SensorAggregator::addSample(int8_t channel, float value) {
+    if (channel < 0 || channel >= channelCount || isnan(value)) return;
+
+    RunningStats* windows = channels[channel].windows;
+    for (uint8_t w = 0; w < AGG_WINDOW_COUNT; w++) {
+        windows[w].update(value);
+    }
+}
+
+void SensorAggregator::service(unsigned long now) {
+    for (uint8_t w = 0; w < AGG_WINDOW_COUNT; w++) {
+        if (now - windowStart[w] < windowMs[w]) continue;
+
+        // Keep the window phase, but restart from now after a stall
+        windowStart[w] += windowMs[w];
+        if (now - windowStart[w] >= windowMs[w]) {
+            windowStart[w] = now;
+        }
+        windowsClosed[w]++;
+
+        if (onWindow) onWindow(context, w, windowMs[w]);
+
+        for (uint8_t i = 0; i < channelCount; i++) {
+            channels[i].windows[w].reset();
+        }
+    }
+}
+
+bool SensorAggregator::setWindow(uint8_t window, unsigned long ms) {
+    if (window >= AGG_WINDOW_COUNT || ms < AGG_MIN_WINDOW_MS || ms > AGG_MAX_WINDOW_MS) return false;
+
+    // Start the new window cleanly rather than closing a mixed one
+    windowMs[window] = ms;
+    windowStart[window] = millis();
+    for (uint8_t i = 0; i < channelCount; i++) {
+        channels[i].windows[window].reset();
+    }
+    return true;
+}
+
+void SensorAggregator::getStatistics(ResponseSink& out) {
+    out.print("windows:");
+    for (uint8_t w = 0; w < AGG_WINDOW_COUNT; w++) {
+        out.printf(" %u=%lums(closed=%lu)", w + 1, windowMs[w], (unsigned long)windowsClosed[w]);
+    }
+
+    // Third window (the longest by default) so far, per channel
+    for (uint8_t i = 0; i < channelCount; i++) {
+        const RunningStats& stats = channels[i].windows[AGG_WINDOW_COUNT - 1];
+        out.printf("\r\n%s: n=%lu min=%.3f max=%.3f mean=%.3f sd=%.3f last=%.3f",
+            channels[i].name, (unsigned long)stats.getCount(), stats.getMin(), stats.getMax(),
+            stats.getMean(), stats.stddev(), stats.getLast());
+    }
+}
@@ -1,6 +1,19 @@
 #include "serial_bridge.h"
+#include "store_forward_log.h"
+#include "response_sink.h"
 #include <string.h>
 
+// Capacity of the Arduino core's interrupt-filled Serial1 FIFO
+#ifdef SERIAL_BUFFER_SIZE
+#define SERIAL1_CORE_RX_BUFFER_SIZE SERIAL_BUFFER_SIZE
+#else
+#define SERIAL1_CORE_RX_BUFFER_SIZE 64
+#endif
+
+// Bridge log lines go through LOG_AT, so every call site has its own rate
+// limiter and DEBUG sites compile out below LOG_COMPILE_LEVEL
+#define logBridgeActivity(level, format, ...) LOG_AT(level, "SerialBridge: " format, ##__VA_ARGS__)
+
 SerialBridge::SerialBridge()
     : networkManager(nullptr)
     , bridgeConnected(false)
@@ -11,16 +24,18 @@ SerialBridge::SerialBridge()
     , criticalMessages(0)
     , parseErrors(0)
     , messagesDropped(0)
-    , windowedReceived(0)
-    , windowedForwarded(0)
-    , windowStartTime(millis())
-    , bufferIndex(0)
-    , expectedMessageSize(0)
+    , lastLossPublish(0)
+    , lastMetricsPublish(0)
     , lastPublishTime(0)
     , burstStartTime(0)
-    , burstCount(0) {
-    
-    memset(messageBuffer, 0, sizeof(messageBuffer));
+    , burstCount(0)
+    , rxHead(0)
+    , rxTail(0)
+    , rxHighWater(0)
+    , rxOverruns(0)
+    , rxFifoSaturations(0)
+    , partialFrameStart(0)
+    , benchPending(0) {
 }
 
 void SerialBridge::begin() {
@@ -36,85 +51,82 @@ void SerialBridge::begin() {
     logBridgeActivity(LOG_INFO, "Serial bridge initialized on Serial1 at %d baud", SERIAL_BRIDGE_BAUD);
 }
 
-void SerialBridge::checkAndResetWindow() {
-    unsigned long currentTime = millis();
-    
-    // Check if window has expired (handle overflow)
-    bool windowExpired = false;
-    if (currentTime >= windowStartTime) {
-        windowExpired = (currentTime - windowStartTime) >= WINDOW_DURATION_MS;
-    } else {
-        // Handle millis() overflow (happens every ~49 days)
-        windowExpired = ((0xFFFFFFFF - windowStartTime) + currentTime) >= WINDOW_DURATION_MS;
-    }
-    
-    if (windowExpired) {
-        windowedReceived = 0;
-        windowedForwarded = 0;
-        windowStartTime = currentTime;
-        logBridgeActivity(LOG_DEBUG, "5-minute traffic window reset");
-    }
-}
-
 void SerialBridge::setNetworkManager(NetworkManager* network) {
     networkManager = network;
     
     // Initialize protobuf decoder for individual topic publishing
     protobufDecoder.begin(network);
+    
+    // Commands are sent from the MQTT callback itself, one frame each, so a
+    // burst of commands is pipelined rather than replacing each other
+    if (network) {
+        network->setRawSubscription(NetworkManager::RAW_SUB_COMMAND, TOPIC_CONTROLLER_COMMAND,
+            [](void* context, const uint8_t* data, size_t length) {
+                static_cast<ProtobufDecoder*>(context)->onMqttCommand(data, length);
+            }, &protobufDecoder);
+    }
     logBridgeActivity(LOG_INFO, "Network manager and protobuf decoder configured");
 }
 
-void SerialBridge::update() {
+void SerialBridge::pollReceive() {
     if (!bridgeConnected) return;
     
-    // Read available data from Serial1 (size-prefixed binary protobuf data)
-    // Per TELEMETRY_API.md: SIZE byte = header + payload length (NOT including size byte itself)
-    // Total message on wire = 1 (size byte) + SIZE value
-    while (Serial1.available()) {
-        uint8_t byte = Serial1.read();
+    // The Arduino core fills a small FIFO from the UART RX interrupt; if it is
+    // (nearly) full when we get here, bytes may already have been lost.
+    int pending = Serial1.available();
+    if (pending >= SERIAL1_CORE_RX_BUFFER_SIZE - 1) {
+        rxFifoSaturations++;
+    }
+    
+    uint16_t head = rxHead;
+    while (pending-- > 0) {
+        int value = Serial1.read();
+        if (value < 0) break;
         
-        // State machine for size-prefixed message parsing
-        if (bufferIndex == 0) {
-            // First byte is the message size (header + payload, NOT including size byte)
-            expectedMessageSize = byte;
-            
-            // Validate size is within reasonable bounds (6-32 bytes for header+payload)
-            // Per API: min 6 bytes (header only), max 32 bytes (header + max payload)
-            if (expectedMessageSize < 6 || expectedMessageSize > 32) {
-                parseErrors++;
-                logBridgeActivity(LOG_WARNING, "Invalid message size: %d bytes", expectedMessageSize);
-                continue; // Skip this byte and try next
-            }
-            
-            // Store the size byte at index 0
-            messageBuffer[bufferIndex++] = byte;
+        uint16_t next = (head + 1) & BRIDGE_RX_RING_MASK;
+        if (next == rxTail) {
+            // Ring full - drop the byte, framing will resync on the next size byte
+            rxOverruns++;
+            metrics.recordDrop(DROP_OVERRUN, millis());
+            continue;
         }
-        else {
-            // Add byte to buffer if there's space
-            if (bufferIndex < sizeof(messageBuffer) - 1) {
-                messageBuffer[bufferIndex++] = byte;
-                
-                // Check if we have received the complete message
-                // bufferIndex includes size byte, so complete when bufferIndex = 1 + expectedMessageSize
-                if (bufferIndex >= (size_t)(expectedMessageSize + 1)) {
-                    // Process the complete protobuf message (including size byte)
-                    processProtobufMessage(reinterpret_cast<uint8_t*>(messageBuffer), bufferIndex);
-                    
-                    // Reset buffer for next message
-                    bufferIndex = 0;
-                    expectedMessageSize = 0;
-                    memset(messageBuffer, 0, sizeof(messageBuffer));
-                }
-            }
-            // Buffer overflow - reset and log error
-            else {
-                parseErrors++;
-                logBridgeActivity(LOG_ERROR, "Protobuf buffer overflow, discarding data");
-                bufferIndex = 0;
-                expectedMessageSize = 0;
-                memset(messageBuffer, 0, sizeof(messageBuffer));
-            }
+        
+        rxRing[head] = (uint8_t)value;
+        if (head < PROTOBUF_MAX_MESSAGE_SIZE) {
+            rxRing[BRIDGE_RX_RING_SIZE + head] = (uint8_t)value;
         }
+        head = next;
+    }
+    rxHead = head;
+    
+    uint16_t used = rxAvailable();
+    if (used > rxHighWater) {
+        rxHighWater = used;
+    }
+}
+
+void SerialBridge::update() {
+    if (!bridgeConnected) return;
+    
+    pollReceive();
+    processReceivedFrames();
+    drainLanes();
+    protobufDecoder.service();
+    
+    if (bench.isRunning()) {
+        injectBenchFrames();
+        processReceivedFrames();
+        if (bench.service(millis())) endBench();
+    }
+    
+    if (millis() - lastLossPublish >= BRIDGE_LOSS_PUBLISH_INTERVAL_MS) {
+        publishLossStatistics();
+        lastLossPublish = millis();
+    }
+    
+    if (millis() - lastMetricsPublish >= BRIDGE_METRICS_PUBLISH_INTERVAL_MS) {
+        publishMetrics();
+        lastMetricsPublish = millis();
     }
     
     // Check for communication timeout
@@ -127,59 +139,311 @@ void SerialBridge::update() {
             lastTimeoutLog = millis();
         }
     }
-    
-    // Check for incomplete message timeout (reset partial message after 1 second)
-    static unsigned long lastByteTime = 0;
-    if (bufferIndex > 0) {
-        if (lastByteTime == 0) {
-            lastByteTime = millis();
-        } else if (millis() - lastByteTime > 1000) {
-            logBridgeActivity(LOG_WARNING, "Incomplete message timeout, discarding %d bytes", bufferIndex);
-            bufferIndex = 0;
-            expectedMessageSize = 0;
-            memset(messageBuffer, 0, sizeof(messageBuffer));
+}
+
+void SerialBridge::processReceivedFrames() {
+    // Frames are parsed in place in the ring. Per TELEMETRY_API.md the SIZE byte
+    // is header + payload length (NOT including the size byte itself), so the
+    // total message on the wire is 1 (size byte) + SIZE.
+    uint16_t available = rxAvailable();
+    
+    while (available > 0) {
+        uint8_t expectedMessageSize = rxRing[rxTail];
+        
+        // Validate size is within reasonable bounds (6-32 bytes for header+payload)
+        // Per API: min 6 bytes (header only), max 32 bytes (header + max payload)
+        if (expectedMessageSize < 6 || expectedMessageSize > 32) {
+            parseErrors++;
+            metrics.recordDrop(DROP_PARSE, millis());
+            logBridgeActivity(LOG_WARNING, "Invalid message size: %d bytes", expectedMessageSize);
+            rxTail = (rxTail + 1) & BRIDGE_RX_RING_MASK;  // Skip this byte and try next
+            available--;
+            partialFrameStart = 0;
+            continue;
+        }
+        
+        size_t frameLength = (size_t)expectedMessageSize + 1;
+        if (available < frameLength) {
+            break;  // Wait for the rest of the frame
+        }
+        
+        // Mirrored tail bytes make the frame contiguous even across the wrap
+        if (benchPending > 0 && rxTail == benchStarts[0]) {
+            benchPending--;
+            memmove(benchStarts, benchStarts + 1, benchPending * sizeof(benchStarts[0]));
+            processBenchFrame(&rxRing[rxTail], frameLength);
+        } else {
+            processProtobufMessage(&rxRing[rxTail], frameLength);
+        }
+        
+        rxTail = (rxTail + frameLength) & BRIDGE_RX_RING_MASK;
+        available -= frameLength;
+        partialFrameStart = 0;
+    }
+    
+    // Check for incomplete message timeout (discard partial message after 1 second)
+    if (available > 0) {
+        if (partialFrameStart == 0) {
+            partialFrameStart = millis();
+        } else if (millis() - partialFrameStart > BRIDGE_TIMEOUT_MS) {
+            logBridgeActivity(LOG_WARNING, "Incomplete message timeout, discarding %d bytes", available);
+            rxTail = (rxTail + available) & BRIDGE_RX_RING_MASK;
             parseErrors++;
-            lastByteTime = 0;
+            metrics.recordDrop(DROP_PARSE, millis());
+            partialFrameStart = 0;
         }
     } else {
-        lastByteTime = 0;
+        partialFrameStart = 0;
     }
 }
 
-void SerialBridge::processProtobufMessage(uint8_t* data, size_t length) {
+void SerialBridge::processProtobufMessage(const uint8_t* data, size_t length) {
     if (length == 0) return;
     
-    // Check and reset 5-minute window if needed
-    checkAndResetWindow();
-    
     messagesReceived++;
-    windowedReceived++;
     lastMessageTime = millis();
+    metrics.recordFrame(length, lastMessageTime);
     
     logBridgeActivity(LOG_DEBUG, "Received protobuf message: %d bytes", length);
     
+    // Command responses are matched to their command, never forwarded
+    if (data[1] == CONTROLLER_RESPONSE_TYPE) {
+        protobufDecoder.processCommandResponse(data, length);
+        return;
+    }
+    
+    // Sequence accounting covers every framed message, forwarded or not
+    protobufDecoder.trackSequence(data, length);
+    
+    // While MQTT is down every frame goes to the store-and-forward log in order
+    BridgeLane lane = BridgeLanes::laneOf(data, length);
+    if (lane == LANE_CRITICAL || !networkManager || !networkManager->isMQTTConnected()) {
+        uint32_t framedUs = micros();
+        LaneOutcome outcome = forwardFrame(lane, data, length);
+        lanes.record(lane, outcome, micros() - framedUs);
+        return;
+    }
+    
+    queueFrame(lane, data, length);
+}
+
+void SerialBridge::queueFrame(BridgeLane lane, const uint8_t* data, size_t length) {
+    if (lanes.enqueue(lane, data, length, micros())) return;
+    
+    // Lane full: send its oldest frame early to make room
+    int8_t slot = lanes.oldest(lane);
+    if (slot >= 0) {
+        lanes.recordEarly(lane);
+        sendQueuedFrame((uint8_t)slot);
+        if (lanes.enqueue(lane, data, length, micros())) return;
+    }
+    
+    // Does not fit a slot
+    uint32_t framedUs = micros();
+    LaneOutcome outcome = forwardFrame(lane, data, length);
+    lanes.record(lane, outcome, micros() - framedUs);
+}
+
+void SerialBridge::sendQueuedFrame(uint8_t slot) {
+    LaneOutcome outcome = forwardFrame(lanes.laneAt(slot), lanes.frameAt(slot), lanes.lengthAt(slot));
+    lanes.release(slot, outcome, micros(), millis());
+}
+
+void SerialBridge::drainLanes() {
+    if (lanes.getDepth() == 0) return;
+    
+    // MQTT went down with frames queued: move them all to the replay log
+    if (!networkManager || !networkManager->isMQTTConnected()) {
+        for (uint8_t l = LANE_EVENT; l < LANE_COUNT; l++) {
+            int8_t slot;
+            while ((slot = lanes.oldest((BridgeLane)l)) >= 0) {
+                sendQueuedFrame((uint8_t)slot);
+            }
+        }
+        return;
+    }
+    
+    for (uint8_t sent = 0; sent < BRIDGE_LANE_SENDS_PER_PASS; sent++) {
+        int8_t slot = lanes.due(millis());
+        if (slot < 0) break;
+        sendQueuedFrame((uint8_t)slot);
+        
+        // Frame whatever arrived during the publish, so a critical frame
+        // goes out before the next queued one
+        pollReceive();
+        processReceivedFrames();
+    }
+}
+
+LaneOutcome SerialBridge::forwardFrame(BridgeLane lane, const uint8_t* data, size_t length) {
     // Forward complete raw protobuf message (including size byte) to MQTT
     if (networkManager && networkManager->isMQTTConnected()) {
         // Publish raw protobuf data to controller/protobuff topic
+        uint32_t publishStart = micros();
         bool rawSuccess = networkManager->publishBinary("controller/protobuff", data, length);
         
         if (rawSuccess) {
             messagesForwarded++;
-            windowedForwarded++;
+            metrics.recordPublish(micros() - publishStart, millis());
             logBridgeActivity(LOG_DEBUG, "Forwarded raw protobuf to MQTT: %d bytes", length);
         } else {
             messagesDropped++;
+            metrics.recordDrop(DROP_PUBLISH, millis());
             logBridgeActivity(LOG_WARNING, "Failed to forward raw protobuf message to MQTT");
         }
         
-        // Decode protobuf and publish to individual topics
+        // Decode protobuf and publish to individual topics; critical and
+        // event topics skip the coalescing publish queue, so a relay or
+        // sequence ON/OFF pair is not collapsed to its last value
         if (length >= 7) { // Minimum valid message size (1 size + 6 header)
+            protobufDecoder.setImmediate(lane != LANE_ROUTINE);
             protobufDecoder.decodeAndPublish(data, length);
+            protobufDecoder.setImmediate(false);
         }
+        return rawSuccess ? LANE_SENT : LANE_DROPPED;
+    } else if (g_storeForward && g_storeForward->appendFrame(data, length)) {
+        // Persisted for replay once MQTT is back
+        logBridgeActivity(LOG_DEBUG, "MQTT not connected, frame stored for replay");
+        return LANE_STORED;
     } else {
         messagesDropped++;
+        metrics.recordDrop(DROP_OFFLINE, millis());
         logBridgeActivity(LOG_WARNING, "Cannot forward protobuf - MQTT not connected");
+        return LANE_DROPPED;
+    }
+}
+
+void SerialBridge::publishLossStatistics() {
+    if (!networkManager || !networkManager->isMQTTConnected()) return;
+    
+    char payload[192];
+    protobufDecoder.getSequenceSummaryJson(payload, sizeof(payload), messagesDropped);
+    networkManager->publish(TOPIC_BRIDGE_LOSS, payload);
+}
+
+uint8_t SerialBridge::getBackPressure() const {
+    // Broker unreachable: every frame spills to the store-and-forward log
+    if (!networkManager || !networkManager->isMQTTConnected()) return 100;
+    
+    uint16_t lanePercent = (uint16_t)lanes.getDepth() * 100 / BRIDGE_LANE_SLOTS;
+    uint16_t queuePercent = (uint16_t)networkManager->getQueueDepth() * 100 / MQTT_QUEUE_DEPTH;
+    return (uint8_t)(lanePercent > queuePercent ? lanePercent : queuePercent);
+}
+
+void SerialBridge::publishMetrics() {
+    if (!networkManager || !networkManager->isMQTTConnected()) return;
+    
+    // Retained, so a dashboard that subscribes later gets the current rates
+    char payload[160];
+    metrics.getSummaryJson(payload, sizeof(payload), BRIDGE_METRICS_WINDOW_S, millis());
+    networkManager->publishWithRetain(TOPIC_BRIDGE_METRICS, payload);
+}
+
+bool SerialBridge::ringWrite(const uint8_t* data, size_t length) {
+    if (length > (size_t)(BRIDGE_RX_RING_SIZE - 1 - rxAvailable())) return false;
+    
+    uint16_t head = rxHead;
+    for (size_t i = 0; i < length; i++) {
+        rxRing[head] = data[i];
+        if (head < PROTOBUF_MAX_MESSAGE_SIZE) {
+            rxRing[BRIDGE_RX_RING_SIZE + head] = data[i];
+        }
+        head = (head + 1) & BRIDGE_RX_RING_MASK;
+    }
+    rxHead = head;
+    return true;
+}
+
+bool SerialBridge::beginBench() {
+    if (!bridgeConnected || !networkManager || !networkManager->isMQTTConnected()) return false;
+    
+    benchPending = 0;
+    networkManager->setRawSubscription(NetworkManager::RAW_SUB_BENCH, TOPIC_BRIDGE_BENCH,
+        [](void* context, const uint8_t* data, size_t length) {
+            static_cast<BridgeBench*>(context)->onEcho(data, length);
+        }, &bench);
+    return true;
+}
+
+bool SerialBridge::startBench(uint16_t rateHz, uint16_t seconds) {
+    if (bench.isRunning() || !beginBench()) return false;
+    if (!bench.start(rateHz, seconds)) {
+        endBench();
+        return false;
+    }
+    logBridgeActivity(LOG_INFO, "Bench started at %u Hz for %u s", rateHz, seconds);
+    return true;
+}
+
+bool SerialBridge::startBenchRamp() {
+    if (bench.isRunning() || !beginBench()) return false;
+    bench.startRamp();
+    logBridgeActivity(LOG_INFO, "Bench ramp started");
+    return true;
+}
+
+void SerialBridge::stopBench() {
+    if (!bench.isRunning()) return;
+    bench.stop();
+    endBench();
+}
+
+void SerialBridge::endBench() {
+    if (networkManager) networkManager->setRawSubscription(NetworkManager::RAW_SUB_BENCH, nullptr, nullptr, nullptr);
+    logBridgeActivity(LOG_INFO, "Bench finished");
+}
+
+void SerialBridge::injectBenchFrames() {
+    uint8_t due = bench.framesDue(micros());
+    if (due == 0) return;
+    
+    // Frames go in only at a frame boundary, never into a partial controller frame
+    if (rxAvailable() != 0 || benchPending > 0) {
+        bench.recordDeferred(due);
+        return;
+    }
+    
+    uint8_t frame[BENCH_FRAME_LENGTH];
+    uint8_t injected = 0;
+    while (injected < due && benchPending < BENCH_MAX_CATCHUP) {
+        uint16_t start = rxHead;
+        bench.buildFrame(frame, micros());
+        if (!ringWrite(frame, sizeof(frame))) break;
+        benchStarts[benchPending++] = start;
+        injected++;
+    }
+    bench.recordInjected(injected);
+    if (injected < due) bench.recordDeferred(due - injected);
+}
+
+void SerialBridge::processBenchFrame(const uint8_t* data, size_t length) {
+    if (!bench.isBenchFrame(data, length)) {
+        processProtobufMessage(data, length);
+        return;
     }
+    
+    unsigned long framedUs = micros();
+    bench.recordStage(BENCH_STAGE_WAIT, (uint32_t)framedUs - bench.injectedAt(data));
+    
+    // Same calls as processProtobufMessage(), but not to controller topics
+    // and outside the sequence and message accounting
+    bool forwarded = networkManager && networkManager->isMQTTConnected() &&
+                     networkManager->publishBinary(TOPIC_BRIDGE_BENCH, data, length);
+    unsigned long forwardedUs = micros();
+    bench.recordForward(forwarded, forwardedUs - framedUs);
+    
+    protobufDecoder.setDryRun(true);
+    protobufDecoder.decodeAndPublish(data, length);
+    protobufDecoder.setDryRun(false);
+    bench.recordStage(BENCH_STAGE_DECODE, micros() - forwardedUs);
+}
+
+void SerialBridge::getSequenceStatistics(ResponseSink& out) {
+    protobufDecoder.getSequenceStatistics(out);
+}
+
+void SerialBridge::resetSequenceStatistics() {
+    protobufDecoder.resetSequenceStatistics();
 }
 
 // Legacy text message processing (deprecated)
@@ -473,6 +737,9 @@ String SerialBridge::extractValue(const String& text, const String& prefix, cons
 }
 
 void SerialBridge::getStatistics(char* buffer, size_t bufferSize) {
+    BridgeMetrics::Summary recent;
+    metrics.summarize(BRIDGE_METRICS_WINDOW_S, millis(), recent);
+    
     snprintf(buffer, bufferSize,
         "Serial Bridge Stats:\n"
         "Connected: %s\n"
@@ -481,31 +748,28 @@ void SerialBridge::getStatistics(char* buffer, size_t bufferSize) {
         "Messages Forwarded: %lu\n"
         "Messages Dropped: %lu\n"
         "Parse Errors: %lu\n"
-        "Buffer State: %d/%d bytes\n"
-        "Expected Size: %d bytes\n"
+        "RX Ring: %u/%u bytes (peak %u)\n"
+        "RX Overruns: %lu (fifo full %lu)\n"
+        "Last %us: %.1f in/s, %.1f pub/s, publish p99 %lu us\n"
         "Last Message: %lu ms ago",
         bridgeConnected ? "YES" : "NO",
         messagesReceived,
         messagesForwarded,
         messagesDropped,
         parseErrors,
-        bufferIndex,
-        sizeof(messageBuffer),
-        expectedMessageSize,
+        (unsigned)rxAvailable(),
+        (unsigned)(BRIDGE_RX_RING_SIZE - 1),
+        (unsigned)rxHighWater,
+        rxOverruns,
+        rxFifoSaturations,
+        recent.seconds,
+        recent.inRate,
+        recent.publishRate,
+        (unsigned long)recent.p99Us,
         lastMessageTime > 0 ? millis() - lastMessageTime : 0
     );
 }
 
-void SerialBridge::logBridgeActivity(LogLevel level, const char* format, ...) {
-    char buffer[256];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-    
-    Logger::log(level, "SerialBridge: %s", buffer);
-}
-
 bool SerialBridge::shouldPublishMessage(const String& level) {
     unsigned long currentTime = millis();
     
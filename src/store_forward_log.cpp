@@ -0,0 +1,325 @@
+#include "store_forward_log.h"
+#include "network_manager.h"
+#include "constants.h"
+#include "logger.h"
+#include "config_log.h"
+#include <string.h>
+
+static_assert(SFLOG_EEPROM_START >= CONFIG_LOG_EEPROM_START + 2 * CONFIG_LOG_BANK_SIZE,
+              "Store-and-forward log must start above the config log banks");
+
+// Record state byte values
+#define SFLOG_STATE_PENDING  0xA5
+#define SFLOG_STATE_REPLAYED 0x00
+#define SFLOG_STATE_EMPTY    0xFF
+
+// Append `text` as a quoted JSON string; `out` must hold 6 bytes per input
+// character (\u00XX) plus the quotes and terminator
+static size_t appendJsonString(char* out, size_t len, const char* text) {
+    out[len++] = '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            out[len++] = '\\';
+            out[len++] = *c;
+        } else if ((uint8_t)*c < 0x20) {
+            len += sprintf(out + len, "\\u%04x", (uint8_t)*c);
+        } else {
+            out[len++] = *c;
+        }
+    }
+    out[len++] = '"';
+    out[len] = '\0';
+    return len;
+}
+
+StoreForwardLog::StoreForwardLog()
+    : networkManager(nullptr)
+    , initialized(false)
+    , slotCount(0)
+    , headSlot(0)
+    , tailSlot(0)
+    , pendingRecords(0)
+    , nextSequence(1)
+    , stagedHead(0)
+    , stagedTail(0)
+    , stagedCount(0)
+    , writeOffset(-1)
+    , replayActive(false)
+    , lastReplayTime(0)
+    , recordsStored(0)
+    , recordsReplayed(0)
+    , recordsOverwritten(0)
+    , recordsDropped(0)
+    , corruptRecords(0) {
+}
+
+void StoreForwardLog::begin(NetworkManager* network) {
+    networkManager = network;
+
+    int regionEnd = EEPROM.length();
+    if (regionEnd > SFLOG_EEPROM_END) regionEnd = SFLOG_EEPROM_END;
+    if (regionEnd <= SFLOG_EEPROM_START) {
+        debugPrintf("StoreForward: No EEPROM space for log (length=%d)\n", (int)EEPROM.length());
+        return;
+    }
+    slotCount = (regionEnd - SFLOG_EEPROM_START) / SFLOG_RECORD_SIZE;
+
+    // Rebuild ring position from flash: the newest valid record (pending or
+    // replayed) marks the head, the oldest pending record marks the tail.
+    uint32_t newestSeq = 0;
+    uint32_t oldestPendingSeq = 0xFFFFFFFF;
+    bool haveNewest = false;
+    uint8_t record[SFLOG_RECORD_SIZE];
+
+    for (uint16_t slot = 0; slot < slotCount; slot++) {
+        int addr = slotAddress(slot);
+        for (uint8_t i = 0; i < SFLOG_RECORD_SIZE; i++) {
+            record[i] = EEPROM.read(addr + i);
+        }
+
+        uint8_t state = record[0];
+        if (state != SFLOG_STATE_PENDING && state != SFLOG_STATE_REPLAYED) continue;
+        if (record[2] > SFLOG_DATA_SIZE || recordCrc(record) != record[3]) continue;
+
+        uint32_t seq;
+        memcpy(&seq, &record[4], sizeof(seq));
+
+        if (!haveNewest || seq > newestSeq) {
+            newestSeq = seq;
+            headSlot = (slot + 1) % slotCount;
+            haveNewest = true;
+        }
+        if (state == SFLOG_STATE_PENDING) {
+            pendingRecords++;
+            if (seq < oldestPendingSeq) {
+                oldestPendingSeq = seq;
+                tailSlot = slot;
+            }
+        }
+    }
+
+    if (haveNewest) {
+        nextSequence = newestSeq + 1;
+    }
+    if (pendingRecords == 0) {
+        tailSlot = headSlot;
+    }
+
+    initialized = true;
+    debugPrintf("StoreForward: %u slots, %u pending records, next seq=%lu\n",
+        slotCount, pendingRecords, (unsigned long)nextSequence);
+}
+
+bool StoreForwardLog::append(uint8_t kind, const uint8_t* data, size_t length) {
+    if (!initialized || !data || length == 0 || length > SFLOG_DATA_SIZE ||
+        stagedCount >= SFLOG_STAGING_RECORDS) {
+        recordsDropped++;
+        return false;
+    }
+
+    // Build the full record image in RAM; service() copies it to flash later
+    uint8_t* record = staging[stagedHead];
+    memset(record, SFLOG_STATE_EMPTY, SFLOG_RECORD_SIZE);
+    record[0] = SFLOG_STATE_PENDING;
+    record[1] = kind;
+    record[2] = (uint8_t)length;
+
+    uint32_t seq = nextSequence++;
+    uint32_t captured = millis();
+    memcpy(&record[4], &seq, sizeof(seq));
+    memcpy(&record[8], &captured, sizeof(captured));
+    memcpy(&record[SFLOG_HEADER_SIZE], data, length);
+    record[3] = recordCrc(record);
+
+    stagedHead = (stagedHead + 1) % SFLOG_STAGING_RECORDS;
+    stagedCount++;
+    return true;
+}
+
+bool StoreForwardLog::appendFrame(const uint8_t* frame, size_t length) {
+    return append(SFLOG_KIND_CONTROLLER_FRAME, frame, length);
+}
+
+bool StoreForwardLog::appendSample(const char* topic, const char* payload) {
+    if (!topic || !payload) return false;
+
+    size_t topicLength = strlen(topic);
+    size_t payloadLength = strlen(payload);
+    if (topicLength + 1 + payloadLength > SFLOG_DATA_SIZE) {
+        recordsDropped++;
+        return false;
+    }
+
+    uint8_t data[SFLOG_DATA_SIZE];
+    memcpy(data, topic, topicLength + 1);
+    memcpy(data + topicLength + 1, payload, payloadLength);
+    return append(SFLOG_KIND_MONITOR_SAMPLE, data, topicLength + 1 + payloadLength);
+}
+
+void StoreForwardLog::service() {
+    if (!initialized) return;
+
+    serviceWrite();
+    serviceReplay();
+}
+
+void StoreForwardLog::serviceWrite() {
+    if (writeOffset < 0) {
+        if (stagedCount == 0) return;
+
+        // Log full - the slot under the head still holds the oldest pending record
+        if (pendingRecords >= slotCount) {
+            pendingRecords--;
+            recordsOverwritten++;
+            advanceTail();
+        }
+
+        // Invalidate the slot first so a reset mid-write leaves no half record
+        EEPROM.update(slotAddress(headSlot), SFLOG_STATE_EMPTY);
+        writeOffset = 1;
+        return;
+    }
+
+    const uint8_t* record = staging[stagedTail];
+    int addr = slotAddress(headSlot);
+    int recordEnd = SFLOG_HEADER_SIZE + record[2];
+
+    for (uint8_t n = 0; n < SFLOG_WRITE_SLICE_BYTES && writeOffset < recordEnd; n++) {
+        EEPROM.update(addr + writeOffset, record[writeOffset]);
+        writeOffset++;
+    }
+
+    if (writeOffset < recordEnd) return;
+
+    // Body complete - committing the state byte makes the record visible
+    EEPROM.update(addr, SFLOG_STATE_PENDING);
+
+    if (pendingRecords == 0) {
+        tailSlot = headSlot;
+    }
+    headSlot = (headSlot + 1) % slotCount;
+    pendingRecords++;
+    recordsStored++;
+
+    stagedTail = (stagedTail + 1) % SFLOG_STAGING_RECORDS;
+    stagedCount--;
+    writeOffset = -1;
+}
+
+void StoreForwardLog::serviceReplay() {
+    if (pendingRecords == 0 || !networkManager || !networkManager->isMQTTConnected()) {
+        replayActive = false;
+        return;
+    }
+
+    // Live traffic has priority: only replay while the publish queue has room
+    if (networkManager->getQueueDepth() > MQTT_QUEUE_DEPTH / 2) return;
+
+    unsigned long now = millis();
+    if (now - lastReplayTime < SFLOG_REPLAY_INTERVAL_MS) return;
+    lastReplayTime = now;
+
+    if (!replayActive) {
+        replayActive = true;
+        debugPrintf("StoreForward: Replaying %u stored records\n", pendingRecords);
+    }
+
+    if (!replaySlot(tailSlot)) return;  // Publish failed - retry the same record later
+
+    EEPROM.update(slotAddress(tailSlot), SFLOG_STATE_REPLAYED);
+    pendingRecords--;
+    advanceTail();
+
+    if (pendingRecords == 0) {
+        replayActive = false;
+        debugPrintf("StoreForward: Replay complete (%lu records total)\n", (unsigned long)recordsReplayed);
+    }
+}
+
+bool StoreForwardLog::replaySlot(uint16_t slot) {
+    uint8_t record[SFLOG_RECORD_SIZE];
+    int addr = slotAddress(slot);
+    for (uint8_t i = 0; i < SFLOG_RECORD_SIZE; i++) {
+        record[i] = EEPROM.read(addr + i);
+    }
+
+    uint8_t length = record[2];
+    if (record[0] != SFLOG_STATE_PENDING || length > SFLOG_DATA_SIZE || recordCrc(record) != record[3]) {
+        corruptRecords++;
+        return true;  // Consume it so replay does not stall
+    }
+
+    const uint8_t* data = &record[SFLOG_HEADER_SIZE];
+    bool success = false;
+
+    if (record[1] == SFLOG_KIND_CONTROLLER_FRAME) {
+        // Frame carries the controller's own timestamp and sequence ID.
+        // Only the raw topic is replayed; decoded topics hold live state.
+        success = networkManager->publishBinary(TOPIC_SFLOG_CONTROLLER_REPLAY, data, length);
+    } else if (record[1] == SFLOG_KIND_MONITOR_SAMPLE) {
+        char sample[SFLOG_DATA_SIZE + 1];
+        memcpy(sample, data, length);
+        sample[length] = '\0';
+
+        const char* topic = sample;
+        const char* value = sample + strlen(sample);
+        if (value < sample + length) value++;  // Skip the separator
+
+        uint32_t seq;
+        uint32_t captured;
+        memcpy(&seq, &record[4], sizeof(seq));
+        memcpy(&captured, &record[8], sizeof(captured));
+
+        // Topic and value share SFLOG_DATA_SIZE bytes, each may escape to 6x
+        char payload[SFLOG_DATA_SIZE * 6 + 64];
+        size_t len = 0;
+        len += sprintf(payload, "{\"topic\":");
+        len = appendJsonString(payload, len, topic);
+        len += sprintf(payload + len, ",\"value\":");
+        len = appendJsonString(payload, len, value);
+        snprintf(payload + len, sizeof(payload) - len, ",\"t\":%lu,\"seq\":%lu}",
+            (unsigned long)captured, (unsigned long)seq);
+        success = networkManager->publish(TOPIC_SFLOG_MONITOR_REPLAY, payload);
+    } else {
+        corruptRecords++;
+        return true;
+    }
+
+    if (success) {
+        recordsReplayed++;
+    }
+    return success;
+}
+
+void StoreForwardLog::advanceTail() {
+    tailSlot = (tailSlot + 1) % slotCount;
+}
+
+uint8_t StoreForwardLog::crc8(const uint8_t* data, size_t length, uint8_t crc) {
+    // CRC-8, polynomial 0x07
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint8_t StoreForwardLog::recordCrc(const uint8_t* record) {
+    // Covers kind and length, then sequence, timestamp and data
+    uint8_t crc = crc8(&record[1], 2);
+    return crc8(&record[4], SFLOG_HEADER_SIZE - 4 + record[2], crc);
+}
+
+void StoreForwardLog::getStatistics(char* buffer, size_t bufferSize) {
+    if (!buffer || bufferSize == 0) return;
+
+    snprintf(buffer, bufferSize,
+        "backlog=%u/%u staged=%u stored=%lu replayed=%lu overwritten=%lu dropped=%lu corrupt=%lu%s",
+        (unsigned)pendingRecords, (unsigned)slotCount, (unsigned)stagedCount,
+        (unsigned long)recordsStored, (unsigned long)recordsReplayed,
+        (unsigned long)recordsOverwritten, (unsigned long)recordsDropped,
+        (unsigned long)corruptRecords,
+        replayActive ? " replaying" : "");
+}
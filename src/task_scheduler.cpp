@@ -0,0 +1,200 @@
+#include "task_scheduler.h"
+#include "logger.h"
+#include "response_sink.h"
+#include <string.h>
+
+TaskScheduler::TaskScheduler()
+    : taskCount(0)
+    , currentTask(SCHEDULER_INVALID_TASK)
+    , resumeRequested(false)
+    , resumeDelayMs(0)
+    , idleHook(nullptr)
+    , idleContext(nullptr)
+    , inIdleHook(false)
+    , passCount(0)
+    , maxPassUs(0) {
+
+    memset(tasks, 0, sizeof(tasks));
+}
+
+int8_t TaskScheduler::addTask(const char* name, TaskCallback callback, void* context,
+                              unsigned long periodMs, unsigned long budgetUs) {
+    if (!callback || taskCount >= SCHEDULER_MAX_TASKS) {
+        debugPrintf("Scheduler: Cannot add task %s (table full)\n", name ? name : "?");
+        return SCHEDULER_INVALID_TASK;
+    }
+
+    Task& task = tasks[taskCount];
+    memset(&task, 0, sizeof(task));
+    task.name = name;
+    task.callback = callback;
+    task.context = context;
+    task.periodMs = periodMs;
+    task.budgetUs = budgetUs;
+    task.nextRunMs = millis();
+    task.enabled = true;
+
+    debugPrintf("Scheduler: Task %s added (period=%lums budget=%luus)\n", name, periodMs, budgetUs);
+    return (int8_t)taskCount++;
+}
+
+void TaskScheduler::setEnabled(int8_t taskId, bool enabled) {
+    if (taskId < 0 || taskId >= taskCount) return;
+
+    Task& task = tasks[taskId];
+    if (enabled && !task.enabled) {
+        task.nextRunMs = millis();
+    }
+    task.enabled = enabled;
+}
+
+void TaskScheduler::setPeriod(int8_t taskId, unsigned long periodMs) {
+    if (taskId < 0 || taskId >= taskCount) return;
+    tasks[taskId].periodMs = periodMs;
+}
+
+void TaskScheduler::run() {
+    unsigned long passStart = micros();
+    uint32_t ranMask = 0;
+
+    // Earliest deadline first: keep picking the most overdue task that has
+    // not run in this pass until nothing else is due.
+    while (true) {
+        unsigned long now = millis();
+        int8_t selected = SCHEDULER_INVALID_TASK;
+        long mostLate = -1;
+
+        for (uint8_t i = 0; i < taskCount; i++) {
+            if (!tasks[i].enabled || (ranMask & (1UL << i))) continue;
+
+            long lateness = (long)(now - tasks[i].nextRunMs);
+            if (lateness >= 0 && lateness > mostLate) {
+                mostLate = lateness;
+                selected = (int8_t)i;
+            }
+        }
+
+        if (selected == SCHEDULER_INVALID_TASK) break;
+
+        ranMask |= (1UL << selected);
+        runTask((uint8_t)selected, now);
+    }
+
+    passCount++;
+    uint32_t passUs = micros() - passStart;
+    if (passUs > maxPassUs) {
+        maxPassUs = passUs;
+    }
+}
+
+void TaskScheduler::runTask(uint8_t index, unsigned long now) {
+    Task& task = tasks[index];
+
+    // Lateness only means something for periodic tasks
+    if (task.periodMs > 0) {
+        uint32_t lateness = now - task.nextRunMs;
+        task.totalLatenessMs += lateness;
+        if (lateness > task.maxLatenessMs) {
+            task.maxLatenessMs = lateness;
+        }
+    }
+
+    currentTask = (int8_t)index;
+    resumeRequested = false;
+
+    unsigned long startUs = micros();
+    task.callback(task.context);
+    uint32_t elapsedUs = micros() - startUs;
+
+    currentTask = SCHEDULER_INVALID_TASK;
+
+    task.runCount++;
+    task.lastRunUs = elapsedUs;
+    task.totalRunUs += elapsedUs;
+    if (elapsedUs > task.maxRunUs) {
+        task.maxRunUs = elapsedUs;
+    }
+    if (task.budgetUs > 0 && elapsedUs > task.budgetUs) {
+        task.overBudgetCount++;
+    }
+
+    unsigned long finished = millis();
+    if (resumeRequested) {
+        task.nextRunMs = finished + resumeDelayMs;
+    } else if (task.periodMs == 0) {
+        task.nextRunMs = finished;
+    } else {
+        // Keep a fixed cadence; if we fell a whole period behind, skip ahead
+        task.nextRunMs += task.periodMs;
+        if ((long)(finished - task.nextRunMs) >= 0) {
+            task.missedPeriods++;
+            task.nextRunMs = finished + task.periodMs;
+        }
+    }
+}
+
+void TaskScheduler::resumeAfter(unsigned long delayMs) {
+    if (currentTask == SCHEDULER_INVALID_TASK) return;
+    resumeRequested = true;
+    resumeDelayMs = delayMs;
+}
+
+void TaskScheduler::setIdleHook(TaskCallback callback, void* context) {
+    idleHook = callback;
+    idleContext = context;
+}
+
+void TaskScheduler::cooperativeDelay(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        if (idleHook && !inIdleHook) {
+            inIdleHook = true;
+            idleHook(idleContext);
+            inIdleHook = false;
+        }
+    }
+}
+
+void TaskScheduler::resetStatistics() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        task.runCount = 0;
+        task.overBudgetCount = 0;
+        task.missedPeriods = 0;
+        task.lastRunUs = 0;
+        task.maxRunUs = 0;
+        task.totalRunUs = 0;
+        task.maxLatenessMs = 0;
+        task.totalLatenessMs = 0;
+    }
+    passCount = 0;
+    maxPassUs = 0;
+}
+
+void TaskScheduler::getStatistics(ResponseSink& out) {
+    out.printf("passes=%lu maxpass=%luus",
+        (unsigned long)passCount, (unsigned long)maxPassUs);
+
+    // One compact entry per task: name avg/max runtime (us), max lateness (ms), overruns
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        unsigned long avgUs = task.runCount > 0 ? (unsigned long)(task.totalRunUs / task.runCount) : 0;
+        out.printf(
+            "\r\n%s: n=%lu avg=%luus max=%luus late=%lums over=%lu miss=%lu",
+            task.name,
+            (unsigned long)task.runCount,
+            avgUs,
+            (unsigned long)task.maxRunUs,
+            (unsigned long)task.maxLatenessMs,
+            (unsigned long)task.overBudgetCount,
+            (unsigned long)task.missedPeriods);
+    }
+}
+
+void cooperativeDelay(unsigned long ms) {
+    if (g_scheduler) {
+        g_scheduler->cooperativeDelay(ms);
+    } else {
+        delay(ms);
+    }
+}
@@ -1,14 +1,25 @@
 #include "tca9548a_multiplexer.h"
+#include "task_scheduler.h"
+#include "logger.h"
 
 TCA9548A_Multiplexer::TCA9548A_Multiplexer(uint8_t address) {
     _address = address;
-    _currentChannel = NO_CHANNEL;
+    _channelMask = 0;
+    _maskValid = false;
+    _lastSelectChanged = false;
+    _lastChangeMs = 0;
     _initialized = false;
+    for (uint8_t i = 0; i < 8; i++) {
+        _channelClock[i] = I2C_CLOCK_STANDARD;
+    }
+    _busClock = 0;
+    resetStatistics();
 }
 
 bool TCA9548A_Multiplexer::begin() {
     if (isConnected()) {
         _initialized = true;
+        invalidate();
         disableAllChannels();
         return true;
     }
@@ -16,49 +27,218 @@ bool TCA9548A_Multiplexer::begin() {
 }
 
 bool TCA9548A_Multiplexer::selectChannel(uint8_t channel) {
-    if (!_initialized) {
+    if (channel > 7) {
         return false;
     }
-    
+
+    return selectChannels(1 << channel);  // Set the bit for the desired channel
+}
+
+bool TCA9548A_Multiplexer::selectChannel(uint8_t channel, unsigned long settleMs) {
     if (channel > 7) {
         return false;
     }
-    
-    Wire1.beginTransmission(_address);
-    Wire1.write(1 << channel);  // Set the bit for the desired channel
-    uint8_t error = Wire1.endTransmission();
-    
-    if (error == 0) {
-        _currentChannel = channel;
-        return true;
-    }
-    
-    return false;
+
+    return selectChannels(1 << channel, settleMs);
 }
 
-bool TCA9548A_Multiplexer::disableAllChannels() {
+bool TCA9548A_Multiplexer::selectChannels(uint8_t mask) {
     if (!_initialized) {
         return false;
     }
-    
-    Wire1.beginTransmission(_address);
-    Wire1.write(0);  // Disable all channels
-    uint8_t error = Wire1.endTransmission();
-    
-    if (error == 0) {
-        _currentChannel = NO_CHANNEL;
+
+    _selectCount++;
+
+    if (_maskValid && mask == _channelMask) {
+        _cacheHits++;
+        _lastSelectChanged = false;
         return true;
     }
-    
-    return false;
+
+    return writeMask(mask);
+}
+
+bool TCA9548A_Multiplexer::selectChannels(uint8_t mask, unsigned long settleMs) {
+    if (!selectChannels(mask)) {
+        return false;
+    }
+
+    // A cache hit can still land inside the settle window of an earlier switch
+    unsigned long remaining = getSettleRemaining(settleMs);
+    if (remaining > 0) {
+        cooperativeDelay(remaining);
+    }
+    return true;
+}
+
+bool TCA9548A_Multiplexer::disableAllChannels() {
+    return selectChannels(0);  // Disable all channels
 }
 
 uint8_t TCA9548A_Multiplexer::getCurrentChannel() {
-    return _currentChannel;
+    if (!_maskValid || _channelMask == 0 || (_channelMask & (_channelMask - 1)) != 0) {
+        return NO_CHANNEL;
+    }
+
+    uint8_t channel = 0;
+    while (!(_channelMask & (1 << channel))) {
+        channel++;
+    }
+    return channel;
+}
+
+bool TCA9548A_Multiplexer::isChannelEnabled(uint8_t channel) const {
+    return channel <= 7 && _maskValid && (_channelMask & (1 << channel)) != 0;
+}
+
+unsigned long TCA9548A_Multiplexer::getSettleRemaining(unsigned long settleMs) const {
+    unsigned long elapsed = millis() - _lastChangeMs;
+    return elapsed < settleMs ? settleMs - elapsed : 0;
+}
+
+void TCA9548A_Multiplexer::invalidate() {
+    _maskValid = false;
+    _busClock = 0;      // A bus restart also resets the clock
+}
+
+void TCA9548A_Multiplexer::setChannelClock(uint8_t channel, uint32_t hz) {
+    if (channel > 7 || hz == 0) return;
+    _channelClock[channel] = hz;
+
+    // Takes effect now if the channel is enabled, otherwise on its next select
+    if (isChannelEnabled(channel)) {
+        applyClock(clockFor(_channelMask));
+    }
+}
+
+uint32_t TCA9548A_Multiplexer::clockFor(uint8_t mask) const {
+    // Nothing enabled: only the mux itself is on the bus
+    if (mask == 0) return I2C_CLOCK_FAST;
+
+    uint32_t hz = I2C_CLOCK_FAST;
+    for (uint8_t i = 0; i < 8; i++) {
+        if ((mask & (1 << i)) && _channelClock[i] < hz) {
+            hz = _channelClock[i];
+        }
+    }
+    return hz;
+}
+
+void TCA9548A_Multiplexer::applyClock(uint32_t hz) {
+    if (hz == _busClock) return;
+    Wire1.setClock(hz);
+    _busClock = hz;
+    _clockChanges++;
+}
+
+bool TCA9548A_Multiplexer::recoverBus() {
+    Wire1.end();
+
+    // Open drain by hand: drive low, or release to the pull-up
+    pinMode(I2C_RECOVERY_SDA_PIN, INPUT_PULLUP);
+    pinMode(I2C_RECOVERY_SCL_PIN, INPUT_PULLUP);
+    delayMicroseconds(I2C_RECOVERY_HALF_PERIOD_US);
+
+    // A slave stuck mid-byte shifts out its remaining bits and releases SDA
+    uint8_t pulses = 0;
+    while (pulses < I2C_RECOVERY_CLOCK_PULSES && digitalRead(I2C_RECOVERY_SDA_PIN) == LOW) {
+        digitalWrite(I2C_RECOVERY_SCL_PIN, LOW);
+        pinMode(I2C_RECOVERY_SCL_PIN, OUTPUT);
+        delayMicroseconds(I2C_RECOVERY_HALF_PERIOD_US);
+        pinMode(I2C_RECOVERY_SCL_PIN, INPUT_PULLUP);
+        delayMicroseconds(I2C_RECOVERY_HALF_PERIOD_US);
+        pulses++;
+    }
+
+    // STOP: SDA rises while SCL is high
+    digitalWrite(I2C_RECOVERY_SCL_PIN, LOW);
+    pinMode(I2C_RECOVERY_SCL_PIN, OUTPUT);
+    digitalWrite(I2C_RECOVERY_SDA_PIN, LOW);
+    pinMode(I2C_RECOVERY_SDA_PIN, OUTPUT);
+    delayMicroseconds(I2C_RECOVERY_HALF_PERIOD_US);
+    pinMode(I2C_RECOVERY_SCL_PIN, INPUT_PULLUP);
+    delayMicroseconds(I2C_RECOVERY_HALF_PERIOD_US);
+    pinMode(I2C_RECOVERY_SDA_PIN, INPUT_PULLUP);
+    delayMicroseconds(I2C_RECOVERY_HALF_PERIOD_US);
+
+    bool released = digitalRead(I2C_RECOVERY_SDA_PIN) == HIGH &&
+                    digitalRead(I2C_RECOVERY_SCL_PIN) == HIGH;
+
+    // Restart the peripheral at a clock every channel accepts; the mux
+    // register state is unknown until the next select writes it
+    Wire1.begin();
+    invalidate();
+    applyClock(clockFor(0xFF));
+
+    _recoveries++;
+    if (released) {
+        LOG_WARN("I2C bus recovery: bus released after %u clock pulses", pulses);
+    } else {
+        _recoveryFailures++;
+        LOG_ERROR("I2C bus recovery failed: SDA or SCL still held low");
+    }
+    return released;
 }
 
 bool TCA9548A_Multiplexer::isConnected() {
     Wire1.beginTransmission(_address);
     uint8_t error = Wire1.endTransmission();
     return (error == 0);
-}
\ No newline at end of file
+}
+
+void TCA9548A_Multiplexer::resetStatistics() {
+    _selectCount = 0;
+    _cacheHits = 0;
+    _writeCount = 0;
+    _writeErrors = 0;
+    _clockChanges = 0;
+    _recoveries = 0;
+    _recoveryFailures = 0;
+}
+
+void TCA9548A_Multiplexer::getStatistics(char* buffer, size_t bufferSize) {
+    if (!buffer || bufferSize == 0) return;
+
+    char maskStr[8];
+    if (_maskValid) {
+        snprintf(maskStr, sizeof(maskStr), "0x%02X", _channelMask);
+    } else {
+        snprintf(maskStr, sizeof(maskStr), "?");
+    }
+
+    snprintf(buffer, bufferSize,
+        "mux: mask=%s selects=%lu hits=%lu writes=%lu errors=%lu saved=%luus "
+        "clock=%lukHz clock_changes=%lu recoveries=%lu failed=%lu",
+        maskStr, (unsigned long)_selectCount, (unsigned long)_cacheHits,
+        (unsigned long)_writeCount, (unsigned long)_writeErrors,
+        (unsigned long)_cacheHits * TCA9548A_WRITE_US,
+        (unsigned long)(_busClock / 1000), (unsigned long)_clockChanges,
+        (unsigned long)_recoveries, (unsigned long)_recoveryFailures);
+}
+
+bool TCA9548A_Multiplexer::writeMask(uint8_t mask) {
+    // Every device on the old and the new channels sees this write
+    uint32_t oldClock = clockFor(_maskValid ? _channelMask : 0xFF);
+    uint32_t newClock = clockFor(mask);
+    applyClock(oldClock < newClock ? oldClock : newClock);
+
+    Wire1.beginTransmission(_address);
+    Wire1.write(mask);
+    uint8_t error = Wire1.endTransmission();
+    _writeCount++;
+
+    if (error == 0) {
+        _channelMask = mask;
+        _maskValid = true;
+        _lastSelectChanged = true;
+        _lastChangeMs = millis();
+        applyClock(newClock);
+        return true;
+    }
+
+    // Unknown register state - write again on the next select
+    _writeErrors++;
+    _maskValid = false;
+    _lastSelectChanged = false;
+    return false;
+}
@@ -1,12 +1,24 @@
 ﻿#include "telnet_server.h"
+#include "logger.h"
+#include "response_sink.h"
+#include "task_scheduler.h"
 #include <WiFiS3.h>
 #include <stdarg.h>
 
-extern void debugPrintf(const char* fmt, ...);
+static_assert((TELNET_OUTPUT_RING & (TELNET_OUTPUT_RING - 1)) == 0, "TELNET_OUTPUT_RING must be a power of two");
+
+static const size_t DROP_MARK_LENGTH = sizeof(TELNET_DROP_MARK) - 1;
 
 TelnetServer::TelnetServer() : 
     server(23),
-    clientConnected(false) {
+    sessionCount(0),
+    nextReadSession(0),
+    accepted(0),
+    rejected(0) {
+    
+    for (uint8_t i = 0; i < TELNET_MAX_SESSIONS; i++) {
+        sessions[i].active = false;
+    }
     
     // Set default connection info
     strncpy(hostname, "LogMonitor", sizeof(hostname) - 1);
@@ -19,107 +31,207 @@ TelnetServer::TelnetServer() :
 void TelnetServer::begin(int port) {
     server = WiFiServer(port);
     server.begin();
-    debugPrintf("TelnetServer: Started on port %d\n", port);
+    debugPrintf("TelnetServer: Started on port %d (%d sessions)\n", port, TELNET_MAX_SESSIONS);
 }
 
 void TelnetServer::update() {
-    // Check for new client connections
-    if (!clientConnected) {
-        client = server.available();
-        if (client) {
-            handleNewConnection();
-        }
-    } else {
-        // Check if existing client is still connected
-        if (!client.connected()) {
-            handleClientDisconnection();
+    acceptConnections();
+    
+    for (uint8_t i = 0; i < TELNET_MAX_SESSIONS; i++) {
+        Session& session = sessions[i];
+        if (!session.active) continue;
+        
+        if (!session.client.connected()) {
+            closeSession(i);
+            continue;
         }
+        
+        readInput(session);
+        drainOutput(session);
     }
 }
 
-void TelnetServer::handleNewConnection() {
-    clientConnected = true;
-    inputBuffer = "";
+void TelnetServer::acceptConnections() {
+    WiFiClient incoming = server.accept();
+    if (!incoming) return;
+    
+    uint8_t index = NO_SESSION;
+    for (uint8_t i = 0; i < TELNET_MAX_SESSIONS; i++) {
+        if (!sessions[i].active) {
+            index = i;
+            break;
+        }
+    }
     
-    debugPrintf("TelnetServer: Client connected from %s\n", client.remoteIP().toString().c_str());
+    if (index == NO_SESSION) {
+        rejected++;
+        incoming.print("All telnet sessions in use\r\n");
+        incoming.stop();
+        debugPrintf("TelnetServer: Rejected client from %s (sessions full)\n",
+            incoming.remoteIP().toString().c_str());
+        return;
+    }
     
-    // Show welcome message
-    showWelcomeMessage();
+    Session& session = sessions[index];
+    session.client = incoming;
+    session.active = true;
+    session.lineLength = 0;
+    session.lineReady = false;
+    session.telnetState = TELNET_DATA;
+    session.head = 0;
+    session.tail = 0;
+    session.markPending = false;
+    session.connectedAt = millis();
+    session.bytesSent = 0;
+    session.droppedBytes = 0;
+    session.peakQueued = 0;
+    sessionCount++;
+    accepted++;
     
-    // Show prompt
-    client.print("> ");
+    debugPrintf("TelnetServer: Client %u connected from %s\n", index,
+        session.client.remoteIP().toString().c_str());
+    
+    // Show welcome message and prompt
+    showWelcomeMessage(index);
+    print(index, "> ");
 }
 
-void TelnetServer::handleClientDisconnection() {
-    debugPrintf("TelnetServer: Client disconnected\n");
-    client.stop();
-    clientConnected = false;
-    inputBuffer = "";
+void TelnetServer::closeSession(uint8_t index) {
+    Session& session = sessions[index];
+    debugPrintf("TelnetServer: Client %u disconnected (sent=%lu dropped=%lu)\n", index,
+        (unsigned long)session.bytesSent, (unsigned long)session.droppedBytes);
+    session.client.stop();
+    session.active = false;
+    sessionCount--;
 }
 
-void TelnetServer::showWelcomeMessage() {
-    if (!clientConnected) return;
-    
-    client.print("\r\n");
-    client.print("===============================================\r\n");
-    client.print("   LogSplitter Monitor\r\n");
-    client.print("   Version: ");
-    client.print(version);
-    client.print("\r\n");
-    client.print("   Type 'help' for available commands\r\n");
-    client.print("===============================================\r\n");
-    client.print("Connected to: ");
-    client.print(WiFi.localIP().toString().c_str());
-    client.print("\r\n");
-    client.print("Hostname: ");
-    client.print(hostname);
-    client.print("\r\n\r\n");
+void TelnetServer::readInput(Session& session) {
+    for (uint8_t budget = TELNET_INPUT_BYTES; budget > 0 && !session.lineReady; budget--) {
+        if (session.client.available() <= 0) break;
+        int c = session.client.read();
+        if (c < 0) break;
+        
+        // Skip telnet protocol sequences (IAC commands), even split across reads
+        if (session.telnetState == TELNET_IAC) {
+            session.telnetState = (c >= 251 && c <= 254) ? TELNET_OPTION : TELNET_DATA;
+            continue;
+        }
+        if (session.telnetState == TELNET_OPTION) {
+            session.telnetState = TELNET_DATA;
+            continue;
+        }
+        if (c == 255) { // IAC (Interpret as Command)
+            session.telnetState = TELNET_IAC;
+            continue;
+        }
+        
+        if (c == '\n') {
+            if (session.lineLength > 0) {
+                session.line[session.lineLength] = '\0';
+                session.lineReady = true;
+                enqueue(session, "\r\n", 2); // Move to next line
+            }
+        } else if (c == '\r') {
+            // Ignore carriage return, wait for line feed
+            continue;
+        } else if (c == '\b' || c == 127) { // Backspace or DEL
+            if (session.lineLength > 0) {
+                session.lineLength--;
+                enqueue(session, "\b \b", 3); // Erase character on screen
+            }
+        } else if (c >= 32 && c <= 126) { // Printable ASCII characters only
+            if (session.lineLength < sizeof(session.line) - 1) {
+                session.line[session.lineLength++] = (char)c;
+                char echo = (char)c;
+                enqueue(session, &echo, 1); // Echo character back
+            }
+        }
+        // Ignore all other control characters
+    }
 }
 
-void TelnetServer::setConnectionInfo(const char* newHostname, const char* newVersion) {
-    if (newHostname) {
-        strncpy(hostname, newHostname, sizeof(hostname) - 1);
-        hostname[sizeof(hostname) - 1] = '\0';
+void TelnetServer::drainOutput(Session& session) {
+    uint16_t pending = queued(session);
+    uint16_t budget = TELNET_DRAIN_BYTES;
+    
+    while (pending > 0 && budget > 0) {
+        // Contiguous part of the ring only, the rest goes in the next round
+        uint16_t count = TELNET_OUTPUT_RING - session.tail;
+        if (count > pending) count = pending;
+        if (count > budget) count = budget;
+        
+        size_t written = session.client.write((const uint8_t*)session.output + session.tail, count);
+        if (written == 0) break;    // Socket full - try again on the next update
+        
+        session.tail = (session.tail + written) & (TELNET_OUTPUT_RING - 1);
+        session.bytesSent += written;
+        pending -= written;
+        budget -= written;
     }
     
-    if (newVersion) {
-        strncpy(version, newVersion, sizeof(version) - 1);
-        version[sizeof(version) - 1] = '\0';
+    if (session.markPending && space(session) >= DROP_MARK_LENGTH) {
+        enqueue(session, "", 0);
     }
 }
 
-void TelnetServer::stop() {
-    if (clientConnected) {
-        client.stop();
-        clientConnected = false;
+bool TelnetServer::enqueue(Session& session, const char* data, size_t length) {
+    size_t needed = length + (session.markPending ? DROP_MARK_LENGTH : 0);
+    if (needed > space(session)) {
+        session.droppedBytes += length;
+        session.markPending = true;
+        return false;
     }
-    server.end();
-    debugPrintf("TelnetServer: Stopped\n");
+    
+    if (session.markPending) {
+        session.markPending = false;
+        enqueue(session, TELNET_DROP_MARK, DROP_MARK_LENGTH);
+    }
+    
+    for (size_t i = 0; i < length; i++) {
+        session.output[session.head] = data[i];
+        session.head = (session.head + 1) & (TELNET_OUTPUT_RING - 1);
+    }
+    
+    uint16_t used = queued(session);
+    if (used > session.peakQueued) session.peakQueued = used;
+    return true;
 }
 
-bool TelnetServer::isConnected() {
-    return clientConnected && client.connected();
+bool TelnetServer::write(uint8_t session, const char* data, size_t length, unsigned long waitMs) {
+    if (session >= TELNET_MAX_SESSIONS || !sessions[session].active || !data) return false;
+    Session& target = sessions[session];
+    
+    // Wait for room by sending queued output, keeping Serial1 drained meanwhile
+    unsigned long start = millis();
+    while (length + (target.markPending ? DROP_MARK_LENGTH : 0) > space(target) &&
+           length < TELNET_OUTPUT_RING && millis() - start < waitMs) {
+        if (!target.client.connected()) break;
+        drainOutput(target);
+        if (length + (target.markPending ? DROP_MARK_LENGTH : 0) > space(target)) {
+            cooperativeDelay(1);
+        }
+    }
+    
+    return enqueue(target, data, length);
 }
 
-bool TelnetServer::hasData() {
-    return clientConnected && client.available() > 0;
+void TelnetServer::print(uint8_t session, const char* str) {
+    if (str) write(session, str, strlen(str));
 }
 
 void TelnetServer::print(const char* str) {
-    if (clientConnected && client.connected()) {
-        client.print(str);
+    for (uint8_t i = 0; i < TELNET_MAX_SESSIONS; i++) {
+        if (sessions[i].active) print(i, str);
     }
 }
 
 void TelnetServer::println(const char* str) {
-    if (clientConnected && client.connected()) {
-        client.print(str);
-        client.print("\r\n");
-    }
+    print(str);
+    print("\r\n");
 }
 
 void TelnetServer::printf(const char* fmt, ...) {
-    if (!clientConnected || !client.connected()) return;
+    if (sessionCount == 0) return;
     
     char buffer[256];
     va_list args;
@@ -127,51 +239,76 @@ void TelnetServer::printf(const char* fmt, ...) {
     vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
     
-    client.print(buffer);
+    print(buffer);
 }
 
-String TelnetServer::readLine() {
-    String line = "";
+bool TelnetServer::readLine(char* buffer, size_t bufferSize, uint8_t& session) {
+    if (!buffer || bufferSize == 0) return false;
     
-    while (hasData()) {
-        char c = client.read();
+    for (uint8_t n = 0; n < TELNET_MAX_SESSIONS; n++) {
+        uint8_t index = (nextReadSession + n) % TELNET_MAX_SESSIONS;
+        Session& source = sessions[index];
+        if (!source.active || !source.lineReady) continue;
         
-        // Handle telnet protocol sequences (IAC commands)
-        if ((unsigned char)c == 255) { // IAC (Interpret as Command)
-            // Skip telnet protocol sequences
-            if (hasData()) client.read(); // Command
-            if (hasData()) client.read(); // Option
-            continue;
-        }
+        strncpy(buffer, source.line, bufferSize - 1);
+        buffer[bufferSize - 1] = '\0';
+        source.lineReady = false;
+        source.lineLength = 0;
         
-        if (c == '\n') {
-            if (inputBuffer.length() > 0) {
-                line = inputBuffer;
-                inputBuffer = "";
-                println(""); // Move to next line
-                break;
-            }
-        } else if (c == '\r') {
-            // Ignore carriage return, wait for line feed
-            continue;
-        } else if (c == '\b' || c == 127) { // Backspace or DEL
-            if (inputBuffer.length() > 0) {
-                inputBuffer.remove(inputBuffer.length() - 1);
-                print("\b \b"); // Erase character on screen
-            }
-        } else if (c >= 32 && c <= 126) { // Printable ASCII characters only
-            inputBuffer += c;
-            client.write(c); // Echo character back
-        }
-        // Ignore all other control characters
+        session = index;
+        nextReadSession = (index + 1) % TELNET_MAX_SESSIONS;
+        return true;
+    }
+    return false;
+}
+
+void TelnetServer::showWelcomeMessage(uint8_t session) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "\r\n"
+        "===============================================\r\n"
+        "   LogSplitter Monitor\r\n"
+        "   Version: %s\r\n"
+        "   Type 'help' for available commands\r\n"
+        "===============================================\r\n"
+        "Connected to: %s\r\n"
+        "Hostname: %s\r\n\r\n",
+        version, WiFi.localIP().toString().c_str(), hostname);
+    print(session, buffer);
+}
+
+void TelnetServer::setConnectionInfo(const char* newHostname, const char* newVersion) {
+    if (newHostname) {
+        strncpy(hostname, newHostname, sizeof(hostname) - 1);
+        hostname[sizeof(hostname) - 1] = '\0';
     }
     
-    return line;
+    if (newVersion) {
+        strncpy(version, newVersion, sizeof(version) - 1);
+        version[sizeof(version) - 1] = '\0';
+    }
 }
 
-void TelnetServer::flushInput() {
-    inputBuffer = "";
-    while (hasData()) {
-        client.read();
+void TelnetServer::stop() {
+    for (uint8_t i = 0; i < TELNET_MAX_SESSIONS; i++) {
+        if (sessions[i].active) closeSession(i);
+    }
+    server.end();
+    debugPrintf("TelnetServer: Stopped\n");
+}
+
+void TelnetServer::getStatistics(ResponseSink& out) {
+    out.printf("telnet: sessions=%u/%u accepted=%lu rejected=%lu ring=%u",
+        sessionCount, TELNET_MAX_SESSIONS, (unsigned long)accepted, (unsigned long)rejected,
+        TELNET_OUTPUT_RING);
+    
+    for (uint8_t i = 0; i < TELNET_MAX_SESSIONS; i++) {
+        Session& session = sessions[i];
+        if (!session.active) continue;
+        out.printf("\r\n#%u %s: up=%lus queued=%u peak=%u sent=%lu dropped=%lu",
+            i, session.client.remoteIP().toString().c_str(),
+            (millis() - session.connectedAt) / 1000,
+            queued(session), session.peakQueued,
+            (unsigned long)session.bytesSent, (unsigned long)session.droppedBytes);
     }
 }
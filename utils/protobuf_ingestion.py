@@ -15,12 +15,15 @@ import paho.mqtt.client as mqtt
 MQTT_BROKER = "192.168.1.155"
 MQTT_PORT = 1883
 TOPIC_PROTOBUF = "controller/protobuff"
+# Monitors with 'set namespace on' publish under <hostname>/
+TOPIC_PROTOBUF_NAMESPACED = "+/" + TOPIC_PROTOBUF
 
 # Global state
 running = True
 stats = {
     'messages_received': 0,
     'bytes_received': 0,
+    'devices': {},
     'start_time': time.time()
 }
 
@@ -43,8 +46,8 @@ def on_connect(client, userdata, flags, rc):
     """MQTT connection callback"""
     if rc == 0:
         logger.info(f"✅ Connected to MQTT broker {MQTT_BROKER}:{MQTT_PORT}")
-        client.subscribe(TOPIC_PROTOBUF)
-        logger.info(f"📡 Subscribed to {TOPIC_PROTOBUF}")
+        client.subscribe([(TOPIC_PROTOBUF, 0), (TOPIC_PROTOBUF_NAMESPACED, 0)])
+        logger.info(f"📡 Subscribed to {TOPIC_PROTOBUF} and {TOPIC_PROTOBUF_NAMESPACED}")
     else:
         logger.error(f"❌ Failed to connect to MQTT broker: {rc}")
 
@@ -53,7 +56,11 @@ def on_message(client, userdata, msg):
     stats['messages_received'] += 1
     stats['bytes_received'] += len(msg.payload)
     
-    logger.info(f"📦 Protobuf #{stats['messages_received']}: {len(msg.payload)} bytes")
+    # Namespaced topics carry the device hostname as the first level
+    device = msg.topic[:-len(TOPIC_PROTOBUF) - 1] if msg.topic != TOPIC_PROTOBUF else "-"
+    stats['devices'][device] = stats['devices'].get(device, 0) + 1
+    
+    logger.info(f"📦 Protobuf #{stats['messages_received']} from {device}: {len(msg.payload)} bytes")
     
     # TODO: Parse protobuf when schema is available
     # For now, just log the message reception
@@ -72,6 +79,8 @@ def print_stats():
     logger.info(f"📊 Stats - Uptime: {uptime:.1f}s")
     logger.info(f"📊 Messages: {stats['messages_received']} ({rate:.2f}/sec)")
     logger.info(f"📊 Data: {stats['bytes_received']} bytes")
+    for device, count in sorted(stats['devices'].items()):
+        logger.info(f"📊   {device}: {count} messages")
     logger.info("=" * 50)
 
 def main():